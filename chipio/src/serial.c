@@ -22,6 +22,7 @@
 #include <sysio/log.h>
 #include <sysio/i2c.h>
 #include <sysio/doutput.h>
+#include <sysio/scheduler.h>
 #include <chipio/serial.h>
 #include "interface.h"
 
@@ -147,6 +148,7 @@ pvSerialThread (void * xContext) {
   xChipIoSerial * port = (xChipIoSerial *) xContext;
 
   pthread_setcancelstate (PTHREAD_CANCEL_ENABLE, NULL);
+  iSchedulerApplyProfile ("chipio-serial");
   vLedDebugInit();
 
   for (;;) {
@@ -91,6 +91,15 @@ enum ArduinoBool {
   LOW = false   ///< état bas
 };
 
+/**
+ * @enum ArduinoBitOrder
+ * @brief Ordre de transmission des bits de shiftOut() et shiftIn()
+ */
+enum ArduinoBitOrder {
+  LSBFIRST = 0, ///< bit de poids faible en premier
+  MSBFIRST = 1  ///< bit de poids fort en premier
+};
+
 // Digital pins ----------------------------------------------------------------
 /**
  * @brief Modification du mode d'une broche digitale
@@ -120,6 +129,75 @@ int digitalRead (int pin);
  */
 void digitalToggle (int pin); // Not supported by Arduino !
 
+// Advanced I/O ----------------------------------------------------------------
+/**
+ * @brief Transmet un octet bit par bit
+ *
+ * La donnée est placée sur \c dataPin puis validée par une impulsion
+ * positive sur \c clockPin. Avec la couche AccessLayerIoMap, chaque
+ * modification est une écriture directe dans les registres du GPIO.
+ *
+ * https://www.arduino.cc/reference/en/language/functions/advanced-io/shiftout/
+ */
+void shiftOut (int dataPin, int clockPin, int bitOrder, uint8_t value);
+
+/**
+ * @brief Reçoit un octet bit par bit
+ *
+ * \c dataPin est lue pendant l'état haut de chaque impulsion sur \c clockPin.
+ *
+ * https://www.arduino.cc/reference/en/language/functions/advanced-io/shiftin/
+ */
+uint8_t shiftIn (int dataPin, int clockPin, int bitOrder);
+
+/**
+ * @brief Mesure la durée d'une impulsion
+ *
+ * Attend que la broche passe à l'état \c state, puis mesure la durée de cet
+ * état. Le registre de niveau est scruté en attente active et les fronts
+ * sont datés par l'horloge CLOCK_MONOTONIC, la précision est de l'ordre de
+ * la microseconde si le thread n'est pas préempté (voir Scheduler).
+ *
+ * https://www.arduino.cc/reference/en/language/functions/advanced-io/pulsein/
+ *
+ * @param pin broche en entrée
+ * @param state HIGH pour une impulsion positive, LOW pour une négative
+ * @param timeout délai d'attente maximal de la fin de l'impulsion en µs
+ * @return durée de l'impulsion en µs, 0 si le délai a expiré
+ */
+unsigned long pulseIn (int pin, int state, unsigned long timeout = 1000000UL);
+
+/**
+ * @brief Mesure la durée d'une impulsion
+ *
+ * Identique à pulseIn(), présente pour la compatibilité Arduino.
+ */
+unsigned long pulseInLong (int pin, int state, unsigned long timeout = 1000000UL);
+
+/**
+ * @brief Génère un signal carré de rapport cyclique 50%
+ *
+ * Le signal est produit par un PWM logiciel (SoftPwm), une seule broche à
+ * la fois, un appel sur une autre broche arrête le signal en cours.
+ *
+ * https://www.arduino.cc/reference/en/language/functions/advanced-io/tone/
+ *
+ * @param pin broche de sortie
+ * @param frequency fréquence en Hz
+ * @param duration durée en ms, 0 jusqu'à l'appel de noTone()
+ */
+void tone (int pin, unsigned int frequency, unsigned long duration = 0);
+
+/**
+ * @brief Arrête le signal généré par tone()
+ *
+ * https://www.arduino.cc/reference/en/language/functions/advanced-io/notone/
+ *
+ * @param pin broche, sans effet si le signal n'est pas généré sur cette
+ * broche
+ */
+void noTone (int pin);
+
 // Interrupts ------------------------------------------------------------------
 /**
  * @brief Installe une routine d'interruption (Isr)
@@ -30,6 +30,11 @@
  * front (montant, descendant ou montant et descendant). Bien que ce
  * fonctionnement puisse s'apparenter à une interruption matérielle, il est en
  * fait implémenté grâce au multi-thread. \n
+ * Les fronts sont signalés par le noyau (/dev/gpiochipN), puis confirmés à
+ * l'issue d'un délai anti-rebond réglable pour chaque entrée
+ * (iDinSetDebounce()). Un port au repos ne consomme aucun temps processeur.
+ * Si l'interface du noyau n'est pas disponible, les entrées sont scrutées
+ * toutes les 20 ms. \n
  * Le nombre maximal de broches d'un port logique est de 31 sur une plateforme
  * 32 bits (63 pour 64 bits ...)
  * @{
@@ -172,6 +177,29 @@ int iDinReadAll (xDinPort * port);
  */
 int iDinSetEdge (unsigned input, eDinEdge edge, xDinPort * port);
 
+/**
+ * @brief Réglage du délai anti-rebond d'une entrée
+ *
+ * Un changement d'état n'est pris en compte que si l'entrée est restée
+ * stable pendant ce délai après le dernier front. Le délai par défaut est
+ * de 20 ms.
+ *
+ * @param input le numéro logique de l'entrée concernée
+ * @param us délai en microsecondes, 0 pour aucun anti-rebond
+ * @param port le port d'entrée
+ * @return 0, -1 si erreur
+ */
+int iDinSetDebounce (unsigned input, unsigned long us, xDinPort * port);
+
+/**
+ * @brief Délai anti-rebond d'une entrée en microsecondes
+ *
+ * @param input le numéro logique de l'entrée concernée
+ * @param port le port d'entrée
+ * @return le délai, -1 si erreur
+ */
+long lDinDebounce (unsigned input, xDinPort * port);
+
 /**
  * @brief Front(s) déclenchant d'une entrée
  *
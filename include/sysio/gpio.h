@@ -17,6 +17,7 @@
  *  @defgroup sysio_gpio_class Gpio
  *  @defgroup sysio_gpio_pin Broches
  *  @defgroup sysio_gpio_connector Connecteurs
+ *  @defgroup sysio_gpio_pingroup Groupes de broches
  *  @}
  */
 
@@ -33,7 +34,19 @@
 #include <map>
 #include <memory>
 #include <exception>
+#include <cstdint>
 #include <sysio/gpioconnector.h>
+#include <sysio/gpiopingroup.h>
+#include <sysio/gpiodispatcher.h>
+#include <sysio/gpiofastpin.h>
+#include <sysio/gpiowaveform.h>
+#include <sysio/gpiocapture.h>
+#include <sysio/gpiosoftpwm.h>
+#include <sysio/gpiostate.h>
+#include <sysio/gpiosoftspi.h>
+#include <sysio/gpiosofti2c.h>
+#include <sysio/gpioonewire.h>
+#include <sysio/gpioencoder.h>
 
 namespace Sysio {
 
@@ -53,6 +66,9 @@ namespace Sysio {
   class Gpio {
     public:
       friend class Connector;
+      friend class PinGroup;
+      friend class Waveform;
+      friend class SoftPwm;
 
       /**
        * @class Descriptor
@@ -73,6 +89,23 @@ namespace Sysio {
        */
       Gpio (AccessLayer layer = AccessLayerAuto);
 
+      /**
+       * @brief Constructeur permettant de choisir un GPIO simulé
+       *
+       * Le GPIO simulé reproduit les registres d'un BCM2835 en mémoire, il ne
+       * nécessite ni matériel, ni droits particuliers et seule la couche
+       * AccessLayerIoMap est utilisable. Il permet d'utiliser et de mesurer
+       * les performances de la bibliothèque sur n'importe quelle machine. \n
+       * Le constructeur par défaut choisit le GPIO simulé si la variable
+       * d'environnement SYSIO_GPIO_SIM est différente de 0. Sur une plateforme
+       * sans GPIO (Linux générique), le GPIO simulé est toujours choisi.
+       *
+       * @param layer choix de la couche d'accès
+       * @param simulated true pour le GPIO simulé, false pour celui de la
+       * plateforme
+       */
+      Gpio (AccessLayer layer, bool simulated);
+
       /**
        * @brief Destructeur
        */
@@ -231,6 +264,80 @@ namespace Sysio {
        */
       const std::map<int, std::shared_ptr<Pin>> & pin();
 
+      /**
+       * @brief Modification des résistances de tirage de plusieurs broches
+       *
+       * Équivalent à un appel de Pin::setPull() pour chaque broche, mais avec
+       * la couche AccessLayerIoMap, les broches d'un même port sont modifiées
+       * par une seule séquence matérielle (GPPUD/GPPUDCLKn sur un Raspberry Pi)
+       * au lieu d'une séquence par broche. Les broches qui ne sont pas de type
+       * \c TypeGpio sont ignorées.
+       *
+       * @param pins liste des broches
+       * @param pull résistance à appliquer
+       */
+      void setPull (const std::vector<Pin *> & pins, Pin::Pull pull);
+
+      /**
+       * @overload
+       *
+       * Les broches sont regroupées par résistance et par port, une séquence
+       * matérielle est effectuée pour chaque groupe.
+       *
+       * @param pulls résistance à appliquer à chaque broche
+       */
+      void setPull (const std::map<Pin *, Pin::Pull> & pulls);
+
+      /**
+       * @brief Photographie de l'état de toutes les broches GPIO
+       *
+       * Avec la couche AccessLayerIoMap, les registres du GPIO sont lus une
+       * seule fois pour toutes les broches au lieu d'appeler Pin::mode(),
+       * Pin::pull() et Pin::read() pour chacune. Les broches utilisant
+       * SysFs ou /dev/gpiochipN sont lues une à une.
+       */
+      GpioState snapshot() const;
+
+      //------------------------------------------------------------------------
+      //                          Accès par port
+      //------------------------------------------------------------------------
+
+      /**
+       * @brief Nombre de ports (bancs de registres) du GPIO
+       *
+       * @return le nombre de ports, 0 si la plateforme ne permet pas l'accès
+       * par port.
+       */
+      unsigned int ports() const;
+
+      /**
+       * @brief Modification simultanée des broches d'un port
+       *
+       * Les broches correspondant aux bits à 1 de \c setMask passent à l'état
+       * haut, celles correspondant aux bits à 1 de \c clrMask passent à l'état
+       * bas, les autres ne sont pas modifiées. Les broches d'un même port sont
+       * modifiées par un seul accès aux registres, sans décalage entre elles. \n
+       * Cette fonction nécessite la couche d'accès AccessLayerIoMap, elle déclenche
+       * une exception std::domain_error si ce n'est pas le cas, std::system_error
+       * si le GPIO n'est pas ouvert et std::out_of_range si le port n'existe pas.
+       *
+       * @param port numéro du port (banc), de 0 à ports() - 1
+       * @param setMask masque des bits à mettre à 1
+       * @param clrMask masque des bits à mettre à 0
+       */
+      void writePort (unsigned int port, uint32_t setMask, uint32_t clrMask);
+
+      /**
+       * @brief Lecture simultanée des broches d'un port
+       *
+       * Mêmes conditions que writePort().
+       *
+       * @param port numéro du port (banc), de 0 à ports() - 1
+       * @return état binaire des broches du port, le bit 0 correspondant à la
+       * première broche du port.
+       */
+      uint32_t readPort (unsigned int port) const;
+
     protected:
       /**
        * @brief Accès à la couche matérielle
@@ -255,6 +362,8 @@ namespace Sysio {
       Pin::Numbering _numbering; // Numérotation en cours
       std::map<int, std::shared_ptr<Pin>> _pin; // Broches uniquement GPIO
       std::map<int, std::shared_ptr<Connector>> _connector; // Connecteurs avec toutes les broches physiques
+
+      void checkPortAccess() const;
   };
 }
 /**
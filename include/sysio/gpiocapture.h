@@ -0,0 +1,205 @@
+/**
+ * @file
+ * @brief GPIO logic capture
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_CAPTURE_H_
+#define _SYSIO_GPIO_CAPTURE_H_
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <ostream>
+#include <cstdint>
+#include <sysio/gpiopingroup.h>
+
+namespace Sysio {
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class Capture
+   * @author epsilonrt
+   * @date 03/18/18
+   * @brief Analyseur logique logiciel
+   *
+   * Les broches d'un groupe sont échantillonnées à fréquence fixe. Avec la
+   * couche AccessLayerIoMap, un échantillon est obtenu par une lecture de
+   * chaque registre de niveau utilisé (GPLEV0/GPLEV1 sur un Raspberry Pi),
+   * sans appel virtuel, ce qui permet plusieurs millions d'échantillons par
+   * seconde. Les autres couches passent par PinGroup::read().
+   *
+   * Les échantillons identiques successifs sont regroupés en séquences
+   * (codage RLE) stockées dans un tampon circulaire alloué à l'avance, en
+   * mémoire ou projeté dans un fichier (setFile()). Lorsque le tampon est
+   * plein, les séquences les plus anciennes sont écrasées.
+   *
+   * Le précalcul est limité à deux registres de niveau, au delà le groupe
+   * est lu par PinGroup::read().
+   *
+   * Les échantillons dont l'échéance a été manquée (préemption...) prennent
+   * la valeur de l'échantillon suivant et sont comptés par overruns().
+   *
+   * Le résultat peut être exporté au format VCD (Value Change Dump) ou au
+   * format de session sigrok (.sr) pour PulseView.
+   */
+  class Capture {
+
+    public:
+      /**
+       * @class Run
+       * @brief Séquence d'échantillons identiques
+       */
+      class Run {
+        public:
+          uint32_t value; ///< Valeur du groupe (bit i pour la broche i)
+          uint32_t count; ///< Nombre d'échantillons
+      };
+
+      /**
+       * @brief Constructeur
+       *
+       * @param group groupe de broches à échantillonner
+       * @param capacity nombre de séquences du tampon
+       */
+      explicit Capture (PinGroup & group, size_t capacity = 1 << 20);
+
+      /**
+       * @brief Destructeur
+       */
+      virtual ~Capture();
+
+      /**
+       * @brief Projette le tampon dans un fichier
+       *
+       * Le fichier est créé ou tronqué à la taille du tampon. Les séquences
+       * y sont écrites en binaire (Run) dans l'ordre du tampon circulaire.
+       * Une exception std::system_error est déclenchée en cas d'erreur.
+       *
+       * @param path chemin du fichier, vide pour un tampon en mémoire
+       */
+      void setFile (const std::string & path);
+
+      /**
+       * @brief Modifie la fréquence d'échantillonnage
+       *
+       * @param hz fréquence en Hz, 1 MHz par défaut
+       */
+      void setRate (double hz);
+
+      /**
+       * @brief Fréquence d'échantillonnage en Hz
+       */
+      double rate() const;
+
+      /**
+       * @brief Effectue une capture
+       *
+       * La fonction retourne après \c samples échantillons ou après un appel
+       * à stop(). Le contenu précédent du tampon est effacé.
+       *
+       * @param samples nombre d'échantillons
+       */
+      void record (uint64_t samples);
+
+      /**
+       * @brief Interrompt la capture en cours
+       *
+       * Peut être appelée par un autre thread ou un gestionnaire de signal.
+       */
+      void stop();
+
+      /**
+       * @brief Nombre d'échantillons de la dernière capture
+       */
+      uint64_t samples() const;
+
+      /**
+       * @brief Nombre d'échantillons dont l'échéance a été manquée
+       */
+      uint64_t overruns() const;
+
+      /**
+       * @brief Indique si des séquences ont été écrasées
+       */
+      bool wrapped() const;
+
+      /**
+       * @brief Indice du premier échantillon encore dans le tampon
+       */
+      uint64_t firstSample() const;
+
+      /**
+       * @brief Nombre de séquences dans le tampon
+       */
+      size_t size() const;
+
+      /**
+       * @brief Séquence du tampon, 0 pour la plus ancienne
+       */
+      const Run & run (size_t i) const;
+
+      /**
+       * @brief Groupe de broches
+       */
+      PinGroup & group() const;
+
+      /**
+       * @brief Export au format VCD
+       *
+       * Une variable par broche, nommée d'après la broche, l'échelle de temps
+       * est la nanoseconde et l'origine le premier échantillon du tampon.
+       */
+      void writeVcd (std::ostream & os) const;
+
+      /**
+       * @brief Export au format de session sigrok (.sr)
+       *
+       * Le fichier est une archive zip (non compressée) contenant les
+       * échantillons décompressés, il peut être ouvert par PulseView ou
+       * sigrok-cli. Une exception std::system_error est déclenchée en cas
+       * d'erreur d'écriture.
+       */
+      void writeSigrok (const std::string & path) const;
+
+    private:
+      // Registre de niveau d'un port et bits des broches du groupe
+      class Bank {
+        public:
+          volatile uint32_t * lev;
+          uint32_t mask;
+          std::vector<std::pair<uint32_t, uint32_t>> bit; // (masque port, masque groupe)
+      };
+
+      PinGroup & _group;
+      Run * _buf;
+      std::vector<Run> _mem;
+      size_t _capacity;
+      size_t _head; // indice de la plus ancienne séquence
+      size_t _size;
+      int _fd;
+      double _period; // en ns
+      uint64_t _samples;
+      uint64_t _overruns;
+      uint64_t _first;
+      std::vector<Bank> _bank;
+      std::atomic<bool> _stop;
+
+      void unmap();
+      void compile();
+      void push (uint32_t value, uint64_t count);
+      std::string name (int i) const;
+      static uint64_t now();
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_CAPTURE_H_ defined */
@@ -9,7 +9,9 @@
 #define _SYSIO_GPIO_CONNECTOR_H_
 
 #include <iostream>
+#include <array>
 #include <sysio/gpiopin.h>
+#include <sysio/gpiostate.h>
 
 namespace Sysio {
 
@@ -243,8 +245,14 @@ namespace Sysio {
        * @param os flux d'affichage
        * @param num numéro de broche dans la numérotation du connecteur. Déclenche
        * une exception std::out_of_range si la broche n'existe pas
+       * @param state état des broches, lu une seule fois pour tout le tableau
        */
-      void printRow (std::ostream & os, int num) const;
+      void printRow (std::ostream & os, int num, const GpioState & state) const;
+
+      /**
+       * @brief Textes des colonnes d'une broche, le dernier est le nom
+       */
+      void cells (Pin * p, const GpioState & state, std::array<std::string, 6> & s) const;
 
     private:
       bool _isopen;
@@ -8,7 +8,9 @@
 #ifndef _SYSIO_GPIO_DEVICE_H_
 #define _SYSIO_GPIO_DEVICE_H_
 
+#include <cstdint>
 #include <sysio/gpio.h>
+#include <sysio/gpiofastpin.h>
 
 #ifndef __DOXYGEN__
 
@@ -28,7 +30,10 @@ namespace Sysio {
       enum {
         hasToggle   = 0x0001,
         hasPullRead = 0x0002,
-        hasAltRead  = 0x0004
+        hasAltRead  = 0x0004,
+        hasPortAccess = 0x0008,
+        hasPullMask = 0x0010,
+        hasSnapshot = 0x0020
       };
       
       Device();
@@ -56,6 +61,23 @@ namespace Sysio {
 
       virtual const std::map<Pin::Mode, std::string> & modes() const = 0;
 
+      // Accès par port (hasPortAccess)
+      virtual unsigned int banks() const;
+      virtual void pinBit (const Pin * pin, unsigned int & bank, unsigned int & bit) const;
+      virtual void writeMask (unsigned int bank, uint32_t setMask, uint32_t clrMask);
+      virtual uint32_t readBank (unsigned int bank) const;
+      virtual void setPullMask (unsigned int bank, uint32_t mask, Pin::Pull p);
+
+      // Lecture groupée des registres (hasSnapshot), renseigne les broches
+      // dont le numéro mcu est déjà présent dans state.pin
+      virtual void snapshot (GpioState & state) const;
+
+      // Accès direct aux registres projetés en mémoire (FastPin)
+      virtual void fastRegisters (const Pin * pin, FastPinRegisters & r) const;
+
+      // Accès par /dev/gpiochipN (AccessLayerCharDev)
+      virtual void charDevLine (const Pin * pin, std::string & chip, unsigned int & offset) const;
+
     protected:
       virtual void setOpen (bool open);
 
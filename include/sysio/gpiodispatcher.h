@@ -0,0 +1,139 @@
+/**
+ * @file
+ * @brief GPIO interrupt dispatcher
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_DISPATCHER_H_
+#define _SYSIO_GPIO_DISPATCHER_H_
+
+#include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sysio/gpiopin.h>
+
+namespace Sysio {
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class InterruptDispatcher
+   * @author epsilonrt
+   * @date 03/14/18
+   * @brief Répartiteur des interruptions des broches
+   *
+   * Toutes les broches dont une routine d'interruption est installée par
+   * Pin::attachInterrupt() sont surveillées par un unique descripteur epoll.
+   * Un nombre fixe de threads temps réel attend les fronts et exécute les
+   * routines correspondantes, ils ne sont réveillés que par un front réel
+   * ou par leur arrêt (eventfd). Une même broche n'est jamais traitée par
+   * deux threads en même temps. Chaque front est compté (Pin::enableCounter()),
+   * placé dans le tampon de la broche (Pin::attachEvents()) ou transmis à sa
+   * routine d'interruption.
+   *
+   * Le répartiteur est unique, il est démarré automatiquement à la première
+   * installation d'une routine d'interruption.
+   */
+  class InterruptDispatcher {
+
+    public:
+      /**
+       * @brief Instance unique du répartiteur
+       */
+      static InterruptDispatcher & instance();
+
+      /**
+       * @brief Modifie le nombre de threads de traitement
+       *
+       * Si le répartiteur est démarré, ses threads sont redémarrés.
+       * @param n nombre de threads, 1 par défaut
+       */
+      void setThreads (int n);
+
+      /**
+       * @brief Nombre de threads de traitement
+       */
+      int threads() const;
+
+      /**
+       * @brief Modifie la priorité temps réel des threads de traitement
+       *
+       * Si le répartiteur est démarré, ses threads sont redémarrés.
+       * @param priority priorité (voir Scheduler::setRtPriority()), 50 par défaut
+       */
+      void setRtPriority (int priority);
+
+      /**
+       * @brief Priorité temps réel des threads de traitement
+       */
+      int rtPriority() const;
+
+      /**
+       * @brief Indique si les threads de traitement sont démarrés
+       */
+      bool isRunning() const;
+
+      /**
+       * @brief Arrête les threads de traitement
+       *
+       * Les broches restent enregistrées, les threads sont redémarrés à la
+       * prochaine installation d'une routine d'interruption.
+       */
+      void stop();
+
+      /**
+       * @brief Destructeur
+       */
+      virtual ~InterruptDispatcher();
+
+    protected:
+      friend class Pin;
+
+      void add (Pin * pin);
+      void remove (Pin * pin);
+
+    private:
+      // Descripteur surveillé, il peut être partagé par plusieurs broches
+      // dans le cas d'une requête /dev/gpiochipN commune (PinGroup)
+      class Source {
+        public:
+          bool charDev;
+          bool busy;
+          std::thread::id owner;
+          std::vector<Pin *> pin;
+      };
+
+      int _epfd;
+      int _stopfd;
+      int _threads;
+      int _priority;
+      std::vector<std::thread> _thread;
+      std::map<int, Source> _source;
+      mutable std::mutex _mutex;
+      std::condition_variable _idle;
+
+      InterruptDispatcher();
+      InterruptDispatcher (const InterruptDispatcher &) = delete;
+      InterruptDispatcher & operator= (const InterruptDispatcher &) = delete;
+
+      void start();
+      void restart();
+      void loop();
+      void process (int fd, const Source & src);
+      bool attached (int fd, const Pin * pin) const;
+      static void notify (Pin * pin, Pin::Edge edge, uint64_t timestamp_ns);
+      static int pinFd (const Pin * pin);
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_DISPATCHER_H_ defined */
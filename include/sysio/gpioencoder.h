@@ -0,0 +1,164 @@
+/**
+ * @file
+ * @brief GPIO quadrature encoder decoder
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_ENCODER_H_
+#define _SYSIO_GPIO_ENCODER_H_
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <sysio/gpiopin.h>
+
+namespace Sysio {
+
+  class EdgeHistory;
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class QuadratureEncoder
+   * @author epsilonrt
+   * @date 03/26/18
+   * @brief Décodeur de codeur incrémental en quadrature
+   *
+   * Les deux voies A et B sont enregistrées auprès du répartiteur
+   * d'interruptions (InterruptDispatcher) sur les deux fronts. Chaque front
+   * est décodé par le répartiteur lui-même, sans routine utilisateur. La
+   * position compte tous les fronts des deux voies (résolution x4), elle
+   * croît lorsque A est en avance sur B.
+   *
+   * Avec la couche AccessLayerCharDev, les deux voies d'un même contrôleur
+   * sont regroupées dans une seule requête (comme PinGroup) : le noyau met
+   * leurs fronts dans une même file, dans l'ordre chronologique, et un seul
+   * thread du répartiteur les décode d'après leur type (rising/falling). Un
+   * front qui ne change pas l'état mémorisé (front de même sens que le
+   * précédent sur la même voie) signifie qu'un front a été perdu, il est
+   * compté comme transition illégale.
+   *
+   * Sinon (sysfs, voies sur deux contrôleurs), les fronts des deux voies
+   * arrivent sur deux descripteurs et peuvent être traités dans le désordre
+   * par deux threads : chaque front déclenche la lecture des niveaux des
+   * deux voies au même instant (un seul readBank() lorsque les deux broches
+   * sont sur le même port accessible par AccessLayerIoMap), sous un verrou
+   * propre au décodeur. Un front déjà pris en compte par une lecture
+   * précédente ne compte pas, un changement simultané des deux voies est
+   * compté comme transition illégale et l'état est resynchronisé. Ce
+   * décodage n'est exact que si au plus un front survient entre deux
+   * lectures.
+   *
+   * La position, le nombre de transitions illégales et la vitesse sont lus
+   * sans verrou depuis n'importe quel thread.
+   *
+   * @code
+   * QuadratureEncoder enc (gpio.pin (0), gpio.pin (2));
+   * for (;;) {
+   *   std::cout << enc.position() << " " << enc.velocity() << std::endl;
+   *   Clock::delay (100);
+   * }
+   * @endcode
+   */
+  class QuadratureEncoder {
+
+    public:
+      /**
+       * @brief Constructeur
+       *
+       * Les broches, qui doivent être ouvertes et sans routine
+       * d'interruption, sont passées en entrée et enregistrées auprès du
+       * répartiteur. Avec AccessLayerCharDev, les lignes des deux broches
+       * d'un même contrôleur sont regroupées dans une seule requête. L'état
+       * initial est lu sur les broches, la position est nulle.
+       *
+       * @param a voie A
+       * @param b voie B
+       */
+      QuadratureEncoder (Pin & a, Pin & b);
+
+      /**
+       * @brief Destructeur
+       *
+       * Les broches sont retirées du répartiteur (Pin::detachInterrupt()).
+       */
+      virtual ~QuadratureEncoder();
+
+      QuadratureEncoder (const QuadratureEncoder &) = delete;
+      QuadratureEncoder & operator= (const QuadratureEncoder &) = delete;
+
+      /**
+       * @brief Position en nombre de fronts
+       */
+      int64_t position() const;
+
+      /**
+       * @brief Modification de la position
+       *
+       * L'historique utilisé par velocity() n'est pas modifié.
+       */
+      void setPosition (int64_t position = 0);
+
+      /**
+       * @brief Nombre de transitions illégales (fronts perdus)
+       */
+      uint64_t illegalTransitions() const;
+
+      /**
+       * @brief Vitesse en fronts par seconde
+       *
+       * Variation moyenne de la position entre le premier et le dernier front
+       * de la fenêtre (voir Pin::frequency()).
+       *
+       * @param window_ms durée de la fenêtre se terminant à l'instant de
+       * l'appel en millisecondes
+       * @return vitesse signée, 0 si moins de deux fronts ont été reçus dans
+       * la fenêtre
+       */
+      double velocity (unsigned long window_ms = 100) const;
+
+      /**
+       * @brief Inverse le sens de comptage
+       */
+      void setReversed (bool reversed);
+
+      /**
+       * @brief Indique si le sens de comptage est inversé
+       */
+      bool reversed() const;
+
+    protected:
+      friend class InterruptDispatcher;
+
+      // Appelée par le répartiteur pour chaque front de la voie channel
+      void decode (int channel, Pin::Edge edge, uint64_t timestamp_ns);
+
+    private:
+      Pin & _a;
+      Pin & _b;
+      bool _ordered; // fronts des deux voies dans une même file du noyau
+      bool _sameBank; // niveaux des deux voies lus par un seul readBank()
+      unsigned int _bank, _bitA, _bitB;
+      std::mutex _mutex; // lecture des niveaux et mise à jour de _state
+      std::atomic<unsigned> _state; // bit 0 : A, bit 1 : B
+      std::atomic<int64_t> _raw; // position décodée
+      std::atomic<int64_t> _base; // valeur de _raw à la position 0
+      std::atomic<uint64_t> _illegal;
+      std::atomic<int> _dir;
+      std::unique_ptr<EdgeHistory> _history;
+
+      // Niveaux des deux voies (bit 0 : A, bit 1 : B) lus au même instant
+      unsigned levels() const;
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_ENCODER_H_ defined */
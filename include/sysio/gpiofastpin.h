@@ -0,0 +1,236 @@
+/**
+ * @file
+ * @brief GPIO Fast Pin
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_FASTPIN_H_
+#define _SYSIO_GPIO_FASTPIN_H_
+
+#include <cstdint>
+#include <stdexcept>
+#include <sysio/gpiopin.h>
+
+namespace Sysio {
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class FastPinRegisters
+   * @author epsilonrt
+   * @date 03/16/18
+   * @brief Registres d'accès direct à une broche
+   *
+   * Adresses des registres du GPIO projetés en mémoire (AccessLayerIoMap)
+   * et masques de la broche, fournis par la couche matérielle.
+   */
+  class FastPinRegisters {
+    public:
+      volatile uint32_t * set; ///< Registre de mise à 1 (ou registre de données)
+      volatile uint32_t * clr; ///< Registre de mise à 0 (ou registre de données)
+      volatile uint32_t * lev; ///< Registre de lecture de l'état
+      volatile uint32_t * cfg; ///< Registre de configuration de la fonction
+      uint32_t mask; ///< Masque de la broche dans set, clr et lev
+      uint32_t cfgMask; ///< Masque du champ de fonction dans cfg
+      uint32_t cfgOutput; ///< Valeur du champ de fonction pour une sortie (0 pour une entrée)
+      bool setClear; ///< true si set et clr sont des registres distincts en écriture seule
+      bool inputLevel; ///< true si lev donne le niveau d'une broche passée en entrée par cfg (false pour le GPIO simulé)
+
+      /**
+       * @brief Lecture des registres d'une broche
+       *
+       * Déclenche une exception std::invalid_argument si la broche n'est pas
+       * ouverte, n'est pas de type \c TypeGpio ou n'utilise pas la couche
+       * AccessLayerIoMap et une exception std::system_error avec le code
+       * ENOTSUP si la plateforme ne fournit pas l'accès direct à ses registres.
+       */
+      static FastPinRegisters get (Pin & pin);
+  };
+
+  /**
+   * @class SetClearRegisters
+   * @brief Modèle de GPIO à registres de mise à 1 et à 0 séparés (BCM2835)
+   */
+  class SetClearRegisters {};
+
+  /**
+   * @class DataRegister
+   * @brief Modèle de GPIO à registre de données unique (Allwinner H3, GPIO simulé)
+   */
+  class DataRegister {};
+
+  /**
+   * @class FastPin
+   * @author epsilonrt
+   * @date 03/16/18
+   * @brief Accès rapide à une broche
+   *
+   * Un FastPin est obtenu une fois à partir d'une broche ouverte utilisant la
+   * couche AccessLayerIoMap. Il mémorise les adresses des registres et le
+   * masque de la broche, ses fonctions sont inline et sans appel virtuel :
+   * set() et clear() se résument à une écriture (un accès lecture-modification-
+   * écriture avec DataRegister), read() à une lecture. Aucune vérification
+   * n'est effectuée, il est destiné aux protocoles logiciels (bit-banging).
+   *
+   * Le modèle doit correspondre à la plateforme, FastPinBcm2835, FastPinH3 et
+   * FastPinSim sont prévus à cet effet, sinon le constructeur déclenche une
+   * exception std::invalid_argument.
+   *
+   * Le FastPin ne doit plus être utilisé après la fermeture du GPIO.
+   *
+   * @tparam Model SetClearRegisters ou DataRegister
+   */
+  template <class Model>
+  class FastPin {
+    public:
+      /**
+       * @brief Constructeur
+       *
+       * @param pin broche ouverte de type \c TypeGpio utilisant la couche
+       * AccessLayerIoMap
+       */
+      explicit FastPin (Pin & pin) : _pin (pin), _r (FastPinRegisters::get (pin)) {
+
+        if (_r.setClear != isSetClear()) {
+
+          throw std::invalid_argument ("FastPin model does not match the GPIO device");
+        }
+      }
+
+      /**
+       * @brief Met la sortie à l'état haut
+       */
+      inline void set();
+
+      /**
+       * @brief Met la sortie à l'état bas
+       */
+      inline void clear();
+
+      /**
+       * @brief Modification de l'état binaire de la sortie
+       */
+      inline void write (bool value) {
+        if (value) {
+          set();
+        }
+        else {
+          clear();
+        }
+      }
+
+      /**
+       * @brief Bascule l'état de la sortie
+       */
+      inline void toggle();
+
+      /**
+       * @brief Lecture de l'état binaire de la broche
+       */
+      inline bool read() const {
+        return (*_r.lev & _r.mask) != 0;
+      }
+
+      /**
+       * @brief Passe la broche en entrée
+       *
+       * Contrairement à Pin::setMode(), le mode initial n'est pas mémorisé.
+       */
+      inline void setInput() {
+        *_r.cfg &= ~_r.cfgMask;
+      }
+
+      /**
+       * @brief Passe la broche en sortie
+       *
+       * Contrairement à Pin::setMode(), le mode initial n'est pas mémorisé.
+       */
+      inline void setOutput() {
+        *_r.cfg = (*_r.cfg & ~_r.cfgMask) | _r.cfgOutput;
+      }
+
+      /**
+       * @brief Broche d'origine
+       */
+      inline Pin & pin() const {
+        return _pin;
+      }
+
+      /**
+       * @brief Registres utilisés
+       */
+      inline const FastPinRegisters & registers() const {
+        return _r;
+      }
+
+    private:
+      Pin & _pin;
+      FastPinRegisters _r;
+
+      static bool isSetClear();
+  };
+
+  // Modèle SetClearRegisters ---------------------------------------------------
+  template<> inline bool FastPin<SetClearRegisters>::isSetClear() {
+    return true;
+  }
+
+  template<> inline void FastPin<SetClearRegisters>::set() {
+    *_r.set = _r.mask;
+  }
+
+  template<> inline void FastPin<SetClearRegisters>::clear() {
+    *_r.clr = _r.mask;
+  }
+
+  template<> inline void FastPin<SetClearRegisters>::toggle() {
+    if (read()) {
+      clear();
+    }
+    else {
+      set();
+    }
+  }
+
+  // Modèle DataRegister --------------------------------------------------------
+  template<> inline bool FastPin<DataRegister>::isSetClear() {
+    return false;
+  }
+
+  template<> inline void FastPin<DataRegister>::set() {
+    *_r.set |= _r.mask;
+  }
+
+  template<> inline void FastPin<DataRegister>::clear() {
+    *_r.clr &= ~_r.mask;
+  }
+
+  template<> inline void FastPin<DataRegister>::toggle() {
+    *_r.set ^= _r.mask;
+  }
+
+  /**
+   * @brief Accès rapide à une broche d'un Raspberry Pi (BCM2835 à BCM2837)
+   */
+  typedef FastPin<SetClearRegisters> FastPinBcm2835;
+
+  /**
+   * @brief Accès rapide à une broche d'une carte NanoPi (Allwinner H3/H5)
+   */
+  typedef FastPin<DataRegister> FastPinH3;
+
+  /**
+   * @brief Accès rapide à une broche du GPIO simulé
+   */
+  typedef FastPin<DataRegister> FastPinSim;
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_FASTPIN_H_ defined */
@@ -0,0 +1,227 @@
+/**
+ * @file
+ * @brief GPIO 1-Wire bus master
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_ONEWIRE_H_
+#define _SYSIO_GPIO_ONEWIRE_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <sysio/gpiopin.h>
+
+namespace Sysio {
+
+  class SoftLine;
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class OneWire
+   * @author epsilonrt
+   * @date 03/23/18
+   * @brief Maître 1-Wire
+   *
+   * Bus 1-Wire sur une broche GPIO quelconque, pilotée en drain ouvert (une
+   * résistance de tirage externe de 4,7 kΩ est nécessaire). Avec la couche
+   * AccessLayerIoMap, les créneaux sont générés par accès directs aux
+   * registres du GPIO et attente active, sans passer par le pilote w1-gpio
+   * du noyau ni par sysfs. Les créneaux durent de quelques µs à 480 µs, une
+   * préemption pendant un créneau le rend invalide : un thread temps réel
+   * est conseillé (voir Scheduler), les erreurs sont de toute façon
+   * détectées par le CRC.
+   *
+   * La lecture par lot des thermomètres (DS18B20, DS18S20, DS1822) lance la
+   * conversion de tous les capteurs par une seule commande, puis lit chacun
+   * d'eux : un cycle dure une seule conversion (750 ms à 12 bits) quel que
+   * soit le nombre de capteurs.
+   *
+   * @code
+   * OneWire ow (gpio.pin (7));
+   * std::vector<uint64_t> probes = ow.search();
+   * std::vector<double> t = ow.readTemperatures (probes);
+   * @endcode
+   *
+   * Les identifiants (ROM) sont des entiers de 64 bits dont l'octet de poids
+   * faible est le code de famille et l'octet de poids fort le CRC.
+   */
+  class OneWire {
+
+    public:
+      /**
+       * @brief Codes de famille usuels
+       */
+      enum Family {
+        FamilyDS18S20 = 0x10, ///< DS18S20, DS1820
+        FamilyDS1822 = 0x22, ///< DS1822
+        FamilyDS18B20 = 0x28 ///< DS18B20
+      };
+
+      /**
+       * @brief Constructeur
+       *
+       * La broche, qui doit être ouverte, est libérée (entrée).
+       * Déclenche une exception std::invalid_argument si la broche n'utilise
+       * pas la couche AccessLayerIoMap et une exception std::system_error
+       * (ENOTSUP) si la plateforme ne fournit pas l'accès direct à ses
+       * registres ou ne permet pas d'y lire une entrée (GPIO simulé) : les
+       * créneaux ne peuvent pas être tenus autrement.
+       */
+      explicit OneWire (Pin & pin);
+
+      /**
+       * @brief Destructeur
+       */
+      virtual ~OneWire();
+
+      OneWire (const OneWire &) = delete;
+      OneWire & operator= (const OneWire &) = delete;
+
+      /**
+       * @brief Impulsion de réinitialisation
+       *
+       * @return true si au moins un esclave a signalé sa présence
+       */
+      virtual bool reset();
+
+      /**
+       * @brief Écriture d'un bit
+       */
+      virtual void writeBit (bool bit);
+
+      /**
+       * @brief Lecture d'un bit
+       */
+      virtual bool readBit();
+
+      /**
+       * @brief Écriture d'un octet, bit de poids faible en premier
+       */
+      void write (uint8_t byte);
+
+      /**
+       * @brief Écriture d'un bloc d'octets
+       */
+      void write (const uint8_t * buf, size_t len);
+
+      /**
+       * @brief Lecture d'un octet
+       */
+      uint8_t read();
+
+      /**
+       * @brief Lecture d'un bloc d'octets
+       */
+      void read (uint8_t * buf, size_t len);
+
+      /**
+       * @brief Sélection d'un esclave (Match ROM)
+       *
+       * Doit suivre reset().
+       */
+      void select (uint64_t rom);
+
+      /**
+       * @brief Sélection de tous les esclaves (Skip ROM)
+       *
+       * Doit suivre reset().
+       */
+      void skip();
+
+      /**
+       * @brief Recherche des esclaves présents sur le bus (Search ROM)
+       *
+       * Algorithme de recherche binaire de Maxim (note d'application 187),
+       * chaque identifiant trouvé est vérifié par son CRC. Déclenche une
+       * exception std::system_error avec le code EIO si la recherche est
+       * incohérente (bus perturbé).
+       *
+       * @param alarm true pour ne rechercher que les esclaves en alarme
+       * (Alarm Search)
+       * @return identifiants trouvés, vide si aucun esclave n'est présent
+       */
+      std::vector<uint64_t> search (bool alarm = false);
+
+      /**
+       * @brief Indique si un esclave est alimenté par le bus (parasite)
+       */
+      bool parasitePowered();
+
+      /**
+       * @brief Lance la conversion de température de tous les capteurs
+       *
+       * Commande Convert T adressée à tous les esclaves (Skip ROM). Si un
+       * capteur est alimenté par le bus, la ligne est maintenue à l'état haut
+       * pendant \c timeout_ms, sinon la fin de conversion est détectée par
+       * lecture du bus (sans attente active).
+       *
+       * @param timeout_ms durée maximale de conversion, 750 ms à 12 bits
+       * @return false si la conversion n'est pas terminée dans le délai ou
+       * si aucun esclave n'est présent
+       */
+      bool convertAll (unsigned long timeout_ms = 750);
+
+      /**
+       * @brief Lecture de la température d'un capteur
+       *
+       * La conversion doit avoir été effectuée (convertAll()).
+       *
+       * @return température en °C, NAN si le capteur ne répond pas ou si le
+       * CRC est incorrect
+       */
+      double readTemperature (uint64_t rom);
+
+      /**
+       * @brief Conversion et lecture d'un lot de capteurs
+       *
+       * convertAll(), puis lecture de chaque capteur.
+       *
+       * @return températures en °C dans l'ordre de \c roms, NAN pour un
+       * capteur en erreur
+       */
+      std::vector<double> readTemperatures (const std::vector<uint64_t> & roms,
+                                            unsigned long timeout_ms = 750);
+
+      /**
+       * @brief Calcul du CRC 8 bits Dallas/Maxim (x^8 + x^5 + x^4 + 1)
+       *
+       * Le CRC d'un bloc suivi de son CRC est nul.
+       */
+      static uint8_t crc8 (const uint8_t * buf, size_t len);
+
+      /**
+       * @brief Code de famille d'un identifiant
+       */
+      static inline int family (uint64_t rom) {
+        return rom & 0xFF;
+      }
+
+    protected:
+      /**
+       * @brief Constructeur d'un bus sans broche
+       *
+       * Les créneaux sont générés par une classe dérivée qui redéfinit
+       * reset(), writeBit() et readBit() (pont DS2482 par exemple).
+       */
+      OneWire();
+
+    private:
+      std::unique_ptr<SoftLine> _line;
+      std::recursive_mutex _mutex;
+
+      bool readScratchpad (uint64_t rom, uint8_t * sp);
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_ONEWIRE_H_ defined */
@@ -15,12 +15,18 @@
 #include <atomic>
 #include <thread>
 #include <mutex>
+#include <functional>
+#include <cstdint>
 
 namespace Sysio {
 
   class Gpio;
   class Device;
   class Connector;
+  class LineRequest;
+  class EventRing;
+  class EdgeCounter;
+  class QuadratureEncoder;
 
   /**
    *  @addtogroup sysio_gpio
@@ -39,7 +45,8 @@ namespace Sysio {
     AccessLayerAuto  = 0, //< Choix automatique (à utiliser la plupart du temps), c'est la plateforme qui choisit par le GpioDevice
     AccessLayerIoMap = 0x0001, ///< Accès par les registres du SOC, la plus performante mais il faut être sûr que cela est disponible sur la plateforme
     AccessLayerSysFs = 0x0002, ///< Accès par l'interface "utilisateur" dans /sys/class/gpio, la plus générique
-    AccessLayerAll = AccessLayerIoMap + AccessLayerSysFs ///< Le mieux, toutes les fonctions sont disponibles
+    AccessLayerAll = AccessLayerIoMap + AccessLayerSysFs, ///< Le mieux, toutes les fonctions sont disponibles
+    AccessLayerCharDev = 0x0004 ///< Accès par l'interface caractère du noyau /dev/gpiochipN, remplace SysFs si elle est autorisée (lecture/écriture de plusieurs lignes par un seul appel système, fronts horodatés par le noyau)
   };
   /**
    * @}
@@ -59,7 +66,12 @@ namespace Sysio {
   class Pin {
 
     public:
+      friend class Gpio;
       friend class Connector;
+      friend class PinGroup;
+      friend class InterruptDispatcher;
+      friend class FastPinRegisters;
+      friend class QuadratureEncoder;
 
       /**
        * @enum Mode
@@ -159,6 +171,18 @@ namespace Sysio {
           std::map<Mode, std::string> name; ///< Noms
       };
 
+      /**
+       * @class Event
+       * @author epsilonrt
+       * @date 03/15/18
+       * @brief Front horodaté
+       */
+      class Event {
+        public:
+          uint64_t timestamp_ns; ///< Instant du front en nanosecondes (CLOCK_MONOTONIC)
+          Edge edge; ///< Front détecté, EdgeRising ou EdgeFalling
+      };
+
 
       //------------------------------------------------------------------------
       //                          Opérations
@@ -278,7 +302,8 @@ namespace Sysio {
        * L'accès par SysFs doit donc être autorisée dans le Gpio parent
        * (AccessLayerSysFs ou AccessLayerAll) ou par l'appel à forceUseSysFs(true). \n
        * Si la broche n'est pas en mode SysFs et que cet accès est autorisé, la
-       * broche est passée automatiquement en mode SysFs.
+       * broche est passée automatiquement en mode SysFs. Si la couche
+       * AccessLayerCharDev est autorisée, elle est utilisée à la place de SysFs.
        *
        * @param edge front de déclenchement
        * @param timeout temps maximal d'attente en millisecondes. -1 pour l'infini.
@@ -295,24 +320,137 @@ namespace Sysio {
        */
       typedef void (* Isr) (void);
 
+      /**
+       * @brief Routine d'interruption avec paramètres
+       *
+       * Une telle routine reçoit la broche concernée, le front détecté et
+       * l'instant de détection en nanosecondes (CLOCK_MONOTONIC, horodaté par
+       * le noyau avec la couche AccessLayerCharDev).
+       */
+      typedef std::function<void (Pin & pin, Edge edge, uint64_t timestamp_ns)> Callback;
+
       /**
        * @brief Installe une routine d'interruption (Isr)
        * 
-       * Cette fonction créée un thread qui attend l'arrivée d'une interruption
-       * déclenchée par chaque front edge et exécute la fonction isr.
+       * La broche est enregistrée auprès du répartiteur d'interruptions
+       * (InterruptDispatcher) qui exécute la fonction isr à chaque front edge.
        * 
        * @param isr fonction exécuté à chaque interruption
        * @param edge front déclenchant l'interruption
        */
       void attachInterrupt (Isr isr, Edge edge);
 
+      /**
+       * @overload
+       */
+      void attachInterrupt (Callback callback, Edge edge);
+
       /**
        * @brief Désinstalle la routine d'interruption
        * 
-       * Le thread est détruit.
+       * Au retour, la routine n'est plus en cours d'exécution, sauf si cette
+       * fonction est appelée par la routine elle-même.
        */
       void detachInterrupt();
 
+      /**
+       * @brief Mémorise les fronts dans un tampon circulaire
+       *
+       * La broche est enregistrée auprès du répartiteur d'interruptions
+       * (InterruptDispatcher) qui place chaque front edge, avec son instant,
+       * dans un tampon propre à la broche. Les fronts sont horodatés par le
+       * noyau avec la couche AccessLayerCharDev, lors de leur réception avec
+       * SysFs. Cela permet de mesurer des durées d'impulsion ou des fréquences
+       * sans exécuter une routine à chaque front. \n
+       * Les fronts sont récupérés par drainEvents(), le tampon est vidé. Si une
+       * routine d'interruption est installée, cette fonction ne fait rien.
+       * detachInterrupt() arrête l'enregistrement, les fronts restant dans le
+       * tampon peuvent encore être lus.
+       *
+       * @param edge front à mémoriser
+       * @param capacity nombre de fronts que peut contenir le tampon, arrondi
+       * à la puissance de 2 supérieure
+       */
+      void attachEvents (Edge edge, size_t capacity = 1024);
+
+      /**
+       * @brief Lecture des fronts mémorisés
+       *
+       * Les fronts sont retirés du tampon, du plus ancien au plus récent. Un
+       * seul thread doit lire les fronts d'une broche.
+       *
+       * @param events tableau où seront copiés les fronts
+       * @param max nombre maximal de fronts à lire
+       * @return le nombre de fronts copiés dans events
+       */
+      size_t drainEvents (Event * events, size_t max);
+
+      /**
+       * @overload
+       *
+       * Les fronts sont ajoutés à la fin de events.
+       */
+      size_t drainEvents (std::vector<Event> & events, size_t max = SIZE_MAX);
+
+      /**
+       * @brief Nombre de fronts en attente de lecture
+       */
+      size_t pendingEvents() const;
+
+      /**
+       * @brief Nombre de fronts perdus car le tampon était plein
+       *
+       * Le compteur est remis à zéro par attachEvents().
+       */
+      uint64_t eventOverflows() const;
+
+      /**
+       * @brief Compte les fronts sans exécuter de routine
+       *
+       * La broche est enregistrée auprès du répartiteur d'interruptions
+       * (InterruptDispatcher) qui se contente d'incrémenter un compteur à
+       * chaque front edge et de mémoriser au plus un instant par
+       * milliseconde : aucun code utilisateur n'est exécuté, ce qui permet de
+       * compter des signaux de plusieurs dizaines de kHz. Le compteur est
+       * remis à zéro. Si une routine d'interruption est installée, si les
+       * fronts sont mémorisés (attachEvents()) ou déjà comptés, une exception
+       * std::logic_error est déclenchée. detachInterrupt() arrête le
+       * comptage, le compteur peut encore être lu.
+       *
+       * @param edge front à compter, EdgeBoth compte les deux fronts
+       */
+      void enableCounter (Edge edge);
+
+      /**
+       * @brief Nombre de fronts comptés depuis enableCounter() ou resetCounter()
+       */
+      uint64_t counter() const;
+
+      /**
+       * @brief Remise à zéro du compteur de fronts
+       *
+       * L'historique utilisé par frequency() n'est pas modifié.
+       */
+      void resetCounter();
+
+      /**
+       * @brief Fréquence des fronts comptés
+       *
+       * La fréquence est la moyenne des périodes entre le premier et le
+       * dernier front de la fenêtre, ces fronts étant horodatés par le
+       * répartiteur (par le noyau avec la couche AccessLayerCharDev). Le
+       * dernier front pris en compte peut précéder le plus récent d'au plus
+       * 1 ms. L'historique couvre au moins 4 s, une fenêtre plus longue est
+       * limitée à l'historique disponible. Avec EdgeBoth, deux fronts sont
+       * comptés par période du signal.
+       *
+       * @param window_ms durée de la fenêtre se terminant à l'instant de
+       * l'appel en millisecondes
+       * @return la fréquence des fronts en Hz, 0 si moins de deux fronts ont
+       * été comptés dans la fenêtre
+       */
+      double frequency (unsigned long window_ms = 1000) const;
+
       //------------------------------------------------------------------------
       //                          Propriétés
       //------------------------------------------------------------------------
@@ -405,6 +543,19 @@ namespace Sysio {
        */
       bool forceUseSysFs (bool enable);
 
+      /**
+       * @brief Indique si la broche utilise l'interface caractère /dev/gpiochipN
+       */
+      bool useCharDev() const;
+
+      /**
+       * @brief Force ou non l'utilisation de l'interface caractère /dev/gpiochipN
+       *
+       * La ligne correspondant à la broche est alors réservée auprès du noyau,
+       * ce qui ne nécessite pas de droits root.
+       */
+      bool forceUseCharDev (bool enable);
+
       /**
       * @brief Accès au connecteur parent
       */
@@ -563,14 +714,21 @@ namespace Sysio {
       bool _holdState;
       bool _useSysFs;
       int _valueFd;
+      bool _useCharDev;
+      std::shared_ptr<LineRequest> _line;
+      unsigned int _lineIndex;
       bool _firstPolling;
 
       Edge _edge;
       Mode _mode;
       Pull _pull;
 
-      std::atomic<int> _run;  // indique au thread de continuer
-      std::thread _thread;
+      bool _attached;
+      Callback _callback;
+      std::unique_ptr<EventRing> _events;
+      std::unique_ptr<EdgeCounter> _counter;
+      QuadratureEncoder * _encoder;
+      int _channel; // voie du codeur
 
       static const std::map<Pull, std::string> _pulls;
       static const std::map<Type, std::string> _types;
@@ -582,7 +740,8 @@ namespace Sysio {
       static std::string _syspath;
 
       static bool directoryExist (const std::string & dname);
-      static void * irqThread (std::atomic<int> & run, int fd, Isr isr);
+      int pollInterrupt (int timeout_ms);
+      void attach (Edge edge);
 
       void holdMode();
       void holdPull();
@@ -611,6 +770,16 @@ namespace Sysio {
       void sysFsWriteFile (const char * n, const std::string & v);
       std::string sysFsReadFile (const char * n) const;
       bool sysFsFileExist (const char * n) const;
+
+      bool charDevEnable (bool enable);
+      void charDevOpen();
+      void charDevClose();
+      uint64_t charDevFlags() const;
+      void charDevGetMode();
+      void charDevGetPull();
+      void charDevGetEdge();
+      void charDevUpdate();
+      int charDevPoll (int timeout_ms);
   };
 }
 /**
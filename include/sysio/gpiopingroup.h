@@ -0,0 +1,159 @@
+/**
+ * @file
+ * @brief GPIO Pin group
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_PINGROUP_H_
+#define _SYSIO_GPIO_PINGROUP_H_
+
+#include <vector>
+#include <memory>
+#include <initializer_list>
+#include <cstdint>
+#include <sysio/gpiopin.h>
+
+namespace Sysio {
+
+  class Gpio;
+  class LineRequest;
+
+  /**
+   *  @addtogroup sysio_gpio_pingroup
+   *  @{
+   */
+
+  /**
+   * @class PinGroup
+   * @author epsilonrt
+   * @date 03/12/18
+   * @brief Groupe de broches manipulées simultanément
+   *
+   * Un groupe permet de lire ou de modifier plusieurs broches (un bus parallèle
+   * par exemple) par un seul accès aux registres par port, ce qui supprime le
+   * décalage entre les broches. Le bit i des valeurs lues ou écrites
+   * correspond à la broche d'indice i dans la liste fournie au constructeur.
+   *
+   * Si la couche d'accès AccessLayerIoMap n'est pas disponible et que les
+   * broches utilisent l'interface caractère /dev/gpiochipN (AccessLayerCharDev),
+   * les lignes d'un même contrôleur sont regroupées dans une seule requête
+   * et sont accédées par un seul appel système. Une broche ne peut alors
+   * appartenir qu'à un seul groupe. Sinon, les broches sont accédées une à une.
+   *
+   * @code
+   *    Sysio::Gpio * g = new Sysio::Gpio;
+   *    g->open();
+   *    Sysio::PinGroup bus ({&g->pin (0), &g->pin (1), &g->pin (2), &g->pin (3)});
+   *    bus.setMode (Sysio::Pin::ModeOutput);
+   *    bus.write (0x0A);
+   * @endcode
+   */
+  class PinGroup {
+
+    public:
+      /**
+       * @brief Constructeur
+       *
+       * @param pins liste des broches, toutes de type TypeGpio et appartenant
+       * au même Gpio, 32 broches au maximum. Une exception std::invalid_argument
+       * est déclenchée si ce n'est pas le cas.
+       */
+      explicit PinGroup (const std::vector<Pin *> & pins);
+
+      /**
+       * @overload
+       */
+      PinGroup (std::initializer_list<Pin *> pins);
+
+      /**
+       * @brief Destructeur
+       */
+      virtual ~PinGroup();
+
+      /**
+       * @brief Modification de l'état des broches
+       *
+       * @param value le bit i correspond à la broche d'indice i
+       */
+      void write (uint32_t value);
+
+      /**
+       * @brief Modification de l'état des broches sélectionnées
+       *
+       * Seules les broches dont le bit est à 1 dans \c mask sont modifiées.
+       *
+       * @param value le bit i correspond à la broche d'indice i
+       * @param mask masque de sélection des broches
+       */
+      void write (uint32_t value, uint32_t mask);
+
+      /**
+       * @brief Lecture de l'état des broches
+       *
+       * @return le bit i correspond à la broche d'indice i
+       */
+      uint32_t read() const;
+
+      /**
+       * @brief Modification du mode de toutes les broches du groupe
+       */
+      void setMode (Pin::Mode mode);
+
+      /**
+       * @brief Modification de la résistance de tirage de toutes les broches
+       *
+       * Voir Gpio::setPull(), les broches d'un même port sont modifiées en
+       * une fois.
+       */
+      void setPull (Pin::Pull pull);
+
+      /**
+       * @brief Nombre de broches du groupe
+       */
+      int size() const;
+
+      /**
+       * @brief Broche d'indice i
+       *
+       * Déclenche une exception std::out_of_range si i n'est pas valide.
+       */
+      Pin & pin (int i) const;
+
+      /**
+       * @brief Accès au GPIO parent
+       */
+      Gpio * gpio() const;
+
+    private:
+      friend class QuadratureEncoder;
+
+      // Broches d'un même port
+      class Port {
+        public:
+          unsigned int index;
+          std::vector<std::pair<unsigned int, unsigned int>> bit; // (indice groupe, bit port)
+      };
+
+      // Lignes d'une même requête /dev/gpiochipN
+      class Lines {
+        public:
+          std::shared_ptr<LineRequest> request;
+          std::vector<std::pair<unsigned int, unsigned int>> bit; // (indice groupe, indice ligne)
+      };
+
+      std::vector<Pin *> _pin;
+      std::vector<Port> _port;
+      std::vector<Lines> _lines;
+
+      bool usePort() const;
+      void init();
+      void initLines();
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_PINGROUP_H_ defined */
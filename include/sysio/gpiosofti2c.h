@@ -0,0 +1,218 @@
+/**
+ * @file
+ * @brief GPIO software I2C master
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_SOFTI2C_H_
+#define _SYSIO_GPIO_SOFTI2C_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <sysio/gpiopin.h>
+
+namespace Sysio {
+
+  class SoftLine;
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class SoftI2c
+   * @author epsilonrt
+   * @date 03/22/18
+   * @brief Maître I2C logiciel
+   *
+   * Bus I2C sur deux broches GPIO quelconques (bit-banging). Les lignes sont
+   * pilotées en drain ouvert : l'état bas est forcé en sortie, l'état haut
+   * est obtenu en passant la broche en entrée, des résistances de tirage
+   * sont donc nécessaires (les résistances internes sont activées par le
+   * constructeur, elles ne suffisent qu'à faible vitesse). Avec la couche
+   * AccessLayerIoMap, chaque front est une écriture directe dans les
+   * registres du GPIO.
+   *
+   * L'allongement de l'horloge par l'esclave (clock stretching) est pris en
+   * charge : après chaque libération de SCL, le maître attend que la ligne
+   * soit effectivement à l'état haut. Les messages d'une même transaction
+   * sont séparés par une condition de démarrage répétée (repeated start).
+   *
+   * Les fonctions déclenchent une exception std::system_error en cas
+   * d'erreur : ENXIO si l'esclave n'acquitte pas son adresse, EIO s'il
+   * n'acquitte pas un octet, ETIMEDOUT si SCL reste à l'état bas.
+   *
+   * Une fois enregistré par registerDevice(), le bus est utilisable par les
+   * fonctions du module I2C (iI2cOpen(), iI2cReadRegBlock()...) et donc par
+   * les pilotes qui les utilisent (xHih6130...) sans modification :
+   * @code
+   * SoftI2c i2c (gpio.pin (5), gpio.pin (6));
+   * i2c.registerDevice ("/dev/i2c-soft");
+   * xHih6130 * hih = xHih6130Open ("/dev/i2c-soft", HIH6130_I2CADDR);
+   * @endcode
+   */
+  class SoftI2c {
+
+    public:
+      /**
+       * @brief Constructeur
+       *
+       * Les broches, qui doivent être ouvertes, sont libérées (entrées avec
+       * résistance de tirage). Si un esclave bloque SDA à l'état bas, jusqu'à
+       * 9 impulsions d'horloge sont générées pour le débloquer. La fréquence
+       * par défaut est 100 kHz.
+       *
+       * @param scl broche d'horloge
+       * @param sda broche de données
+       */
+      SoftI2c (Pin & scl, Pin & sda);
+
+      /**
+       * @brief Destructeur
+       *
+       * Supprime l'enregistrement du bus s'il a été fait, le bus n'est
+       * plus utilisé par le module I2C au retour.
+       */
+      virtual ~SoftI2c();
+
+      SoftI2c (const SoftI2c &) = delete;
+      SoftI2c & operator= (const SoftI2c &) = delete;
+
+      /**
+       * @brief Modifie la fréquence d'horloge
+       *
+       * @param hz fréquence en Hz, 0 pour la fréquence maximale permise par
+       * le processeur (et l'esclave si il allonge l'horloge)
+       */
+      void setSpeed (uint32_t hz);
+
+      /**
+       * @brief Fréquence d'horloge en Hz
+       */
+      uint32_t speed() const;
+
+      /**
+       * @brief Modifie la durée maximale d'allongement de l'horloge
+       *
+       * @param us durée en µs, 25000 par défaut (délai SMBus)
+       */
+      void setStretchTimeout (unsigned long us);
+
+      /**
+       * @brief Durée maximale d'allongement de l'horloge en µs
+       */
+      unsigned long stretchTimeout() const;
+
+      /**
+       * @brief Écriture puis lecture dans une même transaction
+       *
+       * Écrit \c wlen octets, puis après un démarrage répété, lit \c rlen
+       * octets. Si \c wlen est nul, seule la lecture est effectuée, si \c rlen
+       * est nul, seule l'écriture est effectuée. Si les deux sont nuls, seule
+       * l'adresse est transmise (quick write).
+       *
+       * @param addr adresse de l'esclave (alignée à droite)
+       * @param wbuf octets à écrire
+       * @param wlen nombre d'octets à écrire
+       * @param rbuf octets lus
+       * @param rlen nombre d'octets à lire
+       */
+      void transfer (int addr, const uint8_t * wbuf, size_t wlen,
+                     uint8_t * rbuf, size_t rlen);
+
+      /**
+       * @brief Écriture d'un bloc d'octets
+       */
+      void write (int addr, const uint8_t * buf, size_t len);
+
+      /**
+       * @brief Lecture d'un bloc d'octets
+       */
+      void read (int addr, uint8_t * buf, size_t len);
+
+      /**
+       * @brief Lecture d'un bloc de registres
+       *
+       * Identique à iI2cReadRegBlock() : écriture de \c reg puis lecture de
+       * \c len octets après un démarrage répété.
+       */
+      void readRegBlock (int addr, uint8_t reg, uint8_t * buf, size_t len);
+
+      /**
+       * @brief Écriture d'un bloc de registres
+       *
+       * Identique à iI2cWriteRegBlock().
+       */
+      void writeRegBlock (int addr, uint8_t reg, const uint8_t * buf, size_t len);
+
+      /**
+       * @brief Indique si un esclave acquitte une adresse
+       */
+      bool probe (int addr);
+
+      /**
+       * @brief Enregistre le bus auprès du module I2C
+       *
+       * Déclenche une exception std::system_error si le nom est déjà utilisé
+       * ou si la bibliothèque est compilée sans le module I2C (ENOTSUP).
+       *
+       * @param device nom passé à iI2cOpen(), par exemple /dev/i2c-soft
+       */
+      void registerDevice (const std::string & device);
+
+      /**
+       * @brief Supprime l'enregistrement du bus
+       *
+       * Attend la fin des transferts en cours, les connexions encore ouvertes
+       * par iI2cOpen() renvoient ensuite une erreur (ENODEV).
+       */
+      void unregisterDevice();
+
+      /**
+       * @brief Nom d'enregistrement, vide si le bus n'est pas enregistré
+       */
+      const std::string & device() const;
+
+#ifndef __DOXYGEN__
+      // Transaction de n messages, utilisée par le module I2C
+      class Message {
+        public:
+          uint16_t addr;
+          bool read;
+          uint16_t len;
+          uint8_t * buf;
+      };
+      void transfer (const Message * msgs, int n);
+#endif
+
+    private:
+      std::unique_ptr<SoftLine> _scl;
+      std::unique_ptr<SoftLine> _sda;
+      std::mutex _mutex;
+      uint32_t _speed;
+      uint64_t _half; // demi-période d'horloge en ns
+      uint64_t _stretch; // en ns
+      uint64_t _t; // instant du dernier front en ns
+      std::string _device;
+
+      void delay();
+      void sclRelease();
+      void start (bool repeated);
+      void stop();
+      void writeBit (bool bit);
+      bool readBit();
+      bool writeByte (uint8_t byte);
+      uint8_t readByte (bool ack);
+      void recover();
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_SOFTI2C_H_ defined */
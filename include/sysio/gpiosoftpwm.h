@@ -0,0 +1,226 @@
+/**
+ * @file
+ * @brief GPIO software PWM
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_SOFTPWM_H_
+#define _SYSIO_GPIO_SOFTPWM_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <sysio/gpiopin.h>
+
+namespace Sysio {
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class SoftPwm
+   * @author epsilonrt
+   * @date 03/19/18
+   * @brief PWM logiciel multi-voies
+   *
+   * Toutes les voies sont gérées par un unique thread temps réel. Chaque voie
+   * a sa propre fréquence et son propre rapport cyclique. Le thread tient un
+   * échéancier trié des prochains fronts de toutes les voies, attend le plus
+   * proche (clock_nanosleep() puis attente active), puis applique ensemble
+   * tous les fronts compris dans le même pas (tick). Avec la couche
+   * AccessLayerIoMap, les fronts d'un pas sont appliqués par une seule
+   * écriture masquée de chaque port (GPSET/GPCLR sur un Raspberry Pi). Le
+   * coût processeur dépend du nombre de fronts, pas du nombre de threads.
+   *
+   * La résolution est le pas : une impulsion plus courte que le pas n'est
+   * pas générée. Les modifications de fréquence et de rapport cyclique sont
+   * prises en compte au début de la période suivante de la voie.
+   *
+   * Exemple, un servomoteur et un variateur :
+   * @code
+   * SoftPwm pwm;
+   * int servo = pwm.add (gpio.pin (1), 50);
+   * int led = pwm.add (gpio.pin (2), 200, 0.25);
+   * pwm.setPulseWidth (servo, 1500000);
+   * pwm.start();
+   * @endcode
+   */
+  class SoftPwm {
+
+    public:
+      /**
+       * @brief Constructeur
+       */
+      SoftPwm();
+
+      /**
+       * @brief Destructeur
+       *
+       * Arrête le thread, les sorties sont mises à l'état bas.
+       */
+      virtual ~SoftPwm();
+
+      /**
+       * @brief Ajoute une voie
+       *
+       * La broche est configurée en sortie à l'état bas. Toutes les broches
+       * doivent appartenir au même GPIO. Déclenche std::logic_error si le PWM
+       * est démarré.
+       *
+       * @param pin broche de sortie, de type \c TypeGpio
+       * @param frequency fréquence en Hz
+       * @param duty rapport cyclique de 0 à 1
+       * @return numéro de la voie
+       */
+      int add (Pin & pin, double frequency, double duty = 0);
+
+      /**
+       * @brief Nombre de voies
+       */
+      int channels() const;
+
+      /**
+       * @brief Broche d'une voie
+       */
+      Pin & pin (int channel) const;
+
+      /**
+       * @brief Modifie la fréquence d'une voie
+       */
+      void setFrequency (int channel, double frequency);
+
+      /**
+       * @brief Fréquence d'une voie en Hz
+       */
+      double frequency (int channel) const;
+
+      /**
+       * @brief Modifie le rapport cyclique d'une voie
+       *
+       * @param duty rapport cyclique de 0 (toujours à l'état bas) à 1
+       * (toujours à l'état haut)
+       */
+      void setDuty (int channel, double duty);
+
+      /**
+       * @brief Rapport cyclique d'une voie
+       */
+      double duty (int channel) const;
+
+      /**
+       * @brief Modifie la durée de l'état haut d'une voie (servomoteurs)
+       *
+       * @param width_ns durée en nanosecondes, limitée à la période
+       */
+      void setPulseWidth (int channel, uint64_t width_ns);
+
+      /**
+       * @brief Modifie le pas de l'échéancier
+       *
+       * Les fronts dont les échéances sont séparées de moins d'un pas sont
+       * appliqués ensemble. Déclenche std::logic_error si le PWM est démarré.
+       *
+       * @param tick_ns pas en nanosecondes, 10000 par défaut
+       */
+      void setTick (uint64_t tick_ns);
+
+      /**
+       * @brief Pas de l'échéancier en nanosecondes
+       */
+      uint64_t tick() const;
+
+      /**
+       * @brief Modifie la priorité temps réel du thread
+       *
+       * @param priority priorité (voir Scheduler::setRtPriority()), 80 par défaut
+       */
+      void setRtPriority (int priority);
+
+      /**
+       * @brief Priorité temps réel du thread
+       */
+      int rtPriority() const;
+
+      /**
+       * @brief Fixe le processeur du thread
+       *
+       * @param cpu numéro du processeur, -1 (par défaut) pour aucun
+       */
+      void setCpu (int cpu);
+
+      /**
+       * @brief Processeur du thread, -1 si aucun
+       */
+      int cpu() const;
+
+      /**
+       * @brief Démarre le thread
+       */
+      void start();
+
+      /**
+       * @brief Arrête le thread, les sorties sont mises à l'état bas
+       */
+      void stop();
+
+      /**
+       * @brief Indique si le thread est démarré
+       */
+      bool isRunning() const;
+
+      /**
+       * @brief Plus grand retard d'application d'un front en ns
+       */
+      uint64_t maxLatency() const;
+
+    private:
+      // Voie, les durées sont en ns
+      class Channel {
+        public:
+          Pin * pin;
+          unsigned int bank;
+          uint32_t mask;
+          uint64_t period;
+          uint64_t high;
+      };
+
+      // Échéance d'une voie dans l'échéancier
+      class Event {
+        public:
+          uint64_t time;
+          int channel;
+          bool rising;
+          bool operator> (const Event & other) const {
+            return time > other.time;
+          }
+      };
+
+      Gpio * _gpio;
+      std::vector<Channel> _ch;
+      mutable std::mutex _mutex;
+      std::thread _thread;
+      std::atomic<bool> _run;
+      bool _usePort;
+      uint64_t _tick;
+      int _priority;
+      int _cpu;
+      uint64_t _maxLatency;
+
+      Channel & channel (int i);
+      const Channel & channel (int i) const;
+      void loop();
+      void writeAll (bool value);
+      static uint64_t now();
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_SOFTPWM_H_ defined */
@@ -0,0 +1,183 @@
+/**
+ * @file
+ * @brief GPIO software SPI master
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_SOFTSPI_H_
+#define _SYSIO_GPIO_SOFTSPI_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <sysio/gpiopin.h>
+
+namespace Sysio {
+
+  class SoftLine;
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class SoftSpi
+   * @author epsilonrt
+   * @date 03/22/18
+   * @brief Maître SPI logiciel
+   *
+   * Bus SPI sur des broches GPIO quelconques (bit-banging). Avec la couche
+   * AccessLayerIoMap, chaque front est une écriture directe dans les
+   * registres du GPIO, sans appel système ni appel virtuel. La fréquence
+   * d'horloge est obtenue par attente active, elle n'est respectée que si
+   * le thread n'est pas préempté (voir Scheduler).
+   *
+   * Une fois enregistré par registerDevice(), le bus est utilisable par les
+   * fonctions du module SPI (iSpiOpen(), iSpiXfer(), iSpiReadRegBlock()...)
+   * et donc par les pilotes qui les utilisent (xRf69...) sans modification :
+   * @code
+   * SoftSpi spi (gpio.pin (1), gpio.pin (2), &gpio.pin (3), &gpio.pin (4));
+   * spi.setSpeed (1000000);
+   * spi.registerDevice ("/dev/spidev9.0");
+   * xRf69 * rf = xRf69New (9, 0, irqpin);
+   * @endcode
+   */
+  class SoftSpi {
+
+    public:
+      /**
+       * @brief Constructeur
+       *
+       * Les broches, qui doivent être ouvertes, sont configurées : SCLK, MOSI et
+       * CS en sortie, MISO en entrée. Le mode par défaut est 0, MSB en premier,
+       * à 1 MHz.
+       *
+       * @param sclk broche d'horloge
+       * @param mosi broche de sortie des données
+       * @param miso broche d'entrée des données, nullptr si le bus est en
+       * écriture seule (les octets lus sont alors nuls)
+       * @param cs broche de sélection active à l'état bas, nullptr si elle est
+       * gérée par ailleurs
+       */
+      SoftSpi (Pin & sclk, Pin & mosi, Pin * miso = nullptr, Pin * cs = nullptr);
+
+      /**
+       * @brief Destructeur
+       *
+       * Supprime l'enregistrement du bus s'il a été fait, le bus n'est
+       * plus utilisé par le module SPI au retour.
+       */
+      virtual ~SoftSpi();
+
+      SoftSpi (const SoftSpi &) = delete;
+      SoftSpi & operator= (const SoftSpi &) = delete;
+
+      /**
+       * @brief Modifie le mode SPI
+       *
+       * @param mode 0 à 3, combinaison de SPI_CPOL et SPI_CPHA (voir eSpiMode)
+       */
+      void setMode (int mode);
+
+      /**
+       * @brief Mode SPI
+       */
+      int mode() const;
+
+      /**
+       * @brief Modifie la fréquence d'horloge
+       *
+       * @param hz fréquence en Hz, 0 pour la fréquence maximale permise par
+       * le processeur
+       */
+      void setSpeed (uint32_t hz);
+
+      /**
+       * @brief Fréquence d'horloge en Hz
+       */
+      uint32_t speed() const;
+
+      /**
+       * @brief Modifie l'ordre des bits
+       *
+       * @param lsb true pour transmettre le bit de poids faible en premier
+       */
+      void setLsbFirst (bool lsb);
+
+      /**
+       * @brief Indique si le bit de poids faible est transmis en premier
+       */
+      bool lsbFirst() const;
+
+      /**
+       * @brief Transfert bidirectionnel
+       *
+       * CS est activé pendant tout le transfert. Identique à iSpiXfer().
+       *
+       * @param tx octets à transmettre, nullptr pour transmettre des zéros
+       * @param rx octets reçus, nullptr si ils ne sont pas utiles, peut être
+       * égal à \c tx
+       * @param len nombre d'octets
+       * @return len
+       */
+      int xfer (const uint8_t * tx, uint8_t * rx, size_t len);
+
+      /**
+       * @brief Lecture d'un bloc d'octets
+       * @return len
+       */
+      int read (uint8_t * rx, size_t len);
+
+      /**
+       * @brief Écriture d'un bloc d'octets
+       * @return len
+       */
+      int write (const uint8_t * tx, size_t len);
+
+      /**
+       * @brief Enregistre le bus auprès du module SPI
+       *
+       * Déclenche une exception std::system_error si le nom est déjà utilisé
+       * ou si la bibliothèque est compilée sans le module SPI (ENOTSUP).
+       *
+       * @param device nom passé à iSpiOpen(), par exemple /dev/spidev9.0
+       */
+      void registerDevice (const std::string & device);
+
+      /**
+       * @brief Supprime l'enregistrement du bus
+       *
+       * Attend la fin des transferts en cours, les connexions encore ouvertes
+       * par iSpiOpen() renvoient ensuite une erreur (ENODEV).
+       */
+      void unregisterDevice();
+
+      /**
+       * @brief Nom d'enregistrement, vide si le bus n'est pas enregistré
+       */
+      const std::string & device() const;
+
+    private:
+      std::unique_ptr<SoftLine> _sclk;
+      std::unique_ptr<SoftLine> _mosi;
+      std::unique_ptr<SoftLine> _miso;
+      std::unique_ptr<SoftLine> _cs;
+      std::mutex _mutex;
+      int _mode;
+      uint32_t _speed;
+      uint64_t _half; // demi-période d'horloge en ns
+      bool _lsb;
+      std::string _device;
+
+      uint8_t transfer (uint8_t out, uint64_t & t);
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_SOFTSPI_H_ defined */
@@ -0,0 +1,65 @@
+/**
+ * @file
+ * @brief GPIO state snapshot
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_STATE_H_
+#define _SYSIO_GPIO_STATE_H_
+
+#include <map>
+#include <cstdint>
+#include <sysio/gpiopin.h>
+
+namespace Sysio {
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class GpioState
+   * @author epsilonrt
+   * @date 03/20/18
+   * @brief Photographie de l'état des broches GPIO
+   *
+   * Fournie par Gpio::snapshot(). Avec la couche AccessLayerIoMap, chaque
+   * registre de fonction, de niveau et de tirage est lu une seule fois pour
+   * toutes les broches, l'état obtenu est donc cohérent et peu coûteux.
+   */
+  class GpioState {
+
+    public:
+      /**
+       * @class PinState
+       * @brief État d'une broche
+       */
+      class PinState {
+        public:
+          Pin::Mode mode; ///< Mode
+          Pin::Pull pull; ///< Résistance de tirage, PullUnknown si elle ne peut être lue
+          bool value; ///< État binaire
+      };
+
+      /**
+       * @brief État d'une broche
+       *
+       * Déclenche une exception std::out_of_range si la broche n'est pas dans
+       * la photographie (broche qui n'est pas de type \c TypeGpio).
+       */
+      const PinState & at (const Pin & p) const {
+        return pin.at (p.mcuNumber());
+      }
+
+      uint64_t timestamp; ///< Instant de la photographie (CLOCK_MONOTONIC) en ns
+      std::map<int, PinState> pin; ///< État des broches GPIO, indexé par numéro mcu
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_STATE_H_ defined */
@@ -0,0 +1,230 @@
+/**
+ * @file
+ * @brief GPIO waveform playback
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_WAVEFORM_H_
+#define _SYSIO_GPIO_WAVEFORM_H_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+#include <sysio/gpiopingroup.h>
+
+namespace Sysio {
+
+  /**
+   *  @addtogroup sysio_gpio_pin
+   *  @{
+   */
+
+  /**
+   * @class Waveform
+   * @author epsilonrt
+   * @date 03/17/18
+   * @brief Forme d'onde jouée sur un groupe de broches
+   *
+   * Une forme d'onde est une liste d'étapes {instant, bits à 1, bits à 0}
+   * construite à l'avance. Les bits correspondent aux broches du groupe
+   * (bit 0 pour la broche 0 du groupe...), les instants sont comptés en
+   * nanosecondes à partir du début de la lecture.
+   *
+   * La lecture est effectuée par un thread temps réel dédié qui attend
+   * chaque échéance absolue (clock_nanosleep() sur CLOCK_MONOTONIC), puis
+   * attend activement les dernières microsecondes avant de modifier les
+   * sorties. Les échéances ne dépendant pas de la durée des étapes
+   * précédentes, les erreurs ne se cumulent pas. Avec la couche
+   * AccessLayerIoMap, les masques de chaque port sont calculés avant la
+   * lecture et chaque étape se résume à une écriture par port.
+   *
+   * L'erreur maximale entre les échéances et les modifications des sorties
+   * est disponible après la lecture (maxError()).
+   *
+   * Exemple, impulsion de 1,5 ms toutes les 20 ms pour un servomoteur :
+   * @code
+   * PinGroup servo ({&gpio.pin (1)});
+   * Waveform w (servo);
+   * servo.setMode (Pin::ModeOutput);
+   * for (int i = 0; i < 50; i++) {
+   *   w.add (i * 20000000ULL, 1, 0);
+   *   w.add (i * 20000000ULL + 1500000ULL, 0, 1);
+   * }
+   * w.play();
+   * @endcode
+   */
+  class Waveform {
+
+    public:
+      /**
+       * @class Step
+       * @brief Étape d'une forme d'onde
+       */
+      class Step {
+        public:
+          Step (uint64_t offset, uint32_t set, uint32_t clr) :
+            offset_ns (offset), setMask (set), clrMask (clr) {}
+          uint64_t offset_ns; ///< Instant depuis le début de la lecture en ns
+          uint32_t setMask; ///< Broches du groupe mises à 1
+          uint32_t clrMask; ///< Broches du groupe mises à 0
+      };
+
+      /**
+       * @brief Constructeur
+       *
+       * @param group groupe de broches, elles doivent être configurées en
+       * sortie avant la lecture.
+       */
+      explicit Waveform (PinGroup & group);
+
+      /**
+       * @brief Destructeur
+       *
+       * Attend la fin de la lecture en cours.
+       */
+      virtual ~Waveform();
+
+      /**
+       * @brief Ajoute une étape
+       *
+       * Déclenche une exception std::invalid_argument si l'instant est
+       * antérieur à celui de l'étape précédente ou si une broche est à la
+       * fois dans setMask et clrMask, et std::logic_error si une lecture
+       * est en cours.
+       */
+      void add (uint64_t offset_ns, uint32_t setMask, uint32_t clrMask);
+
+      /**
+       * @overload
+       */
+      void add (const Step & step);
+
+      /**
+       * @brief Supprime toutes les étapes
+       */
+      void clear();
+
+      /**
+       * @brief Étapes de la forme d'onde
+       */
+      const std::vector<Step> & steps() const;
+
+      /**
+       * @brief Durée de la forme d'onde en ns (instant de la dernière étape)
+       */
+      uint64_t duration() const;
+
+      /**
+       * @brief Groupe de broches
+       */
+      PinGroup & group() const;
+
+      /**
+       * @brief Modifie la priorité temps réel du thread de lecture
+       *
+       * @param priority priorité (voir Scheduler::setRtPriority()), 90 par défaut
+       */
+      void setRtPriority (int priority);
+
+      /**
+       * @brief Priorité temps réel du thread de lecture
+       */
+      int rtPriority() const;
+
+      /**
+       * @brief Fixe le processeur du thread de lecture
+       *
+       * @param cpu numéro du processeur, -1 (par défaut) pour aucun
+       */
+      void setCpu (int cpu);
+
+      /**
+       * @brief Processeur du thread de lecture, -1 si aucun
+       */
+      int cpu() const;
+
+      /**
+       * @brief Modifie la durée de l'attente active avant chaque étape
+       *
+       * @param spin_ns durée en ns, 50000 par défaut
+       */
+      void setSpin (uint64_t spin_ns);
+
+      /**
+       * @brief Durée de l'attente active avant chaque étape en ns
+       */
+      uint64_t spin() const;
+
+      /**
+       * @brief Joue la forme d'onde et attend la fin de la lecture
+       */
+      void play();
+
+      /**
+       * @brief Démarre la lecture de la forme d'onde
+       *
+       * La fonction retourne immédiatement, wait() permet d'attendre la fin.
+       */
+      void start();
+
+      /**
+       * @brief Attend la fin de la lecture
+       *
+       * Une exception survenue dans le thread de lecture est transmise.
+       */
+      void wait();
+
+      /**
+       * @brief Indique si une lecture est en cours
+       */
+      bool isPlaying() const;
+
+      /**
+       * @brief Erreur maximale de la dernière lecture en ns
+       *
+       * Plus grand écart entre l'échéance d'une étape et l'instant où les
+       * sorties ont été modifiées.
+       */
+      uint64_t maxError() const;
+
+      /**
+       * @brief Erreur moyenne de la dernière lecture en ns
+       */
+      double meanError() const;
+
+    private:
+      // Écriture d'un port pour une étape (AccessLayerIoMap)
+      class PortWrite {
+        public:
+          unsigned int bank;
+          uint32_t setMask;
+          uint32_t clrMask;
+      };
+
+      PinGroup & _group;
+      std::vector<Step> _step;
+      std::vector<PortWrite> _write; // précalcul, écritures de chaque étape
+      std::vector<size_t> _first; // indice de la première écriture de chaque étape
+      std::thread _thread;
+      std::exception_ptr _error;
+      std::atomic<bool> _playing;
+      int _priority;
+      int _cpu;
+      uint64_t _spin;
+      uint64_t _maxError;
+      double _meanError;
+
+      void compile();
+      void loop();
+      static uint64_t now();
+  };
+}
+/**
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_WAVEFORM_H_ defined */
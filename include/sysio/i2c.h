@@ -34,10 +34,47 @@
  */
 #define I2C_BLOCK_MAX 32
 
+/**
+ * Message en lecture (xI2cMsg::flags)
+ */
+#define I2C_MSG_READ 0x0001
+
+/* structures =============================================================== */
+/**
+ * @brief Message d'une transaction I2C
+ *
+ * Une transaction est une suite de messages séparés par une condition de
+ * démarrage répétée (repeated start), terminée par une condition d'arrêt.
+ */
+typedef struct xI2cMsg {
+  uint16_t addr; /**< adresse du circuit (alignée à droite) */
+  uint16_t flags; /**< 0 pour une écriture, I2C_MSG_READ pour une lecture */
+  uint16_t len; /**< nombre d'octets */
+  uint8_t * buf; /**< octets à écrire ou à lire */
+} xI2cMsg;
+
+/**
+ * @brief Bus I2C non géré par le noyau
+ *
+ * Opérations d'un bus I2C logiciel (Sysio::SoftI2c par exemple) enregistré
+ * par iI2cRegisterAdapter().
+ */
+typedef struct xI2cAdapter {
+  /** Transaction de \c n messages, renvoie \c n, -1 si erreur (errno
+   * renseigné, ENXIO si le circuit ne répond pas) */
+  int (*xfer) (void * ctx, xI2cMsg * msgs, int n);
+  void * ctx; /**< contexte passé à xfer */
+} xI2cAdapter;
+
 /* internal public functions ================================================ */
 /**
  * @brief Ouverture d'une connexion vers un circuit I2C
  *
+ * Si \c device a été enregistré par iI2cRegisterAdapter(), les fonctions de
+ * ce module appliquées au descripteur renvoyé utilisent le bus logiciel
+ * correspondant, un pilote utilisant ce module fonctionne donc sans
+ * modification sur un bus logiciel.
+ *
  * @param device nom du fichier d'accès au bus I2C (par exemple /dev/i2c-1)
  * @param i2caddr adresse du circuit I2C (alignée à droite)
  * @return le descripteur de fichier vers la connexion ouverte, -1 si erreur
@@ -159,6 +196,51 @@ int iI2cWriteReg16     (int fd, uint8_t reg, uint16_t data);
  */
 int iI2cWriteRegBlock  (int fd, uint8_t reg, const uint8_t * buffer, uint8_t size);
 
+/**
+ * @brief Transaction I2C brute
+ *
+ * Les messages sont transmis dans l'ordre, séparés par une condition de
+ * démarrage répétée. Chaque message porte sa propre adresse.
+ *
+ * @param fd descripteur de fichier vers la connexion ouverte
+ * @param msgs messages
+ * @param n nombre de messages, de 1 à 42 (I2C_RDWR_IOCTL_MAX_MSGS)
+ * @return le nombre de messages transmis, -1 si erreur (EINVAL si n est hors
+ * limites)
+ */
+int iI2cTransfer (int fd, xI2cMsg * msgs, int n);
+
+/**
+ * @brief Indique si le bus permet les transactions I2C brutes
+ *
+ * @param fd descripteur de fichier vers la connexion ouverte
+ * @return true si iI2cTransfer() est possible
+ */
+bool bI2cIsPlain (int fd);
+
+/**
+ * @brief Enregistre un bus I2C logiciel
+ *
+ * @param device nom utilisé par iI2cOpen() pour ce bus, peut être celui
+ * d'un bus du noyau (/dev/i2c-3 par exemple) pour le remplacer
+ * @param adapter opérations du bus, copiées
+ * @return 0, -1 si erreur (nom déjà enregistré)
+ */
+int iI2cRegisterAdapter (const char * device, const xI2cAdapter * adapter);
+
+/**
+ * @brief Supprime l'enregistrement d'un bus I2C logiciel
+ *
+ * Attend la fin des transferts en cours sur ce bus, le contexte de
+ * l'adaptateur n'est plus utilisé au retour. Les connexions encore ouvertes
+ * sur ce bus renvoient ensuite une erreur (errno = ENODEV) jusqu'à leur
+ * fermeture. Ne doit pas être appelée par une fonction de l'adaptateur.
+ *
+ * @param device nom du bus
+ * @return 0, -1 si erreur (nom non enregistré)
+ */
+int iI2cUnregisterAdapter (const char * device);
+
 /**
  *  @defgroup sysio_i2c_mem Mémoires I2C
  *
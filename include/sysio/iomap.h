@@ -36,16 +36,55 @@ typedef struct xIoMap xIoMap;
 /**
  * @brief Ouverture d'une projection mémoire
  *
+ * Les projections sont partagées au sein du processus : si la zone (base,
+ * size) est déjà projetée, la même projection est renvoyée et son nombre
+ * d'ouvertures est incrémenté, chaque ouverture devant être suivie d'un
+ * appel à iIoMapClose(). La zone est projetée à partir de /dev/mem, le
+ * descripteur de fichier est fermé dès que la projection est faite.
+ *
  * @param base adresse de base de la zone à projeter
  * @param size taille de la zone à projeter en octets
  * @return pointeur sur la projection, NULL si erreur
  */
 xIoMap * xIoMapOpen (unsigned long base, unsigned int size);
 
+/**
+ * @brief Ouverture de la projection du bloc de registres GPIO
+ *
+ * Identique à xIoMapOpen(), mais si /dev/gpiomem est disponible (Raspberry
+ * Pi), la zone est projetée à partir de ce fichier qui ne donne accès
+ * qu'aux registres GPIO et ne nécessite pas les droits root. /dev/mem est
+ * utilisé sinon. La projection est partagée avec celles ouvertes par
+ * xIoMapOpen() pour la même zone.
+ *
+ * @param base adresse de base physique du bloc GPIO
+ * @param size taille de la zone à projeter en octets
+ * @return pointeur sur la projection, NULL si erreur
+ */
+xIoMap * xIoMapOpenGpio (unsigned long base, unsigned int size);
+
+/**
+ * @brief Ouverture d'une projection en mémoire anonyme
+ *
+ * La zone n'est pas associée à des registres matériels mais à un fichier
+ * en mémoire (memfd) initialisé à zéro. Cela permet de simuler des registres
+ * d'entrée-sortie sans droits particuliers, sur n'importe quelle machine.
+ * L'adresse de base est 0.
+ *
+ * @param name nom du fichier en mémoire (visible dans /proc/self/fd)
+ * @param size taille de la zone à projeter en octets
+ * @return pointeur sur la projection, NULL si erreur
+ */
+xIoMap * xIoMapOpenMemory (const char * name, unsigned int size);
+
 /**
  * @brief Fermeture d'une projection mémoire
  *
+ * La projection n'est supprimée qu'à la fermeture de sa dernière ouverture,
+ * le pointeur p ne doit plus être utilisé après l'appel.
+ *
  * @param p pointeur sur la projection
+ * @return 0, -1 si erreur
  */
 int iIoMapClose (xIoMap *p);
 
@@ -83,10 +122,61 @@ unsigned int uIoMapSize (const xIoMap *p);
  */
 volatile unsigned int * pIo(const xIoMap *p, unsigned int offset);
 
+#if defined(__DOXYGEN__)
+/**
+ * @brief Barrière de lecture
+ *
+ * Les lectures de registres qui précèdent la barrière sont terminées avant
+ * celles qui la suivent. Sur les SoC Broadcom (BCM2835...), l'ordre des
+ * accès à deux périphériques différents n'est pas garanti par le bus : une
+ * barrière doit être placée au changement de périphérique (GPIO, horloges,
+ * PWM...). Sur les architectures non ARM, c'est une barrière complète.
+ */
+static inline void vIoMapReadBarrier (void);
+
+/**
+ * @brief Barrière d'écriture
+ *
+ * Les écritures de registres qui précèdent la barrière sont terminées avant
+ * celles qui la suivent (voir vIoMapReadBarrier()).
+ */
+static inline void vIoMapWriteBarrier (void);
+
 /**
  * @}
  */
 
+#else /* ! defined(__DOXYGEN__) */
+// -----------------------------------------------------------------------------
+INLINE void
+vIoMapReadBarrier (void) {
+#if defined(__aarch64__)
+  __asm__ __volatile__ ("dmb oshld" : : : "memory");
+#elif defined(__arm__) && (__ARM_ARCH >= 7)
+  __asm__ __volatile__ ("dmb osh" : : : "memory");
+#elif defined(__arm__)
+  // ARMv6 (BCM2835) : Data Memory Barrier par le coprocesseur CP15
+  __asm__ __volatile__ ("mcr p15, 0, %0, c7, c10, 5" : : "r" (0) : "memory");
+#else
+  __sync_synchronize();
+#endif
+}
+
+// -----------------------------------------------------------------------------
+INLINE void
+vIoMapWriteBarrier (void) {
+#if defined(__aarch64__)
+  __asm__ __volatile__ ("dmb oshst" : : : "memory");
+#elif defined(__arm__) && (__ARM_ARCH >= 7)
+  __asm__ __volatile__ ("dmb oshst" : : : "memory");
+#elif defined(__arm__)
+  __asm__ __volatile__ ("mcr p15, 0, %0, c7, c10, 5" : : "r" (0) : "memory");
+#else
+  __sync_synchronize();
+#endif
+}
+#endif /* !defined(__DOXYGEN__) */
+
 /* ========================================================================== */
 #ifdef __cplusplus
   }
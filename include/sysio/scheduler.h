@@ -8,6 +8,8 @@
 #ifndef _SYSIO_SCHEDULER_H_
 #define _SYSIO_SCHEDULER_H_
 
+#include <sysio/defs.h>
+
 /**
  *  @defgroup sysio_sceduler Scheduler
  */
@@ -17,17 +19,96 @@
  *  @{
  */
 
+__BEGIN_C_DECLS
+/* ========================================================================== */
+
+/**
+ * @brief Applique un profil d'ordonnancement au thread appelant
+ *
+ * Interface C de Scheduler::applyProfile(), utilisée par les threads créés
+ * par la partie C de la bibliothèque.
+ *
+ * @param name nom du profil
+ * @return 1 si un profil a été appliqué, 0 si aucun profil n'est défini,
+ * -1 en cas d'erreur
+ */
+int iSchedulerApplyProfile (const char * name);
+
+/* ========================================================================== */
+__END_C_DECLS
+
+#if defined(__cplusplus) || defined(__DOXYGEN__)
+// -----------------------------------------------------------------------------
+// C++ part --->
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
 namespace Sysio {
 
   /**
    * @class Scheduler
    * @author epsilonrt
    * @date 10/03/18
-   * @brief
+   * @brief Ordonnancement temps réel
+   *
+   * Les fonctions de réglage s'appliquent au thread appelant, sauf le
+   * verrouillage de la mémoire qui concerne tout le processus.
+   *
+   * Un profil regroupe ces réglages sous un nom. Les threads créés par la
+   * bibliothèque appliquent au démarrage le profil qui porte leur nom ou, à
+   * défaut, le profil "default". Un profil défini prend le pas sur la
+   * priorité propre au thread (setRtPriority() des classes concernées).
+   * Les noms utilisés sont :
+   * - "gpio-irq" : threads de InterruptDispatcher
+   * - "gpio-waveform" : thread de Waveform
+   * - "gpio-softpwm" : thread de SoftPwm
+   * - "dinput" : thread de surveillance des entrées (xDinPort)
+   * - "timer" : thread des callbacks de timer
+   * - "chipio-serial" : thread de la liaison série ChipIo
+   *
+   * Exemple, tous les threads sur le cœur isolé 3 :
+   * @code
+   * Scheduler::Profile rt;
+   * rt.policy = Scheduler::PolicyFifo;
+   * rt.priority = 80;
+   * rt.cpus = {3};
+   * rt.lockMemory = true;
+   * Scheduler::setProfile ("default", rt);
+   * @endcode
    */
   class Scheduler {
 
     public:
+      /**
+       * @enum Policy
+       * @brief Politique d'ordonnancement
+       */
+      enum Policy {
+        PolicyOther = 0, ///< SCHED_OTHER, temps partagé normal
+        PolicyFifo, ///< SCHED_FIFO, temps réel sans partage de temps
+        PolicyRoundRobin, ///< SCHED_RR, temps réel avec partage de temps
+        PolicyDeadline ///< SCHED_DEADLINE, réservation de temps processeur
+      };
+
+      /**
+       * @class Profile
+       * @brief Profil d'ordonnancement
+       */
+      class Profile {
+        public:
+          Profile();
+          Policy policy; ///< Politique, PolicyOther par défaut
+          int priority; ///< Priorité pour PolicyFifo et PolicyRoundRobin
+          std::vector<int> cpus; ///< Processeurs autorisés, vide pour tous
+          bool lockMemory; ///< Verrouille la mémoire du processus (mlockall())
+          size_t stackPrefault; ///< Taille de pile à précharger en octets, 0 aucune
+          uint64_t runtime; ///< Temps d'exécution en ns pour PolicyDeadline
+          uint64_t deadline; ///< Échéance relative en ns pour PolicyDeadline
+          uint64_t period; ///< Période en ns pour PolicyDeadline
+      };
+
       /**
        * @brief Définie la priorité en temps réel du thread appelant
        *
@@ -39,9 +120,118 @@ namespace Sysio {
        * @param priority valeur de la priorité
        */
       static void setRtPriority (int priority);
+
+      /**
+       * @brief Modifie la politique d'ordonnancement du thread appelant
+       *
+       * La priorité est limitée aux valeurs permises par la politique, elle
+       * est ignorée pour PolicyOther. PolicyDeadline nécessite setDeadline().
+       * Une exception std::system_error est déclenchée en cas d'erreur (droits
+       * insuffisants...).
+       *
+       * @param policy politique
+       * @param priority priorité
+       */
+      static void setPolicy (Policy policy, int priority = 0);
+
+      /**
+       * @brief Passe le thread appelant en SCHED_DEADLINE
+       *
+       * Le noyau réserve \c runtime ns de processeur toutes les \c period ns,
+       * à consommer avant \c deadline ns après le début de chaque période.
+       * Une exception std::system_error est déclenchée en cas d'erreur, avec
+       * le code ENOTSUP si le système ne le permet pas.
+       */
+      static void setDeadline (uint64_t runtime, uint64_t deadline, uint64_t period);
+
+      /**
+       * @brief Politique d'ordonnancement du thread appelant
+       */
+      static Policy policy();
+
+      /**
+       * @brief Priorité du thread appelant
+       */
+      static int priority();
+
+      /**
+       * @brief Fixe les processeurs autorisés pour le thread appelant
+       *
+       * @param cpus numéros des processeurs, vide pour tous
+       */
+      static void setAffinity (const std::vector<int> & cpus);
+
+      /**
+       * @brief Processeurs autorisés pour le thread appelant
+       */
+      static std::vector<int> affinity();
+
+      /**
+       * @brief Verrouille la mémoire du processus en RAM
+       *
+       * Évite les défauts de page dans les threads temps réel, mlockall() sur
+       * les pages actuelles et futures.
+       */
+      static void lockMemory();
+
+      /**
+       * @brief Déverrouille la mémoire du processus
+       */
+      static void unlockMemory();
+
+      /**
+       * @brief Précharge la pile du thread appelant
+       *
+       * Les pages de pile sont touchées à l'avance, associé à lockMemory(),
+       * cela évite les défauts de page lors des appels de fonctions.
+       *
+       * @param size taille à précharger en octets
+       */
+      static void prefaultStack (size_t size);
+
+      /**
+       * @brief Définie ou remplace un profil
+       */
+      static void setProfile (const std::string & name, const Profile & profile);
+
+      /**
+       * @brief Supprime un profil
+       */
+      static void removeProfile (const std::string & name);
+
+      /**
+       * @brief Indique si un profil est défini
+       */
+      static bool hasProfile (const std::string & name);
+
+      /**
+       * @brief Profil
+       *
+       * Déclenche une exception std::out_of_range si le profil n'existe pas.
+       */
+      static Profile profile (const std::string & name);
+
+      /**
+       * @brief Applique un profil au thread appelant
+       *
+       * Le profil \c name est utilisé s'il existe, sinon le profil "default"
+       * s'il existe.
+       *
+       * @return true si un profil a été appliqué, false si aucun n'est défini
+       */
+      static bool applyProfile (const std::string & name);
+
+      /**
+       * @brief Applique un profil au thread appelant
+       */
+      static void apply (const Profile & profile);
   };
 }
 
+// <--- C++ part
+// -----------------------------------------------------------------------------
+#endif /* defined(__cplusplus) || defined(DOXYGEN) */
+
 /**
 * @}
 */
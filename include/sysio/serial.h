@@ -234,6 +234,10 @@ eSerialFlow eSerialGetFlow (int fd);
 /**
  * Modification de la vitesse de transmission
  *
+ * Une vitesse qui ne correspond à aucune constante Bxxx (250000, 3000000...)
+ * est appliquée par l'interface termios2 du noyau (BOTHER), le pilote
+ * choisit alors le diviseur le plus proche.
+ *
  * @param xPort Pointeur sur le port
  * @return 0, -1 si erreur.
  */
@@ -314,6 +318,10 @@ int iSerialTermiosGetAttr (const struct termios * ts, xSerialIos * xIos);
 
 /**
  * Modification du baudrate d'une structure termios
+ *
+ * Une vitesse sans constante Bxxx est mémorisée dans c_ospeed avec BOTHER,
+ * elle n'est appliquée au port que par les fonctions de ce module (la
+ * fonction tcsetattr() de la glibc l'ignore).
  */
 int iSerialTermiosSetBaudrate (struct termios * ts, int iBaudrate);
 
@@ -413,6 +421,8 @@ int iSerialSpeedToInt (speed_t speed);
 
 /**
  *  Constante speed_t associée à une valeur en baud
+ *
+ *  @return la constante, -1 si la vitesse n'a pas de constante Bxxx
  */
 speed_t eSerialIntToSpeed (int baud);
 
@@ -423,6 +433,421 @@ speed_t eSerialIntToSpeed (int baud);
  */
 double dSerialFrameDuration (int fd, size_t ulSize);
 
+/**
+ * @brief Mode faible latence
+ *
+ * Active ou désactive l'indicateur ASYNC_LOW_LATENCY du pilote : les octets
+ * reçus sont transmis sans délai à la couche tty (pour un adaptateur FTDI,
+ * le temporisateur de latence passe à 1 ms).
+ *
+ * Si ulPacketSize est non nul, les lectures bloquantes travaillent par
+ * paquets : read() rend la main lorsque ulPacketSize octets (255 au plus)
+ * sont reçus ou après un silence de 0,1 s suivant le dernier octet reçu
+ * (VMIN = ulPacketSize, VTIME = 1). À la désactivation, read() redevient
+ * non bloquant (VMIN = VTIME = 0). VMIN et VTIME sont sans effet sur un port
+ * ouvert en mode O_NONBLOCK (réacteur).
+ *
+ * @param fd le descripteur de fichier du port
+ * @param bEnable true pour activer
+ * @param ulPacketSize taille des paquets, 0 pour des lectures non bloquantes
+ * @return 0, -1 si erreur (notamment si le pilote ne gère pas
+ * ASYNC_LOW_LATENCY)
+ */
+int iSerialSetLowLatency (int fd, bool bEnable, size_t ulPacketSize);
+
+/**
+ * @brief Indique si le mode faible latence est actif
+ */
+bool bSerialIsLowLatency (int fd);
+
+/**
+ * @brief Mesure de la durée de transmission d'une trame
+ *
+ * Transmet ulSize octets de buf et mesure le temps écoulé jusqu'à la fin de
+ * l'émission (tcdrain()). L'écart avec dSerialFrameDuration() donne le
+ * surcoût du pilote et de l'adaptateur : un rapport proche de 1 indique que
+ * la liaison est exploitée à sa vitesse nominale.
+ *
+ * @param fd le descripteur de fichier du port
+ * @param buf octets à transmettre
+ * @param ulSize nombre d'octets
+ * @param dRatio si non NULL, rapport entre la durée mesurée et
+ * dSerialFrameDuration()
+ * @return durée mesurée en secondes, -1 si erreur
+ */
+double dSerialMeasureFrameDuration (int fd, const void * buf, size_t ulSize,
+                                    double * dRatio);
+
+/**
+ * @brief Réacteur multi-ports
+ *
+ * Surveille un ensemble de ports série par un unique descripteur epoll en
+ * mode déclenché par front (edge-triggered). Lorsque des octets arrivent
+ * sur un port, ils sont lus dans le tampon propre au port, sans scrutation
+ * préalable ni ioctl FIONREAD, puis transmis à la fonction de réception du
+ * port. Un seul thread peut ainsi servir tous les ports d'une passerelle :
+ * @code
+ * xSerialReactor * r = xSerialReactorNew();
+ * iXBeeAttachReactor (xbee, r);
+ * iTinfoAttachReactor (tinfo, r);
+ * for (;;) {
+ *   iSerialReactorRun (r, -1);
+ * }
+ * @endcode
+ * La structure est opaque pour l'utilisateur.
+ */
+typedef struct xSerialReactor xSerialReactor;
+
+/**
+ * @brief Fonction de réception d'un port du réacteur
+ *
+ * @param fd descripteur du port
+ * @param buf octets reçus, NULL si le port a été fermé par l'autre extrémité
+ * ou est en erreur (il est alors retiré du réacteur après l'appel, ses
+ * attributs d'origine sont rétablis avant l'appel, fd peut être fermé)
+ * @param len nombre d'octets reçus, 0 si buf est NULL
+ * @param udata pointeur fourni à iSerialReactorAdd()
+ * @return 0, une valeur négative retire le port du réacteur (fd ne doit
+ * alors pas avoir été fermé par la fonction)
+ */
+typedef int (*iSerialReactorCb) (int fd, const uint8_t * buf, size_t len, void * udata);
+
+/**
+ * @brief Création d'un réacteur
+ *
+ * @return le réacteur, NULL si erreur
+ */
+xSerialReactor * xSerialReactorNew (void);
+
+/**
+ * @brief Destruction d'un réacteur
+ *
+ * Les descripteurs des ports ne sont pas fermés, leurs attributs d'origine
+ * sont rétablis.
+ * @return 0, -1 si erreur
+ */
+int iSerialReactorDelete (xSerialReactor * r);
+
+/**
+ * @brief Ajout d'un port
+ *
+ * Le port est passé en mode non bloquant (O_NONBLOCK), ce qu'impose le mode
+ * edge-triggered, jusqu'à son retrait du réacteur qui rétablit ses attributs
+ * d'origine. Cet attribut appartient à la description de fichier ouvert :
+ * il s'applique aussi aux écritures et aux autres descripteurs du même port
+ * (obtenus par dup() ou hérités par fork()). Tant que le port est dans le
+ * réacteur, un appel à write() peut donc échouer avec EAGAIN lorsque le
+ * tampon d'émission du pilote est plein, l'appelant doit alors attendre
+ * POLLOUT (c'est le cas des modules xbee et tnc). Peut être appelée depuis
+ * la fonction de réception d'un port ou depuis un autre thread que celui qui
+ * exécute le réacteur.
+ *
+ * @param r le réacteur
+ * @param fd descripteur du port, un même descripteur ne peut être ajouté
+ * qu'une fois (EEXIST)
+ * @param bufsize taille du tampon de réception, 0 pour la taille par défaut
+ * (256 octets)
+ * @param cb fonction de réception
+ * @param udata pointeur transmis à cb
+ * @return 0, -1 si erreur
+ */
+int iSerialReactorAdd (xSerialReactor * r, int fd, size_t bufsize,
+                       iSerialReactorCb cb, void * udata);
+
+/**
+ * @brief Retrait d'un port
+ *
+ * Le descripteur n'est pas fermé, ses attributs d'origine sont rétablis. Au
+ * retour, la fonction de réception du port n'est plus en cours d'exécution,
+ * sauf si le retrait est demandé par une fonction de réception.
+ *
+ * @return 0, -1 si erreur (ENOENT si le port est inconnu)
+ */
+int iSerialReactorRemove (xSerialReactor * r, int fd);
+
+/**
+ * @brief Nombre de ports du réacteur
+ */
+int iSerialReactorSize (const xSerialReactor * r);
+
+/**
+ * @brief Attente et traitement des réceptions
+ *
+ * Attend qu'au moins un port reçoive des octets puis appelle la fonction de
+ * réception de chaque port prêt.
+ *
+ * @param r le réacteur
+ * @param timeout_ms temps d'attente maximal, une valeur négative pour l'infini
+ * @return le nombre de ports traités, 0 si le délai est écoulé ou si
+ * l'attente a été interrompue par vSerialReactorWakeup(), -1 si erreur
+ */
+int iSerialReactorRun (xSerialReactor * r, int timeout_ms);
+
+/**
+ * @brief Interrompt l'attente de iSerialReactorRun()
+ *
+ * Peut être appelée depuis un autre thread ou un gestionnaire de signal.
+ */
+void vSerialReactorWakeup (xSerialReactor * r);
+
+/**
+ * @brief Délais de basculement RTS d'un port en mode RS485
+ *
+ * Modifie les délais appliqués par le pilote autour de chaque émission
+ * (champs delay_rts_before_send et delay_rts_after_send de TIOCSRS485). Le
+ * port doit être en mode SERIAL_FLOW_RS485_RTS_AFTER_SEND ou
+ * SERIAL_FLOW_RS485_RTS_ON_SEND.
+ *
+ * @param fd le descripteur de fichier du port
+ * @param uBeforeSendMs délai entre la bascule de RTS et le premier octet en ms
+ * @param uAfterSendMs délai entre le dernier octet et la bascule de RTS en ms
+ * @return 0, -1 si erreur (ENOTTY si le pilote ne gère pas le RS485)
+ */
+int iSerialSetRs485Delays (int fd, unsigned uBeforeSendMs, unsigned uAfterSendMs);
+
+/**
+ * @brief Bus RS485 half-duplex
+ *
+ * Moteur de transactions requête/réponse sur un bus RS485 : la requête est
+ * émise, la ligne est basculée en réception puis la réponse est lue jusqu'à
+ * un silence inter-caractère.
+ *
+ * Si le pilote gère le RS485 (TIOCSRS485), il commande RTS lui-même avec les
+ * délais demandés. Sinon, RTS est commandé par ioctl (TIOCMBIS/TIOCMBIC)
+ * avec la même convention de niveaux que le pilote : la bascule en
+ * réception a lieu au retour de tcdrain(), mais jamais avant la fin
+ * théorique de la trame (dSerialFrameDuration() compté depuis le début de
+ * l'émission), certains pilotes rendant la main avant que le dernier bit de
+ * stop soit sorti.
+ * @code
+ * xSerialRs485 * bus = xSerialRs485New (fd, SERIAL_FLOW_RS485_RTS_ON_SEND, 0, 0);
+ * xSerialRs485Stats st;
+ * int n = iSerialRs485Transaction (bus, req, sizeof (req), rsp, sizeof (rsp),
+ *                                  100, 0, &st);
+ * printf ("%d octets, retournement %.0f us\n", n, st.dTurnaround * 1e6);
+ * @endcode
+ * La structure est opaque pour l'utilisateur.
+ */
+typedef struct xSerialRs485 xSerialRs485;
+
+/**
+ * @brief Mesures d'une transaction
+ *
+ * Les durées sont en secondes.
+ */
+typedef struct xSerialRs485Stats {
+  double dTx;         /**< du début de l'émission à la bascule en réception */
+  double dTurnaround; /**< de la bascule en réception au premier octet reçu, -1 sans réponse */
+  double dRx;         /**< du premier au dernier octet reçu */
+  size_t ulRxLen;     /**< nombre d'octets reçus */
+} xSerialRs485Stats;
+
+/**
+ * @brief Création d'un bus RS485
+ *
+ * Le port est placé en mode RS485 (iSerialSetFlow() et
+ * iSerialSetRs485Delays()). Si le pilote ne gère pas le RS485, RTS est placé
+ * au niveau de réception et sera commandé par iSerialRs485Transaction().
+ *
+ * @param fd le descripteur de fichier du port, il n'est pas fermé par
+ * iSerialRs485Delete()
+ * @param eFlow SERIAL_FLOW_RS485_RTS_ON_SEND ou
+ * SERIAL_FLOW_RS485_RTS_AFTER_SEND
+ * @param uBeforeSendMs délai entre la bascule de RTS et le premier octet en ms
+ * @param uAfterSendMs délai entre le dernier octet et la bascule de RTS en ms
+ * @return le bus, NULL si erreur
+ */
+xSerialRs485 * xSerialRs485New (int fd, eSerialFlow eFlow,
+                                unsigned uBeforeSendMs, unsigned uAfterSendMs);
+
+/**
+ * @brief Destruction d'un bus RS485
+ *
+ * @return 0, -1 si erreur
+ */
+int iSerialRs485Delete (xSerialRs485 * bus);
+
+/**
+ * @brief Indique si RTS est commandé par le pilote
+ */
+bool bSerialRs485IsKernel (const xSerialRs485 * bus);
+
+/**
+ * @brief Transaction requête/réponse
+ *
+ * Les octets en attente de lecture sont éliminés, la requête est émise puis
+ * la réponse est lue jusqu'à ce que rxsize octets soient reçus ou qu'un
+ * silence de lCharTimeoutUs suive le dernier octet reçu.
+ *
+ * @param bus le bus
+ * @param tx requête
+ * @param txlen taille de la requête
+ * @param rx tampon de réponse, NULL avec rxsize nul pour une requête sans
+ * réponse (diffusion)
+ * @param rxsize taille du tampon de réponse
+ * @param iTimeoutMs délai d'attente du premier octet de la réponse en ms,
+ * une valeur négative pour une attente infinie
+ * @param lCharTimeoutUs silence inter-caractère marquant la fin de la
+ * réponse en µs, 0 pour 3,5 caractères (1 ms au moins, les adaptateurs USB
+ * transmettent les octets par paquets)
+ * @param stats si non NULL, mesures de la transaction
+ * @return le nombre d'octets reçus, 0 si aucune réponse dans le délai, -1
+ * si erreur
+ */
+int iSerialRs485Transaction (xSerialRs485 * bus,
+                             const void * tx, size_t txlen,
+                             void * rx, size_t rxsize,
+                             int iTimeoutMs, long lCharTimeoutUs,
+                             xSerialRs485Stats * stats);
+
+/**
+ * @brief Sens d'un bloc enregistré
+ */
+typedef enum {
+  SERIAL_REC_RX = 0, /**< octets reçus */
+  SERIAL_REC_TX = 1  /**< octets transmis */
+} eSerialRecDir;
+
+/**
+ * @brief Enregistreur de trafic
+ *
+ * Enregistre des blocs d'octets reçus ou transmis dans un journal binaire
+ * compact : un en-tête de 16 octets ("SYSIOREC" puis l'heure de création
+ * CLOCK_REALTIME en ns, petit-boutiste sur 64 bits) suivi d'un
+ * enregistrement par bloc, composé de trois entiers LEB128 (durée en ns
+ * depuis le bloc précédent sur CLOCK_MONOTONIC, numéro de port décalé d'un
+ * bit à gauche et combiné au sens, nombre d'octets) suivis des octets. Un
+ * bloc de quelques octets coûte ainsi 4 à 6 octets d'en-tête.
+ *
+ * Attaché à un réacteur (vSerialReactorSetRecorder()), il enregistre tous
+ * les blocs reçus par les ports du réacteur, le numéro de port étant le
+ * descripteur de fichier. Les journaux sont relus par iSerialReplay().
+ * La structure est opaque pour l'utilisateur.
+ */
+typedef struct xSerialRecorder xSerialRecorder;
+
+/**
+ * @brief Création d'un enregistreur
+ *
+ * @param path chemin du journal, créé ou tronqué
+ * @return l'enregistreur, NULL si erreur
+ */
+xSerialRecorder * xSerialRecorderNew (const char * path);
+
+/**
+ * @brief Destruction d'un enregistreur
+ *
+ * Les blocs en mémoire tampon sont écrits et le journal est fermé.
+ * @return 0, -1 si erreur
+ */
+int iSerialRecorderDelete (xSerialRecorder * rec);
+
+/**
+ * @brief Enregistrement d'un bloc
+ *
+ * L'instant est lu à l'appel. Peut être appelée par plusieurs threads.
+ *
+ * @param rec l'enregistreur
+ * @param port numéro de port
+ * @param dir sens
+ * @param buf octets
+ * @param len nombre d'octets
+ * @return 0, -1 si erreur
+ */
+int iSerialRecorderWrite (xSerialRecorder * rec, unsigned port,
+                          eSerialRecDir dir, const void * buf, size_t len);
+
+/**
+ * @brief Écriture des blocs en mémoire tampon dans le journal
+ *
+ * @return 0, -1 si erreur
+ */
+int iSerialRecorderFlush (xSerialRecorder * rec);
+
+/**
+ * @brief Transmission enregistrée
+ *
+ * write() sur fd, les octets transmis sont enregistrés avec le sens
+ * SERIAL_REC_TX et fd comme numéro de port.
+ *
+ * @param rec l'enregistreur, NULL pour un simple write()
+ * @return nombre d'octets transmis, -1 si erreur
+ */
+ssize_t iSerialRecordedWrite (xSerialRecorder * rec, int fd,
+                              const void * buf, size_t len);
+
+/**
+ * @brief Attache un enregistreur à un réacteur
+ *
+ * @param r le réacteur
+ * @param rec l'enregistreur, NULL pour détacher
+ */
+void vSerialReactorSetRecorder (xSerialReactor * r, xSerialRecorder * rec);
+
+/**
+ * @brief Fonction de relecture d'un journal
+ *
+ * @param port numéro de port
+ * @param dir sens
+ * @param buf octets du bloc
+ * @param len nombre d'octets
+ * @param udata pointeur fourni à iSerialReplay()
+ * @return 0, une valeur négative arrête la relecture qui renvoie alors -1
+ * (errno doit être fixé)
+ */
+typedef int (*iSerialReplayCb) (unsigned port, eSerialRecDir dir,
+                                const uint8_t * buf, size_t len, void * udata);
+
+/**
+ * @brief Relecture d'un journal
+ *
+ * Chaque bloc est transmis à cb, soit au rythme de l'enregistrement divisé
+ * par dSpeed, soit aussi vite que possible si dSpeed est nul. Les blocs
+ * peuvent ainsi être injectés directement dans un décodeur (iXBeeFeed(),
+ * iTinfoFeed(), iTncFeed()), ce qui permet aussi de mesurer le débit
+ * maximal du décodeur. Un journal tronqué (enregistreur interrompu) est
+ * relu jusqu'au dernier bloc complet, un bloc de plus de 16 Mo est une
+ * erreur (EILSEQ).
+ *
+ * @param path chemin du journal
+ * @param dSpeed facteur de vitesse, 1 pour le rythme d'origine, 0 pour
+ * aller aussi vite que possible
+ * @param cb fonction de relecture
+ * @param udata pointeur transmis à cb
+ * @return le nombre de blocs relus, -1 si erreur
+ */
+int iSerialReplay (const char * path, double dSpeed,
+                   iSerialReplayCb cb, void * udata);
+
+/**
+ * @brief Relecture d'un journal vers un descripteur
+ *
+ * Les blocs reçus (SERIAL_REC_RX) du port iPort sont écrits sur fd. Avec
+ * le maître d'un pseudo-terminal (iSerialOpenPty()), l'application lit le
+ * trafic enregistré sur l'esclave comme s'il provenait du matériel.
+ *
+ * @param path chemin du journal
+ * @param iPort numéro de port, -1 pour tous les ports
+ * @param dSpeed facteur de vitesse, voir iSerialReplay()
+ * @param fd descripteur de destination
+ * @return le nombre de blocs relus, -1 si erreur (d'écriture sur fd par
+ * exemple)
+ */
+int iSerialReplayToFd (const char * path, int iPort, double dSpeed, int fd);
+
+/**
+ * @brief Ouverture d'un pseudo-terminal
+ *
+ * Le maître est configuré en mode brut (cfmakeraw()), les octets écrits
+ * sont transmis sans modification à l'esclave.
+ *
+ * @param name tampon recevant le chemin de l'esclave (à ouvrir avec
+ * iSerialOpen())
+ * @param size taille de name
+ * @return le descripteur du maître, -1 si erreur
+ */
+int iSerialOpenPty (char * name, size_t size);
+
 /**
  * @}
  */
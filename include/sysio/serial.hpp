@@ -11,6 +11,8 @@
 
 #include <sysio/serial.h>
 #include <string>
+#include <vector>
+#include <deque>
 
 /**
  *  @addtogroup sysio_serial
@@ -22,6 +24,25 @@
  */
 /**
  * Port série
+ *
+ * Les lectures passent par un tampon circulaire rempli par readv() dans ses
+ * deux zones libres, autant d'octets que le pilote en a reçus à chaque appel
+ * système. Les écritures sont mises en file et transmises par writev() en
+ * une seule fois (sync()). Les blocs std::vector sont échangés par
+ * déplacement : readExact() et readUntil() rendent un bloc qui ne sera plus
+ * copié, write() accepte un bloc déplacé qui est transmis tel quel.
+ *
+ * Les fonctions de lecture et d'écriture tamponnées déclenchent une
+ * exception std::system_error en cas d'erreur (EBADF si le port est fermé,
+ * ETIMEDOUT si le délai est écoulé).
+ *
+ * @code
+ * Serial port ("/dev/ttyUSB0", 115200);
+ * port.open();
+ * port.write (std::vector<uint8_t> { 'A', 'T', '\r' });
+ * port.sync();
+ * std::vector<uint8_t> line = port.readUntil ('\n', 256, 1000);
+ * @endcode
  */
 class Serial {
 
@@ -102,6 +123,9 @@ class Serial {
     void setPort (const char * portname);
     /**
      * Ferme le port
+     *
+     * La file d'écriture est abandonnée, sync() doit être appelée avant pour
+     * la transmettre.
      */
     void close();
     /**
@@ -110,6 +134,9 @@ class Serial {
     int fileno() const;
     /**
      * Vide les tampons
+     *
+     * Les tampons du pilote, le tampon de lecture et la file d'écriture sont
+     * vidés sans transmission.
      */
     void flush();
     /**
@@ -129,6 +156,103 @@ class Serial {
      */
     bool setFlowControlName (const char * newFlowControl);
 
+    /**
+     * @brief Nombre d'octets disponibles en lecture
+     *
+     * Le tampon de lecture est complété sans attente avec les octets reçus
+     * par le pilote.
+     */
+    size_t available();
+    /**
+     * @brief Lecture d'au plus len octets
+     *
+     * Si le tampon de lecture est vide, attend la réception d'au moins un
+     * octet pendant timeout_ms. Un bloc plus grand que le tampon est lu
+     * directement dans buf lorsque le tampon est vide.
+     *
+     * @param timeout_ms délai d'attente en ms, 0 pour ne pas attendre, -1
+     * pour attendre indéfiniment
+     * @return nombre d'octets lus, 0 si le délai est écoulé
+     */
+    size_t read (uint8_t * buf, size_t len, int timeout_ms = 0);
+    /**
+     * @brief Lecture sans retrait d'au plus len octets
+     *
+     * Identique à read(), les octets restent dans le tampon de lecture.
+     */
+    size_t peek (uint8_t * buf, size_t len, int timeout_ms = 0);
+    /**
+     * @brief Lecture sans retrait du prochain octet
+     *
+     * @return l'octet, -1 si aucun octet n'a été reçu dans le délai
+     */
+    int peek (int timeout_ms = 0);
+    /**
+     * @brief Lecture d'exactement n octets
+     *
+     * Si le délai est écoulé avant la réception des n octets, une exception
+     * std::system_error avec le code ETIMEDOUT est déclenchée et les octets
+     * reçus restent dans le tampon de lecture.
+     *
+     * @param timeout_ms délai global en ms, -1 pour attendre indéfiniment
+     */
+    std::vector<uint8_t> readExact (size_t n, int timeout_ms = -1);
+    /**
+     * @brief Lecture jusqu'à un délimiteur
+     *
+     * Si le délai est écoulé avant la réception du délimiteur, une exception
+     * std::system_error avec le code ETIMEDOUT est déclenchée et les octets
+     * reçus restent dans le tampon de lecture.
+     *
+     * @param delim délimiteur
+     * @param maxlen nombre maximal d'octets rendus, 0 sans limite. Si maxlen
+     * octets sont reçus sans délimiteur, ils sont rendus (le dernier octet du
+     * bloc n'est alors pas le délimiteur).
+     * @param timeout_ms délai global en ms, -1 pour attendre indéfiniment
+     * @return octets lus, délimiteur compris
+     */
+    std::vector<uint8_t> readUntil (uint8_t delim, size_t maxlen = 0,
+                                    int timeout_ms = -1);
+    /**
+     * @brief Mise en file d'un bloc à transmettre, par copie
+     *
+     * Les petits blocs sont regroupés. Si le nombre d'octets en attente
+     * atteint writeThreshold(), la file est transmise (sync()).
+     */
+    void write (const uint8_t * buf, size_t len);
+    /**
+     * @brief Mise en file d'un bloc à transmettre, par déplacement
+     *
+     * Le bloc est transmis sans copie.
+     */
+    void write (std::vector<uint8_t> && buf);
+    /**
+     * @brief Transmission de la file d'écriture
+     *
+     * Les blocs en attente sont transmis par writev(), par lots de IOV_MAX
+     * blocs au plus.
+     *
+     * @param timeout_ms délai global d'attente de place dans le tampon du
+     * pilote en ms, -1 pour attendre indéfiniment
+     * @return true si tous les octets ont été transmis, false si le délai
+     * est écoulé (les octets restants restent en file)
+     */
+    bool sync (int timeout_ms = -1);
+    /**
+     * @brief Nombre d'octets en attente de transmission
+     */
+    size_t pending() const;
+    /**
+     * @brief Seuil de transmission automatique de la file d'écriture
+     */
+    size_t writeThreshold() const;
+    /**
+     * @brief Modifie le seuil de transmission automatique
+     *
+     * 0 désactive la transmission automatique, seul sync() transmet.
+     */
+    void setWriteThreshold (size_t threshold);
+
 #if !defined(__DOXYGEN__)
     // Swig access functions (python interface)
     inline int getFileno() const {
@@ -151,6 +275,24 @@ class Serial {
     int fd;
     xSerialIos ios;
     std::string _portname;
+
+    // Tampon de lecture circulaire, sa taille est une puissance de 2
+    std::vector<uint8_t> _rx;
+    size_t _rxhead; // indice du premier octet
+    size_t _rxcount;
+
+    // File d'écriture, _txoffset octets du premier bloc ont été transmis
+    std::deque<std::vector<uint8_t>> _tx;
+    size_t _txoffset;
+    size_t _txcount;
+    size_t _txthreshold;
+
+    void checkOpen (const char * func) const;
+    void rxReserve (size_t n);
+    size_t rxRead (uint8_t * buf, size_t len);
+    size_t rxFill();
+    size_t rxCopy (uint8_t * buf, size_t len, bool consume);
+    std::vector<uint8_t> rxTake (size_t n);
 #endif /* __DOXYGEN__ not defined */
 };
 /**
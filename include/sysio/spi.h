@@ -81,10 +81,33 @@ typedef struct xSpiIos {
 } xSpiIos;
 
 
+/**
+ * @brief Bus SPI non géré par le noyau
+ *
+ * Opérations d'un bus SPI logiciel (Sysio::SoftSpi par exemple) enregistré
+ * par iSpiRegisterAdapter(). Chaque fonction reçoit \c ctx en premier
+ * paramètre et renvoie -1 en cas d'erreur (errno renseigné).
+ */
+typedef struct xSpiAdapter {
+  /** Transfert bidirectionnel de \c len octets, \c tx et \c rx peuvent être
+   * NULL, renvoie \c len */
+  int (*xfer) (void * ctx, const uint8_t * tx, uint8_t * rx, uint8_t len);
+  /** Modification de la configuration, renvoie 0 */
+  int (*setconfig) (void * ctx, const xSpiIos * config);
+  /** Lecture de la configuration, renvoie 0 */
+  int (*getconfig) (void * ctx, xSpiIos * config);
+  void * ctx; /**< contexte passé aux fonctions */
+} xSpiAdapter;
+
 /* internal public functions ================================================ */
 /**
  * @brief Ouverture d'une connexion vers un circuit SPI
  *
+ * Si \c device a été enregistré par iSpiRegisterAdapter(), les fonctions de
+ * ce module appliquées au descripteur renvoyé utilisent le bus logiciel
+ * correspondant, un pilote utilisant ce module fonctionne donc sans
+ * modification sur un bus logiciel.
+ *
  * @param device nom du fichier d'accès au bus SPI (par exemple /dev/spidev0.1,
  * 0 pour le numéro de bus, 1 pour le numéro de broche CS)
  * @param config configuration de la connexion
@@ -215,6 +238,29 @@ int iSpiWriteReg16 (int fd, uint8_t reg, uint16_t data);
  */
 int iSpiWriteRegBlock (int fd, uint8_t reg, const uint8_t * buffer, uint8_t len);
 
+/**
+ * @brief Enregistre un bus SPI logiciel
+ *
+ * @param device nom utilisé par iSpiOpen() pour ce bus, peut être celui
+ * d'un bus du noyau (/dev/spidev1.0 par exemple) pour le remplacer
+ * @param adapter opérations du bus, copiées
+ * @return 0, -1 si erreur (nom déjà enregistré)
+ */
+int iSpiRegisterAdapter (const char * device, const xSpiAdapter * adapter);
+
+/**
+ * @brief Supprime l'enregistrement d'un bus SPI logiciel
+ *
+ * Attend la fin des transferts en cours sur ce bus, le contexte de
+ * l'adaptateur n'est plus utilisé au retour. Les connexions encore ouvertes
+ * sur ce bus renvoient ensuite une erreur (errno = ENODEV) jusqu'à leur
+ * fermeture. Ne doit pas être appelée par une fonction de l'adaptateur.
+ *
+ * @param device nom du bus
+ * @return 0, -1 si erreur (nom non enregistré)
+ */
+int iSpiUnregisterAdapter (const char * device);
+
 /**
  * @}
  */
@@ -16,6 +16,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <time.h>
+#include <sysio/serial.h>
 
 /**
  *  @defgroup sysio_tinfo Télé-information client ERDF
@@ -281,6 +282,37 @@ xTinfo * xTinfoOpen (const char * port, unsigned long baudrate);
  */
 int iTinfoPoll (xTinfo *tinfo);
 
+/**
+ * @brief Confie la réception à un réacteur multi-ports
+ *
+ * Les trames sont décodées et les gestionnaires appelés par le thread qui
+ * exécute iSerialReactorRun(), iTinfoPoll() ne doit plus être appelée.
+ * @param tinfo pointeur sur l'objet Tinfo
+ * @param r réacteur
+ * @return 0, -1 si erreur
+ */
+int iTinfoAttachReactor (xTinfo *tinfo, xSerialReactor *r);
+
+/**
+ * @brief Retire la liaison d'un réacteur multi-ports
+ * @param tinfo pointeur sur l'objet Tinfo
+ * @param r réacteur
+ * @return 0, -1 si erreur
+ */
+int iTinfoDetachReactor (xTinfo *tinfo, xSerialReactor *r);
+
+/**
+ * @brief Décodage d'octets déjà lus
+ *
+ * Identique à iTinfoPoll() pour des octets provenant d'une autre source que
+ * la liaison (relecture d'un journal par iSerialReplay() par exemple).
+ * @param tinfo pointeur sur l'objet Tinfo
+ * @param buf octets reçus
+ * @param len nombre d'octets
+ * @return 0, -1 si erreur
+ */
+int iTinfoFeed (xTinfo *tinfo, const void *buf, size_t len);
+
 /**
  * @brief Fermeture d'une liaison de télé-information
  * @param tinfo pointeur sur l'objet Tinfo
@@ -378,6 +378,48 @@ eXBeeSeries eXBeeGetSeries (const xXBee *xbee);
  */
 int iXBeePoll (xXBee *xbee, int timeout);
 
+/**
+ * @brief Confie la réception à un réacteur multi-ports
+ *
+ * Les octets reçus par le module sont traités par le thread qui exécute
+ * iSerialReactorRun(), iXBeePoll() ne doit plus être appelée.
+ * @param xbee pointeur sur l'objet XBee
+ * @param r réacteur
+ * @return 0, -1 si erreur
+ */
+int iXBeeAttachReactor (xXBee *xbee, xSerialReactor *r);
+
+/**
+ * @brief Retire le module d'un réacteur multi-ports
+ * @param xbee pointeur sur l'objet XBee
+ * @param r réacteur
+ * @return 0, -1 si erreur
+ */
+int iXBeeDetachReactor (xXBee *xbee, xSerialReactor *r);
+
+/**
+ * @brief Décodage d'octets déjà lus
+ *
+ * Identique à iXBeePoll() pour des octets provenant d'une autre source que
+ * le port du module (relecture d'un journal par iSerialReplay() par exemple).
+ * @param xbee pointeur sur l'objet XBee
+ * @param buf octets reçus
+ * @param len nombre d'octets
+ * @return 0, -1 si erreur
+ */
+int iXBeeFeed (xXBee *xbee, const void *buf, size_t len);
+
+/**
+ * @brief Enregistre les trames transmises au module
+ *
+ * Les trames transmises sont enregistrées avec le sens SERIAL_REC_TX et le
+ * descripteur du port comme numéro de port. Les octets reçus sont
+ * enregistrés par le réacteur (vSerialReactorSetRecorder()).
+ * @param xbee pointeur sur l'objet XBee
+ * @param rec enregistreur, NULL pour arrêter l'enregistrement
+ */
+void vXBeeSetRecorder (xXBee *xbee, xSerialRecorder *rec);
+
 /**
  * @brief Envoi une commande AT locale
  *
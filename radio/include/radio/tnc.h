@@ -58,6 +58,8 @@ typedef enum {
 //#                                                                            #
 //##############################################################################
 
+struct xSerialReactor;
+
 /**
  * Tnc Class
  */
@@ -72,8 +74,17 @@ typedef struct xTnc {
   int state;
   uint8_t cnt;
   uint8_t msb;
+  void (*rxcb) (struct xTnc *, void *); ///< frame handler used with a reactor
+  void *udata;  ///< user data passed to rxcb
 } xTnc;
 
+/**
+ * Frame handler
+ *
+ * Called for each valid frame, the payload is in tnc->rxbuf (tnc->len bytes).
+ */
+typedef void (*vTncFrameCb) (xTnc *tnc, void *udata);
+
 /**
  * Create and initialize a new xTnc object
  *
@@ -126,6 +137,43 @@ int iTncSetFdout (xTnc *p, int fdout);
  */
 int iTncPoll(xTnc *tnc);
 
+/**
+ * Decode received characters
+ *
+ * Same as iTncPoll() for characters already read from the medium, cb is
+ * called for each valid frame found in buf.
+ *
+ * @param tnc TNC object to operate on.
+ * @param buf received characters
+ * @param count number of characters
+ * @param cb frame handler, may be NULL
+ * @param udata user data passed to cb
+ * @return number of valid frames found, negative value on error
+ */
+int iTncFeed (xTnc *tnc, const void *buf, size_t count, vTncFrameCb cb, void *udata);
+
+/**
+ * Hand the input medium over to a serial reactor
+ *
+ * Characters received on the input file descriptor (iTncSetFdin()) are
+ * decoded by the thread running iSerialReactorRun(), cb is called for each
+ * valid frame. iTncPoll() must not be called anymore.
+ *
+ * @param tnc TNC object to operate on.
+ * @param r serial reactor
+ * @param cb frame handler
+ * @param udata user data passed to cb
+ * @return TNC_SUCCESS, negative value on error
+ */
+int iTncAttachReactor (xTnc *tnc, struct xSerialReactor *r, vTncFrameCb cb, void *udata);
+
+/**
+ * Remove the input medium from a serial reactor
+ *
+ * @return TNC_SUCCESS, negative value on error
+ */
+int iTncDetachReactor (xTnc *tnc, struct xSerialReactor *r);
+
 /**
  * Send an TNC message
  *
@@ -12,8 +12,10 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
 #include <termios.h>
 
+#include <sysio/serial.h>
 #include <radio/tnc.h>
 #include <radio/crc.h>
 
@@ -185,6 +187,99 @@ iTncSetFdout (xTnc *p, int fd) {
   return prviSetError (p, TNC_SUCCESS);
 }
 
+// -----------------------------------------------------------------------------
+// Traitement d'un octet reçu, renvoie l'état (TNC_EOT si une trame complète
+// est disponible) ou TNC_CRC_ERROR
+static int
+prviParse (xTnc *p, uint8_t c) {
+
+  switch (c) {
+
+    case TNC_SOH:
+      p->crc_rx = CRC_CCITT_INIT_VAL;
+      p->state = TNC_SOH;
+      p->len = 0;
+      break;
+
+    case TNC_STX:
+      if (p->state == TNC_SOH) {
+
+        p->cnt = 0;
+        p->state = TNC_STX;
+      }
+      else {
+        p->state = 0;
+      }
+      break;
+
+    case TNC_ETX:
+      if (p->state == TNC_STX) {
+
+        p->cnt = 0;
+        p->crc_tx = 0;
+        p->state = TNC_ETX;
+      }
+      else {
+        p->state = 0;
+      }
+      break;
+
+    case TNC_EOT:
+      if (p->state == TNC_ETX) {
+
+        p->state = TNC_EOT;
+        if (p->crc_rx != p->crc_tx) {
+          return prviSetError (p, TNC_CRC_ERROR);
+        }
+      }
+      else {
+        p->state = 0;
+      }
+      break;
+
+    default:
+      if (isxdigit (c)) {
+
+        // Digit hexa
+        switch (p->state) {
+
+          case TNC_STX:
+            p->crc_rx = usCrcCcittUpdate (c, p->crc_rx);
+            if (p->cnt++ & 1) {
+              // LSB
+              p->rxbuf[p->len++] = p->msb + htoi (c);
+            }
+            else {
+              // MSB
+              p->msb = htoi (c) << 4;
+            }
+            break;
+
+          case TNC_ETX:
+            if (p->cnt <= 12) {
+
+              p->crc_tx += ( (uint16_t) htoi (c)) << (12 - p->cnt);
+              p->cnt += 4;
+            }
+            else {
+
+              // Plus de 4 octets de CRC reçu
+              p->state = TNC_ILLEGAL_MSG;
+            }
+            break;
+
+          default:
+            // Digit hexa en dehors d'une trame, on ignore
+            p->state = 0;
+            break;
+        }
+      }
+      break;
+
+  }
+  return p->state;
+}
+
 // -----------------------------------------------------------------------------
 int
 iTncPoll (xTnc *p) {
@@ -217,96 +312,92 @@ iTncPoll (xTnc *p) {
         }
         if (count > 0) {
 
-          switch (c) {
-
-            case TNC_SOH:
-              p->crc_rx = CRC_CCITT_INIT_VAL;
-              p->state = TNC_SOH;
-              p->len = 0;
-              break;
+          if (prviParse (p, c) == TNC_CRC_ERROR) {
 
-            case TNC_STX:
-              if (p->state == TNC_SOH) {
+            return TNC_CRC_ERROR;
+          }
+        }
+      }
+      while ( (count > 0) && (p->state != TNC_EOT));
+    }
+  }
+  return p->state;
+}
 
-                p->cnt = 0;
-                p->state = TNC_STX;
-              }
-              else {
-                p->state = 0;
-              }
-              break;
+// -----------------------------------------------------------------------------
+int
+iTncFeed (xTnc *p, const void *buf, size_t count, vTncFrameCb cb, void *udata) {
+  const uint8_t *c = (const uint8_t *) buf;
+  int frames = 0;
 
-            case TNC_ETX:
-              if (p->state == TNC_STX) {
+  if (!p) {
 
-                p->cnt = 0;
-                p->crc_tx = 0;
-                p->state = TNC_ETX;
-              }
-              else {
-                p->state = 0;
-              }
-              break;
+    return prviSetError (p, TNC_OBJECT_NOT_FOUND);
+  }
 
-            case TNC_EOT:
-              if (p->state == TNC_ETX) {
+  for (size_t i = 0; i < count; i++) {
 
-                p->state = TNC_EOT;
-                if (p->crc_rx != p->crc_tx) {
-                  return prviSetError (p, TNC_CRC_ERROR);
-                }
-              }
-              else {
-                p->state = 0;
-              }
-              break;
-
-            default:
-              if (isxdigit (c)) {
-
-                // Digit hexa
-                switch (p->state) {
-
-                  case TNC_STX:
-                    p->crc_rx = usCrcCcittUpdate (c, p->crc_rx);
-                    if (p->cnt++ & 1) {
-                      // LSB
-                      p->rxbuf[p->len++] = p->msb + htoi (c);
-                    }
-                    else {
-                      // MSB
-                      p->msb = htoi (c) << 4;
-                    }
-                    break;
-
-                  case TNC_ETX:
-                    if (p->cnt <= 12) {
-
-                      p->crc_tx += ( (uint16_t) htoi (c)) << (12 - p->cnt);
-                      p->cnt += 4;
-                    }
-                    else {
-
-                      // Plus de 4 octets de CRC reçu
-                      p->state = TNC_ILLEGAL_MSG;
-                    }
-                    break;
-
-                  default:
-                    // Digit hexa en dehors d'une trame, on ignore
-                    p->state = 0;
-                    break;
-                }
-              }
-              break;
+    if (p->state == TNC_EOT) {
+      p->state = 0;
+    }
+    if (prviParse (p, c[i]) == TNC_EOT) {
 
-          }
-        }
+      frames++;
+      if (cb) {
+        cb (p, udata);
       }
-      while ( (count > 0) && (p->state != TNC_EOT));
     }
   }
-  return p->state;
+  return frames;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviReactorCb (int fd, const uint8_t *buf, size_t len, void *udata) {
+  xTnc *p = (xTnc *) udata;
+
+  (void) fd;
+  if (buf) {
+
+    (void) iTncFeed (p, buf, len, p->rxcb, p->udata);
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncAttachReactor (xTnc *p, xSerialReactor *r, vTncFrameCb cb, void *udata) {
+
+  if (!p) {
+
+    return prviSetError (p, TNC_OBJECT_NOT_FOUND);
+  }
+  if (p->fin < 0) {
+
+    return prviSetError (p, TNC_FILE_NOT_FOUND);
+  }
+  p->rxcb = cb;
+  p->udata = udata;
+  if (iSerialReactorAdd (r, p->fin, 0, prviReactorCb, p) < 0) {
+
+    return prviSetError (p, TNC_IO_ERROR);
+  }
+  return prviSetError (p, TNC_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncDetachReactor (xTnc *p, xSerialReactor *r) {
+
+  if (!p) {
+
+    return prviSetError (p, TNC_OBJECT_NOT_FOUND);
+  }
+  if (iSerialReactorRemove (r, p->fin) < 0) {
+
+    return prviSetError (p, TNC_IO_ERROR);
+  }
+  return prviSetError (p, TNC_SUCCESS);
 }
 
 // -----------------------------------------------------------------------------
@@ -403,6 +494,20 @@ iTncWrite (xTnc *p, const void *buf, size_t count) {
         i = write (p->fout, &c, 1);
         if (i < 0) {
 
+          if (errno == EINTR) {
+
+            i = 0;
+            continue;
+          }
+          if (errno == EAGAIN) {
+            // port en mode non bloquant (réacteur), attente de place dans le
+            // tampon d'émission
+            struct pollfd pfd = { .fd = p->fout, .events = POLLOUT };
+
+            (void) poll (&pfd, 1, -1);
+            i = 0;
+            continue;
+          }
           perror ("write: ");
           return prviSetError (p, TNC_IO_ERROR);
         }
@@ -183,13 +183,13 @@ vPrintAllBanks (const xGpio * gp) {
 #endif
 
 // -----------------------------------------------------------------------------
-static xBank *
-pxGetPinBank (int * mcupin, const xGpio * gp) {
+// Indice du port d'une broche, mcupin est remplacé par son numéro dans le port
+static int
+iGetPinBankIndex (int * mcupin) {
   const int list[] = { 22, 0, 17, 18, 16, 7, 14, 12, -1 };
   const int *p = list;
   int bkindex = 0;
   int ng = *mcupin;
-  xBank * bank = NULL;
 
   while ( (*p >= 0) && (ng >= *p)) {
 
@@ -204,10 +204,16 @@ pxGetPinBank (int * mcupin, const xGpio * gp) {
   if (bkindex < 8) {
 
     *mcupin = ng;
-    bank = pxGetBank (bkindex, gp);
   }
+  return bkindex;
+}
 
-  return bank;
+// -----------------------------------------------------------------------------
+static xBank *
+pxGetPinBank (int * mcupin, const xGpio * gp) {
+  int bkindex = iGetPinBankIndex (mcupin);
+
+  return bkindex < 8 ? pxGetBank (bkindex, gp) : NULL;
 }
 
 // -----------------------------------------------------------------------------
@@ -546,6 +552,21 @@ iArchGpioRead (int g, xGpio * gp) {
   return -1;
 }
 
+// -----------------------------------------------------------------------------
+int
+iArchGpioLine (int g, char * chip, size_t size, unsigned * offset) {
+  int bkindex = iGetPinBankIndex (&g);
+
+  // PIO1 (PA à PG): 32 lignes par port, PIO2 (PL): lignes à partir de 0
+  if ( (bkindex < 8) &&
+       (iGpioFindChip (bkindex < 7 ? "1c20800.pinctrl" : "1f02c00.pinctrl", chip, size) == 0)) {
+
+    *offset = (bkindex < 7 ? bkindex * 32 : 0) + g;
+    return 0;
+  }
+  return -1;
+}
+
 // -----------------------------------------------------------------------------
 int
 iArchGpioToggle (int g, xGpio * gp) {
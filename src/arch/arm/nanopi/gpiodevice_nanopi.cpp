@@ -9,6 +9,7 @@
 #include <exception>
 #include <sysio/gpio.h>
 #include <sysio/clock.h>
+#include "gpio/gpiochardev.h"
 #include "gpiodevice_nanopi.h"
 
 namespace Sysio {
@@ -63,7 +64,7 @@ namespace Sysio {
 // -----------------------------------------------------------------------------
   unsigned int 
   DeviceNanoPi::flags() const {
-    return  hasPullRead | hasToggle;
+    return  hasPullRead | hasToggle | hasPortAccess | hasPullMask | hasSnapshot;
   }
   
 // -----------------------------------------------------------------------------
@@ -122,17 +123,21 @@ namespace Sysio {
 // -----------------------------------------------------------------------------
   Pin::Mode
   DeviceNanoPi::mode (const Pin * pin) const {
-    Pin::Mode ret;
     PioBank * b;
-    int i, r, m;
+    int i, r;
     int g = pin->mcuNumber();
     int f = g;
 
     b = pinBank (&f);
     r = f >> 3;
     i = (f - (r * 8)) * 4;
-    m = b->CFG[r] >> i & 7;
-    ret = _int2mode.at (m);
+    return decodeMode (g, b->CFG[r] >> i & 7);
+  }
+
+// -----------------------------------------------------------------------------
+  Pin::Mode
+  DeviceNanoPi::decodeMode (int g, unsigned int m) {
+    Pin::Mode ret = _int2mode.at (m);
 
     // PA5: PWM0 FUNC3-> UART0 !,  PA6: PWM1 FUNC3, PL10: S_PWM FUNC2
     if ( ( (ret == Pin::ModeAlt3) && ( (g == 5) || (g == 6))) ||
@@ -178,13 +183,18 @@ namespace Sysio {
   Pin::Pull
   DeviceNanoPi::pull (const Pin * pin) const {
     PioBank * b;
-    int i, r, v;
+    int i, r;
     int g = pin->mcuNumber();
 
     b = pinBank (&g);
     r = g >> 4;
     i = (g - (r * 16)) * 2;
-    v = b->PUL[r] >> i & 3;
+    return decodePull (b->PUL[r] >> i & 3);
+  }
+
+// -----------------------------------------------------------------------------
+  Pin::Pull
+  DeviceNanoPi::decodePull (unsigned int v) {
     /*
       00: Pull-up/down disable
       10: Pull-down
@@ -207,18 +217,25 @@ namespace Sysio {
 // -----------------------------------------------------------------------------
   void
   DeviceNanoPi::setPull (const Pin * pin, Pin::Pull p) {
+    unsigned int bk, bit;
+
+    pinBit (pin, bk, bit);
+    setPullMask (bk, 1U << bit, p);
+  }
+
+// -----------------------------------------------------------------------------
+  // Les broches d'un banc sont modifiées ensemble, avec une seule paire
+  // d'attentes pour tout le banc
+  void
+  DeviceNanoPi::setPullMask (unsigned int bkindex, uint32_t mask, Pin::Pull p) {
     PioBank * b;
-    int v = -1;
-    int g = pin->mcuNumber();
-    int f = g;
+    uint32_t clr[2] = {0, 0}, set[2] = {0, 0};
+    uint32_t v;
 
-    b = pinBank (&f);
-    /*
-      00: Pull-up/down disable
-      10: Pull-down
-      01: Pull-up
-      11: Reserved
-    */
+    if ( (bkindex >= banks()) || (bkindex == 1)) {
+
+      throw std::out_of_range ("Bad Allwinner H3/H5 PIO bank index");
+    }
     switch (p) {
       case Pin::PullOff:
         v = 0;
@@ -230,20 +247,32 @@ namespace Sysio {
         v = 1;
         break;
       default:
-        break;
+        return;
+    }
+
+    for (int g = 0; g < 32; g++) {
+
+      if (mask & (1U << g)) {
+        int r = g >> 4;
+        int i = (g - (r * 16)) * 2;
+
+        clr[r] |= 0b11 << i;
+        set[r] |= v << i;
+      }
     }
 
-    if (v >= 0) {
-      int i, r;
+    b = bank (bkindex);
+    for (int r = 0; r < 2; r++) {
+
+      b->PUL[r] &= ~clr[r]; // clear config -> disable
+    }
+    Clock::delayMicroseconds (10);
+    for (int r = 0; r < 2; r++) {
 
-      r = f >> 4;
-      i = (f - (r * 16)) * 2;
-      b->PUL[r] &= ~ (0b11 << i); // clear config -> disable
-      Clock::delayMicroseconds (10);
-      b->PUL[r] |= (v << i);
-      Clock::delayMicroseconds (10);
-      debugPrintBank (b);
+      b->PUL[r] |= set[r];
     }
+    Clock::delayMicroseconds (10);
+    debugPrintBank (b);
   }
 
 // -----------------------------------------------------------------------------
@@ -285,6 +314,121 @@ namespace Sysio {
     return b->DAT & (1 << g) ? true : false;
   }
 
+// -----------------------------------------------------------------------------
+  // Les registres d'un banc sont lus une seule fois, lors de la première
+  // broche du banc rencontrée
+  void
+  DeviceNanoPi::snapshot (GpioState & state) const {
+    class BankRegs {
+      public:
+        uint32_t cfg[4];
+        uint32_t dat;
+        uint32_t pul[2];
+    };
+    std::map<unsigned int, BankRegs> regs;
+
+    for (auto & p : state.pin) {
+      int f = p.first;
+      unsigned int bk = pinBankIndex (&f);
+      auto it = regs.find (bk);
+
+      if (it == regs.end()) {
+        PioBank * b = bank (bk);
+        BankRegs r;
+
+        for (int i = 0; i < 4; i++) {
+
+          r.cfg[i] = b->CFG[i];
+        }
+        r.dat = b->DAT;
+        r.pul[0] = b->PUL[0];
+        r.pul[1] = b->PUL[1];
+        it = regs.insert (std::make_pair (bk, r)).first;
+      }
+
+      const BankRegs & r = it->second;
+      p.second.mode = decodeMode (p.first, r.cfg[f >> 3] >> ( (f & 7) * 4) & 7);
+      p.second.pull = decodePull (r.pul[f >> 4] >> ( (f & 15) * 2) & 3);
+      p.second.value = (r.dat & (1 << f)) != 0;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  unsigned int
+  DeviceNanoPi::banks() const {
+
+    return 8; // PA à PG puis PL, PB n'existe pas
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceNanoPi::pinBit (const Pin * pin, unsigned int & bank, unsigned int & bit) const {
+    int g = pin->mcuNumber();
+
+    bank = pinBankIndex (&g);
+    bit = g;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceNanoPi::writeMask (unsigned int bkindex, uint32_t setMask, uint32_t clrMask) {
+    PioBank * b;
+
+    if ( (bkindex >= banks()) || (bkindex == 1)) {
+
+      throw std::out_of_range ("Bad Allwinner H3/H5 PIO bank index");
+    }
+    // Une seule écriture du registre DAT pour toutes les broches du banc
+    b = bank (bkindex);
+    b->DAT = (b->DAT & ~clrMask) | setMask;
+    debugPrintBank (b);
+  }
+
+// -----------------------------------------------------------------------------
+  uint32_t
+  DeviceNanoPi::readBank (unsigned int bkindex) const {
+
+    if ( (bkindex >= banks()) || (bkindex == 1)) {
+
+      throw std::out_of_range ("Bad Allwinner H3/H5 PIO bank index");
+    }
+    return bank (bkindex)->DAT;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceNanoPi::fastRegisters (const Pin * pin, FastPinRegisters & r) const {
+    int f = pin->mcuNumber();
+    // PioBank est compacté, les registres sont adressés par leur rang
+    void * base = pinBank (&f);
+    volatile uint32_t * b = static_cast<volatile uint32_t *> (base);
+    int i = (f % 8) * 4;
+
+    r.set = r.clr = r.lev = b + 4; // DAT
+    r.cfg = b + (f >> 3); // CFG[n]
+    r.mask = 1U << f;
+    r.cfgMask = 0b1111 << i;
+    r.cfgOutput = _mode2int.at (Pin::ModeOutput) << i;
+    r.setClear = false;
+    r.inputLevel = true;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceNanoPi::charDevLine (const Pin * pin, std::string & chip, unsigned int & offset) const {
+    int g = pin->mcuNumber();
+    unsigned int bkindex = pinBankIndex (&g);
+
+    // PIO1 (PA à PG): 32 lignes par port, PIO2 (PL): lignes à partir de 0
+    chip = LineRequest::findChip (bkindex < 7 ? "1c20800.pinctrl" : "1f02c00.pinctrl");
+    if (!chip.empty()) {
+
+      offset = (bkindex < 7 ? bkindex * 32 : 0) + g;
+      return;
+    }
+    Device::charDevLine (pin, chip, offset);
+  }
+
 // -----------------------------------------------------------------------------
   const std::map<Pin::Mode, std::string> &
   DeviceNanoPi::modes() const {
@@ -368,9 +512,8 @@ namespace Sysio {
   }
 
 // -----------------------------------------------------------------------------
-  PioBank *
-  DeviceNanoPi::pinBank (int * mcupin) const {
-    PioBank * bk = nullptr;
+  unsigned int
+  DeviceNanoPi::pinBankIndex (int * mcupin) const {
     const int * p = _portSize;
     unsigned int bkindex = 0;
     int ng = *mcupin;
@@ -385,20 +528,27 @@ namespace Sysio {
       while (bkindex == 1);   // saute PortB
     }
 
-    if (bkindex < 8) {
-
-      *mcupin = ng;
-      bk = bank (bkindex);
-      if (isDebug()) {
+    if (bkindex >= 8) {
 
-        char c = (bkindex < 7 ? 'A' + bkindex : 'L');
-        std::cout << "---Port " << c << "---" << std::endl;
-        debugPrintBank (bk);
-      }
+      throw std::out_of_range ("Unable to find Allwinner H3/H5 PIO registers bank");
     }
-    else {
 
-      throw std::out_of_range ("Unable to find Allwinner H3/H5 PIO registers bank");
+    *mcupin = ng;
+    return bkindex;
+  }
+
+// -----------------------------------------------------------------------------
+  PioBank *
+  DeviceNanoPi::pinBank (int * mcupin) const {
+    PioBank * bk;
+    unsigned int bkindex = pinBankIndex (mcupin);
+
+    bk = bank (bkindex);
+    if (isDebug()) {
+
+      char c = (bkindex < 7 ? 'A' + bkindex : 'L');
+      std::cout << "---Port " << c << "---" << std::endl;
+      debugPrintBank (bk);
     }
 
     return bk;
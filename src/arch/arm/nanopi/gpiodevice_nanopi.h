@@ -44,6 +44,15 @@ namespace Sysio {
 
       const std::map<Pin::Mode, std::string> & modes() const;
 
+      unsigned int banks() const;
+      void pinBit (const Pin * pin, unsigned int & bank, unsigned int & bit) const;
+      void writeMask (unsigned int bank, uint32_t setMask, uint32_t clrMask);
+      uint32_t readBank (unsigned int bank) const;
+      void setPullMask (unsigned int bank, uint32_t mask, Pin::Pull p);
+      void snapshot (GpioState & state) const;
+      void fastRegisters (const Pin * pin, FastPinRegisters & r) const;
+      void charDevLine (const Pin * pin, std::string & chip, unsigned int & offset) const;
+
     private:
       xIoMap * iomap[2];
       const Gpio::Descriptor * _gpioDescriptor;
@@ -63,8 +72,11 @@ namespace Sysio {
 
       void debugPrintBank (const PioBank * b) const;
       void debugPrintAllBanks () const;
+      unsigned int pinBankIndex (int * mcupin) const;
       struct PioBank * pinBank (int * mcupin) const;
       struct PioBank * bank (unsigned int bkindex) const;
+      static Pin::Mode decodeMode (int g, unsigned int m);
+      static Pin::Pull decodePull (unsigned int v);
   };
 }
 /* ========================================================================== */
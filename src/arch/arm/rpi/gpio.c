@@ -220,7 +220,7 @@ xGpioOpen (UNUSED_VAR (void *, setup)) {
 
     (void) iGpioSetNumbering (eNumberingLogical, gp);
 
-    gp->map[0] = xIoMapOpen (GPIO_BASE (ulRpiIoBase()), BCM270X_BLOCK_SIZE);
+    gp->map[0] = xIoMapOpenGpio (GPIO_BASE (ulRpiIoBase()), BCM270X_BLOCK_SIZE);
     if (gp->map[0]) {
 
       // Lecture des modes actuels
@@ -443,6 +443,25 @@ iArchGpioRead (int g, xGpio * gp) {
   return iValue;
 }
 
+// -----------------------------------------------------------------------------
+int
+iArchGpioLine (int g, char * chip, size_t size, unsigned * offset) {
+  static const char * labels[] = { "pinctrl-bcm2835", "pinctrl-bcm2711", NULL };
+
+  // Les lignes du contrôleur du SOC sont numérotées comme les broches BCM
+  for (const char ** l = labels; *l; l++) {
+
+    if (iGpioFindChip (*l, chip, size) == 0) {
+
+      *offset = g;
+      return 0;
+    }
+  }
+  snprintf (chip, size, "/dev/gpiochip0");
+  *offset = g;
+  return 0;
+}
+
 // -----------------------------------------------------------------------------
 int
 iArchGpioToggle (int g, xGpio * gp) {
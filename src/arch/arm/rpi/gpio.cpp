@@ -5,6 +5,7 @@
  * This software is governed by the CeCILL license <http://www.cecill.info>
  */
 #include <sysio/gpio.h>
+#include "gpio/gpiodevice_sim.h"
 #include "gpiodevice_bcm2835.h"
 
 namespace Sysio {
@@ -16,7 +17,13 @@ namespace Sysio {
 // -----------------------------------------------------------------------------
 
 // -----------------------------------------------------------------------------
-  Gpio::Gpio (AccessLayer layer) : Gpio (new DeviceBcm2835(), layer) {
+  Gpio::Gpio (AccessLayer layer) : Gpio (layer, DeviceSim::isEnabled()) {
+
+  }
+
+// -----------------------------------------------------------------------------
+  Gpio::Gpio (AccessLayer layer, bool simulated) :
+    Gpio (simulated ? static_cast<Device *> (new DeviceSim()) : new DeviceBcm2835(), layer) {
 
   }
 }
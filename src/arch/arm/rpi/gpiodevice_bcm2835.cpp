@@ -9,6 +9,7 @@
 #include <exception>
 #include <sysio/gpio.h>
 #include <sysio/clock.h>
+#include "gpio/gpiochardev.h"
 #include "gpiodevice_bcm2835.h"
 
 namespace Sysio {
@@ -45,7 +46,7 @@ namespace Sysio {
 // -----------------------------------------------------------------------------
   unsigned int 
   DeviceBcm2835::flags() const {
-    return  hasAltRead;
+    return  hasAltRead | hasPortAccess | hasPullMask | hasSnapshot;
   }
 
 // -----------------------------------------------------------------------------
@@ -60,7 +61,7 @@ namespace Sysio {
 
     if (!isOpen()) {
 
-      _iomap = xIoMapOpen (_piobase, MapBlockSize);
+      _iomap = xIoMapOpenGpio (_piobase, MapBlockSize);
       if (_iomap) {
 
         setOpen (true);
@@ -86,13 +87,18 @@ namespace Sysio {
 // -----------------------------------------------------------------------------
   Pin::Mode
   DeviceBcm2835::mode (const Pin * pin) const {
-    Pin::Mode m;
     int g;
     unsigned int r;
 
     g = pin->mcuNumber();
     r = readReg (GFPSEL0 + g / 10) >> ( (g % 10) * 3) & 7;
-    m = _int2mode.at (r);
+    return decodeMode (g, r);
+  }
+
+// -----------------------------------------------------------------------------
+  Pin::Mode
+  DeviceBcm2835::decodeMode (int g, unsigned int r) {
+    Pin::Mode m = _int2mode.at (r);
     /*
      *  - BCM12 ALT0 -> PWM0
      *  - BCM13 ALT0 -> PWM1
@@ -144,15 +150,22 @@ namespace Sysio {
 // -----------------------------------------------------------------------------
   void
   DeviceBcm2835::setPull (const Pin * pin, Pin::Pull p) {
-    unsigned int pval, pclk = GPPUDCLK0;
     int g = pin->mcuNumber();
 
-    if (g > 31) {
+    setPullMask (g / 32, 1 << (g % 32), p);
+  }
 
-      pclk++;
-      g -= 32;
-    }
+// -----------------------------------------------------------------------------
+  // La séquence GPPUD/GPPUDCLKn modifie en une fois toutes les broches dont
+  // le bit est à 1 dans GPPUDCLKn
+  void
+  DeviceBcm2835::setPullMask (unsigned int bank, uint32_t mask, Pin::Pull p) {
+    unsigned int pval;
 
+    if (bank >= banks()) {
+
+      throw std::out_of_range ("Bad BCM2835 GPIO bank index");
+    }
     /*
       PUD - GPIO Pin Pull-up/down
       00 = Off – disable pull-up/down
@@ -187,10 +200,34 @@ namespace Sysio {
      */
     writeReg (GPPUD, pval);
     Clock::delayMicroseconds (10);
-    writeReg (pclk, 1 << g);
+    writeReg (GPPUDCLK0 + bank, mask);
     Clock::delayMicroseconds (10);
     writeReg (GPPUD, 0);
-    writeReg (pclk, 0);
+    writeReg (GPPUDCLK0 + bank, 0);
+  }
+
+// -----------------------------------------------------------------------------
+  // Chaque registre GPFSELn et GPLEVn n'est lu qu'une fois, la résistance de
+  // tirage ne peut pas être lue sur le BCM2835
+  void
+  DeviceBcm2835::snapshot (GpioState & state) const {
+    uint32_t fsel[GFPSEL5 - GFPSEL0 + 1];
+    uint32_t lev[2];
+
+    for (unsigned int i = 0; i <= GFPSEL5 - GFPSEL0; i++) {
+
+      fsel[i] = readReg (GFPSEL0 + i);
+    }
+    lev[0] = readReg (GPLEV0);
+    lev[1] = readReg (GPLEV1);
+
+    for (auto & p : state.pin) {
+      int g = p.first;
+
+      p.second.mode = decodeMode (g, fsel[g / 10] >> ( (g % 10) * 3) & 7);
+      p.second.pull = Pin::PullUnknown;
+      p.second.value = (lev[g / BankSize] & (1 << (g % BankSize))) != 0;
+    }
   }
 
 // -----------------------------------------------------------------------------
@@ -222,6 +259,87 @@ namespace Sysio {
     return (readReg (offset) & (1 << g)) != 0;
   }
 
+// -----------------------------------------------------------------------------
+  unsigned int
+  DeviceBcm2835::banks() const {
+
+    return (GpioSize + BankSize - 1) / BankSize;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceBcm2835::pinBit (const Pin * pin, unsigned int & bank, unsigned int & bit) const {
+    int g = pin->mcuNumber();
+
+    bank = g / BankSize;
+    bit = g % BankSize;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceBcm2835::writeMask (unsigned int bank, uint32_t setMask, uint32_t clrMask) {
+
+    if (bank >= banks()) {
+
+      throw std::out_of_range ("Bad BCM2835 GPIO bank index");
+    }
+    // GPSETn et GPCLRn n'agissent que sur les bits à 1, les autres broches
+    // du banc ne sont pas modifiées.
+    if (setMask) {
+
+      writeReg (GPSET0 + bank, setMask);
+    }
+    if (clrMask) {
+
+      writeReg (GPCLR0 + bank, clrMask);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  uint32_t
+  DeviceBcm2835::readBank (unsigned int bank) const {
+
+    if (bank >= banks()) {
+
+      throw std::out_of_range ("Bad BCM2835 GPIO bank index");
+    }
+    return readReg (GPLEV0 + bank);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceBcm2835::fastRegisters (const Pin * pin, FastPinRegisters & r) const {
+    int g = pin->mcuNumber();
+    unsigned int bank = g / BankSize;
+
+    r.set = pIo (_iomap, GPSET0 + bank);
+    r.clr = pIo (_iomap, GPCLR0 + bank);
+    r.lev = pIo (_iomap, GPLEV0 + bank);
+    r.cfg = pIo (_iomap, GFPSEL0 + g / 10);
+    r.mask = 1U << (g % BankSize);
+    r.cfgMask = 7 << ( (g % 10) * 3);
+    r.cfgOutput = _mode2int.at (Pin::ModeOutput) << ( (g % 10) * 3);
+    r.setClear = true;
+    r.inputLevel = true;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceBcm2835::charDevLine (const Pin * pin, std::string & chip, unsigned int & offset) const {
+
+    // Les lignes du contrôleur du SOC sont numérotées comme les broches BCM
+    for (const auto & label : {"pinctrl-bcm2835", "pinctrl-bcm2711"}) {
+
+      chip = LineRequest::findChip (label);
+      if (!chip.empty()) {
+
+        offset = pin->mcuNumber();
+        return;
+      }
+    }
+    Device::charDevLine (pin, chip, offset);
+  }
+
 // -----------------------------------------------------------------------------
   const std::map<Pin::Mode, std::string> &
   DeviceBcm2835::modes() const {
@@ -41,6 +41,15 @@ namespace Sysio {
 
       const std::map<Pin::Mode, std::string> & modes() const;
 
+      unsigned int banks() const;
+      void pinBit (const Pin * pin, unsigned int & bank, unsigned int & bit) const;
+      void writeMask (unsigned int bank, uint32_t setMask, uint32_t clrMask);
+      uint32_t readBank (unsigned int bank) const;
+      void setPullMask (unsigned int bank, uint32_t mask, Pin::Pull p);
+      void snapshot (GpioState & state) const;
+      void fastRegisters (const Pin * pin, FastPinRegisters & r) const;
+      void charDevLine (const Pin * pin, std::string & chip, unsigned int & offset) const;
+
     private:
       unsigned long _piobase;
       xIoMap * _iomap;
@@ -54,6 +63,8 @@ namespace Sysio {
         *pIo (_iomap, offset) = value;
       }
 
+      static Pin::Mode decodeMode (int g, unsigned int r);
+
       static const std::map<eRpiMcu, unsigned long> _iobase;
       static const std::map<unsigned int, Pin::Mode> _int2mode;
       static const std::map<Pin::Mode, unsigned int> _mode2int;
@@ -61,6 +72,7 @@ namespace Sysio {
       static const std::map<Pin::Mode, std::string> _modes;
 
       static const unsigned int  GpioSize     = 54;
+      static const unsigned int  BankSize     = 32;
       static const unsigned long Bcm2708Base  = BCM2708_IO_BASE;
       static const unsigned long Bcm2709Base  = BCM2709_IO_BASE;
       static const unsigned long Bcm2710Base  = BCM2709_IO_BASE;
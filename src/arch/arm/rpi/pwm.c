@@ -284,6 +284,8 @@ iPwmSetClockDiv (int div) {
   preg(PWM_CTL) = 0; // Stop PWM
   delay_us (10);
 
+  // changement de périphérique (PWM -> horloges)
+  vIoMapWriteBarrier();
   creg(PWMCLK_CNTL) = PASSWD | KILL;
   delay_us (10);
 
@@ -293,6 +295,7 @@ iPwmSetClockDiv (int div) {
   // enable clock
   creg(PWMCLK_CNTL) = PASSWD | ENAB | SRC_OSC;
 
+  vIoMapWriteBarrier();
   preg(PWM_CTL) = backupctl;
 
   return div;
@@ -307,6 +310,7 @@ iPwmClockDiv (void) {
   }
 
   int div = (creg(PWMCLK_DIV) >> 12);
+  vIoMapReadBarrier(); // les accès suivants peuvent concerner le PWM
   return div;
 }
 
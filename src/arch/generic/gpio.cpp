@@ -0,0 +1,30 @@
+/*
+ * arch/generic/gpio.cpp
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/gpio.h>
+#include "gpio/gpiodevice_sim.h"
+
+namespace Sysio {
+
+// -----------------------------------------------------------------------------
+//
+//                           Gpio Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  Gpio::Gpio (AccessLayer layer) : Gpio (layer, true) {
+
+  }
+
+// -----------------------------------------------------------------------------
+  // Linux générique : pas de GPIO matériel, seul le GPIO simulé est disponible
+  Gpio::Gpio (AccessLayer layer, bool /* simulated */) :
+    Gpio (new DeviceSim(), layer) {
+
+  }
+}
+/* ========================================================================== */
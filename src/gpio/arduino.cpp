@@ -10,7 +10,13 @@
 #include <iostream>
 #include <csignal>
 #include <cstdlib>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <sysio/arduino.h>
+//
+#include <time.h>
 
 using namespace Sysio;
 using namespace std;
@@ -20,9 +26,148 @@ namespace Arduino {
   Clock * clk;
   Gpio *  gpio;
 
+  // Broche et registres mémorisés pour chaque numéro, évite la recherche
+  // dans Gpio::pin() et les appels virtuels
+  class Handle {
+    public:
+      Pin * pin;
+      FastPinRegisters reg;
+      bool fast; // reg est valide (AccessLayerIoMap)
+  };
+  std::vector<Handle> * handle;
+
+  // tone()
+  int tonePin = -1;
+  SoftPwm * tonePwm;
+  std::thread * toneTimer;
+  std::mutex toneMutex;
+  std::condition_variable toneCond;
+  bool toneCancel;
+
+// -----------------------------------------------------------------------------
+  void addHandle (int n, Pin * p) {
+    Handle h;
+
+    h.pin = p;
+    try {
+
+      h.reg = FastPinRegisters::get (*p);
+      h.fast = true;
+    }
+    catch (std::exception & e) {
+
+      h.fast = false;
+    }
+    if (static_cast<size_t> (n) >= handle->size()) {
+
+      handle->resize (n + 1, Handle {nullptr, FastPinRegisters(), false});
+    }
+    (*handle) [n] = h;
+  }
+
+// -----------------------------------------------------------------------------
+  void initHandles () {
+
+    handle = new std::vector<Handle>;
+    for (const auto & p : gpio->pin()) {
+
+      if (p.first >= 0) {
+
+        addHandle (p.first, p.second.get());
+      }
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  // Une broche absente du cache est recherchée dans Gpio::pin(), qui
+  // déclenche std::out_of_range si elle n'existe pas
+  inline Handle & pinHandle (int n) {
+
+    if (n < 0) {
+
+      throw std::out_of_range ("Arduino pin " + std::to_string (n) + " does not exist");
+    }
+    if ( (static_cast<size_t> (n) >= handle->size()) || ! (*handle) [n].pin) {
+
+      addHandle (n, &gpio->pin (n));
+    }
+    return (*handle) [n];
+  }
+
+// -----------------------------------------------------------------------------
+  inline void write (const Handle & h, bool v) {
+
+    if (h.fast) {
+
+      if (h.reg.setClear) {
+
+        * (v ? h.reg.set : h.reg.clr) = h.reg.mask;
+      }
+      else if (v) {
+
+        *h.reg.set |= h.reg.mask;
+      }
+      else {
+
+        *h.reg.clr &= ~h.reg.mask;
+      }
+    }
+    else {
+
+      h.pin->write (v);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  inline bool read (const Handle & h) {
+
+    if (h.fast) {
+
+      return (*h.reg.lev & h.reg.mask) != 0;
+    }
+    return h.pin->read();
+  }
+
+// -----------------------------------------------------------------------------
+  inline uint64_t nanos() {
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  }
+
+// -----------------------------------------------------------------------------
+  void stopTone () {
+
+    {
+      std::lock_guard<std::mutex> lock (toneMutex);
+      toneCancel = true;
+    }
+    toneCond.notify_all();
+    if (toneTimer) {
+
+      toneTimer->join();
+      delete toneTimer;
+      toneTimer = 0;
+    }
+    if (tonePwm) {
+
+      delete tonePwm;
+      tonePwm = 0;
+    }
+    tonePin = -1;
+  }
+
 // -----------------------------------------------------------------------------
   void closeall () {
 
+    stopTone();
+    if (handle) {
+
+      delete handle;
+      handle = 0;
+    }
+
     if (gpio) {
 
       gpio->close();
@@ -55,6 +200,7 @@ namespace Arduino {
     gpio = new Gpio;
     clk = new Clock;
     gpio->open();
+    initHandles();
     // sighandler() intercepts CTRL+C
     signal (SIGINT, sighandler);
     signal (SIGTERM, sighandler);
@@ -83,38 +229,163 @@ void pinMode (int n, ArduinoPinMode mode) {
     }
   }
 
-  Arduino::gpio->pin (n).setMode (m);
-  Arduino::gpio->pin (n).setPull (p);
+  Pin * pin = Arduino::pinHandle (n).pin;
+
+  pin->setMode (m);
+  pin->setPull (p);
+  // le mode peut changer la validité des registres mémorisés
+  Arduino::addHandle (n, pin);
 }
 
 // -----------------------------------------------------------------------------
 void digitalWrite (int n, int value) {
 
-  Arduino::gpio->pin (n).write (value);
+  Arduino::write (Arduino::pinHandle (n), value);
 }
 
 // -----------------------------------------------------------------------------
 void digitalToggle (int n) {
 
-  Arduino::gpio->pin (n).toggle ();
+  Arduino::pinHandle (n).pin->toggle ();
 }
 
 // -----------------------------------------------------------------------------
 int digitalRead (int n) {
 
-  return Arduino::gpio->pin (n).read();
+  return Arduino::read (Arduino::pinHandle (n));
+}
+
+// -----------------------------------------------------------------------------
+void shiftOut (int dataPin, int clockPin, int bitOrder, uint8_t value) {
+  const Arduino::Handle & d = Arduino::pinHandle (dataPin);
+  const Arduino::Handle & c = Arduino::pinHandle (clockPin);
+
+  for (int i = 0; i < 8; i++) {
+
+    if (bitOrder == LSBFIRST) {
+
+      Arduino::write (d, value & (1 << i));
+    }
+    else {
+
+      Arduino::write (d, value & (1 << (7 - i)));
+    }
+    Arduino::write (c, true);
+    Arduino::write (c, false);
+  }
+}
+
+// -----------------------------------------------------------------------------
+uint8_t shiftIn (int dataPin, int clockPin, int bitOrder) {
+  const Arduino::Handle & d = Arduino::pinHandle (dataPin);
+  const Arduino::Handle & c = Arduino::pinHandle (clockPin);
+  uint8_t value = 0;
+
+  for (int i = 0; i < 8; i++) {
+
+    Arduino::write (c, true);
+    if (bitOrder == LSBFIRST) {
+
+      value |= Arduino::read (d) << i;
+    }
+    else {
+
+      value |= Arduino::read (d) << (7 - i);
+    }
+    Arduino::write (c, false);
+  }
+  return value;
+}
+
+// -----------------------------------------------------------------------------
+// Les fronts sont datés juste après leur détection, le retard de détection
+// étant le même pour les deux fronts, il n'affecte pas la durée mesurée
+unsigned long pulseIn (int n, int state, unsigned long timeout) {
+  const Arduino::Handle & h = Arduino::pinHandle (n);
+  const bool s = (state != LOW);
+  const uint64_t limit = Arduino::nanos() + timeout * 1000ULL;
+  uint64_t start;
+
+  // fin de l'impulsion en cours
+  while (Arduino::read (h) == s) {
+
+    if (Arduino::nanos() > limit) {
+      return 0;
+    }
+  }
+  // début de l'impulsion
+  while (Arduino::read (h) != s) {
+
+    if (Arduino::nanos() > limit) {
+      return 0;
+    }
+  }
+  start = Arduino::nanos();
+  // fin de l'impulsion
+  while (Arduino::read (h) == s) {
+
+    if (Arduino::nanos() > limit) {
+      return 0;
+    }
+  }
+  return (Arduino::nanos() - start + 500) / 1000;
+}
+
+// -----------------------------------------------------------------------------
+unsigned long pulseInLong (int n, int state, unsigned long timeout) {
+
+  return pulseIn (n, state, timeout);
+}
+
+// -----------------------------------------------------------------------------
+void tone (int n, unsigned int frequency, unsigned long duration) {
+  Pin * p = Arduino::pinHandle (n).pin;
+
+  Arduino::stopTone();
+  Arduino::tonePwm = new SoftPwm;
+  Arduino::tonePwm->add (*p, frequency, 0.5);
+  Arduino::tonePwm->start();
+  Arduino::tonePin = n;
+
+  if (duration) {
+
+    Arduino::toneCancel = false;
+    Arduino::toneTimer = new std::thread ([duration] {
+      std::unique_lock<std::mutex> lock (Arduino::toneMutex);
+
+      if (!Arduino::toneCond.wait_for (lock, std::chrono::milliseconds (duration),
+      [] { return Arduino::toneCancel; })) {
+
+        Arduino::tonePwm->stop();
+      }
+    });
+  }
+}
+
+// -----------------------------------------------------------------------------
+void noTone (int n) {
+
+  if (n == Arduino::tonePin) {
+
+    Arduino::stopTone();
+  }
 }
 
 // -----------------------------------------------------------------------------
 void attachInterrupt (int n, Pin::Isr isr, ArduinoIntEdge mode) {
+  Pin * pin = Arduino::pinHandle (n).pin;
 
-  Arduino::gpio->pin (n).attachInterrupt (isr, static_cast<Pin::Edge> (mode));
+  pin->attachInterrupt (isr, static_cast<Pin::Edge> (mode));
+  // la broche peut être passée par SysFs ou le chardev
+  Arduino::addHandle (n, pin);
 }
 
 // -----------------------------------------------------------------------------
 void detachInterrupt (int n) {
+  Pin * pin = Arduino::pinHandle (n).pin;
 
-  Arduino::gpio->pin (n).detachInterrupt();
+  pin->detachInterrupt();
+  Arduino::addHandle (n, pin);
 }
 
 // -----------------------------------------------------------------------------
@@ -6,13 +6,27 @@
  */
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
 #include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <linux/gpio.h>
 #include <sysio/dinput.h>
 #include <sysio/delay.h>
 #include <sysio/log.h>
+#include <sysio/scheduler.h>
+#include "gpio_private.h"
 
 /* constants ================================================================ */
 #define DINPUT_POLL_DELAY 20
+#define DINPUT_DEBOUNCE_DELAY 20000UL
+#define DINPUT_TIMER_ID (-1)
+#define DINPUT_STOP_ID  (-2)
 static const char sErrorRange[] = "the pin number is out of range";
 static const char sGroupRange[] = "this pin is grouped";
 
@@ -26,6 +40,9 @@ typedef struct xDinCbContext {
   eDinEdge edge_occurred;
   pthread_mutex_t read_mutex;
   pthread_mutex_t write_mutex;
+  int fd;            /* requête /dev/gpiochipN de la ligne, -1 si scrutation */
+  unsigned long debounce; /* délai anti-rebond en µs */
+  uint64_t deadline; /* fin du délai anti-rebond en cours en ns, 0 si aucun */
 } xDinCbContext;
 
 // -----------------------------------------------------------------------------
@@ -39,6 +56,9 @@ typedef struct xDinPort {
   bool run;      /* indique au thread de continuer */
   bool grouped;  /* indique que la gestion est groupée */
   pthread_t thread;
+  int epfd;      /* fronts, timer et arrêt, -1 si scrutation */
+  int timerfd;   /* échéance anti-rebond la plus proche */
+  int stopfd;    /* arrêt du thread */
 } xDinPort;
 
 // -----------------------------------------------------------------------------
@@ -98,12 +118,33 @@ iDinGrpHandler (eDinEdge edge, void *pdata) {
 }
 
 // -----------------------------------------------------------------------------
-// Thread de surveillance des entrées du port
+// Signale un front confirmé de l'entrée p, retourne la valeur du gestionnaire
+static int
+iDinNotify (unsigned p, eDinEdge edge, xDinPort * port) {
+  int ret = 0;
+
+  pthread_mutex_lock (&port->ctx[p].read_mutex);
+  port->ctx[p].edge_occurred = edge & port->ctx[p].edge;
+  pthread_mutex_unlock (&port->ctx[p].read_mutex);
+
+  pthread_mutex_lock (&port->ctx[p].write_mutex);
+  if ( (port->ctx[p].edge & edge) && (port->ctx[p].callback)) {
+    // Le front est valide et le callback est présent
+    ret = port->ctx[p].callback (edge, port->ctx[p].udata);
+  }
+  pthread_mutex_unlock (&port->ctx[p].write_mutex);
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+// Thread de surveillance des entrées du port par scrutation (pas d'accès à
+// /dev/gpiochipN)
 static void *
 pvDinPoll (void * xContext) {
 
   xDinPort *port = (xDinPort *) xContext;
 
+  iSchedulerApplyProfile ("dinput");
   while (port->run) {
     int values = iDinReadAll (port);
 
@@ -122,7 +163,6 @@ pvDinPoll (void * xContext) {
 
           if (diff & mask) {
             // Ce bit a changé
-            int ret;
             eDinEdge edge;
 
             if (values & mask) {
@@ -137,21 +177,7 @@ pvDinPoll (void * xContext) {
             }
             diff &= ~mask;  // clear du bit traité
 
-            pthread_mutex_lock (&port->ctx[p].read_mutex);
-            port->ctx[p].edge_occurred = edge & port->ctx[p].edge;
-            pthread_mutex_unlock (&port->ctx[p].read_mutex);
-
-            pthread_mutex_lock (&port->ctx[p].write_mutex);
-            if ( (port->ctx[p].edge & edge) && (port->ctx[p].callback)) {
-              // Le front est valide et le callback est présent
-              ret = port->ctx[p].callback (edge, port->ctx[p].udata);
-            }
-            else {
-              ret = 0;
-            }
-            pthread_mutex_unlock (&port->ctx[p].write_mutex);
-
-            if (ret != 0) {
+            if (iDinNotify (p, edge, port) != 0) {
 
               port->run = false;
               break;
@@ -168,6 +194,206 @@ pvDinPoll (void * xContext) {
   return NULL;
 }
 
+// -----------------------------------------------------------------------------
+static uint64_t
+ullDinNow (void) {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+// Confirme les entrées dont le délai anti-rebond est écoulé et arme le timer
+// sur la prochaine échéance. Retourne la valeur non nulle d'un gestionnaire.
+static int
+iDinDebounce (xDinPort * port) {
+  struct itimerspec its;
+  uint64_t now = ullDinNow();
+  uint64_t next = 0;
+
+  for (unsigned p = 0; p < port->size; p++) {
+    uint64_t deadline = port->ctx[p].deadline;
+
+    if (deadline == 0) {
+      continue;
+    }
+
+    if (deadline <= now) {
+      int mask = _BV (p);
+      int value = iDinRead (p, port) ? mask : 0;
+
+      port->ctx[p].deadline = 0;
+      if (value != (port->prev_values & mask)) {
+        // l'entrée est stable dans un nouvel état
+        port->prev_values ^= mask;
+        if (iDinNotify (p, value ? eEdgeRising : eEdgeFalling, port) != 0) {
+
+          return -1;
+        }
+      }
+    }
+    else if ( (next == 0) || (deadline < next)) {
+
+      next = deadline;
+    }
+  }
+
+  // échéance absolue, 0 désarme le timer
+  memset (&its, 0, sizeof (its));
+  its.it_value.tv_sec = next / 1000000000ULL;
+  its.it_value.tv_nsec = next % 1000000000ULL;
+  timerfd_settime (port->timerfd, TFD_TIMER_ABSTIME, &its, NULL);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Thread de surveillance des entrées du port par les fronts signalés par le
+// noyau. Chaque front (re)démarre le délai anti-rebond de l'entrée, un seul
+// timer est armé sur l'échéance la plus proche.
+static void *
+pvDinEvents (void * xContext) {
+  xDinPort *port = (xDinPort *) xContext;
+  struct epoll_event events[8];
+
+  iSchedulerApplyProfile ("dinput");
+  // les entrées actives à l'ouverture sont signalées, comme par pvDinPoll()
+  for (unsigned p = 0; p < port->size; p++) {
+
+    port->ctx[p].deadline = 1;
+  }
+  if (iDinDebounce (port) != 0) {
+
+    port->run = false;
+  }
+
+  while (port->run) {
+    int n = epoll_wait (port->epfd, events, 8, -1);
+
+    if (n < 0) {
+
+      if (errno == EINTR) {
+        continue;
+      }
+      PERROR ("epoll_wait: %s", strerror (errno));
+      break;
+    }
+
+    for (int i = 0; i < n; i++) {
+      int id = events[i].data.u32;
+
+      if (id == DINPUT_STOP_ID) {
+
+        return NULL;
+      }
+      else if (id == DINPUT_TIMER_ID) {
+        uint64_t expirations;
+
+        (void) read (port->timerfd, &expirations, sizeof (expirations));
+      }
+      else {
+        struct gpio_v2_line_event ev[16];
+        xDinCbContext * ctx = &port->ctx[id];
+
+        if (read (ctx->fd, ev, sizeof (ev)) > 0) {
+
+          ctx->deadline = ullDinNow() + ctx->debounce * 1000ULL;
+        }
+      }
+    }
+
+    if (iDinDebounce (port) != 0) {
+
+      port->run = false;
+    }
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Requête des fronts de chaque entrée et création des descripteurs du thread
+// pvDinEvents(), retourne -1 si l'interface du noyau n'est pas disponible
+static int
+iDinOpenEvents (xDinPort * port) {
+  struct epoll_event ev;
+
+  port->epfd = epoll_create1 (EPOLL_CLOEXEC);
+  port->timerfd = timerfd_create (CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+  port->stopfd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if ( (port->epfd < 0) || (port->timerfd < 0) || (port->stopfd < 0)) {
+    return -1;
+  }
+
+  for (unsigned p = 0; p < port->size; p++) {
+    struct gpio_v2_line_request req;
+    char chip[64];
+    unsigned offset;
+    int cfd;
+
+    if (iGpioLine (port->pins[p].num, chip, sizeof (chip), &offset, port->gpio) != 0) {
+      return -1;
+    }
+    if ( (cfd = open (chip, O_RDWR | O_CLOEXEC)) < 0) {
+      return -1;
+    }
+
+    memset (&req, 0, sizeof (req));
+    req.offsets[0] = offset;
+    req.num_lines = 1;
+    strncpy (req.consumer, "sysio-dinput", sizeof (req.consumer) - 1);
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT |
+                       GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    if (ioctl (cfd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+
+      close (cfd);
+      return -1;
+    }
+    close (cfd);
+
+    port->ctx[p].fd = req.fd;
+    ev.events = EPOLLIN;
+    ev.data.u32 = p;
+    if (epoll_ctl (port->epfd, EPOLL_CTL_ADD, req.fd, &ev) < 0) {
+      return -1;
+    }
+  }
+
+  ev.events = EPOLLIN;
+  ev.data.u32 = (uint32_t) DINPUT_TIMER_ID;
+  if (epoll_ctl (port->epfd, EPOLL_CTL_ADD, port->timerfd, &ev) < 0) {
+    return -1;
+  }
+  ev.data.u32 = (uint32_t) DINPUT_STOP_ID;
+  if (epoll_ctl (port->epfd, EPOLL_CTL_ADD, port->stopfd, &ev) < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vDinCloseEvents (xDinPort * port) {
+
+  for (unsigned p = 0; p < port->size; p++) {
+
+    if (port->ctx[p].fd >= 0) {
+
+      close (port->ctx[p].fd);
+      port->ctx[p].fd = -1;
+    }
+  }
+  if (port->stopfd >= 0) {
+    close (port->stopfd);
+  }
+  if (port->timerfd >= 0) {
+    close (port->timerfd);
+  }
+  if (port->epfd >= 0) {
+    close (port->epfd);
+  }
+  port->epfd = port->timerfd = port->stopfd = -1;
+}
+
 /* internal public functions ================================================ */
 
 // -----------------------------------------------------------------------------
@@ -209,17 +435,30 @@ xDinOpen (const xDin * pins, unsigned size) {
   for (unsigned p = 0; p < size; p++) {
     pthread_mutex_init(&port->ctx[p].read_mutex, NULL);
     pthread_mutex_init(&port->ctx[p].write_mutex, NULL);
+    port->ctx[p].fd = -1;
+    port->ctx[p].debounce = DINPUT_DEBOUNCE_DELAY;
   }
-  
   port->run = true;
-  if (pthread_create (&port->thread, NULL, pvDinPoll, port) != 0) {
+  if (iDinOpenEvents (port) == 0) {
+
+    if (pthread_create (&port->thread, NULL, pvDinEvents, port) != 0) {
 
-    goto xDinTheadError;
+      goto xDinTheadError;
+    }
+  }
+  else {
+    // pas d'accès à /dev/gpiochipN, scrutation des entrées
+    vDinCloseEvents (port);
+    if (pthread_create (&port->thread, NULL, pvDinPoll, port) != 0) {
+
+      goto xDinTheadError;
+    }
   }
 
   return port;
 
 xDinTheadError:   // Erreur lors de la création du thread
+  vDinCloseEvents (port);
   free (port->ctx);
 xDinGpioError:    // Erreur lors de l'accès au gpio
   (void) iGpioClose (port->gpio);
@@ -236,9 +475,16 @@ iDinClose (xDinPort * port) {
 
   port->run = false;
   (void) iDinClearGrpCallback (port);
+  if (port->stopfd >= 0) {
+    uint64_t one = 1;
+
+    (void) write (port->stopfd, &one, sizeof (one));
+  }
   pthread_join (port->thread, NULL);
+  vDinCloseEvents (port);
   int i = iGpioClose (port->gpio);
 
+  free (port->ctx);
   free (port->pins);
   free (port);
   return i;
@@ -344,6 +590,31 @@ iDinSetEdge (unsigned p, eDinEdge edge, xDinPort * port) {
   return 0;
 }
 
+// -----------------------------------------------------------------------------
+int
+iDinSetDebounce (unsigned p, unsigned long us, xDinPort * port) {
+  assert (port);
+
+  if (p >= port->size) {
+    PERROR ("%s", sErrorRange);
+    return -1;
+  }
+  port->ctx[p].debounce = us;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+long
+lDinDebounce (unsigned p, xDinPort * port) {
+  assert (port);
+
+  if (p >= port->size) {
+    PERROR ("%s", sErrorRange);
+    return -1;
+  }
+  return port->ctx[p].debounce;
+}
+
 // -----------------------------------------------------------------------------
 int
 iDinEdgeOccured (unsigned p, xDinPort *port) {
@@ -148,6 +148,19 @@ iGpioRead (int p, xGpio * gp) {
   return -1;
 }
 
+// -----------------------------------------------------------------------------
+int
+iGpioLine (int p, char * chip, size_t size, unsigned * offset, xGpio * gp) {
+  int g;
+
+  g = iGpioMcuPin (p, gp);
+  if (g >= 0) {
+
+    return iArchGpioLine (g, chip, size, offset);
+  }
+  return -1;
+}
+
 // -----------------------------------------------------------------------------
 int
 iGpioToggle (int p, xGpio * gp) {
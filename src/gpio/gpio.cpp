@@ -7,6 +7,9 @@
  */
 #include <sysio/gpio.h>
 #include <sysio/gpiodevice.h>
+#include <system_error>
+//
+#include <time.h>
 
 namespace Sysio {
 
@@ -202,6 +205,135 @@ namespace Sysio {
     return _connector;
   }
 
+// -----------------------------------------------------------------------------
+  unsigned int
+  Gpio::ports() const {
+
+    if (device()->flags() & Device::hasPortAccess) {
+
+      return device()->banks();
+    }
+    return 0;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Gpio::checkPortAccess() const {
+
+    if ( ( (accessLayer() & AccessLayerIoMap) == 0) ||
+         ( (device()->flags() & Device::hasPortAccess) == 0)) {
+
+      throw std::domain_error ("Port access requires the AccessLayerIoMap layer");
+    }
+    if (!isOpen()) {
+
+      throw std::system_error (ENODEV, std::system_category(), __FUNCTION__);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Gpio::writePort (unsigned int port, uint32_t setMask, uint32_t clrMask) {
+
+    checkPortAccess();
+    device()->writeMask (port, setMask, clrMask);
+  }
+
+// -----------------------------------------------------------------------------
+  uint32_t
+  Gpio::readPort (unsigned int port) const {
+
+    checkPortAccess();
+    return device()->readBank (port);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Gpio::setPull (const std::vector<Pin *> & pins, Pin::Pull pull) {
+    std::map<Pin *, Pin::Pull> pulls;
+
+    for (Pin * p : pins) {
+
+      pulls[p] = pull;
+    }
+    setPull (pulls);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Gpio::setPull (const std::map<Pin *, Pin::Pull> & pulls) {
+    // masque de chaque (résistance, port)
+    std::map<std::pair<Pin::Pull, unsigned int>, uint32_t> group;
+    bool useMask = isOpen() && (accessLayer() & AccessLayerIoMap) &&
+                   (device()->flags() & Device::hasPullMask);
+
+    for (const auto & pp : pulls) {
+      Pin * p = pp.first;
+
+      if (p->type() != Pin::TypeGpio) {
+
+        continue;
+      }
+
+      if (useMask && p->isOpen() && !p->useCharDev() &&
+          (pp.second != Pin::PullUnknown)) {
+        unsigned int bank, bit;
+
+        // même traitement que Pin::writePull(), la séquence en moins
+        p->_pull = pp.second;
+        p->holdPull();
+        device()->pinBit (p, bank, bit);
+        group[std::make_pair (pp.second, bank)] |= 1U << bit;
+      }
+      else {
+
+        p->setPull (pp.second);
+      }
+    }
+
+    for (const auto & g : group) {
+
+      device()->setPullMask (g.first.second, g.second, g.first.first);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  GpioState
+  Gpio::snapshot() const {
+    GpioState s;
+    struct timespec ts;
+    std::vector<Pin *> single;
+    bool useRegs = isOpen() && (accessLayer() & AccessLayerIoMap) &&
+                   (device()->flags() & Device::hasSnapshot);
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    s.timestamp = static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+
+    for (const auto & p : _pin) {
+      Pin * pin = p.second.get();
+
+      if (useRegs && !pin->useSysFs() && !pin->useCharDev()) {
+
+        s.pin[pin->mcuNumber()] = GpioState::PinState {Pin::ModeUnknown, Pin::PullUnknown, false};
+      }
+      else {
+
+        single.push_back (pin);
+      }
+    }
+
+    if (useRegs) {
+
+      device()->snapshot (s);
+    }
+
+    for (Pin * pin : single) {
+
+      s.pin[pin->mcuNumber()] = GpioState::PinState {pin->mode(), pin->pull(), pin->read()};
+    }
+    return s;
+  }
+
 // -----------------------------------------------------------------------------
   Device *
   Gpio::device() const {
@@ -0,0 +1,631 @@
+/**
+ * @file
+ * @brief Analyseur logique GPIO
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/gpio.h>
+#include <sysio/gpiocapture.h>
+#include <sysio/gpiofastpin.h>
+#include <system_error>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cmath>
+#include <cctype>
+//
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace Sysio {
+
+// -----------------------------------------------------------------------------
+//
+//                          Zip stored archive
+//
+// -----------------------------------------------------------------------------
+  // Archive zip sans compression (méthode 0), suffisante pour une session
+  // sigrok. Les tailles et CRC sont corrigés après l'écriture des données.
+  class ZipWriter {
+    public:
+      explicit ZipWriter (const std::string & path) :
+        _os (path, std::ios::binary | std::ios::trunc) {
+
+        if (!_os) {
+
+          throw std::system_error (errno, std::system_category(), path);
+        }
+      }
+
+      void begin (const std::string & name) {
+        Entry e;
+
+        e.name = name;
+        e.offset = _os.tellp();
+        e.crc = 0xFFFFFFFF;
+        e.size = 0;
+        _entry.push_back (e);
+        localHeader (e);
+      }
+
+      void write (const void * data, size_t len) {
+        const uint8_t * p = static_cast<const uint8_t *> (data);
+        Entry & e = _entry.back();
+
+        for (size_t i = 0; i < len; i++) {
+
+          e.crc = crcTable() [ (e.crc ^ p[i]) & 0xFF] ^ (e.crc >> 8);
+        }
+        if (static_cast<uint64_t> (e.size) + len > UINT32_MAX) {
+
+          throw std::system_error (EFBIG, std::system_category(), e.name);
+        }
+        e.size += len;
+        _os.write (reinterpret_cast<const char *> (p), len);
+      }
+
+      void write (const std::string & s) {
+
+        write (s.data(), s.size());
+      }
+
+      void end() {
+        Entry & e = _entry.back();
+        std::streampos pos = _os.tellp();
+
+        e.crc ^= 0xFFFFFFFF;
+        _os.seekp (e.offset);
+        localHeader (e);
+        _os.seekp (pos);
+      }
+
+      void close() {
+        std::streampos cd = _os.tellp();
+
+        for (const Entry & e : _entry) {
+
+          le32 (0x02014b50);
+          le16 (20); // version made by
+          le16 (10); // version needed
+          le16 (0);  // flags
+          le16 (0);  // stored
+          le16 (0);  // time
+          le16 (0x21); // date 1980-01-01
+          le32 (e.crc);
+          le32 (e.size);
+          le32 (e.size);
+          le16 (e.name.size());
+          le16 (0);  // extra
+          le16 (0);  // comment
+          le16 (0);  // disk
+          le16 (0);  // internal attributes
+          le32 (0);  // external attributes
+          le32 (static_cast<uint32_t> (e.offset));
+          _os.write (e.name.data(), e.name.size());
+        }
+
+        uint32_t cdsize = static_cast<uint32_t> (_os.tellp() - cd);
+        le32 (0x06054b50);
+        le16 (0);
+        le16 (0);
+        le16 (_entry.size());
+        le16 (_entry.size());
+        le32 (cdsize);
+        le32 (static_cast<uint32_t> (cd));
+        le16 (0);
+
+        _os.close();
+        if (_os.fail()) {
+
+          throw std::system_error (EIO, std::system_category(), __FUNCTION__);
+        }
+      }
+
+    private:
+      class Entry {
+        public:
+          std::string name;
+          std::streampos offset;
+          uint32_t crc;
+          uint32_t size;
+      };
+
+      std::ofstream _os;
+      std::vector<Entry> _entry;
+
+      void le16 (uint16_t v) {
+        char b[2] = { char (v), char (v >> 8) };
+
+        _os.write (b, 2);
+      }
+
+      void le32 (uint32_t v) {
+
+        le16 (v);
+        le16 (v >> 16);
+      }
+
+      void localHeader (const Entry & e) {
+
+        le32 (0x04034b50);
+        le16 (10); // version needed
+        le16 (0);  // flags
+        le16 (0);  // stored
+        le16 (0);  // time
+        le16 (0x21); // date 1980-01-01
+        le32 (e.size ? e.crc : 0);
+        le32 (e.size);
+        le32 (e.size);
+        le16 (e.name.size());
+        le16 (0);  // extra
+        _os.write (e.name.data(), e.name.size());
+      }
+
+      static const uint32_t * crcTable() {
+        static uint32_t table[256];
+        static bool init = false;
+
+        if (!init) {
+
+          for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+
+            for (int k = 0; k < 8; k++) {
+
+              c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+          }
+          init = true;
+        }
+        return table;
+      }
+  };
+
+// -----------------------------------------------------------------------------
+//
+//                          Capture Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  Capture::Capture (PinGroup & group, size_t capacity) :
+    _group (group), _buf (0), _capacity (capacity), _head (0), _size (0),
+    _fd (-1), _period (1000), _samples (0), _overruns (0), _first (0),
+    _stop (false) {
+
+    if (_capacity == 0) {
+
+      throw std::invalid_argument ("The capture buffer can not be empty");
+    }
+    _mem.resize (_capacity);
+    _buf = _mem.data();
+  }
+
+// -----------------------------------------------------------------------------
+  Capture::~Capture() {
+
+    unmap();
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Capture::setFile (const std::string & path) {
+
+    unmap();
+    if (!path.empty()) {
+      size_t len = _capacity * sizeof (Run);
+      void * p;
+
+      _fd = ::open (path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      if (_fd < 0) {
+
+        throw std::system_error (errno, std::system_category(), path);
+      }
+      if (ftruncate (_fd, len) < 0) {
+        int err = errno;
+
+        unmap();
+        throw std::system_error (err, std::system_category(), path);
+      }
+      p = mmap (NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+      if (p == MAP_FAILED) {
+        int err = errno;
+
+        unmap();
+        throw std::system_error (err, std::system_category(), path);
+      }
+      _mem.clear();
+      _mem.shrink_to_fit();
+      _buf = static_cast<Run *> (p);
+    }
+    _head = _size = 0;
+    _samples = _overruns = _first = 0;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Capture::setRate (double hz) {
+
+    if (hz <= 0) {
+
+      throw std::invalid_argument ("The sample rate must be positive");
+    }
+    _period = 1e9 / hz;
+  }
+
+// -----------------------------------------------------------------------------
+  double
+  Capture::rate() const {
+
+    return 1e9 / _period;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Capture::record (uint64_t samples) {
+    uint64_t t0, n = 0;
+    uint32_t prev[2] = {0, 0};
+    uint32_t value = 0;
+
+    compile();
+    _head = _size = 0;
+    _samples = _overruns = _first = 0;
+    _stop = false;
+
+    // accès préalable à toutes les pages du tampon
+    memset (static_cast<void *> (_buf), 0, _capacity * sizeof (Run));
+
+    t0 = now();
+    while ( (n < samples) && !_stop) {
+      uint64_t deadline = t0 + static_cast<uint64_t> (n * _period);
+      uint64_t t, missed;
+
+      do {
+        t = now();
+      }
+      while (t < deadline);
+
+      if (_bank.empty()) {
+
+        value = _group.read();
+      }
+      else {
+        bool changed = (n == 0);
+
+        // une lecture par registre de niveau, la valeur du groupe n'est
+        // recalculée que si une broche a changé
+        for (size_t b = 0; b < _bank.size(); b++) {
+          uint32_t w = *_bank[b].lev & _bank[b].mask;
+
+          if (w != prev[b]) {
+
+            prev[b] = w;
+            changed = true;
+          }
+        }
+        if (changed) {
+
+          value = 0;
+          for (size_t b = 0; b < _bank.size(); b++) {
+
+            for (const auto & m : _bank[b].bit) {
+
+              if (prev[b] & m.first) {
+
+                value |= m.second;
+              }
+            }
+          }
+        }
+      }
+
+      // échéances manquées, les échantillons prennent la valeur lue
+      missed = static_cast<uint64_t> ( (t - deadline) / _period);
+      if (missed > samples - n - 1) {
+
+        missed = samples - n - 1;
+      }
+      _overruns += missed;
+      push (value, missed + 1);
+      n += missed + 1;
+    }
+    _samples = n;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Capture::stop() {
+
+    _stop = true;
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Capture::samples() const {
+
+    return _samples;
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Capture::overruns() const {
+
+    return _overruns;
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  Capture::wrapped() const {
+
+    return _first > 0;
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Capture::firstSample() const {
+
+    return _first;
+  }
+
+// -----------------------------------------------------------------------------
+  size_t
+  Capture::size() const {
+
+    return _size;
+  }
+
+// -----------------------------------------------------------------------------
+  const Capture::Run &
+  Capture::run (size_t i) const {
+
+    if (i >= _size) {
+
+      throw std::out_of_range ("Bad capture run index");
+    }
+    return _buf[ (_head + i) % _capacity];
+  }
+
+// -----------------------------------------------------------------------------
+  PinGroup &
+  Capture::group() const {
+
+    return _group;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Capture::writeVcd (std::ostream & os) const {
+    uint64_t s = 0;
+    uint32_t last = 0;
+
+    os << "$date " << time (NULL) << " $end" << std::endl
+       << "$version sysio gpio capture $end" << std::endl
+       << "$comment " << std::fixed << rate() << " Hz, " << _samples
+       << " samples, " << _overruns << " overruns $end" << std::endl
+       << "$timescale 1 ns $end" << std::endl
+       << "$scope module gpio $end" << std::endl;
+    for (int i = 0; i < _group.size(); i++) {
+
+      os << "$var wire 1 " << char ('!' + i) << " " << name (i) << " $end" << std::endl;
+    }
+    os << "$upscope $end" << std::endl
+       << "$enddefinitions $end" << std::endl;
+
+    for (size_t r = 0; r < _size; r++) {
+      const Run & run = this->run (r);
+      uint32_t diff = run.value ^ last;
+
+      if (r == 0) {
+
+        os << "#0" << std::endl << "$dumpvars" << std::endl;
+        diff = ~0U;
+      }
+      else if (diff) {
+
+        os << "#" << llround (s * _period) << std::endl;
+      }
+      for (int i = 0; i < _group.size(); i++) {
+
+        if (diff & (1U << i)) {
+
+          os << ( (run.value >> i) & 1) << char ('!' + i) << std::endl;
+        }
+      }
+      if (r == 0) {
+
+        os << "$end" << std::endl;
+      }
+      last = run.value;
+      s += run.count;
+    }
+    os << "#" << llround (s * _period) << std::endl;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Capture::writeSigrok (const std::string & path) const {
+    ZipWriter zip (path);
+    std::ostringstream meta;
+    unsigned int unitsize = (_group.size() + 7) / 8;
+    double hz = rate();
+    std::vector<uint8_t> chunk;
+
+    zip.begin ("version");
+    zip.write ("2");
+    zip.end();
+
+    meta << "[global]" << std::endl
+         << "sigrok version=0.5.0" << std::endl << std::endl
+         << "[device 1]" << std::endl
+         << "capturefile=logic-1" << std::endl
+         << "total probes=" << _group.size() << std::endl;
+    if ( (hz >= 1e6) && (fmod (hz, 1e6) == 0)) {
+
+      meta << "samplerate=" << llround (hz / 1e6) << " MHz" << std::endl;
+    }
+    else if ( (hz >= 1e3) && (fmod (hz, 1e3) == 0)) {
+
+      meta << "samplerate=" << llround (hz / 1e3) << " kHz" << std::endl;
+    }
+    else {
+
+      meta << "samplerate=" << llround (hz) << " Hz" << std::endl;
+    }
+    meta << "total analog=0" << std::endl;
+    for (int i = 0; i < _group.size(); i++) {
+
+      meta << "probe" << i + 1 << "=" << name (i) << std::endl;
+    }
+    meta << "unitsize=" << unitsize << std::endl;
+
+    zip.begin ("metadata");
+    zip.write (meta.str());
+    zip.end();
+
+    // échantillons décompressés, octet de poids faible en premier
+    zip.begin ("logic-1-1");
+    chunk.reserve (4096 * unitsize);
+    for (size_t r = 0; r < _size; r++) {
+      const Run & run = this->run (r);
+
+      for (uint32_t c = 0; c < run.count; c++) {
+
+        for (unsigned int b = 0; b < unitsize; b++) {
+
+          chunk.push_back (run.value >> (b * 8));
+        }
+        if (chunk.size() >= 4096 * unitsize) {
+
+          zip.write (chunk.data(), chunk.size());
+          chunk.clear();
+        }
+      }
+    }
+    zip.write (chunk.data(), chunk.size());
+    zip.end();
+
+    zip.close();
+  }
+
+// -----------------------------------------------------------------------------
+//                                   Private
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Capture::now() {
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Capture::unmap() {
+
+    if (_fd >= 0) {
+
+      if (_mem.empty()) {
+
+        munmap (_buf, _capacity * sizeof (Run));
+      }
+      ::close (_fd);
+      _fd = -1;
+      _mem.resize (_capacity);
+      _buf = _mem.data();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  // Registres de niveau des broches du groupe (FastPinRegisters), le groupe
+  // est lu par PinGroup::read() si ils ne sont pas accessibles
+  void
+  Capture::compile() {
+
+    _bank.clear();
+    try {
+
+      for (int i = 0; i < _group.size(); i++) {
+        FastPinRegisters r = FastPinRegisters::get (_group.pin (i));
+        size_t b;
+
+        for (b = 0; b < _bank.size(); b++) {
+
+          if (_bank[b].lev == r.lev) {
+            break;
+          }
+        }
+        if (b == _bank.size()) {
+
+          if (b == 2) {
+            // plus de 2 registres, cas non prévu par le précalcul
+            _bank.clear();
+            return;
+          }
+          _bank.push_back (Bank());
+          _bank[b].lev = r.lev;
+          _bank[b].mask = 0;
+        }
+        _bank[b].mask |= r.mask;
+        _bank[b].bit.push_back (std::make_pair (r.mask, 1U << i));
+      }
+    }
+    catch (std::exception & e) {
+
+      _bank.clear();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  // Ajout en fin de tampon, la plus ancienne séquence est écrasée si il est plein
+  void
+  Capture::push (uint32_t value, uint64_t count) {
+
+    while (count) {
+      Run * last = _size ? &_buf[ (_head + _size - 1) % _capacity] : 0;
+
+      if (last && (last->value == value) && (last->count < UINT32_MAX)) {
+        uint64_t n = std::min<uint64_t> (count, UINT32_MAX - last->count);
+
+        last->count += n;
+        count -= n;
+      }
+      else {
+        Run * r;
+
+        if (_size == _capacity) {
+
+          _first += _buf[_head].count;
+          _head = (_head + 1) % _capacity;
+          _size--;
+        }
+        r = &_buf[ (_head + _size) % _capacity];
+        r->value = value;
+        r->count = 0;
+        _size++;
+      }
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  // Nom de la broche i sans espace (VCD)
+  std::string
+  Capture::name (int i) const {
+    std::string s = _group.pin (i).name();
+
+    for (char & c : s) {
+
+      if (isspace (c)) {
+        c = '_';
+      }
+    }
+    return s;
+  }
+}
+/* ========================================================================== */
@@ -0,0 +1,442 @@
+/**
+ * @file
+ * @brief Accès GPIO par l'interface caractère du noyau (gpiochip v2)
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <system_error>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+//
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/ioctl.h>
+#include "gpiochardev.h"
+#include "gpio_private.h"
+
+namespace Sysio {
+
+// -----------------------------------------------------------------------------
+//
+//                          LineRequest Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  LineRequest::LineRequest (const std::string & chip,
+                            const std::vector<unsigned int> & offsets,
+                            const std::vector<uint64_t> & flags,
+                            uint64_t values) :
+    _fd (-1), _chip (chip), _offset (offsets), _flags (flags), _values (values),
+    _pending (offsets.size()) {
+    struct gpio_v2_line_request req;
+    int cfd, ret;
+
+    if ( (offsets.size() == 0) || (offsets.size() > GPIO_V2_LINES_MAX) ||
+         (offsets.size() != flags.size())) {
+
+      throw std::invalid_argument ("Bad line request");
+    }
+
+    std::memset (&req, 0, sizeof (req));
+    for (unsigned int i = 0; i < offsets.size(); i++) {
+
+      req.offsets[i] = offsets[i];
+    }
+    req.num_lines = offsets.size();
+    std::strncpy (req.consumer, "sysio", GPIO_MAX_NAME_SIZE - 1);
+    buildConfig (req.config);
+
+    if ( (cfd = ::open (chip.c_str(), O_RDWR | O_CLOEXEC)) < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+    ret = ioctl (cfd, GPIO_V2_GET_LINE_IOCTL, &req);
+    if (ret < 0) {
+      int err = errno;
+
+      ::close (cfd);
+      throw std::system_error (err, std::system_category(), __FUNCTION__);
+    }
+    ::close (cfd);
+    _fd = req.fd;
+    readInfo();
+  }
+
+// -----------------------------------------------------------------------------
+  LineRequest::~LineRequest() {
+
+    if (_fd >= 0) {
+
+      ::close (_fd);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  LineRequest::fd() const {
+
+    return _fd;
+  }
+
+// -----------------------------------------------------------------------------
+  unsigned int
+  LineRequest::size() const {
+
+    return _offset.size();
+  }
+
+// -----------------------------------------------------------------------------
+  const std::string &
+  LineRequest::chip() const {
+
+    return _chip;
+  }
+
+// -----------------------------------------------------------------------------
+  unsigned int
+  LineRequest::offset (unsigned int i) const {
+
+    return _offset.at (i);
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  LineRequest::flags (unsigned int i) const {
+
+    return _flags.at (i);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  LineRequest::setFlags (unsigned int i, uint64_t f) {
+    struct gpio_v2_line_config config;
+    uint64_t old = _flags.at (i);
+
+    _flags[i] = f;
+    buildConfig (config);
+    if (ioctl (_fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) < 0) {
+      int err = errno;
+
+      _flags[i] = old;
+      throw std::system_error (err, std::system_category(), __FUNCTION__);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  LineRequest::getValues (uint64_t mask) const {
+    struct gpio_v2_line_values v;
+
+    v.bits = 0;
+    v.mask = mask;
+    if (ioctl (_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &v) < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+    return v.bits & mask;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  LineRequest::setValues (uint64_t mask, uint64_t bits) {
+    struct gpio_v2_line_values v;
+
+    v.bits = bits;
+    v.mask = mask;
+    if (ioctl (_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &v) < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+    _values = (_values & ~mask) | (bits & mask);
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  LineRequest::poll (int timeout_ms) const {
+    struct pollfd  fds;
+
+    fds.fd = _fd;
+    fds.events = POLLIN | POLLERR;
+    return ::poll (& fds, 1, timeout_ms);
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  LineRequest::readEvents (struct gpio_v2_line_event * events, int max) const {
+    ssize_t ret;
+
+    ret = ::read (_fd, events, max * sizeof (struct gpio_v2_line_event));
+    if (ret < 0) {
+
+      return -1;
+    }
+    return ret / sizeof (struct gpio_v2_line_event);
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  LineRequest::waitEvent (unsigned int index, int timeout_ms) {
+    std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds (timeout_ms);
+
+    for (;;) {
+      int ret, t = timeout_ms;
+
+      {
+        std::lock_guard<std::mutex> lock (_eventMutex);
+
+        if (!_pending[index].empty()) {
+
+          _pending[index].pop_front();
+          return 1;
+        }
+      }
+
+      if (timeout_ms >= 0) {
+
+        t = std::chrono::duration_cast<std::chrono::milliseconds> (
+              deadline - std::chrono::steady_clock::now()).count();
+        t = (t < 0) ? 0 : t;
+      }
+      if ( (ret = poll (t)) <= 0) {
+
+        return ret;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock (_eventMutex);
+        struct gpio_v2_line_event ev[16];
+
+        // un autre thread a pu lire les fronts entre poll() et la prise du
+        // verrou, read() serait alors bloquant
+        if (poll (0) <= 0) {
+
+          continue;
+        }
+        if ( (ret = readEvents (ev, 16)) < 0) {
+
+          return -1;
+        }
+        for (int i = 0; i < ret; i++) {
+
+          for (unsigned int j = 0; j < _offset.size(); j++) {
+
+            if (_offset[j] == ev[i].offset) {
+
+              if (_pending[j].size() >= PendingMax) {
+
+                _pending[j].pop_front(); // le plus ancien est perdu
+              }
+              _pending[j].push_back (ev[i]);
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  std::string
+  LineRequest::findChip (const std::string & label) {
+    std::string path;
+    DIR * dir;
+
+    if ( (dir = opendir ("/dev")) != nullptr) {
+      struct dirent * e;
+
+      while ( (path.empty()) && ( (e = readdir (dir)) != nullptr)) {
+
+        if (std::strncmp (e->d_name, "gpiochip", 8) == 0) {
+          std::string fn = std::string ("/dev/") + e->d_name;
+          int fd = ::open (fn.c_str(), O_RDWR | O_CLOEXEC);
+
+          if (fd >= 0) {
+            struct gpiochip_info info;
+
+            if ( (ioctl (fd, GPIO_GET_CHIPINFO_IOCTL, &info) == 0) &&
+                 (label == info.label)) {
+
+              path = fn;
+            }
+            ::close (fd);
+          }
+        }
+      }
+      closedir (dir);
+    }
+    return path;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  LineRequest::findLine (int system, std::string & chip, unsigned int & offset) {
+    const std::string syspath ("/sys/class/gpio");
+    DIR * dir;
+
+    if (system < 0) {
+
+      throw std::invalid_argument ("Unknown pin number in the system numbering");
+    }
+
+    // La numérotation système est celle de l'interface SysFs: elle est la
+    // somme de la base du contrôleur et du numéro de la ligne.
+    if ( (dir = opendir (syspath.c_str())) != nullptr) {
+      struct dirent * e;
+
+      while ( (e = readdir (dir)) != nullptr) {
+
+        if (std::strncmp (e->d_name, "gpiochip", 8) == 0) {
+          std::string d = syspath + "/" + e->d_name;
+          std::ifstream fbase (d + "/base");
+          std::ifstream fngpio (d + "/ngpio");
+          std::ifstream flabel (d + "/label");
+          std::string label;
+          int base, ngpio;
+
+          if ( (fbase >> base) && (fngpio >> ngpio) && std::getline (flabel, label)) {
+
+            if ( (system >= base) && (system < (base + ngpio))) {
+
+              closedir (dir);
+              chip = findChip (label);
+              if (chip.empty()) {
+
+                throw std::system_error (ENODEV, std::system_category(), label);
+              }
+              offset = system - base;
+              return;
+            }
+          }
+        }
+      }
+      closedir (dir);
+    }
+
+    // Pas de SysFs, le premier contrôleur est supposé commencer à 0
+    chip = "/dev/gpiochip0";
+    offset = system;
+  }
+
+// -----------------------------------------------------------------------------
+//                                   Private
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  void
+  LineRequest::buildConfig (struct gpio_v2_line_config & config) const {
+    unsigned int n = 0;
+    uint64_t outputs = 0;
+    std::vector<uint64_t> done (1, _flags[0]);
+
+    std::memset (&config, 0, sizeof (config));
+    config.flags = _flags[0];
+
+    for (unsigned int i = 0; i < _flags.size(); i++) {
+
+      if (_flags[i] & GPIO_V2_LINE_FLAG_OUTPUT) {
+
+        outputs |= 1ULL << i;
+      }
+    }
+
+    // Un attribut par jeu de drapeaux différent de celui de la première ligne,
+    // une place est réservée aux valeurs des sorties s'il y en a
+    for (unsigned int i = 0; i < _flags.size(); i++) {
+      bool found = false;
+
+      for (auto f : done) {
+
+        found = found || (f == _flags[i]);
+      }
+
+      if (!found) {
+
+        if (n + (outputs ? 1 : 0) >= GPIO_V2_LINE_NUM_ATTRS_MAX) {
+
+          throw std::length_error ("Too many line configurations in a request");
+        }
+        struct gpio_v2_line_config_attribute & a = config.attrs[n++];
+
+        a.attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+        a.attr.flags = _flags[i];
+        for (unsigned int j = i; j < _flags.size(); j++) {
+
+          if (_flags[j] == _flags[i]) {
+
+            a.mask |= 1ULL << j;
+          }
+        }
+        done.push_back (_flags[i]);
+      }
+    }
+
+    // Les sorties conservent leurs dernières valeurs
+    if (outputs) {
+      struct gpio_v2_line_config_attribute & a = config.attrs[n++];
+
+      a.attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+      a.attr.values = _values;
+      a.mask = outputs;
+    }
+    config.num_attrs = n;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  LineRequest::readInfo() {
+    int cfd;
+    const uint64_t mask = DirectionMask | EdgeMask | BiasMask |
+                          GPIO_V2_LINE_FLAG_ACTIVE_LOW |
+                          GPIO_V2_LINE_FLAG_OPEN_DRAIN |
+                          GPIO_V2_LINE_FLAG_OPEN_SOURCE;
+
+    if ( (cfd = ::open (_chip.c_str(), O_RDWR | O_CLOEXEC)) >= 0) {
+
+      for (unsigned int i = 0; i < _offset.size(); i++) {
+        struct gpio_v2_line_info info;
+
+        std::memset (&info, 0, sizeof (info));
+        info.offset = _offset[i];
+        if (ioctl (cfd, GPIO_V2_GET_LINEINFO_IOCTL, &info) == 0) {
+
+          _flags[i] = info.flags & mask;
+          if (_flags[i] & GPIO_V2_LINE_FLAG_OUTPUT) {
+
+            if (getValues (1ULL << i)) {
+
+              _values |= 1ULL << i;
+            }
+            else {
+
+              _values &= ~ (1ULL << i);
+            }
+          }
+        }
+      }
+      ::close (cfd);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Accès depuis l'interface C (gpio_private.h)
+int
+iGpioFindChip (const char * label, char * path, size_t size) {
+  std::string chip = Sysio::LineRequest::findChip (label);
+
+  if (chip.empty() || (chip.size() >= size)) {
+
+    return -1;
+  }
+  std::strcpy (path, chip.c_str());
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @brief Accès GPIO par l'interface caractère du noyau (gpiochip v2)
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_CHARDEV_H_
+#define _SYSIO_GPIO_CHARDEV_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <cstdint>
+#include <linux/gpio.h>
+
+#ifndef __DOXYGEN__
+
+namespace Sysio {
+
+  /*
+   * @class LineRequest
+   * @brief Requête de lignes sur un /dev/gpiochipN
+   *
+   * Une requête réserve une ou plusieurs lignes d'un même contrôleur, elle
+   * permet de lire ou de modifier toutes ses lignes par un seul ioctl et de
+   * recevoir les fronts horodatés par le noyau (CLOCK_MONOTONIC).
+   * Les drapeaux GPIO_V2_LINE_FLAG_xxx sont mémorisés ligne par ligne.
+   */
+  class LineRequest {
+
+    public:
+      LineRequest (const std::string & chip,
+                   const std::vector<unsigned int> & offsets,
+                   const std::vector<uint64_t> & flags,
+                   uint64_t values = 0);
+      virtual ~LineRequest();
+
+      int fd() const;
+      unsigned int size() const;
+      const std::string & chip() const;
+      unsigned int offset (unsigned int index) const;
+
+      uint64_t flags (unsigned int index) const;
+      void setFlags (unsigned int index, uint64_t flags);
+
+      uint64_t getValues (uint64_t mask) const;
+      void setValues (uint64_t mask, uint64_t bits);
+
+      int poll (int timeout_ms) const;
+      int readEvents (struct gpio_v2_line_event * events, int max) const;
+      // Attente d'un front de la ligne index (1), 0 si le délai est écoulé,
+      // -1 en cas d'erreur. Les fronts des autres lignes lus au passage sont
+      // conservés dans leur file pour leur propre attente.
+      int waitEvent (unsigned int index, int timeout_ms);
+
+      // Chemin du contrôleur dont le label est fourni, chaîne vide si absent
+      static std::string findChip (const std::string & label);
+      // Contrôleur et ligne correspondant à un numéro de broche système
+      static void findLine (int system, std::string & chip, unsigned int & offset);
+
+      static const uint64_t DirectionMask = GPIO_V2_LINE_FLAG_INPUT |
+                                            GPIO_V2_LINE_FLAG_OUTPUT;
+      static const uint64_t EdgeMask = GPIO_V2_LINE_FLAG_EDGE_RISING |
+                                       GPIO_V2_LINE_FLAG_EDGE_FALLING;
+      static const uint64_t BiasMask = GPIO_V2_LINE_FLAG_BIAS_PULL_UP |
+                                       GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN |
+                                       GPIO_V2_LINE_FLAG_BIAS_DISABLED;
+
+    private:
+      int _fd;
+      std::string _chip;
+      std::vector<unsigned int> _offset;
+      std::vector<uint64_t> _flags;
+      uint64_t _values; // dernières valeurs écrites
+      std::vector<std::deque<struct gpio_v2_line_event>> _pending; // fronts en attente, par ligne
+      std::mutex _eventMutex;
+
+      static const size_t PendingMax = 64;
+
+      void buildConfig (struct gpio_v2_line_config & config) const;
+      void readInfo();
+  };
+}
+#endif /* DOXYGEN not defined */
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_CHARDEV_H_ defined */
@@ -284,29 +284,16 @@ namespace Sysio {
 
 // -----------------------------------------------------------------------------
   void
-  Connector::printRow (std::ostream & os, int number) const {
-    std::array<std::string, 5> s;
+  Connector::printRow (std::ostream & os, int number, const GpioState & state) const {
+    std::array<std::string, 6> s;
     unsigned int i = 0;
 
     Pin * p = &pin (number++);
     os << '|';
-    if (p->type() == Pin::TypeGpio) {
-      s[0] = std::to_string (p->mcuNumber());
-      s[1] = std::to_string (p->logicalNumber());
-      s[2] = toUpper (p->modeName());
-      if (device()->flags() & Device::hasPullRead) {
-        s[3] = toUpper (p->pullName());
-      }
-      if (p->mode() != Pin::ModeDisabled)  {
-        if ( (p->mode() == Pin::ModeInput) || (p->mode() == Pin::ModeOutput) ||
-             (device()->flags() & Device::hasAltRead)) {
-          s[4] = std::to_string (p->read());
-        }
-      }
-    }
+    cells (p, state, s);
     os << format (s[0], _field[i++].size, Right) << '|';
     os << format (s[1], _field[i++].size, Right) << '|';
-    os << format (p->name(), _field[i++].size, Right) << '|';
+    os << format (s[5], _field[i++].size, Right) << '|';
     os << format (s[2], _field[i++].size, Right) << '|';
     if (device()->flags() & Device::hasPullRead) {
       os << format (s[3], _field[i].size, Right) << '|';
@@ -320,28 +307,7 @@ namespace Sysio {
       p = &pin (number);
 
       os << '|';
-      if (p->type() == Pin::TypeGpio) {
-        s[0] = std::to_string (p->mcuNumber());
-        s[1] = std::to_string (p->logicalNumber());
-        s[2] = toUpper (p->modeName());
-        if (device()->flags() & Device::hasPullRead) {
-          s[3] = toUpper (p->pullName());
-        }
-        s[4].clear();
-        if (p->mode() != Pin::ModeDisabled)  {
-          if ( (p->mode() == Pin::ModeInput) || (p->mode() == Pin::ModeOutput) ||
-               (device()->flags() & Device::hasAltRead)) {
-                 
-            s[4] = std::to_string (p->read());
-          }
-        }
-      }
-      else {
-
-        for (auto & n : s) {
-          n.clear();
-        }
-      }
+      cells (p, state, s);
       os << format (std::to_string (p->physicalNumber()), _field[--i].size, Left) << '|';
       os << format (s[4], _field[--i].size, Left) << '|';
       --i;
@@ -349,13 +315,53 @@ namespace Sysio {
         os << format (s[3], _field[i].size, Left) << '|';
       }
       os << format (s[2], _field[--i].size, Left) << '|';
-      os << format (p->name(), _field[--i].size, Left) << '|';
+      os << format (s[5], _field[--i].size, Left) << '|';
       os << format (s[1], _field[--i].size, Left) << '|';
       os << format (s[0], _field[--i].size, Left) << '|';
     }
     os << std::endl;
   }
 
+// -----------------------------------------------------------------------------
+  void
+  Connector::cells (Pin * p, const GpioState & state, std::array<std::string, 6> & s) const {
+
+    for (auto & n : s) {
+      n.clear();
+    }
+
+    if (p->type() == Pin::TypeGpio) {
+      const GpioState::PinState & ps = state.at (*p);
+
+      s[0] = std::to_string (p->mcuNumber());
+      s[1] = std::to_string (p->logicalNumber());
+      s[2] = toUpper (p->modeName (ps.mode));
+      if (device()->flags() & Device::hasPullRead) {
+        s[3] = toUpper (Pin::pullName (ps.pull));
+      }
+      if (ps.mode != Pin::ModeDisabled)  {
+        if ( (ps.mode == Pin::ModeInput) || (ps.mode == Pin::ModeOutput) ||
+             (device()->flags() & Device::hasAltRead)) {
+          s[4] = std::to_string (ps.value);
+        }
+      }
+      if (p->isOpen()) {
+
+        try {
+
+          s[5] = p->name (ps.mode);
+        }
+        catch (...) {
+          // Pas de nom pour le mode concerné
+        }
+      }
+    }
+    if (s[5].empty()) {
+
+      s[5] = p->name (Pin::ModeInput);
+    }
+  }
+
 // -----------------------------------------------------------------------------
   std::ostream& operator<< (std::ostream& os, const Connector * c)  {
     std::string::size_type width = 0;
@@ -380,10 +386,11 @@ namespace Sysio {
     buf << c->name() << " (#" << c->number() << ")";
     os << std::setw ( (width + buf.str().size()) / 2 + 1)  << toUpper (buf.str()) << std::endl;
     c->printTitle (os);
-    // broches
+    // broches, les registres du GPIO sont lus une seule fois
+    GpioState state = c->gpio()->snapshot();
     for (int i = 1; i <= c->size(); i += c->columns()) {
 
-      c->printRow (os, i);
+      c->printRow (os, i, state);
     }
     // pied de page
     if (c->rows() > 6) {
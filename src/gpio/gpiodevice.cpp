@@ -6,6 +6,8 @@
  * This software is governed by the CeCILL license <http://www.cecill.info>
  */
 #include <sysio/gpiodevice.h>
+#include <system_error>
+#include "gpiochardev.h"
 
 namespace Sysio {
 
@@ -50,12 +52,12 @@ namespace Sysio {
 
 // -----------------------------------------------------------------------------
   void
-  Device::toggle (const Pin * pin) {
+  Device::toggle (const Pin * /* pin */) {
   }
 
 // -----------------------------------------------------------------------------
   Pin::Pull
-  Device::pull (const Pin * pin) const {
+  Device::pull (const Pin * /* pin */) const {
     return Pin::PullUnknown;
   }
 
@@ -64,6 +66,61 @@ namespace Sysio {
   Device::flags() const {
     return 0;
   }
+
+// -----------------------------------------------------------------------------
+  unsigned int
+  Device::banks() const {
+    return 0;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Device::pinBit (const Pin * /* pin */, unsigned int & /* bank */, unsigned int & /* bit */) const {
+
+    throw std::system_error (ENOTSUP, std::system_category(), __FUNCTION__);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Device::writeMask (unsigned int /* bank */, uint32_t /* setMask */, uint32_t /* clrMask */) {
+
+    throw std::system_error (ENOTSUP, std::system_category(), __FUNCTION__);
+  }
+
+// -----------------------------------------------------------------------------
+  uint32_t
+  Device::readBank (unsigned int /* bank */) const {
+
+    throw std::system_error (ENOTSUP, std::system_category(), __FUNCTION__);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Device::setPullMask (unsigned int /* bank */, uint32_t /* mask */, Pin::Pull /* p */) {
+
+    throw std::system_error (ENOTSUP, std::system_category(), __FUNCTION__);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Device::snapshot (GpioState & /* state */) const {
+
+    throw std::system_error (ENOTSUP, std::system_category(), __FUNCTION__);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Device::fastRegisters (const Pin * /* pin */, FastPinRegisters & /* r */) const {
+
+    throw std::system_error (ENOTSUP, std::system_category(), __FUNCTION__);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Device::charDevLine (const Pin * pin, std::string & chip, unsigned int & offset) const {
+
+    LineRequest::findLine (pin->systemNumber(), chip, offset);
+  }
 // -----------------------------------------------------------------------------
 }
 /* ========================================================================== */
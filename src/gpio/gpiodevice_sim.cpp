@@ -0,0 +1,467 @@
+/**
+ * @file
+ * @brief Accès matériel GPIO simulé
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <cstdlib>
+#include <system_error>
+#include "gpiodevice_sim.h"
+
+namespace Sysio {
+
+// -----------------------------------------------------------------------------
+//
+//                        DeviceSim Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  DeviceSim::DeviceSim() : Device (), _iomap (0) {
+
+  }
+
+// -----------------------------------------------------------------------------
+  DeviceSim::~DeviceSim() {
+
+    close();
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  DeviceSim::isEnabled() {
+    const char * env = std::getenv ("SYSIO_GPIO_SIM");
+
+    return env && (std::atoi (env) != 0);
+  }
+
+// -----------------------------------------------------------------------------
+  unsigned int
+  DeviceSim::flags() const {
+    return hasToggle | hasPullRead | hasAltRead | hasPortAccess | hasPullMask | hasSnapshot;
+  }
+
+// -----------------------------------------------------------------------------
+  AccessLayer
+  DeviceSim::preferedAccessLayer() const {
+    return AccessLayerIoMap;
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  DeviceSim::open() {
+
+    if (!isOpen()) {
+
+      _iomap = xIoMapOpenMemory ("sysio-gpio-sim", MapBlockSize);
+      if (_iomap) {
+
+        setOpen (true);
+      }
+      else {
+
+        throw std::system_error (errno, std::system_category(), __FUNCTION__);
+      }
+    }
+    return isOpen();
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::close() {
+
+    if (isOpen()) {
+      iIoMapClose (_iomap);
+      setOpen (false);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  Pin::Mode
+  DeviceSim::mode (const Pin * pin) const {
+    int g = pin->mcuNumber();
+
+    return _int2mode.at (readReg (GFPSEL0 + g / 10) >> ( (g % 10) * 3) & 7);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::setMode (const Pin * pin, Pin::Mode m) {
+    int g = pin->mcuNumber();
+    unsigned int offset, rval, lsr;
+
+    if (m == Pin::ModePwm) {
+
+      throw std::invalid_argument ("ModePwm is not supported by the simulated GPIO");
+    }
+
+    offset = GFPSEL0 + g / 10;
+    lsr = (g % 10) * 3;
+
+    sync (g / BankSize);
+    rval = readReg (offset);
+    rval &= ~ (7 << lsr); // clear
+    rval |= _mode2int.at (m) << lsr;
+    writeReg (offset, rval);
+    update (g / BankSize);
+  }
+
+// -----------------------------------------------------------------------------
+  Pin::Pull
+  DeviceSim::pull (const Pin * pin) const {
+    int g = pin->mcuNumber();
+    unsigned int bank = g / BankSize;
+    unsigned int mask = 1 << (g % BankSize);
+
+    if (readReg (SIMPUP0 + bank) & mask) {
+
+      return Pin::PullUp;
+    }
+    if (readReg (SIMPDN0 + bank) & mask) {
+
+      return Pin::PullDown;
+    }
+    return Pin::PullOff;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::setPull (const Pin * pin, Pin::Pull p) {
+    int g = pin->mcuNumber();
+
+    setPullMask (g / BankSize, 1 << (g % BankSize), p);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::setPullMask (unsigned int bank, uint32_t mask, Pin::Pull p) {
+
+    if (bank >= banks()) {
+
+      throw std::out_of_range ("Bad simulated GPIO bank index");
+    }
+    unsigned int pup = readReg (SIMPUP0 + bank) & ~mask;
+    unsigned int pdn = readReg (SIMPDN0 + bank) & ~mask;
+
+    switch (p) {
+      case Pin::PullOff:
+        break;
+      case Pin::PullDown:
+        pdn |= mask;
+        break;
+      case Pin::PullUp:
+        pup |= mask;
+        break;
+      default:
+        return;
+    }
+    // GPPUD et GPPUDCLKn sont remis à zéro à la fin de la séquence sur le SoC
+    sync (bank);
+    writeReg (GPPUD, 0);
+    writeReg (GPPUDCLK0 + bank, 0);
+    writeReg (SIMPUP0 + bank, pup);
+    writeReg (SIMPDN0 + bank, pdn);
+    update (bank);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::write (const Pin * pin, bool v) {
+    int g = pin->mcuNumber();
+    uint32_t mask = 1 << (g % BankSize);
+
+    if (v) {
+
+      writeMask (g / BankSize, mask, 0);
+    }
+    else {
+
+      writeMask (g / BankSize, 0, mask);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::toggle (const Pin * pin) {
+    int g = pin->mcuNumber();
+    unsigned int bank = g / BankSize;
+
+    sync (bank);
+    writeReg (SIMOUT0 + bank, readReg (SIMOUT0 + bank) ^ (1 << (g % BankSize)));
+    update (bank);
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  DeviceSim::read (const Pin * pin) const {
+    int g = pin->mcuNumber();
+
+    return (readReg (GPLEV0 + g / BankSize) & (1 << (g % BankSize))) != 0;
+  }
+
+// -----------------------------------------------------------------------------
+  unsigned int
+  DeviceSim::banks() const {
+
+    return (GpioSize + BankSize - 1) / BankSize;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::pinBit (const Pin * pin, unsigned int & bank, unsigned int & bit) const {
+    int g = pin->mcuNumber();
+
+    bank = g / BankSize;
+    bit = g % BankSize;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::writeMask (unsigned int bank, uint32_t setMask, uint32_t clrMask) {
+
+    if (bank >= banks()) {
+
+      throw std::out_of_range ("Bad simulated GPIO bank index");
+    }
+    if (setMask) {
+
+      writeReg (GPSET0 + bank, setMask);
+    }
+    if (clrMask) {
+
+      writeReg (GPCLR0 + bank, clrMask);
+    }
+    sync (bank);
+    writeReg (SIMOUT0 + bank, (readReg (SIMOUT0 + bank) | setMask) & ~clrMask);
+    update (bank);
+  }
+
+// -----------------------------------------------------------------------------
+  uint32_t
+  DeviceSim::readBank (unsigned int bank) const {
+
+    if (bank >= banks()) {
+
+      throw std::out_of_range ("Bad simulated GPIO bank index");
+    }
+    return readReg (GPLEV0 + bank);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::snapshot (GpioState & state) const {
+    const unsigned int nbanks = (GpioSize + BankSize - 1) / BankSize;
+    uint32_t fsel[ (GpioSize + 9) / 10];
+    uint32_t lev[nbanks], pup[nbanks], pdn[nbanks];
+
+    for (unsigned int i = 0; i < (GpioSize + 9) / 10; i++) {
+
+      fsel[i] = readReg (GFPSEL0 + i);
+    }
+    for (unsigned int b = 0; b < nbanks; b++) {
+
+      lev[b] = readReg (GPLEV0 + b);
+      pup[b] = readReg (SIMPUP0 + b);
+      pdn[b] = readReg (SIMPDN0 + b);
+    }
+
+    for (auto & p : state.pin) {
+      int g = p.first;
+      unsigned int bank = g / BankSize;
+      uint32_t mask = 1 << (g % BankSize);
+
+      p.second.mode = _int2mode.at (fsel[g / 10] >> ( (g % 10) * 3) & 7);
+      p.second.pull = (pup[bank] & mask) ? Pin::PullUp :
+                      ( (pdn[bank] & mask) ? Pin::PullDown : Pin::PullOff);
+      p.second.value = (lev[bank] & mask) != 0;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::fastRegisters (const Pin * pin, FastPinRegisters & r) const {
+    int g = pin->mcuNumber();
+
+    // Les sorties sont écrites directement dans GPLEVn, voir sync()
+    r.set = r.clr = r.lev = pIo (_iomap, GPLEV0 + g / BankSize);
+    r.cfg = pIo (_iomap, GFPSEL0 + g / 10);
+    r.mask = 1U << (g % BankSize);
+    r.cfgMask = 7 << ( (g % 10) * 3);
+    r.cfgOutput = _mode2int.at (Pin::ModeOutput) << ( (g % 10) * 3);
+    r.setClear = false;
+    // GPLEVn n'est recalculé que par les fonctions de DeviceSim : une broche
+    // passée en entrée par GPFSELn garde le niveau de sa sortie
+    r.inputLevel = false;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::drive (int mcu, bool level) {
+    unsigned int bank = mcu / BankSize;
+    unsigned int mask = 1 << (mcu % BankSize);
+    unsigned int ext = readReg (SIMEXT0 + bank);
+
+    sync (bank);
+    writeReg (SIMEXT0 + bank, level ? (ext | mask) : (ext & ~mask));
+    writeReg (SIMEXTEN0 + bank, readReg (SIMEXTEN0 + bank) | mask);
+    update (bank);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  DeviceSim::undrive (int mcu) {
+    unsigned int bank = mcu / BankSize;
+
+    sync (bank);
+    writeReg (SIMEXTEN0 + bank, readReg (SIMEXTEN0 + bank) & ~ (1 << (mcu % BankSize)));
+    update (bank);
+  }
+
+// -----------------------------------------------------------------------------
+  // Masque des broches en sortie d'un banc, lu dans GPFSELn
+  unsigned int
+  DeviceSim::outputs (unsigned int bank) const {
+    unsigned int oen = 0;
+
+    for (unsigned int i = 0; i < BankSize; i++) {
+      unsigned int g = bank * BankSize + i;
+
+      if ( (g < GpioSize) && ( (readReg (GFPSEL0 + g / 10) >> ( (g % 10) * 3) & 7) == 1)) {
+
+        oen |= 1 << i;
+      }
+    }
+    return oen;
+  }
+
+// -----------------------------------------------------------------------------
+  // GPLEVn peut avoir été modifié directement (FastPin), les sorties qu'il
+  // contient sont recopiées dans les bascules avant toute modification
+  void
+  DeviceSim::sync (unsigned int bank) {
+    unsigned int oen = outputs (bank);
+
+    writeReg (SIMOUT0 + bank, (readReg (SIMOUT0 + bank) & ~oen) | (readReg (GPLEV0 + bank) & oen));
+  }
+
+// -----------------------------------------------------------------------------
+  // Calcul de GPLEVn : sorties, puis niveaux imposés, puis résistances de tirage
+  void
+  DeviceSim::update (unsigned int bank) {
+    unsigned int oen = outputs (bank);
+    unsigned int exten = readReg (SIMEXTEN0 + bank);
+    unsigned int in;
+
+    in = (readReg (SIMEXT0 + bank) & exten) | (readReg (SIMPUP0 + bank) & ~exten);
+    writeReg (GPLEV0 + bank, (readReg (SIMOUT0 + bank) & oen) | (in & ~oen));
+  }
+
+// -----------------------------------------------------------------------------
+  const std::map<Pin::Mode, std::string> &
+  DeviceSim::modes() const {
+    return _modes;
+  }
+
+// -----------------------------------------------------------------------------
+  const Gpio::Descriptor *
+  DeviceSim::descriptor() const {
+    return &_gpioDescriptor;
+  }
+
+// -----------------------------------------------------------------------------
+  const std::map<Pin::Mode, std::string> DeviceSim::_modes = {
+    {Pin::ModeInput, "in"},
+    {Pin::ModeOutput, "out"},
+    {Pin::ModeAlt0, "alt0"},
+    {Pin::ModeAlt1, "alt1"},
+    {Pin::ModeAlt2, "alt2"},
+    {Pin::ModeAlt3, "alt3"},
+    {Pin::ModeAlt4, "alt4"},
+    {Pin::ModeAlt5, "alt5"},
+  };
+
+// -----------------------------------------------------------------------------
+  const std::map<unsigned int, Pin::Mode> DeviceSim::_int2mode = {
+    {0, Pin::ModeInput},
+    {1, Pin::ModeOutput},
+    {4, Pin::ModeAlt0},
+    {5, Pin::ModeAlt1},
+    {6, Pin::ModeAlt2},
+    {7, Pin::ModeAlt3},
+    {3, Pin::ModeAlt4},
+    {2, Pin::ModeAlt5},
+  };
+
+// -----------------------------------------------------------------------------
+  const std::map<Pin::Mode, unsigned int> DeviceSim::_mode2int = {
+    {Pin::ModeInput, 0},
+    {Pin::ModeOutput, 1},
+    {Pin::ModeAlt0, 4},
+    {Pin::ModeAlt1, 5},
+    {Pin::ModeAlt2, 6},
+    {Pin::ModeAlt3, 7},
+    {Pin::ModeAlt4, 3},
+    {Pin::ModeAlt5, 2},
+  };
+
+// -----------------------------------------------------------------------------
+  static int dilConnector (int row, int column, int columns) {
+
+    return (row - 1) * columns + column;
+  }
+
+// -----------------------------------------------------------------------------
+  const Gpio::Descriptor DeviceSim::_gpioDescriptor = {
+    "sim",
+    {
+      // Connecteurs
+      {
+        "j8", 1, 20, 2, dilConnector,
+        {
+          {Pin::TypePower, { -1, -1, -1, 1, 1}, {{Pin::ModeInput, "3.3V"}}},
+          {Pin::TypePower, { -1, -1, -1, 1, 2}, {{Pin::ModeInput, "5V"}}},
+          {Pin::TypeGpio, {8, 2, 2, 2, 1}, {{Pin::ModeInput, "GPIO2"}, {Pin::ModeOutput, "GPIO2"}, {Pin::ModeAlt0, "SDA1"}, {Pin::ModeAlt1, "SA3"}}},
+          {Pin::TypePower, { -1, -1, -1, 2, 2}, {{Pin::ModeInput, "5V"}}},
+          {Pin::TypeGpio, {9, 3, 3, 3, 1}, {{Pin::ModeInput, "GPIO3"}, {Pin::ModeOutput, "GPIO3"}, {Pin::ModeAlt0, "SCL1"}, {Pin::ModeAlt1, "SA2"}}},
+          {Pin::TypePower, { -1, -1, -1, 3, 2}, {{Pin::ModeInput, "GND"}}},
+          {Pin::TypeGpio, {7, 4, 4, 4, 1}, {{Pin::ModeInput, "GPIO4"}, {Pin::ModeOutput, "GPIO4"}, {Pin::ModeAlt0, "GPCLK0"}, {Pin::ModeAlt1, "SA1"}, {Pin::ModeAlt5, "ARMTDI"}}},
+          {Pin::TypeGpio, {15, 14, 14, 4, 2}, {{Pin::ModeInput, "GPIO14"}, {Pin::ModeOutput, "GPIO14"}, {Pin::ModeAlt0, "TXD0"}, {Pin::ModeAlt1, "SD6"}, {Pin::ModeAlt5, "TXD1"}}},
+          {Pin::TypePower, { -1, -1, -1, 5, 1}, {{Pin::ModeInput, "GND"}}},
+          {Pin::TypeGpio, {16, 15, 15, 5, 2}, {{Pin::ModeInput, "GPIO15"}, {Pin::ModeOutput, "GPIO15"}, {Pin::ModeAlt0, "RXD0"}, {Pin::ModeAlt1, "SD7"}, {Pin::ModeAlt5, "RXD1"}}},
+          {Pin::TypeGpio, {0, 17, 17, 6, 1}, {{Pin::ModeInput, "GPIO17"}, {Pin::ModeOutput, "GPIO17"}, {Pin::ModeAlt1, "SD9"}, {Pin::ModeAlt3, "RTS0"}, {Pin::ModeAlt4, "SPI1CE1"}, {Pin::ModeAlt5, "RTS1"}}},
+          {Pin::TypeGpio, {1, 18, 18, 6, 2}, {{Pin::ModeInput, "GPIO18"}, {Pin::ModeOutput, "GPIO18"}, {Pin::ModeAlt0, "PCMCLK"}, {Pin::ModeAlt1, "SD10"}, {Pin::ModeAlt3, "BSMOSI"}, {Pin::ModeAlt4, "SPI1CE0"}, {Pin::ModeAlt5, "PWM0"}}},
+          {Pin::TypeGpio, {2, 27, 27, 7, 1}, {{Pin::ModeInput, "GPIO27"}, {Pin::ModeOutput, "GPIO27"}, {Pin::ModeAlt3, "SD1DAT3"}, {Pin::ModeAlt4, "ARMTMS"}}},
+          {Pin::TypePower, { -1, -1, -1, 7, 2}, {{Pin::ModeInput, "GND"}}},
+          {Pin::TypeGpio, {3, 22, 22, 8, 1}, {{Pin::ModeInput, "GPIO22"}, {Pin::ModeOutput, "GPIO22"}, {Pin::ModeAlt1, "SD14"}, {Pin::ModeAlt3, "SD1CLK"}, {Pin::ModeAlt4, "ARMTRST"}}},
+          {Pin::TypeGpio, {4, 23, 23, 8, 2}, {{Pin::ModeInput, "GPIO23"}, {Pin::ModeOutput, "GPIO23"}, {Pin::ModeAlt1, "SD15"}, {Pin::ModeAlt3, "SD1CMD"}, {Pin::ModeAlt4, "ARMRTCK"}}},
+          {Pin::TypePower, { -1, -1, -1, 9, 1}, {{Pin::ModeInput, "3.3V"}}},
+          {Pin::TypeGpio, {5, 24, 24, 9, 2}, {{Pin::ModeInput, "GPIO24"}, {Pin::ModeOutput, "GPIO24"}, {Pin::ModeAlt1, "SD16"}, {Pin::ModeAlt3, "SD1DAT0"}, {Pin::ModeAlt4, "ARMTDO"}}},
+          {Pin::TypeGpio, {12, 10, 10, 10, 1}, {{Pin::ModeInput, "GPIO10"}, {Pin::ModeOutput, "GPIO10"}, {Pin::ModeAlt0, "SPI0MOSI"}, {Pin::ModeAlt1, "SD2"}}},
+          {Pin::TypePower, { -1, -1, -1, 10, 2}, {{Pin::ModeInput, "GND"}}},
+          {Pin::TypeGpio, {13, 9, 9, 11, 1}, {{Pin::ModeInput, "GPIO9"}, {Pin::ModeOutput, "GPIO9"}, {Pin::ModeAlt0, "SPI0MISO"}, {Pin::ModeAlt1, "SD1"}}},
+          {Pin::TypeGpio, {6, 25, 25, 11, 2}, {{Pin::ModeInput, "GPIO25"}, {Pin::ModeOutput, "GPIO25"}, {Pin::ModeAlt1, "SD17"}, {Pin::ModeAlt3, "SD1DAT1"}, {Pin::ModeAlt4, "ARMTCK"}}},
+          {Pin::TypeGpio, {14, 11, 11, 12, 1}, {{Pin::ModeInput, "GPIO11"}, {Pin::ModeOutput, "GPIO11"}, {Pin::ModeAlt0, "SPI0SCLK"}, {Pin::ModeAlt1, "SD3"}}},
+          {Pin::TypeGpio, {10, 8, 8, 12, 2}, {{Pin::ModeInput, "GPIO8"}, {Pin::ModeOutput, "GPIO8"}, {Pin::ModeAlt0, "SPI0CE0"}, {Pin::ModeAlt1, "SD0"}}},
+          {Pin::TypePower, { -1, -1, -1, 13, 1}, {{Pin::ModeInput, "GND"}}},
+          {Pin::TypeGpio, {11, 7, 7, 13, 2}, {{Pin::ModeInput, "GPIO7"}, {Pin::ModeOutput, "GPIO7"}, {Pin::ModeAlt0, "SPI0CE1"}, {Pin::ModeAlt1, "SWE"}}},
+          {Pin::TypeGpio, {30, 0, 0, 14, 1}, {{Pin::ModeInput, "GPIO0"}, {Pin::ModeOutput, "GPIO0"}, {Pin::ModeAlt0, "SDA0"}, {Pin::ModeAlt1, "SA5"}}},
+          {Pin::TypeGpio, {31, 1, 1, 14, 2}, {{Pin::ModeInput, "GPIO1"}, {Pin::ModeOutput, "GPIO1"}, {Pin::ModeAlt0, "SCL0"}, {Pin::ModeAlt1, "SA4"}}},
+          {Pin::TypeGpio, {21, 5, 5, 15, 1}, {{Pin::ModeInput, "GPIO5"}, {Pin::ModeOutput, "GPIO5"}, {Pin::ModeAlt0, "GPCLK1"}, {Pin::ModeAlt1, "SA0"}, {Pin::ModeAlt5, "ARMTDO"}}},
+          {Pin::TypePower, { -1, -1, -1, 15, 2}, {{Pin::ModeInput, "GND"}}},
+          {Pin::TypeGpio, {22, 6, 6, 16, 1}, {{Pin::ModeInput, "GPIO6"}, {Pin::ModeOutput, "LAN_RUN"}, {Pin::ModeAlt0, "GPCLK2"}, {Pin::ModeAlt1, "SOE"}, {Pin::ModeAlt5, "ARMRTCK"}}},
+          {Pin::TypeGpio, {26, 12, 12, 16, 2}, {{Pin::ModeInput, "GPIO12"}, {Pin::ModeOutput, "GPIO12"}, {Pin::ModeAlt0, "PWM0"}, {Pin::ModeAlt1, "SD4"}, {Pin::ModeAlt5, "ARMTMS"}}},
+          {Pin::TypeGpio, {23, 13, 13, 17, 1}, {{Pin::ModeInput, "GPIO13"}, {Pin::ModeOutput, "GPIO13"}, {Pin::ModeAlt0, "PWM1"}, {Pin::ModeAlt1, "SD5"}, {Pin::ModeAlt5, "ARMTCK"}}},
+          {Pin::TypePower, { -1, -1, -1, 17, 2}, {{Pin::ModeInput, "GND"}}},
+          {Pin::TypeGpio, {24, 19, 19, 18, 1}, {{Pin::ModeInput, "GPIO19"}, {Pin::ModeOutput, "GPIO19"}, {Pin::ModeAlt0, "PCMFS"}, {Pin::ModeAlt1, "SD11"}, {Pin::ModeAlt3, "BSSCLK"}, {Pin::ModeAlt4, "SPI1MISO"}, {Pin::ModeAlt5, "PWM1"}}},
+          {Pin::TypeGpio, {27, 16, 16, 18, 2}, {{Pin::ModeInput, "GPIO16"}, {Pin::ModeOutput, "STAT_LED"}, {Pin::ModeAlt1, "SD8"}, {Pin::ModeAlt3, "CTS0"}, {Pin::ModeAlt4, "SPI1CE2"}, {Pin::ModeAlt5, "CTS1"}}},
+          {Pin::TypeGpio, {25, 26, 26, 19, 1}, {{Pin::ModeInput, "GPIO26"}, {Pin::ModeOutput, "GPIO26"}, {Pin::ModeAlt3, "SD1DAT2"}, {Pin::ModeAlt4, "ARMTDI"}}},
+          {Pin::TypeGpio, {28, 20, 20, 19, 2}, {{Pin::ModeInput, "GPIO20"}, {Pin::ModeOutput, "GPIO20"}, {Pin::ModeAlt0, "PCMDIN"}, {Pin::ModeAlt1, "SD12"}, {Pin::ModeAlt3, "BSMISO"}, {Pin::ModeAlt4, "SPI1MOSI"}, {Pin::ModeAlt5, "GPCLK0"}}},
+          {Pin::TypePower, { -1, -1, -1, 20, 1}, {{Pin::ModeInput, "GND"}}},
+          {Pin::TypeGpio, {29, 21, 21, 20, 2}, {{Pin::ModeInput, "GPIO21"}, {Pin::ModeOutput, "GPIO21"}, {Pin::ModeAlt0, "PCMDOUT"}, {Pin::ModeAlt1, "SD13"}, {Pin::ModeAlt3, "BSCE"}, {Pin::ModeAlt4, "SPI1SCLK"}, {Pin::ModeAlt5, "GPCLK1"}}},
+        }
+      },
+    }
+  };
+}
+/* ========================================================================== */
@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @brief Accès matériel GPIO simulé
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_DEVICE_SIM_H_
+#define _SYSIO_GPIO_DEVICE_SIM_H_
+
+#include <sysio/gpiodevice.h>
+#include <sysio/iomap.h>
+
+#ifndef __DOXYGEN__
+
+namespace Sysio {
+
+  /*
+   * @class DeviceSim
+   * @brief GPIO simulé par un banc de registres en mémoire
+   *
+   * Les registres reproduisent ceux du GPIO d'un BCM2835 (GPFSELn, GPSETn,
+   * GPCLRn, GPLEVn, GPPUD, GPPUDCLKn) dans une zone mémoire anonyme ouverte
+   * par xIoMapOpenMemory(), aucun droit ni matériel n'est nécessaire.
+   * GPLEVn reflète les sorties écrites par GPSETn/GPCLRn, le niveau imposé
+   * de l'extérieur par drive() ou la résistance de tirage des entrées. Les
+   * sorties peuvent aussi être écrites directement dans GPLEVn (FastPin).
+   * Le connecteur simulé est celui d'un Raspberry Pi modèle B+ (J8).
+   *
+   * Le GPIO simulé est choisi par le constructeur Gpio (layer, true) ou par
+   * la variable d'environnement SYSIO_GPIO_SIM différente de 0.
+   */
+  class DeviceSim : public Device {
+
+    public:
+      DeviceSim();
+      virtual ~DeviceSim();
+
+      const Gpio::Descriptor * descriptor() const;
+
+      bool open();
+      void close();
+      AccessLayer preferedAccessLayer() const;
+      unsigned int flags() const;
+
+      void setMode (const Pin * pin, Pin::Mode m);
+      void setPull (const Pin * pin, Pin::Pull p);
+      void write (const Pin * pin, bool v);
+      void toggle (const Pin * pin);
+
+      bool read (const Pin * pin) const;
+      Pin::Mode mode (const Pin * pin) const;
+      Pin::Pull pull (const Pin * pin) const;
+
+      const std::map<Pin::Mode, std::string> & modes() const;
+
+      unsigned int banks() const;
+      void pinBit (const Pin * pin, unsigned int & bank, unsigned int & bit) const;
+      void writeMask (unsigned int bank, uint32_t setMask, uint32_t clrMask);
+      uint32_t readBank (unsigned int bank) const;
+      void setPullMask (unsigned int bank, uint32_t mask, Pin::Pull p);
+      void snapshot (GpioState & state) const;
+      void fastRegisters (const Pin * pin, FastPinRegisters & r) const;
+
+      // Niveau imposé de l'extérieur sur une broche en entrée
+      void drive (int mcu, bool level);
+      // Libère une broche imposée par drive()
+      void undrive (int mcu);
+
+      // Indique si la variable d'environnement SYSIO_GPIO_SIM est validée
+      static bool isEnabled();
+
+    private:
+      xIoMap * _iomap;
+
+      inline unsigned int readReg (unsigned int offset) const {
+        return *pIo (_iomap, offset);
+      }
+
+      inline void writeReg (unsigned int offset, unsigned int value) {
+        *pIo (_iomap, offset) = value;
+      }
+
+      unsigned int outputs (unsigned int bank) const;
+      void sync (unsigned int bank);
+      void update (unsigned int bank);
+
+      static const std::map<unsigned int, Pin::Mode> _int2mode;
+      static const std::map<Pin::Mode, unsigned int> _mode2int;
+      static const std::map<Pin::Mode, std::string> _modes;
+      static const Gpio::Descriptor _gpioDescriptor;
+
+      static const unsigned int  GpioSize     = 54;
+      static const unsigned int  BankSize     = 32;
+      static const unsigned int  MapBlockSize = 4096;
+
+// Register offsets (BCM2835)
+      static const unsigned int GFPSEL0 = 0;
+      static const unsigned int GPSET0  = 7;
+      static const unsigned int GPCLR0  = 10;
+      static const unsigned int GPLEV0  = 13;
+      static const unsigned int GPPUD   = 37;
+      static const unsigned int GPPUDCLK0 = 38;
+// Simulation registers, not present on the SoC
+      static const unsigned int SIMOUT0 = 64;  // output latches
+      static const unsigned int SIMEXT0 = 68;  // external levels
+      static const unsigned int SIMEXTEN0 = 70; // external drive enables
+      static const unsigned int SIMPUP0 = 72;  // pull-up enables
+      static const unsigned int SIMPDN0 = 74;  // pull-down enables
+  };
+}
+#endif /* DOXYGEN not defined */
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_DEVICE_SIM_H_ defined */
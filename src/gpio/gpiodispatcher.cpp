@@ -0,0 +1,435 @@
+/**
+ * @file
+ * @brief Répartiteur des interruptions GPIO
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/gpiodispatcher.h>
+#include <sysio/scheduler.h>
+#include <sysio/gpioencoder.h>
+#include <system_error>
+#include <algorithm>
+#include <iostream>
+//
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "gpiochardev.h"
+#include "gpioeventring.h"
+#include "gpioedgecounter.h"
+
+namespace Sysio {
+
+// -----------------------------------------------------------------------------
+//
+//                      InterruptDispatcher Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  InterruptDispatcher &
+  InterruptDispatcher::instance() {
+    static InterruptDispatcher dispatcher;
+
+    return dispatcher;
+  }
+
+// -----------------------------------------------------------------------------
+  InterruptDispatcher::InterruptDispatcher() :
+    _epfd (-1), _stopfd (-1), _threads (1), _priority (50) {
+    struct epoll_event ev;
+
+    _epfd = epoll_create1 (EPOLL_CLOEXEC);
+    if (_epfd < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+
+    _stopfd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (_stopfd < 0) {
+      int err = errno;
+
+      ::close (_epfd);
+      throw std::system_error (err, std::system_category(), __FUNCTION__);
+    }
+
+    // pas de EPOLLONESHOT, l'arrêt doit réveiller tous les threads
+    ev.events = EPOLLIN;
+    ev.data.fd = _stopfd;
+    if (epoll_ctl (_epfd, EPOLL_CTL_ADD, _stopfd, &ev) < 0) {
+      int err = errno;
+
+      ::close (_stopfd);
+      ::close (_epfd);
+      throw std::system_error (err, std::system_category(), __FUNCTION__);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  InterruptDispatcher::~InterruptDispatcher() {
+
+    stop();
+    // Les broches encore enregistrées ne doivent plus faire appel au répartiteur
+    for (auto & s : _source) {
+
+      for (Pin * p : s.second.pin) {
+
+        p->_callback = nullptr;
+        p->_encoder = nullptr;
+        p->_attached = false;
+      }
+    }
+    ::close (_stopfd);
+    ::close (_epfd);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  InterruptDispatcher::setThreads (int n) {
+
+    if (n < 1) {
+
+      throw std::invalid_argument ("The dispatcher must have at least one thread");
+    }
+    if (n != _threads) {
+
+      _threads = n;
+      restart();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  InterruptDispatcher::threads() const {
+
+    return _threads;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  InterruptDispatcher::setRtPriority (int priority) {
+
+    if (priority != _priority) {
+
+      _priority = priority;
+      restart();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  InterruptDispatcher::rtPriority() const {
+
+    return _priority;
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  InterruptDispatcher::isRunning() const {
+
+    return !_thread.empty();
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  InterruptDispatcher::stop() {
+
+    if (isRunning()) {
+      uint64_t v = 1;
+
+      if (::write (_stopfd, &v, sizeof (v)) < 0) {
+
+        throw std::system_error (errno, std::system_category(), __FUNCTION__);
+      }
+
+      for (auto & t : _thread) {
+
+        t.join();
+      }
+      _thread.clear();
+
+      // remise à zéro de l'eventfd
+      if (::read (_stopfd, &v, sizeof (v)) < 0) {
+
+        throw std::system_error (errno, std::system_category(), __FUNCTION__);
+      }
+    }
+  }
+
+// -----------------------------------------------------------------------------
+//                                   Protected
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  void
+  InterruptDispatcher::add (Pin * pin) {
+    int fd = pinFd (pin);
+
+    {
+      std::lock_guard<std::mutex> lock (_mutex);
+      auto s = _source.find (fd);
+
+      if (s == _source.end()) {
+        struct epoll_event ev;
+        Source src;
+
+        src.charDev = pin->useCharDev();
+        src.busy = false;
+        src.pin.push_back (pin);
+
+        ev.events = (src.charDev ? EPOLLIN : (EPOLLPRI | EPOLLERR)) | EPOLLONESHOT;
+        ev.data.fd = fd;
+        if (epoll_ctl (_epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+
+          throw std::system_error (errno, std::system_category(), __FUNCTION__);
+        }
+        _source[fd] = src;
+      }
+      else {
+
+        s->second.pin.push_back (pin);
+      }
+    }
+
+    if (!isRunning()) {
+
+      start();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  InterruptDispatcher::remove (Pin * pin) {
+    std::unique_lock<std::mutex> lock (_mutex);
+
+    for (;;) {
+      auto s = _source.begin();
+
+      while ( (s != _source.end()) &&
+              (std::find (s->second.pin.begin(), s->second.pin.end(), pin) == s->second.pin.end())) {
+        ++s;
+      }
+
+      if (s == _source.end()) {
+
+        return;
+      }
+
+      // attente de la fin du traitement en cours, sauf si l'appel
+      // provient de la routine d'interruption elle-même
+      if (s->second.busy && (s->second.owner != std::this_thread::get_id())) {
+
+        _idle.wait (lock);
+        continue;
+      }
+
+      std::vector<Pin *> & v = s->second.pin;
+      v.erase (std::find (v.begin(), v.end(), pin));
+      if (v.empty()) {
+
+        epoll_ctl (_epfd, EPOLL_CTL_DEL, s->first, nullptr);
+        _source.erase (s);
+      }
+      return;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+//                                   Private
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  void
+  InterruptDispatcher::start() {
+
+    for (int i = 0; i < _threads; i++) {
+
+      _thread.push_back (std::thread (&InterruptDispatcher::loop, this));
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  InterruptDispatcher::restart() {
+
+    if (isRunning()) {
+
+      stop();
+      start();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  // Thread de traitement des interruptions
+  void
+  InterruptDispatcher::loop() {
+    struct epoll_event events[16];
+
+    try {
+
+      if (!Scheduler::applyProfile ("gpio-irq")) {
+
+        Scheduler::setRtPriority (_priority);
+      }
+    }
+    catch (std::system_error & e) {
+      // pas les droits nécessaires, priorité normale
+    }
+
+    for (;;) {
+      int n = epoll_wait (_epfd, events, 16, -1);
+
+      if (n < 0) {
+
+        if (errno == EINTR) {
+          continue;
+        }
+        std::cerr << __FUNCTION__ << ": " << std::system_category().message (errno) << std::endl;
+        return;
+      }
+
+      for (int i = 0; i < n; i++) {
+        int fd = events[i].data.fd;
+        Source src;
+
+        if (fd == _stopfd) {
+
+          return;
+        }
+
+        {
+          std::lock_guard<std::mutex> lock (_mutex);
+          auto s = _source.find (fd);
+
+          if (s == _source.end()) {
+            continue;
+          }
+          s->second.busy = true;
+          s->second.owner = std::this_thread::get_id();
+          src = s->second;
+        }
+
+        try {
+
+          process (fd, src);
+        }
+        catch (std::exception & e) {
+
+          std::cerr << __FUNCTION__ << ": " << e.what() << std::endl;
+        }
+
+        {
+          std::lock_guard<std::mutex> lock (_mutex);
+          auto s = _source.find (fd);
+
+          if (s != _source.end()) {
+            struct epoll_event ev;
+
+            s->second.busy = false;
+            // réarmement du descripteur (EPOLLONESHOT)
+            ev.events = (s->second.charDev ? EPOLLIN : (EPOLLPRI | EPOLLERR)) | EPOLLONESHOT;
+            ev.data.fd = fd;
+            epoll_ctl (_epfd, EPOLL_CTL_MOD, fd, &ev);
+          }
+        }
+        _idle.notify_all();
+      }
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  InterruptDispatcher::process (int fd, const Source & src) {
+
+    if (src.charDev) {
+      struct gpio_v2_line_event ev[16];
+      // copie, une routine peut détruire la broche qui détient la requête
+      std::shared_ptr<LineRequest> line = src.pin.front()->_line;
+      int n = line->readEvents (ev, 16);
+
+      for (int i = 0; i < n; i++) {
+        Pin::Edge e = (ev[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE) ?
+                      Pin::EdgeRising : Pin::EdgeFalling;
+
+        for (Pin * p : src.pin) {
+
+          // attached() en premier, p a pu être détruite par une routine
+          if (attached (fd, p) && (ev[i].offset == line->offset (p->_lineIndex))) {
+
+            notify (p, e, ev[i].timestamp_ns);
+          }
+        }
+      }
+    }
+    else {
+      struct timespec ts;
+      uint64_t t;
+      int v;
+
+      clock_gettime (CLOCK_MONOTONIC, &ts);
+      t = static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+      v = Pin::sysFsRead (fd); // acquitte l'interruption
+
+      for (Pin * p : src.pin) {
+        Pin::Edge e;
+
+        if (!attached (fd, p)) {
+
+          continue;
+        }
+        e = p->_edge;
+        if (e == Pin::EdgeBoth) {
+
+          e = (v > 0) ? Pin::EdgeRising : Pin::EdgeFalling;
+        }
+        notify (p, e, t);
+      }
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  // src.pin est une copie, une routine d'interruption appelée par process()
+  // a pu détacher (et détruire) une autre broche de la même source
+  bool
+  InterruptDispatcher::attached (int fd, const Pin * pin) const {
+    std::lock_guard<std::mutex> lock (_mutex);
+    auto s = _source.find (fd);
+
+    return (s != _source.end()) &&
+           (std::find (s->second.pin.begin(), s->second.pin.end(), pin) != s->second.pin.end());
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  InterruptDispatcher::notify (Pin * pin, Pin::Edge edge, uint64_t timestamp_ns) {
+
+    if (pin->_encoder) {
+
+      pin->_encoder->decode (pin->_channel, edge, timestamp_ns);
+    }
+    else if (pin->_counter) {
+
+      pin->_counter->push (timestamp_ns);
+    }
+    else if (pin->_events) {
+
+      pin->_events->push (timestamp_ns, edge);
+    }
+    if (pin->_callback) {
+      // copie, detachInterrupt() appelée par la routine efface _callback
+      Pin::Callback callback = pin->_callback;
+
+      callback (*pin, edge, timestamp_ns);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  InterruptDispatcher::pinFd (const Pin * pin) {
+
+    return pin->useCharDev() ? pin->_line->fd() : pin->_valueFd;
+  }
+}
+/* ========================================================================== */
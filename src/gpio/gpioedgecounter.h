@@ -0,0 +1,190 @@
+/**
+ * @file
+ * @brief Compteur de fronts d'une broche
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_EDGECOUNTER_H_
+#define _SYSIO_GPIO_EDGECOUNTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <time.h>
+
+#ifndef __DOXYGEN__
+
+namespace Sysio {
+
+  /*
+   * @class EdgeHistory
+   * @brief Historique circulaire de points (instant, valeur) sans verrou
+   *
+   * Au plus un point par milliseconde est mémorisé, chaque point correspond
+   * à un front réel. Plusieurs threads du répartiteur peuvent produire (cas
+   * d'un codeur dont les deux voies sont traitées en parallèle) : un seul
+   * écrit un point à un instant donné, les autres l'omettent sans attendre.
+   * Les lecteurs détectent un point en cours de réécriture par son numéro
+   * de séquence.
+   */
+  class EdgeHistory {
+
+    public:
+      // Durée minimale entre deux points en ns
+      static const int64_t resolution = 1000000LL;
+      // Nombre de points (puissance de 2), au moins 4 s
+      static const size_t size = 4096;
+
+      EdgeHistory() : _head (0), _last (0) {
+
+        _writing.clear();
+        for (auto & p : _point) {
+          p.seq.store (0, std::memory_order_relaxed);
+        }
+      }
+
+      // Producteurs
+      void push (uint64_t timestamp_ns, uint64_t value) {
+
+        if (_writing.test_and_set (std::memory_order_acquire)) {
+          return;
+        }
+        size_t h = _head.load (std::memory_order_relaxed);
+
+        if ( (h == 0) || (static_cast<int64_t> (timestamp_ns - _last) >= resolution)) {
+          Point & p = _point[h & (size - 1)];
+          uint32_t s = p.seq.load (std::memory_order_relaxed);
+
+          p.seq.store (s + 1, std::memory_order_relaxed); // impair: en cours
+          std::atomic_thread_fence (std::memory_order_release);
+          p.timestamp_ns.store (timestamp_ns, std::memory_order_relaxed);
+          p.value.store (value, std::memory_order_relaxed);
+          p.seq.store (s + 2, std::memory_order_release);
+          _head.store (h + 1, std::memory_order_release);
+          _last = timestamp_ns;
+        }
+        _writing.clear (std::memory_order_release);
+      }
+
+      // Variation moyenne par seconde de la valeur entre le premier et le
+      // dernier point postérieurs à since_ns, 0 s'il y en a moins de deux
+      double rate (uint64_t since_ns) const {
+        size_t h = _head.load (std::memory_order_acquire);
+        size_t n = (h < size) ? h : size - 1;
+        uint64_t t1 = 0, v1 = 0, t0 = 0, v0 = 0;
+        bool first = true;
+
+        // parcours du plus récent au plus ancien
+        for (size_t i = 1; i <= n; i++) {
+          uint64_t t, v;
+
+          if (!read (h - i, t, v) || (t < since_ns)) {
+            break;
+          }
+          if (first) {
+            t1 = t;
+            v1 = v;
+            first = false;
+          }
+          t0 = t;
+          v0 = v;
+        }
+
+        if (t1 > t0) {
+
+          return static_cast<double> (static_cast<int64_t> (v1 - v0)) * 1e9 / (t1 - t0);
+        }
+        return 0;
+      }
+
+      // Instant actuel en ns (CLOCK_MONOTONIC), base des fronts horodatés
+      static uint64_t now() {
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+      }
+
+      // Début d'une fenêtre se terminant maintenant
+      static uint64_t since (unsigned long window_ms) {
+        uint64_t t = now();
+        uint64_t w = window_ms * 1000000ULL;
+
+        return (t > w) ? t - w : 0;
+      }
+
+    private:
+      class Point {
+        public:
+          std::atomic<uint32_t> seq;
+          std::atomic<uint64_t> timestamp_ns;
+          std::atomic<uint64_t> value;
+      };
+
+      std::atomic_flag _writing;
+      std::atomic<size_t> _head; // prochain point
+      uint64_t _last; // instant du dernier point, protégé par _writing
+      Point _point[size];
+
+      // false si le point a été réécrit pendant la lecture
+      bool read (size_t i, uint64_t & t, uint64_t & v) const {
+        const Point & p = _point[i & (size - 1)];
+        uint32_t s = p.seq.load (std::memory_order_acquire);
+
+        t = p.timestamp_ns.load (std::memory_order_relaxed);
+        v = p.value.load (std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_acquire);
+        return ( (s & 1) == 0) && (s == p.seq.load (std::memory_order_relaxed));
+      }
+  };
+
+  /*
+   * @class EdgeCounter
+   * @brief Compteur de fronts sans verrou à un producteur
+   *
+   * Le producteur est le répartiteur d'interruptions (un seul thread traite
+   * une broche à un instant donné), il incrémente le compteur et renseigne
+   * l'historique. La fréquence sur une fenêtre est la moyenne exacte des
+   * périodes entre le premier et le dernier point de la fenêtre.
+   */
+  class EdgeCounter {
+
+    public:
+      EdgeCounter() : _count (0), _base (0) {}
+
+      uint64_t count() const {
+
+        return _count.load (std::memory_order_acquire) -
+               _base.load (std::memory_order_acquire);
+      }
+
+      void reset() {
+
+        _base.store (_count.load (std::memory_order_acquire),
+                     std::memory_order_release);
+      }
+
+      // Producteur
+      void push (uint64_t timestamp_ns) {
+        uint64_t c = _count.load (std::memory_order_relaxed) + 1;
+
+        _count.store (c, std::memory_order_release);
+        _history.push (timestamp_ns, c);
+      }
+
+      // Fréquence moyenne des fronts postérieurs à since_ns en Hz
+      double frequency (uint64_t since_ns) const {
+
+        return _history.rate (since_ns);
+      }
+
+    private:
+      std::atomic<uint64_t> _count;
+      std::atomic<uint64_t> _base; // valeur de _count à la remise à zéro
+      EdgeHistory _history;
+  };
+}
+#endif /* DOXYGEN not defined */
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_EDGECOUNTER_H_ defined */
@@ -0,0 +1,195 @@
+/**
+ * @file
+ * @brief Décodeur de codeur incrémental GPIO
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/gpioencoder.h>
+#include <sysio/gpiopingroup.h>
+#include <sysio/gpiodevice.h>
+#include <sysio/gpio.h>
+#include <stdexcept>
+#include "gpiochardev.h"
+#include "gpioedgecounter.h"
+#include "gpioquadrature.h"
+
+namespace Sysio {
+
+// -----------------------------------------------------------------------------
+//
+//                          QuadratureEncoder Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  QuadratureEncoder::QuadratureEncoder (Pin & a, Pin & b) :
+    _a (a), _b (b), _ordered (false), _sameBank (false), _bank (0), _bitA (0),
+    _bitB (0), _state (0), _raw (0), _base (0), _illegal (0), _dir (1),
+    _history (new EdgeHistory) {
+
+    if (_a._attached || _b._attached) {
+
+      throw std::logic_error ("Encoder pins must not have an interrupt routine");
+    }
+
+    _a.setMode (Pin::ModeInput);
+    _b.setMode (Pin::ModeInput);
+
+    if ( (_a.accessLayer() & AccessLayerCharDev) && (_a.gpio() == _b.gpio())) {
+
+      // les deux voies dans une seule requête, leurs fronts sont mis dans
+      // la même file par le noyau dans l'ordre chronologique
+      _a.forceUseCharDev (true);
+      _b.forceUseCharDev (true);
+      PinGroup g ({&_a, &_b});
+
+      if (g._lines.empty()) {
+
+        g.initLines(); // PinGroup utilise les ports avec AccessLayerIoMap
+      }
+    }
+    _ordered = _a.useCharDev() && _b.useCharDev() && _a._line &&
+               (_a._line == _b._line);
+
+    if (!_ordered && (_a.gpio() == _b.gpio()) &&
+        (_a.gpio()->accessLayer() & AccessLayerIoMap) &&
+        (_a.device()->flags() & Device::hasPortAccess)) {
+      unsigned int bank;
+
+      _a.device()->pinBit (&_a, _bank, _bitA);
+      _a.device()->pinBit (&_b, bank, _bitB);
+      _sameBank = (bank == _bank);
+    }
+    _state = levels();
+
+    // le décodeur doit être connu avant l'enregistrement auprès du répartiteur
+    _a._encoder = this;
+    _a._channel = 0;
+    _a.attach (Pin::EdgeBoth);
+    try {
+
+      _b._encoder = this;
+      _b._channel = 1;
+      _b.attach (Pin::EdgeBoth);
+    }
+    catch (...) {
+
+      _a.detachInterrupt();
+      throw;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  QuadratureEncoder::~QuadratureEncoder() {
+
+    _a.detachInterrupt();
+    _b.detachInterrupt();
+  }
+
+// -----------------------------------------------------------------------------
+  int64_t
+  QuadratureEncoder::position() const {
+
+    return _raw.load (std::memory_order_acquire) -
+           _base.load (std::memory_order_acquire);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  QuadratureEncoder::setPosition (int64_t position) {
+
+    _base.store (_raw.load (std::memory_order_acquire) - position,
+                 std::memory_order_release);
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  QuadratureEncoder::illegalTransitions() const {
+
+    return _illegal.load (std::memory_order_relaxed);
+  }
+
+// -----------------------------------------------------------------------------
+  double
+  QuadratureEncoder::velocity (unsigned long window_ms) const {
+
+    return _history->rate (EdgeHistory::since (window_ms));
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  QuadratureEncoder::setReversed (bool reversed) {
+
+    _dir.store (reversed ? -1 : 1, std::memory_order_relaxed);
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  QuadratureEncoder::reversed() const {
+
+    return _dir.load (std::memory_order_relaxed) < 0;
+  }
+
+// -----------------------------------------------------------------------------
+//                                   Protected
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  void
+  QuadratureEncoder::decode (int channel, Pin::Edge edge, uint64_t timestamp_ns) {
+    int64_t d;
+
+    if (_ordered) {
+
+      d = quadratureStep (_state, channel, edge);
+    }
+    else {
+      // fronts des deux voies reçus dans le désordre par deux threads,
+      // seuls les niveaux lus au même instant sont décodés
+      std::lock_guard<std::mutex> lock (_mutex);
+
+      d = quadratureLevels (_state, levels());
+    }
+
+    if (d == 0) {
+
+      return; // front déjà pris en compte par une lecture précédente
+    }
+    if (d == QuadratureIllegal) {
+
+      // un front a été perdu
+      _illegal.fetch_add (1, std::memory_order_relaxed);
+      return;
+    }
+
+    d *= _dir.load (std::memory_order_relaxed);
+    _history->push (timestamp_ns,
+                    static_cast<uint64_t> (_raw.fetch_add (d, std::memory_order_acq_rel) + d));
+  }
+
+// -----------------------------------------------------------------------------
+//                                   Private
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  unsigned
+  QuadratureEncoder::levels() const {
+
+    if (_ordered) {
+      uint64_t mask = (1ULL << _a._lineIndex) | (1ULL << _b._lineIndex);
+      uint64_t v = _a._line->getValues (mask);
+
+      return ( (v >> _a._lineIndex) & 1) | ( ( (v >> _b._lineIndex) & 1) << 1);
+    }
+
+    if (_sameBank) {
+      uint32_t v = _a.device()->readBank (_bank);
+
+      return ( (v >> _bitA) & 1) | ( ( (v >> _bitB) & 1) << 1);
+    }
+
+    return (_a.read() ? 1 : 0) | (_b.read() ? 2 : 0);
+  }
+}
+/* ========================================================================== */
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * @brief Tampon circulaire des fronts d'une broche
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_EVENTRING_H_
+#define _SYSIO_GPIO_EVENTRING_H_
+
+#include <sysio/gpiopin.h>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#ifndef __DOXYGEN__
+
+namespace Sysio {
+
+  /*
+   * @class EventRing
+   * @brief File sans verrou à un producteur et un consommateur
+   *
+   * Le producteur est le répartiteur d'interruptions (un seul thread traite
+   * une broche à un instant donné), le consommateur est l'utilisateur de
+   * Pin::drainEvents(). Les indices croissent sans fin, seuls leurs bits de
+   * poids faibles sont utilisés (capacité puissance de 2). Lorsque la file
+   * est pleine, le nouveau front est perdu et le compteur de débordement
+   * est incrémenté.
+   */
+  class EventRing {
+
+    public:
+      explicit EventRing (size_t capacity) :
+        _head (0), _tail (0), _overflows (0) {
+        size_t n = 1;
+
+        while (n < capacity) {
+          n <<= 1;
+        }
+        _buffer.resize (n);
+        _mask = n - 1;
+      }
+
+      size_t capacity() const {
+
+        return _buffer.size();
+      }
+
+      size_t size() const {
+
+        return _head.load (std::memory_order_acquire) -
+               _tail.load (std::memory_order_acquire);
+      }
+
+      uint64_t overflows() const {
+
+        return _overflows.load (std::memory_order_relaxed);
+      }
+
+      // Producteur
+      bool push (uint64_t timestamp_ns, Pin::Edge edge) {
+        size_t h = _head.load (std::memory_order_relaxed);
+
+        if ( (h - _tail.load (std::memory_order_acquire)) > _mask) {
+
+          _overflows.fetch_add (1, std::memory_order_relaxed);
+          return false;
+        }
+        _buffer[h & _mask].timestamp_ns = timestamp_ns;
+        _buffer[h & _mask].edge = edge;
+        _head.store (h + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Consommateur
+      size_t drain (Pin::Event * events, size_t max) {
+        size_t t = _tail.load (std::memory_order_relaxed);
+        size_t n = _head.load (std::memory_order_acquire) - t;
+
+        if (n > max) {
+          n = max;
+        }
+        for (size_t i = 0; i < n; i++) {
+
+          events[i] = _buffer[ (t + i) & _mask];
+        }
+        _tail.store (t + n, std::memory_order_release);
+        return n;
+      }
+
+    private:
+      std::vector<Pin::Event> _buffer;
+      size_t _mask;
+      std::atomic<size_t> _head; // prochaine écriture
+      std::atomic<size_t> _tail; // prochaine lecture
+      std::atomic<uint64_t> _overflows;
+  };
+}
+#endif /* DOXYGEN not defined */
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_EVENTRING_H_ defined */
@@ -0,0 +1,40 @@
+/**
+ * @file
+ * @brief GPIO Fast Pin
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/gpio.h>
+#include <sysio/gpiodevice.h>
+#include <sysio/gpiofastpin.h>
+
+namespace Sysio {
+
+// -----------------------------------------------------------------------------
+//
+//                        FastPinRegisters Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  FastPinRegisters
+  FastPinRegisters::get (Pin & pin) {
+    FastPinRegisters r;
+
+    if (!pin.isOpen() || (pin.type() != Pin::TypeGpio)) {
+
+      throw std::invalid_argument ("FastPin needs an open GPIO pin");
+    }
+
+    if ( (pin.gpio()->accessLayer() & AccessLayerIoMap) == 0 ||
+         pin.useSysFs() || pin.useCharDev()) {
+
+      throw std::invalid_argument ("FastPin needs the iomap access layer");
+    }
+
+    pin.device()->fastRegisters (&pin, r);
+    return r;
+  }
+}
+/* ========================================================================== */
@@ -0,0 +1,423 @@
+/**
+ * @file
+ * @brief Maître 1-Wire GPIO
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/gpioonewire.h>
+#include <system_error>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include "gpiosoftline.h"
+
+namespace Sysio {
+
+  // Durées des créneaux en vitesse standard en ns (note d'application 126)
+  static const uint64_t tA = 6000; // début d'écriture d'un 1 ou de lecture
+  static const uint64_t tB = 64000; // fin d'écriture d'un 1
+  static const uint64_t tC = 60000; // écriture d'un 0
+  static const uint64_t tD = 10000; // fin d'écriture d'un 0
+  static const uint64_t tE = 9000; // échantillonnage en lecture
+  static const uint64_t tF = 55000; // fin de lecture
+  static const uint64_t tH = 480000; // impulsion de réinitialisation
+  static const uint64_t tI = 70000; // échantillonnage de la présence
+  static const uint64_t tJ = 410000; // fin de réinitialisation
+
+  // Commandes
+  static const uint8_t cmdSearchRom = 0xF0;
+  static const uint8_t cmdAlarmSearch = 0xEC;
+  static const uint8_t cmdMatchRom = 0x55;
+  static const uint8_t cmdSkipRom = 0xCC;
+  static const uint8_t cmdConvertT = 0x44;
+  static const uint8_t cmdReadScratchpad = 0xBE;
+  static const uint8_t cmdReadPowerSupply = 0xB4;
+
+// -----------------------------------------------------------------------------
+//
+//                          OneWire Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  OneWire::OneWire (Pin & pin) : _line (new SoftLine) {
+
+    // les créneaux de quelques µs ne peuvent pas être tenus par sysfs ou le
+    // chardev, l'exception de get() est transmise à l'appelant
+    (void) FastPinRegisters::get (pin);
+    pin.setMode (Pin::ModeInput);
+    _line->attach (pin, true);
+    if (!_line->isFast()) {
+
+      throw std::system_error (ENOTSUP, std::system_category(), "OneWire needs an open-drain fast pin");
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  OneWire::OneWire() {}
+
+// -----------------------------------------------------------------------------
+  OneWire::~OneWire() {
+
+    if (_line) {
+
+      _line->drainRelease();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  // Les durées sont comptées à partir du front descendant de chaque créneau
+  bool
+  OneWire::reset() {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+    uint64_t t;
+    bool presence;
+
+    _line->drainLow();
+    t = SoftLine::nanos();
+    SoftLine::waitUntil (t + tH);
+    _line->drainRelease();
+    t = SoftLine::nanos();
+    SoftLine::waitUntil (t + tI);
+    presence = !_line->read();
+    SoftLine::waitUntil (t + tI + tJ);
+    return presence;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  OneWire::writeBit (bool bit) {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+    uint64_t t;
+
+    _line->drainLow();
+    t = SoftLine::nanos();
+    if (bit) {
+
+      SoftLine::waitUntil (t + tA);
+      _line->drainRelease();
+      SoftLine::waitUntil (t + tA + tB);
+    }
+    else {
+
+      SoftLine::waitUntil (t + tC);
+      _line->drainRelease();
+      SoftLine::waitUntil (t + tC + tD);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  OneWire::readBit() {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+    uint64_t t;
+    bool bit;
+
+    _line->drainLow();
+    t = SoftLine::nanos();
+    SoftLine::waitUntil (t + tA);
+    _line->drainRelease();
+    SoftLine::waitUntil (t + tA + tE);
+    bit = _line->read();
+    SoftLine::waitUntil (t + tA + tE + tF);
+    return bit;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  OneWire::write (uint8_t byte) {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+
+    for (int i = 0; i < 8; i++) {
+
+      writeBit ( (byte >> i) & 1);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  OneWire::write (const uint8_t * buf, size_t len) {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+
+    for (size_t i = 0; i < len; i++) {
+
+      write (buf[i]);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  uint8_t
+  OneWire::read() {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+    uint8_t byte = 0;
+
+    for (int i = 0; i < 8; i++) {
+
+      if (readBit()) {
+
+        byte |= 1 << i;
+      }
+    }
+    return byte;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  OneWire::read (uint8_t * buf, size_t len) {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+
+    for (size_t i = 0; i < len; i++) {
+
+      buf[i] = read();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  OneWire::select (uint64_t rom) {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+
+    write (cmdMatchRom);
+    for (int i = 0; i < 8; i++) {
+
+      write (static_cast<uint8_t> (rom >> (i * 8)));
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  OneWire::skip() {
+
+    write (cmdSkipRom);
+  }
+
+// -----------------------------------------------------------------------------
+  // À chaque bit, les esclaves encore sélectionnés transmettent leur bit puis
+  // son complément. Si les deux valent 0, il y a divergence : la branche 0
+  // est suivie en premier, la dernière divergence où la branche 0 a été
+  // choisie est reprise avec la branche 1 au passage suivant.
+  std::vector<uint64_t>
+  OneWire::search (bool alarm) {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+    std::vector<uint64_t> roms;
+    uint64_t rom = 0;
+    int lastDiscrepancy = 0;
+
+    do {
+      int lastZero = 0;
+      uint8_t buf[8];
+
+      if (!reset()) {
+
+        break;
+      }
+      write (alarm ? cmdAlarmSearch : cmdSearchRom);
+
+      for (int i = 1; i <= 64; i++) {
+        const uint64_t mask = 1ULL << (i - 1);
+        bool id = readBit();
+        bool cmp = readBit();
+        bool dir;
+
+        if (id && cmp) {
+
+          if ( (i == 1) && roms.empty()) {
+            // aucun esclave ne répond (pas d'alarme)
+            return roms;
+          }
+          throw std::system_error (EIO, std::system_category(), "OneWire search failed");
+        }
+
+        if (id != cmp) {
+
+          dir = id;
+        }
+        else {
+
+          if (i < lastDiscrepancy) {
+
+            dir = (rom & mask) != 0;
+          }
+          else {
+
+            dir = (i == lastDiscrepancy);
+          }
+          if (!dir) {
+
+            lastZero = i;
+          }
+        }
+
+        if (dir) {
+
+          rom |= mask;
+        }
+        else {
+
+          rom &= ~mask;
+        }
+        writeBit (dir);
+      }
+
+      for (int i = 0; i < 8; i++) {
+
+        buf[i] = rom >> (i * 8);
+      }
+      // un bus bloqué à l'état bas donne un identifiant nul dont le CRC est
+      // correct
+      if ( (rom == 0) || (crc8 (buf, 8) != 0)) {
+
+        throw std::system_error (EIO, std::system_category(), "OneWire ROM CRC error");
+      }
+      roms.push_back (rom);
+      lastDiscrepancy = lastZero;
+    }
+    while (lastDiscrepancy != 0);
+
+    return roms;
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  OneWire::parasitePowered() {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+
+    if (!reset()) {
+
+      return false;
+    }
+    skip();
+    write (cmdReadPowerSupply);
+    return !readBit();
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  OneWire::convertAll (unsigned long timeout_ms) {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+    bool parasite = parasitePowered();
+
+    if (!reset()) {
+
+      return false;
+    }
+    skip();
+    write (cmdConvertT);
+
+    if (parasite) {
+
+      // alimentation forte pendant la conversion (par la broche, sinon par
+      // la classe dérivée)
+      if (_line) {
+
+        _line->write (true);
+        _line->setOutput();
+      }
+      std::this_thread::sleep_for (std::chrono::milliseconds (timeout_ms));
+      if (_line) {
+
+        _line->drainRelease();
+      }
+      return true;
+    }
+
+    // les capteurs répondent 0 tant que la conversion est en cours
+    auto limit = std::chrono::steady_clock::now() + std::chrono::milliseconds (timeout_ms);
+    while (!readBit()) {
+
+      if (std::chrono::steady_clock::now() > limit) {
+
+        return false;
+      }
+      std::this_thread::sleep_for (std::chrono::milliseconds (5));
+    }
+    return true;
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  OneWire::readScratchpad (uint64_t rom, uint8_t * sp) {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+    uint8_t any = 0;
+
+    if (!reset()) {
+
+      return false;
+    }
+    select (rom);
+    write (cmdReadScratchpad);
+    read (sp, 9);
+
+    // un bus bloqué à l'état bas donne un bloc nul dont le CRC est correct
+    for (int i = 0; i < 9; i++) {
+
+      any |= sp[i];
+    }
+    return any && (crc8 (sp, 9) == 0);
+  }
+
+// -----------------------------------------------------------------------------
+  double
+  OneWire::readTemperature (uint64_t rom) {
+    uint8_t sp[9];
+    int16_t raw;
+
+    if (!readScratchpad (rom, sp)) {
+
+      return NAN;
+    }
+
+    raw = static_cast<int16_t> ( (sp[1] << 8) | sp[0]);
+    if (family (rom) == FamilyDS18S20) {
+
+      // résolution étendue à partir des compteurs COUNT_REMAIN et COUNT_PER_C
+      if (sp[7]) {
+
+        return (raw >> 1) - 0.25 + static_cast<double> (sp[7] - sp[6]) / sp[7];
+      }
+      return raw / 2.0;
+    }
+    return raw / 16.0;
+  }
+
+// -----------------------------------------------------------------------------
+  std::vector<double>
+  OneWire::readTemperatures (const std::vector<uint64_t> & roms,
+                             unsigned long timeout_ms) {
+    std::lock_guard<std::recursive_mutex> lock (_mutex);
+    std::vector<double> t (roms.size(), NAN);
+
+    if (convertAll (timeout_ms)) {
+
+      for (size_t i = 0; i < roms.size(); i++) {
+
+        t[i] = readTemperature (roms[i]);
+      }
+    }
+    return t;
+  }
+
+// -----------------------------------------------------------------------------
+  uint8_t
+  OneWire::crc8 (const uint8_t * buf, size_t len) {
+    uint8_t crc = 0;
+
+    for (size_t i = 0; i < len; i++) {
+      uint8_t b = buf[i];
+
+      for (int j = 0; j < 8; j++) {
+        bool mix = (crc ^ b) & 1;
+
+        crc >>= 1;
+        if (mix) {
+
+          crc ^= 0x8C;
+        }
+        b >>= 1;
+      }
+    }
+    return crc;
+  }
+}
+/* ========================================================================== */
@@ -7,8 +7,12 @@
  */
 #include <sysio/gpio.h>
 #include <sysio/gpiodevice.h>
-#include <sysio/scheduler.h>
+#include <sysio/gpiodispatcher.h>
 #include <exception>
+#include <stdexcept>
+#include "gpiochardev.h"
+#include "gpioeventring.h"
+#include "gpioedgecounter.h"
 #include <fstream>
 #include <sstream>
 //
@@ -90,12 +94,21 @@ namespace Sysio {
   Pin::Pin (Connector * parent, const Descriptor * desc) :
     _isopen (false), _parent (parent), _descriptor (desc), _holdMode (ModeUnknown),
     _holdPull (PullUnknown), _holdState (false), _useSysFs (false),
-    _valueFd (-1), _firstPolling (true), _edge (EdgeUnknown), _mode (ModeUnknown),
-    _pull (PullUnknown), _run (false) {
+    _valueFd (-1), _useCharDev (false), _lineIndex (0), _firstPolling (true),
+    _edge (EdgeUnknown), _mode (ModeUnknown), _pull (PullUnknown), _attached (false),
+    _encoder (nullptr), _channel (0) {
+    AccessLayer layer = parent->gpio()->accessLayer();
 
-    if ( (parent->gpio()->accessLayer() & AccessLayerIoMap) != AccessLayerIoMap) {
+    if ( (layer & AccessLayerIoMap) != AccessLayerIoMap) {
 
-      _useSysFs = true;
+      if (layer & AccessLayerCharDev) {
+
+        _useCharDev = true;
+      }
+      else {
+
+        _useSysFs = true;
+      }
     }
   }
 
@@ -168,9 +181,9 @@ namespace Sysio {
 
     if (type() == TypeGpio) {
       _edge = e;
-      if (isOpen() && _useSysFs) {
+      if (isOpen()) {
 
-        sysFsSetEdge();
+        writeEdge();
       }
     }
   }
@@ -180,9 +193,9 @@ namespace Sysio {
   Pin::Edge
   Pin::edge() {
 
-    if (isOpen() && (type() == TypeGpio) && _useSysFs) {
+    if (isOpen() && (type() == TypeGpio) && (_useSysFs || _useCharDev)) {
 
-      sysFsGetEdge();
+      readEdge();
     }
     return _edge;
   }
@@ -194,11 +207,18 @@ namespace Sysio {
     return _useSysFs;
   }
 
+// -----------------------------------------------------------------------------
+  bool
+  Pin::useCharDev() const {
+
+    return _useCharDev;
+  }
+
 // -----------------------------------------------------------------------------
   AccessLayer
   Pin::accessLayer() const {
 
-    gpio()->accessLayer();
+    return gpio()->accessLayer();
   }
 
 // -----------------------------------------------------------------------------
@@ -434,6 +454,11 @@ namespace Sysio {
           throw std::system_error (errno, std::system_category(), __FUNCTION__);
         }
       }
+      else if (_useCharDev) {
+        uint64_t mask = 1ULL << _lineIndex;
+
+        _line->setValues (mask, value ? mask : 0);
+      }
       else {
 
         device()->write (this, value);
@@ -447,7 +472,7 @@ namespace Sysio {
 
     if (isOpen() && (type() == TypeGpio)) {
 
-      if (!_useSysFs) {
+      if (!_useSysFs && !_useCharDev) {
 
         if (device()->flags() & Device::hasToggle) {
 
@@ -476,8 +501,14 @@ namespace Sysio {
         return ret > 0;
       }
 
+      if (_useCharDev) {
+
+        return _line->getValues (1ULL << _lineIndex) != 0;
+      }
+
       return device()->read (this);
     }
+    return false;
   }
 
 // -----------------------------------------------------------------------------
@@ -510,6 +541,10 @@ namespace Sysio {
 
     if (isOpen() && (_useSysFs != enable)) {
 
+      if (enable && _useCharDev) {
+
+        forceUseCharDev (false);
+      }
       _useSysFs = sysFsEnable (enable);
     }
     else {
@@ -519,6 +554,25 @@ namespace Sysio {
     return useSysFs();
   }
 
+// -----------------------------------------------------------------------------
+  bool
+  Pin::forceUseCharDev (bool enable) {
+
+    if (isOpen() && (_useCharDev != enable)) {
+
+      if (enable && _useSysFs) {
+
+        forceUseSysFs (false);
+      }
+      _useCharDev = charDevEnable (enable);
+    }
+    else {
+
+      _useCharDev = enable;
+    }
+    return useCharDev();
+  }
+
 // -----------------------------------------------------------------------------
   void
   Pin::waitForInterrupt (Pin::Edge e, int timeout_ms) {
@@ -529,13 +583,17 @@ namespace Sysio {
       if (_firstPolling) {
 
         setEdge (EdgeNone);
-        forceUseSysFs (true);
-        setEdge (e);
-        // clear pending irq
-        if (sysFsPoll (_valueFd, 1) > 0) {
+        if (accessLayer() & AccessLayerCharDev) {
 
-          sysFsRead (_valueFd);
+          forceUseCharDev (true);
         }
+        else {
+
+          forceUseSysFs (true);
+        }
+        setEdge (e);
+        // clear pending irq
+        pollInterrupt (1);
         _firstPolling = false;
       }
 
@@ -544,7 +602,7 @@ namespace Sysio {
         setEdge (e);
       }
 
-      ret = sysFsPoll (_valueFd, timeout_ms);
+      ret = pollInterrupt (timeout_ms);
       if (ret < 0) {
 
         throw std::system_error (errno, std::system_category(), __FUNCTION__);
@@ -560,18 +618,21 @@ namespace Sysio {
   void
   Pin::attachInterrupt (Isr isr, Edge e) {
 
-    if (!_thread.joinable()) {
+    attachInterrupt ([isr] (Pin &, Edge, uint64_t) {
+      isr();
+    }, e);
+  }
 
-      setEdge (EdgeNone);
-      forceUseSysFs (true);
-      setEdge (e);
-      // clear pending irq
-      if (sysFsPoll (_valueFd, 1) > 0) {
+// -----------------------------------------------------------------------------
+  void
+  Pin::attachInterrupt (Callback callback, Edge e) {
 
-        sysFsRead (_valueFd);
-      }
-      _run = true;
-      _thread = std::thread (irqThread, std::ref (_run), _valueFd, isr);
+    if (!_attached) {
+
+      _events.reset();
+      _counter.reset();
+      _callback = callback;
+      attach (e);
     }
   }
 
@@ -579,13 +640,112 @@ namespace Sysio {
   void
   Pin::detachInterrupt() {
 
-    if (_thread.joinable()) {
+    if (_attached) {
 
-      _run = false;
-      _thread.join();
+      InterruptDispatcher::instance().remove (this);
+      _callback = nullptr;
+      _encoder = nullptr;
+      _attached = false;
     }
   }
 
+// -----------------------------------------------------------------------------
+  void
+  Pin::attachEvents (Edge e, size_t capacity) {
+
+    if (!_attached) {
+
+      if (capacity == 0) {
+
+        throw std::invalid_argument ("The event buffer can not be empty");
+      }
+      _counter.reset();
+      _events.reset (new EventRing (capacity));
+      attach (e);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  size_t
+  Pin::drainEvents (Event * events, size_t max) {
+
+    return _events ? _events->drain (events, max) : 0;
+  }
+
+// -----------------------------------------------------------------------------
+  size_t
+  Pin::drainEvents (std::vector<Event> & events, size_t max) {
+    size_t n = pendingEvents();
+
+    if (n > max) {
+      n = max;
+    }
+    if (n > 0) {
+      size_t s = events.size();
+
+      events.resize (s + n);
+      n = drainEvents (&events[s], n);
+      events.resize (s + n);
+    }
+    return n;
+  }
+
+// -----------------------------------------------------------------------------
+  size_t
+  Pin::pendingEvents() const {
+
+    return _events ? _events->size() : 0;
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Pin::eventOverflows() const {
+
+    return _events ? _events->overflows() : 0;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Pin::enableCounter (Edge e) {
+
+    if (_attached) {
+
+      // le compteur resterait à zéro sans que l'appelant le sache
+      throw std::logic_error ("Pin already has an interrupt routine");
+    }
+    _events.reset();
+    _counter.reset (new EdgeCounter);
+    attach (e);
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Pin::counter() const {
+
+    return _counter ? _counter->count() : 0;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Pin::resetCounter() {
+
+    if (_counter) {
+
+      _counter->reset();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  double
+  Pin::frequency (unsigned long window_ms) const {
+
+    if (_counter) {
+
+      return _counter->frequency (EdgeHistory::since (window_ms));
+    }
+    return 0;
+  }
+
 // -----------------------------------------------------------------------------
 //                                   Protected
 // -----------------------------------------------------------------------------
@@ -602,6 +762,10 @@ namespace Sysio {
 
           _isopen = sysFsEnable (true);
         }
+        else if (_useCharDev) {
+
+          _isopen = charDevEnable (true);
+        }
         else {
 
           _isopen = true;
@@ -661,6 +825,7 @@ namespace Sysio {
 
           release();
         }
+        charDevEnable (false); // libère la ligne
       }
       _isopen = false;
     }
@@ -670,7 +835,12 @@ namespace Sysio {
   void
   Pin::writePull () {
 
-    if (device()) {
+    if (_useCharDev) {
+
+      holdPull();
+      charDevUpdate();
+    }
+    else if (device()) {
 
       holdPull();
       device()->setPull (this, _pull);
@@ -681,6 +851,11 @@ namespace Sysio {
   void
   Pin::readPull ()  {
 
+    if (_useCharDev) {
+
+      charDevGetPull();
+      return;
+    }
     if (device()) {
       if (device()->flags() & Device::hasPullRead) {
 
@@ -699,6 +874,10 @@ namespace Sysio {
 
       sysFsGetMode();
     }
+    else if (_useCharDev) {
+
+      charDevGetMode();
+    }
     else {
 
       _mode = device()->mode (this);
@@ -714,6 +893,10 @@ namespace Sysio {
 
       sysFsSetMode();
     }
+    else if (_useCharDev) {
+
+      charDevUpdate();
+    }
     else {
 
       device()->setMode (this, _mode);
@@ -728,6 +911,10 @@ namespace Sysio {
 
       sysFsGetEdge();
     }
+    else if (_useCharDev) {
+
+      charDevGetEdge();
+    }
     else {
 
       _edge = EdgeUnknown;
@@ -742,6 +929,10 @@ namespace Sysio {
 
       sysFsSetEdge();
     }
+    else if (_useCharDev) {
+
+      charDevUpdate();
+    }
   }
 
 // -----------------------------------------------------------------------------
@@ -749,45 +940,51 @@ namespace Sysio {
 // -----------------------------------------------------------------------------
 
 // -----------------------------------------------------------------------------
-// Thread de surveillance des entrées du port
-  void *
-  Pin::irqThread (std::atomic<int> & run, int fd, Isr isr) {
-    int ret;
-
-    Scheduler::setRtPriority (50);
+  // Enregistrement auprès du répartiteur d'interruptions
+  void
+  Pin::attach (Edge e) {
 
     try {
-      while (run) {
 
-        ret = sysFsPoll (fd, 100);
-        if (ret > 0) {
+      setEdge (EdgeNone);
+      if (accessLayer() & AccessLayerCharDev) {
 
-          isr();
-        }
-        else if (ret < 0) {
+        forceUseCharDev (true);
+      }
+      else {
 
-          throw std::system_error (errno, std::system_category(), __FUNCTION__);
-        }
+        forceUseSysFs (true);
       }
+      setEdge (e);
+      // clear pending irq
+      pollInterrupt (1);
+      InterruptDispatcher::instance().add (this);
+      _attached = true;
     }
-    catch (std::system_error & e) {
+    catch (...) {
 
-      std::cerr << e.what() << "(code " << e.code() << ")" << std::endl;
-      std::terminate();
+      _callback = nullptr;
+      _encoder = nullptr;
+      throw;
     }
-    catch (...) {
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  Pin::pollInterrupt (int timeout_ms) {
 
+    if (_useCharDev) {
+
+      return charDevPoll (timeout_ms);
     }
-#ifndef NDEBUG
-    std::cout << std::endl << __FUNCTION__ << " terminated" << std::endl;
-#endif
-    return 0;
+    return sysFsPoll (_valueFd, timeout_ms);
   }
 
 // -----------------------------------------------------------------------------
   void Pin::holdPull() {
 
-    if ( (_holdPull == PullUnknown) && device()) {
+    // les registres ne sont accessibles que si la couche IoMap est ouverte
+    if ( (_holdPull == PullUnknown) && device() && device()->isOpen()) {
 
       _holdPull = device()->pull (this);
     }
@@ -797,7 +994,7 @@ namespace Sysio {
   void
   Pin::holdMode() {
 
-    if ( (_holdMode == ModeUnknown) && device()) {
+    if ( (_holdMode == ModeUnknown) && device() && device()->isOpen()) {
 
       _holdMode = device()->mode (this);
       if (_holdMode == ModeOutput) {
@@ -989,22 +1186,18 @@ namespace Sysio {
 // -----------------------------------------------------------------------------
   int
   Pin::sysFsRead (int fd) {
-    int ret;
-
-    ret = lseek (fd, 0, SEEK_SET);
-    if (ret >= 0) {
-      char buffer[2];
+    char buffer[2];
+    // Lire la valeur actuelle du GPIO, pread() ne modifie pas la position du
+    // descripteur qui peut être lu par plusieurs threads (QuadratureEncoder)
+    int ret = pread (fd, buffer, sizeof (buffer), 0);
 
-      // Lire la valeur actuelle du GPIO.
-      ret = ::read (fd, buffer, sizeof (buffer));
-      if (ret > 0) {
+    if (ret > 0) {
 
-        ret = (buffer[0] != '0');
-      }
-      else {
+      ret = (buffer[0] != '0');
+    }
+    else {
 
-        ret = -1;
-      }
+      ret = -1;
     }
     return ret;
   }
@@ -1091,5 +1284,171 @@ namespace Sysio {
     return (stat (fn.str().c_str(), &sb) == 0 && S_ISREG (sb.st_mode));
   }
 
+// -----------------------------------------------------------------------------
+  bool
+  Pin::charDevEnable (bool enable) {
+
+    if (enable) {
+
+      holdMode();
+      holdPull();
+      charDevOpen();
+      return _line != nullptr;
+    }
+
+    charDevClose();
+    return false;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Pin::charDevOpen() {
+
+    if (!_line) {
+      std::string chip;
+      unsigned int offset;
+
+      device()->charDevLine (this, chip, offset);
+      _line = std::make_shared<LineRequest> (chip, std::vector<unsigned int> {offset},
+                                             std::vector<uint64_t> {charDevFlags() });
+      _lineIndex = 0;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Pin::charDevClose() {
+
+    _line.reset();
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Pin::charDevFlags() const {
+    uint64_t f = 0;
+
+    if ( (_mode == ModeInput) || ( (_mode == ModeUnknown) &&
+                                   (_edge != EdgeUnknown) && (_edge != EdgeNone))) {
+
+      f = GPIO_V2_LINE_FLAG_INPUT;
+      if ( (_edge == EdgeRising) || (_edge == EdgeBoth)) {
+
+        f |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+      }
+      if ( (_edge == EdgeFalling) || (_edge == EdgeBoth)) {
+
+        f |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+      }
+    }
+    else if (_mode == ModeOutput) {
+
+      f = GPIO_V2_LINE_FLAG_OUTPUT;
+    }
+
+    // la résistance de tirage nécessite une direction
+    if (f) {
+
+      switch (_pull) {
+        case PullOff:
+          f |= GPIO_V2_LINE_FLAG_BIAS_DISABLED;
+          break;
+        case PullDown:
+          f |= GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN;
+          break;
+        case PullUp:
+          f |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+          break;
+        default:
+          break;
+      }
+    }
+    return f;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Pin::charDevUpdate() {
+    uint64_t f = charDevFlags();
+
+    if (f != _line->flags (_lineIndex)) {
+
+      _line->setFlags (_lineIndex, f);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Pin::charDevGetMode() {
+    uint64_t f = _line->flags (_lineIndex);
+
+    if (f & GPIO_V2_LINE_FLAG_OUTPUT) {
+
+      _mode = ModeOutput;
+    }
+    else if (f & GPIO_V2_LINE_FLAG_INPUT) {
+
+      _mode = ModeInput;
+    }
+    else {
+
+      _mode = ModeUnknown;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Pin::charDevGetPull() {
+    uint64_t f = _line->flags (_lineIndex);
+
+    if (f & GPIO_V2_LINE_FLAG_BIAS_PULL_UP) {
+
+      _pull = PullUp;
+    }
+    else if (f & GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN) {
+
+      _pull = PullDown;
+    }
+    else if (f & GPIO_V2_LINE_FLAG_BIAS_DISABLED) {
+
+      _pull = PullOff;
+    }
+    else {
+
+      _pull = PullUnknown;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Pin::charDevGetEdge() {
+    uint64_t f = _line->flags (_lineIndex) & LineRequest::EdgeMask;
+
+    if (f == LineRequest::EdgeMask) {
+
+      _edge = EdgeBoth;
+    }
+    else if (f & GPIO_V2_LINE_FLAG_EDGE_RISING) {
+
+      _edge = EdgeRising;
+    }
+    else if (f & GPIO_V2_LINE_FLAG_EDGE_FALLING) {
+
+      _edge = EdgeFalling;
+    }
+    else {
+
+      _edge = EdgeNone;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  Pin::charDevPoll (int timeout_ms) {
+
+    // Les fronts des autres lignes d'une requête partagée (PinGroup) restent
+    // en file pour leur broche
+    return _line->waitEvent (_lineIndex, timeout_ms);
+  }
+
 }
 /* ========================================================================== */
@@ -0,0 +1,336 @@
+/**
+ * @file
+ * @brief Groupes de broches GPIO
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/gpio.h>
+#include <sysio/gpiodevice.h>
+#include <exception>
+#include "gpiochardev.h"
+
+namespace Sysio {
+
+// -----------------------------------------------------------------------------
+//
+//                            PinGroup Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  PinGroup::PinGroup (const std::vector<Pin *> & pins) : _pin (pins) {
+
+    init();
+  }
+
+// -----------------------------------------------------------------------------
+  PinGroup::PinGroup (std::initializer_list<Pin *> pins) : _pin (pins) {
+
+    init();
+  }
+
+// -----------------------------------------------------------------------------
+  PinGroup::~PinGroup() {
+
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  PinGroup::write (uint32_t value) {
+
+    write (value, ~0U);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  PinGroup::write (uint32_t value, uint32_t mask) {
+
+    if (usePort()) {
+
+      for (const Port & p : _port) {
+        uint32_t set = 0;
+        uint32_t clr = 0;
+
+        for (const auto & b : p.bit) {
+
+          if (mask & (1U << b.first)) {
+
+            if (value & (1U << b.first)) {
+
+              set |= 1U << b.second;
+            }
+            else {
+
+              clr |= 1U << b.second;
+            }
+          }
+        }
+        gpio()->device()->writeMask (p.index, set, clr);
+      }
+    }
+    else if (! _lines.empty()) {
+
+      for (const Lines & l : _lines) {
+        uint64_t lmask = 0;
+        uint64_t bits = 0;
+
+        for (const auto & b : l.bit) {
+
+          if (mask & (1U << b.first)) {
+
+            lmask |= 1ULL << b.second;
+            if (value & (1U << b.first)) {
+
+              bits |= 1ULL << b.second;
+            }
+          }
+        }
+        l.request->setValues (lmask, bits);
+      }
+    }
+    else {
+
+      for (unsigned int i = 0; i < _pin.size(); i++) {
+
+        if (mask & (1U << i)) {
+
+          _pin[i]->write ( (value & (1U << i)) != 0);
+        }
+      }
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  uint32_t
+  PinGroup::read() const {
+    uint32_t value = 0;
+
+    if (usePort()) {
+
+      for (const Port & p : _port) {
+        uint32_t bank = gpio()->device()->readBank (p.index);
+
+        for (const auto & b : p.bit) {
+
+          if (bank & (1U << b.second)) {
+
+            value |= 1U << b.first;
+          }
+        }
+      }
+    }
+    else if (! _lines.empty()) {
+
+      for (const Lines & l : _lines) {
+        uint64_t lmask = 0;
+        uint64_t bits;
+
+        for (const auto & b : l.bit) {
+
+          lmask |= 1ULL << b.second;
+        }
+        bits = l.request->getValues (lmask);
+        for (const auto & b : l.bit) {
+
+          if (bits & (1ULL << b.second)) {
+
+            value |= 1U << b.first;
+          }
+        }
+      }
+    }
+    else {
+
+      for (unsigned int i = 0; i < _pin.size(); i++) {
+
+        if (_pin[i]->read()) {
+
+          value |= 1U << i;
+        }
+      }
+    }
+    return value;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  PinGroup::setMode (Pin::Mode m) {
+
+    for (Pin * p : _pin) {
+
+      p->setMode (m);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  PinGroup::setPull (Pin::Pull p) {
+
+    gpio()->setPull (_pin, p);
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  PinGroup::size() const {
+
+    return _pin.size();
+  }
+
+// -----------------------------------------------------------------------------
+  Pin &
+  PinGroup::pin (int i) const {
+
+    return *_pin.at (i);
+  }
+
+// -----------------------------------------------------------------------------
+  Gpio *
+  PinGroup::gpio() const {
+
+    return _pin.front()->gpio();
+  }
+
+// -----------------------------------------------------------------------------
+//                                   Private
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  bool
+  PinGroup::usePort() const {
+
+    return (! _port.empty()) && gpio()->device()->isOpen();
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  PinGroup::init() {
+
+    if (_pin.empty() || (_pin.size() > 32)) {
+
+      throw std::invalid_argument ("A pin group must have from 1 to 32 pins");
+    }
+
+    for (Pin * p : _pin) {
+
+      if ( (p->type() != Pin::TypeGpio) || (p->gpio() != gpio())) {
+
+        throw std::invalid_argument ("All pins of a group must be GPIO pins of the same Gpio");
+      }
+    }
+
+    if ( (gpio()->accessLayer() & AccessLayerIoMap) &&
+         (gpio()->device()->flags() & Device::hasPortAccess)) {
+
+      // Précalcul des masques de chaque port utilisé par le groupe
+      for (unsigned int i = 0; i < _pin.size(); i++) {
+        unsigned int bank, bit;
+        std::vector<Port>::iterator p;
+
+        gpio()->device()->pinBit (_pin[i], bank, bit);
+        for (p = _port.begin(); p != _port.end(); ++p) {
+
+          if (p->index == bank) {
+            break;
+          }
+        }
+
+        if (p == _port.end()) {
+
+          _port.push_back (Port());
+          p = _port.end() - 1;
+          p->index = bank;
+        }
+        p->bit.push_back (std::make_pair (i, bit));
+      }
+    }
+    else {
+
+      initLines();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  PinGroup::initLines() {
+    std::vector<bool> done (_pin.size(), false);
+
+    for (Pin * p : _pin) {
+
+      if (!p->isOpen() || !p->useCharDev() || !p->_line) {
+
+        return; // accès broche par broche
+      }
+    }
+
+    // Une requête par contrôleur regroupant toutes les lignes du groupe
+    for (unsigned int i = 0; i < _pin.size(); i++) {
+
+      if (!done[i]) {
+        Lines l;
+        std::vector<unsigned int> offsets;
+        std::vector<uint64_t> flags;
+        uint64_t values = 0;
+        std::string chip = _pin[i]->_line->chip();
+
+        for (unsigned int j = i; j < _pin.size(); j++) {
+          Pin * p = _pin[j];
+
+          if (!done[j] && (p->_line->chip() == chip)) {
+            uint64_t f = p->_line->flags (p->_lineIndex);
+
+            if ( (f & GPIO_V2_LINE_FLAG_OUTPUT) && p->read()) {
+
+              values |= 1ULL << offsets.size();
+            }
+            l.bit.push_back (std::make_pair (j, offsets.size()));
+            offsets.push_back (p->_line->offset (p->_lineIndex));
+            flags.push_back (f);
+            done[j] = true;
+          }
+        }
+
+        // les lignes doivent être libérées avant d'être demandées à nouveau
+        for (const auto & b : l.bit) {
+
+          _pin[b.first]->_line.reset();
+        }
+        try {
+
+          l.request = std::make_shared<LineRequest> (chip, offsets, flags, values);
+        }
+        catch (...) {
+
+          // les broches retrouvent leurs propres lignes, chacune
+          // indépendamment : une broche dont la ligne ne peut être demandée
+          // à nouveau est fermée plutôt que laissée sans requête
+          for (const auto & b : l.bit) {
+            Pin * p = _pin[b.first];
+
+            try {
+
+              p->charDevOpen();
+              if (values & (1ULL << b.second)) {
+
+                p->_line->setValues (1, 1);
+              }
+            }
+            catch (...) {
+
+              p->_line.reset();
+              p->_isopen = false;
+            }
+          }
+          throw;
+        }
+        for (const auto & b : l.bit) {
+
+          _pin[b.first]->_line = l.request;
+          _pin[b.first]->_lineIndex = b.second;
+        }
+        _lines.push_back (l);
+      }
+    }
+  }
+}
+/* ========================================================================== */
@@ -0,0 +1,92 @@
+/**
+ * @file
+ * @brief Décodage des transitions d'un codeur en quadrature
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_QUADRATURE_H_
+#define _SYSIO_GPIO_QUADRATURE_H_
+
+#include <atomic>
+#include <sysio/gpiopin.h>
+
+#ifndef __DOXYGEN__
+
+namespace Sysio {
+
+  // Pas décodé lorsque les deux voies ont changé d'état (un front a été perdu)
+  const int QuadratureIllegal = 2;
+
+  /*
+   * Sens de la transition de l'état s vers l'état ns (bit 0 : A, bit 1 : B)
+   * ne différant que d'une voie : +1 si A est en avance sur B, -1 sinon.
+   */
+  inline int
+  quadratureDirection (unsigned s, unsigned ns) {
+    // Rang de chaque état dans la séquence de Gray parcourue lorsque A est
+    // en avance sur B : 00, 01, 11, 10
+    static const int grayIndex[4] = { 0, 1, 3, 2 };
+
+    return ( ( (grayIndex[ns] - grayIndex[s]) & 3) == 1) ? 1 : -1;
+  }
+
+  /*
+   * Applique le front edge de la voie channel (0 : A, 1 : B) à l'état des
+   * deux voies et retourne le pas décodé : +1 si A est en avance sur B, -1
+   * dans l'autre sens, QuadratureIllegal si le front ne change pas l'état
+   * (front de même sens que le précédent, un front a été perdu).
+   *
+   * Seul le bit de la voie est modifié, les deux voies peuvent être décodées
+   * en parallèle sans verrou. Le résultat n'est exact que si les fronts sont
+   * appliqués dans l'ordre chronologique.
+   */
+  inline int
+  quadratureStep (std::atomic<unsigned> & state, int channel, Pin::Edge edge) {
+    const unsigned mask = 1U << channel;
+    unsigned s = state.load (std::memory_order_relaxed);
+    unsigned ns;
+
+    do {
+
+      ns = (edge == Pin::EdgeRising) ? (s | mask) : (s & ~mask);
+    }
+    while (!state.compare_exchange_weak (s, ns, std::memory_order_acq_rel,
+                                         std::memory_order_relaxed));
+
+    if (ns == s) {
+
+      return QuadratureIllegal;
+    }
+    return quadratureDirection (s, ns);
+  }
+
+  /*
+   * Remplace l'état par les niveaux levels des deux voies lus au même
+   * instant et retourne le pas décodé : 0 si l'état n'a pas changé (front
+   * déjà pris en compte par un instantané précédent), +1 ou -1 si une seule
+   * voie a changé, QuadratureIllegal si les deux voies ont changé (l'état
+   * est resynchronisé sur levels).
+   *
+   * L'appelant doit sérialiser la lecture des niveaux et l'appel, un
+   * instantané plus ancien ne doit pas remplacer un instantané plus récent.
+   */
+  inline int
+  quadratureLevels (std::atomic<unsigned> & state, unsigned levels) {
+    unsigned s = state.exchange (levels & 3, std::memory_order_acq_rel);
+
+    levels &= 3;
+    if (s == levels) {
+
+      return 0;
+    }
+    if ( (s ^ levels) == 3) {
+
+      return QuadratureIllegal;
+    }
+    return quadratureDirection (s, levels);
+  }
+}
+#endif /* DOXYGEN not defined */
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_QUADRATURE_H_ defined */
@@ -0,0 +1,439 @@
+/**
+ * @file
+ * @brief Maître I2C logiciel GPIO
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/defs.h>
+#include <sysio/gpiosofti2c.h>
+#include <system_error>
+#include <stdexcept>
+#include <vector>
+#include "gpiosoftline.h"
+#if SYSIO_WITH_I2C
+#include <sysio/i2c.h>
+#endif
+
+namespace Sysio {
+
+#if SYSIO_WITH_I2C
+  namespace {
+
+    // Opération de xI2cAdapter, ctx est le SoftI2c
+    int adapterXfer (void * ctx, xI2cMsg * msgs, int n) {
+      std::vector<SoftI2c::Message> m (n);
+
+      for (int i = 0; i < n; i++) {
+
+        m[i].addr = msgs[i].addr;
+        m[i].read = (msgs[i].flags & I2C_MSG_READ) != 0;
+        m[i].len = msgs[i].len;
+        m[i].buf = msgs[i].buf;
+      }
+
+      try {
+
+        static_cast<SoftI2c *> (ctx)->transfer (m.data(), n);
+        return n;
+      }
+      catch (std::system_error & e) {
+
+        errno = e.code().value();
+      }
+      catch (std::exception & e) {
+
+        errno = EIO;
+      }
+      return -1;
+    }
+  }
+#endif
+
+// -----------------------------------------------------------------------------
+//
+//                          SoftI2c Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  SoftI2c::SoftI2c (Pin & scl, Pin & sda) :
+    _scl (new SoftLine), _sda (new SoftLine), _stretch (25000000ULL), _t (0) {
+
+    setSpeed (100000);
+
+    for (Pin * p : { &scl, &sda }) {
+
+      try {
+
+        p->setPull (Pin::PullUp);
+      }
+      catch (std::exception & e) {
+        // résistances externes nécessaires
+      }
+      p->setMode (Pin::ModeInput);
+    }
+    _scl->attach (scl, true);
+    _sda->attach (sda, true);
+
+    recover();
+  }
+
+// -----------------------------------------------------------------------------
+  SoftI2c::~SoftI2c() {
+
+    if (!_device.empty()) {
+
+      try {
+
+        unregisterDevice();
+      }
+      catch (...) {
+
+      }
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::setSpeed (uint32_t hz) {
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    _speed = hz;
+    _half = hz ? (500000000ULL + hz - 1) / hz : 0;
+  }
+
+// -----------------------------------------------------------------------------
+  uint32_t
+  SoftI2c::speed() const {
+
+    return _speed;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::setStretchTimeout (unsigned long us) {
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    _stretch = us * 1000ULL;
+  }
+
+// -----------------------------------------------------------------------------
+  unsigned long
+  SoftI2c::stretchTimeout() const {
+
+    return _stretch / 1000;
+  }
+
+// -----------------------------------------------------------------------------
+  // Les demi-périodes sont comptées à partir du front précédent (_t), le
+  // temps de calcul est ainsi absorbé
+  void
+  SoftI2c::delay() {
+
+    if (_half) {
+
+      _t += _half;
+      SoftLine::waitUntil (_t);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::sclRelease() {
+
+    _scl->drainRelease();
+    if (!_scl->read()) {
+      // allongement de l'horloge par l'esclave
+      const uint64_t limit = SoftLine::nanos() + _stretch;
+
+      while (!_scl->read()) {
+
+        if (SoftLine::nanos() > limit) {
+
+          throw std::system_error (ETIMEDOUT, std::system_category(), "SoftI2c SCL stuck low");
+        }
+      }
+      _t = SoftLine::nanos();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::start (bool repeated) {
+
+    if (repeated) {
+
+      _sda->drainRelease();
+      delay();
+      sclRelease();
+      delay();
+    }
+    _sda->drainLow();
+    delay();
+    _scl->drainLow();
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::stop() {
+
+    _sda->drainLow();
+    delay();
+    sclRelease();
+    delay();
+    _sda->drainRelease();
+    delay();
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::writeBit (bool bit) {
+
+    if (bit) {
+
+      _sda->drainRelease();
+    }
+    else {
+
+      _sda->drainLow();
+    }
+    delay();
+    sclRelease();
+    delay();
+    _scl->drainLow();
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  SoftI2c::readBit() {
+    bool bit;
+
+    _sda->drainRelease();
+    delay();
+    sclRelease();
+    delay();
+    bit = _sda->read();
+    _scl->drainLow();
+    return bit;
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  SoftI2c::writeByte (uint8_t byte) {
+
+    for (int i = 7; i >= 0; i--) {
+
+      writeBit ( (byte >> i) & 1);
+    }
+    return !readBit(); // acquittement
+  }
+
+// -----------------------------------------------------------------------------
+  uint8_t
+  SoftI2c::readByte (bool ack) {
+    uint8_t byte = 0;
+
+    for (int i = 0; i < 8; i++) {
+
+      byte = (byte << 1) | readBit();
+    }
+    writeBit (!ack);
+    return byte;
+  }
+
+// -----------------------------------------------------------------------------
+  // Un esclave interrompu au milieu d'une lecture peut maintenir SDA à l'état
+  // bas, il la libère après au plus 9 impulsions d'horloge
+  void
+  SoftI2c::recover() {
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    _t = SoftLine::nanos();
+    try {
+
+      for (int i = 0; (i < 9) && !_sda->read(); i++) {
+
+        _scl->drainLow();
+        delay();
+        sclRelease();
+        delay();
+      }
+      start (false);
+      stop();
+    }
+    catch (std::system_error & e) {
+
+      _scl->drainRelease();
+      _sda->drainRelease();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::transfer (const Message * msgs, int n) {
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    _t = SoftLine::nanos();
+    try {
+
+      for (int i = 0; i < n; i++) {
+        const Message & m = msgs[i];
+
+        start (i > 0);
+        if (!writeByte ( (m.addr << 1) | (m.read ? 1 : 0))) {
+
+          throw std::system_error (ENXIO, std::system_category(), "SoftI2c address not acknowledged");
+        }
+
+        for (uint16_t j = 0; j < m.len; j++) {
+
+          if (m.read) {
+
+            // le dernier octet n'est pas acquitté
+            m.buf[j] = readByte (j < (m.len - 1));
+          }
+          else if (!writeByte (m.buf[j])) {
+
+            throw std::system_error (EIO, std::system_category(), "SoftI2c data not acknowledged");
+          }
+        }
+      }
+      stop();
+    }
+    catch (std::system_error & e) {
+
+      try {
+
+        stop();
+      }
+      catch (std::system_error & stopError) {
+
+        _sda->drainRelease();
+      }
+      throw;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::transfer (int addr, const uint8_t * wbuf, size_t wlen,
+                     uint8_t * rbuf, size_t rlen) {
+    Message m[2];
+    int n = 0;
+
+    if ( (wlen > 0) || (rlen == 0)) {
+
+      m[n].addr = addr;
+      m[n].read = false;
+      m[n].len = wlen;
+      m[n].buf = const_cast<uint8_t *> (wbuf);
+      n++;
+    }
+    if (rlen > 0) {
+
+      m[n].addr = addr;
+      m[n].read = true;
+      m[n].len = rlen;
+      m[n].buf = rbuf;
+      n++;
+    }
+    transfer (m, n);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::write (int addr, const uint8_t * buf, size_t len) {
+
+    transfer (addr, buf, len, nullptr, 0);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::read (int addr, uint8_t * buf, size_t len) {
+
+    transfer (addr, nullptr, 0, buf, len);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::readRegBlock (int addr, uint8_t reg, uint8_t * buf, size_t len) {
+
+    transfer (addr, &reg, 1, buf, len);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::writeRegBlock (int addr, uint8_t reg, const uint8_t * buf, size_t len) {
+    std::vector<uint8_t> b (len + 1);
+
+    b[0] = reg;
+    std::copy (buf, buf + len, b.begin() + 1);
+    transfer (addr, b.data(), b.size(), nullptr, 0);
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  SoftI2c::probe (int addr) {
+
+    try {
+
+      transfer (addr, nullptr, 0, nullptr, 0);
+      return true;
+    }
+    catch (std::system_error & e) {
+
+      if (e.code().value() == ENXIO) {
+
+        return false;
+      }
+      throw;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::registerDevice (const std::string & device) {
+#if SYSIO_WITH_I2C
+    xI2cAdapter a;
+
+    if (!_device.empty()) {
+
+      unregisterDevice();
+    }
+    a.xfer = adapterXfer;
+    a.ctx = this;
+    if (iI2cRegisterAdapter (device.c_str(), &a) < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+    _device = device;
+#else
+    throw std::system_error (ENOTSUP, std::system_category(), __FUNCTION__);
+#endif
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftI2c::unregisterDevice() {
+#if SYSIO_WITH_I2C
+
+    if (!_device.empty()) {
+
+      if (iI2cUnregisterAdapter (_device.c_str()) < 0) {
+
+        throw std::system_error (errno, std::system_category(), __FUNCTION__);
+      }
+      _device.clear();
+    }
+#endif
+  }
+
+// -----------------------------------------------------------------------------
+  const std::string &
+  SoftI2c::device() const {
+
+    return _device;
+  }
+}
+/* ========================================================================== */
@@ -0,0 +1,165 @@
+/**
+ * @file
+ * @brief Ligne d'un bus logiciel
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_GPIO_SOFTLINE_H_
+#define _SYSIO_GPIO_SOFTLINE_H_
+
+#include <sysio/gpiofastpin.h>
+#include <exception>
+#include <cstdint>
+//
+#include <time.h>
+
+#ifndef __DOXYGEN__
+
+namespace Sysio {
+
+  /*
+   * @class SoftLine
+   * @brief Broche d'un bus logiciel (SoftSpi, SoftI2c)
+   *
+   * Avec la couche AccessLayerIoMap, les registres de la broche sont lus une
+   * fois pour toutes et chaque accès est une simple lecture ou écriture,
+   * quel que soit le modèle de GPIO. Sinon, ou pour une ligne à drain ouvert
+   * dont le niveau ne peut pas être relu par ces registres (GPIO simulé), les
+   * fonctions de Pin sont utilisées.
+   */
+  class SoftLine {
+
+    public:
+      SoftLine () : _pin (nullptr), _fast (false) {}
+
+      // drain : ligne à drain ouvert, dont le niveau est lu après son
+      // passage en entrée
+      void attach (Pin & pin, bool drain = false) {
+
+        _pin = &pin;
+        try {
+
+          _r = FastPinRegisters::get (pin);
+          _fast = !drain || _r.inputLevel;
+        }
+        catch (std::exception & e) {
+
+          _fast = false;
+        }
+      }
+
+      inline Pin * pin() const {
+        return _pin;
+      }
+
+      inline bool isFast() const {
+        return _fast;
+      }
+
+      inline void write (bool v) {
+
+        if (_fast) {
+
+          if (_r.setClear) {
+
+            * (v ? _r.set : _r.clr) = _r.mask;
+          }
+          else if (v) {
+
+            *_r.set |= _r.mask;
+          }
+          else {
+
+            *_r.clr &= ~_r.mask;
+          }
+        }
+        else {
+
+          _pin->write (v);
+        }
+      }
+
+      inline bool read() const {
+
+        if (_fast) {
+
+          return (*_r.lev & _r.mask) != 0;
+        }
+        return _pin->read();
+      }
+
+      inline void setInput() {
+
+        if (_fast) {
+
+          *_r.cfg &= ~_r.cfgMask;
+        }
+        else {
+
+          _pin->setMode (Pin::ModeInput);
+        }
+      }
+
+      inline void setOutput() {
+
+        if (_fast) {
+
+          *_r.cfg = (*_r.cfg & ~_r.cfgMask) | _r.cfgOutput;
+        }
+        else {
+
+          _pin->setMode (Pin::ModeOutput);
+        }
+      }
+
+      // Sortie à drain ouvert : l'état bas est forcé, l'état haut est obtenu
+      // en passant en entrée (résistance de tirage). Le registre de données
+      // est remis à 0 avant chaque passage en sortie, une écriture
+      // lecture-modification-écriture d'une autre broche du port ayant pu y
+      // recopier l'état haut lu en entrée (DataRegister). Sans accès direct,
+      // la valeur ne peut être écrite qu'en sortie (SysFs).
+      inline void drainLow() {
+
+        if (_fast) {
+
+          write (false);
+          setOutput();
+        }
+        else {
+
+          setOutput();
+          write (false);
+        }
+      }
+
+      inline void drainRelease() {
+
+        setInput();
+      }
+
+      static inline uint64_t nanos() {
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+      }
+
+      // Attente active jusqu'à l'instant t (ns)
+      static inline void waitUntil (uint64_t t) {
+
+        while (nanos() < t) {
+          ;
+        }
+      }
+
+    private:
+      Pin * _pin;
+      FastPinRegisters _r;
+      bool _fast;
+  };
+}
+
+#endif /* DOXYGEN not defined */
+/* ========================================================================== */
+#endif /*_SYSIO_GPIO_SOFTLINE_H_ defined */
@@ -0,0 +1,449 @@
+/**
+ * @file
+ * @brief PWM logiciel GPIO
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <sysio/gpio.h>
+#include <sysio/gpiodevice.h>
+#include <sysio/gpiosoftpwm.h>
+#include <sysio/scheduler.h>
+#include <system_error>
+//
+#include <time.h>
+
+namespace Sysio {
+
+  // délai entre le démarrage du thread et la première échéance
+  static const uint64_t leadTime = 200000;
+  // durée de l'attente active avant chaque échéance
+  static const uint64_t spinTime = 50000;
+  // durée maximale d'un sommeil, permet à stop() de ne pas attendre une
+  // période complète
+  static const uint64_t maxSleep = 100000000;
+
+// -----------------------------------------------------------------------------
+//
+//                          SoftPwm Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  SoftPwm::SoftPwm() :
+    _gpio (nullptr), _run (false), _usePort (false), _tick (10000),
+    _priority (80), _cpu (-1), _maxLatency (0) {
+
+  }
+
+// -----------------------------------------------------------------------------
+  SoftPwm::~SoftPwm() {
+
+    stop();
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  SoftPwm::add (Pin & pin, double frequency, double duty) {
+    Channel c;
+
+    if (isRunning()) {
+
+      throw std::logic_error ("SoftPwm is running");
+    }
+    if (pin.type() != Pin::TypeGpio) {
+
+      throw std::invalid_argument ("SoftPwm pin must be a GPIO pin");
+    }
+    if (_gpio && (pin.gpio() != _gpio)) {
+
+      throw std::invalid_argument ("SoftPwm pins must belong to the same GPIO");
+    }
+    if (frequency <= 0) {
+
+      throw std::invalid_argument ("SoftPwm frequency must be positive");
+    }
+    if ( (duty < 0) || (duty > 1)) {
+
+      throw std::out_of_range ("SoftPwm duty must be between 0 and 1");
+    }
+
+    pin.setMode (Pin::ModeOutput);
+    pin.write (false);
+
+    _gpio = pin.gpio();
+    c.pin = &pin;
+    c.bank = 0;
+    c.mask = 0;
+    c.period = static_cast<uint64_t> (1e9 / frequency);
+    c.high = static_cast<uint64_t> (duty * c.period);
+    _ch.push_back (c);
+    return _ch.size() - 1;
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  SoftPwm::channels() const {
+
+    return _ch.size();
+  }
+
+// -----------------------------------------------------------------------------
+  Pin &
+  SoftPwm::pin (int i) const {
+
+    return *channel (i).pin;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftPwm::setFrequency (int i, double frequency) {
+
+    if (frequency <= 0) {
+
+      throw std::invalid_argument ("SoftPwm frequency must be positive");
+    }
+    std::lock_guard<std::mutex> lock (_mutex);
+    Channel & c = channel (i);
+    double d = static_cast<double> (c.high) / c.period;
+
+    c.period = static_cast<uint64_t> (1e9 / frequency);
+    c.high = static_cast<uint64_t> (d * c.period);
+  }
+
+// -----------------------------------------------------------------------------
+  double
+  SoftPwm::frequency (int i) const {
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    return 1e9 / channel (i).period;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftPwm::setDuty (int i, double duty) {
+
+    if ( (duty < 0) || (duty > 1)) {
+
+      throw std::out_of_range ("SoftPwm duty must be between 0 and 1");
+    }
+    std::lock_guard<std::mutex> lock (_mutex);
+    Channel & c = channel (i);
+
+    c.high = static_cast<uint64_t> (duty * c.period);
+  }
+
+// -----------------------------------------------------------------------------
+  double
+  SoftPwm::duty (int i) const {
+    std::lock_guard<std::mutex> lock (_mutex);
+    const Channel & c = channel (i);
+
+    return static_cast<double> (c.high) / c.period;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftPwm::setPulseWidth (int i, uint64_t width_ns) {
+    std::lock_guard<std::mutex> lock (_mutex);
+    Channel & c = channel (i);
+
+    c.high = std::min (width_ns, c.period);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftPwm::setTick (uint64_t tick_ns) {
+
+    if (isRunning()) {
+
+      throw std::logic_error ("SoftPwm is running");
+    }
+    _tick = tick_ns;
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  SoftPwm::tick() const {
+
+    return _tick;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftPwm::setRtPriority (int priority) {
+
+    _priority = priority;
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  SoftPwm::rtPriority() const {
+
+    return _priority;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftPwm::setCpu (int cpu) {
+
+    _cpu = cpu;
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  SoftPwm::cpu() const {
+
+    return _cpu;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftPwm::start() {
+
+    if (isRunning()) {
+
+      throw std::logic_error ("SoftPwm is running");
+    }
+    if (_ch.empty()) {
+
+      throw std::logic_error ("SoftPwm has no channel");
+    }
+
+    // écriture par port si toutes les broches le permettent (même condition
+    // que PinGroup)
+    _usePort = (_gpio->accessLayer() & AccessLayerIoMap) &&
+               (_gpio->device()->flags() & Device::hasPortAccess);
+    for (Channel & c : _ch) {
+
+      if (c.pin->useSysFs() || c.pin->useCharDev()) {
+
+        _usePort = false;
+      }
+    }
+    if (_usePort) {
+
+      for (Channel & c : _ch) {
+        unsigned int bit;
+
+        _gpio->device()->pinBit (c.pin, c.bank, bit);
+        c.mask = 1U << bit;
+      }
+    }
+
+    _maxLatency = 0;
+    _run = true;
+    _thread = std::thread (&SoftPwm::loop, this);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftPwm::stop() {
+
+    if (_thread.joinable()) {
+
+      _run = false;
+      _thread.join();
+      writeAll (false);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  SoftPwm::isRunning() const {
+
+    return _run;
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  SoftPwm::maxLatency() const {
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    return _maxLatency;
+  }
+
+// -----------------------------------------------------------------------------
+//                                   Private
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  SoftPwm::Channel &
+  SoftPwm::channel (int i) {
+
+    return _ch.at (i);
+  }
+
+// -----------------------------------------------------------------------------
+  const SoftPwm::Channel &
+  SoftPwm::channel (int i) const {
+
+    return _ch.at (i);
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  SoftPwm::now() {
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftPwm::writeAll (bool value) {
+
+    for (Channel & c : _ch) {
+
+      c.pin->write (value);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  // Thread de génération
+  void
+  SoftPwm::loop() {
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue;
+    std::vector<int> level (_ch.size(), -1); // état à appliquer, -1 aucun
+    std::vector<int> touched; // voies modifiées dans le pas
+    std::vector<uint32_t> setMask, clrMask;
+    Device * dev = _gpio->device();
+    uint64_t t0;
+
+    if (_usePort) {
+      unsigned int banks = 0;
+
+      for (const Channel & c : _ch) {
+
+        banks = std::max (banks, c.bank + 1);
+      }
+      setMask.resize (banks);
+      clrMask.resize (banks);
+    }
+
+    try {
+
+      if (!Scheduler::applyProfile ("gpio-softpwm")) {
+
+        if (_cpu >= 0) {
+
+          Scheduler::setAffinity ({_cpu});
+        }
+        Scheduler::setRtPriority (_priority);
+      }
+    }
+    catch (std::system_error & e) {
+      // pas les droits nécessaires, priorité normale
+    }
+
+    // toutes les voies commencent leur période au même instant
+    t0 = now() + leadTime;
+    for (size_t i = 0; i < _ch.size(); i++) {
+
+      queue.push (Event { t0, static_cast<int> (i), true });
+    }
+
+    while (_run) {
+      uint64_t deadline = queue.top().time;
+      uint64_t t = now();
+
+      if (deadline > t + spinTime) {
+        struct timespec ts;
+        uint64_t wake = deadline - spinTime;
+
+        if (wake > t + maxSleep) {
+
+          wake = t + maxSleep;
+        }
+        ts.tv_sec = wake / 1000000000ULL;
+        ts.tv_nsec = wake % 1000000000ULL;
+        clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        continue; // échéance encore lointaine ou stop()
+      }
+
+      do {
+        t = now();
+      }
+      while (t < deadline);
+
+      {
+        std::lock_guard<std::mutex> lock (_mutex);
+
+        // fronts compris dans le pas, l'ordre chronologique est conservé
+        // pour qu'une voie ne prenne que son dernier état
+        while (queue.top().time <= deadline + _tick) {
+          Event e = queue.top();
+          const Channel & c = _ch[e.channel];
+
+          queue.pop();
+          if (level[e.channel] < 0) {
+
+            touched.push_back (e.channel);
+          }
+
+          if (e.rising) {
+
+            level[e.channel] = (c.high > 0);
+            if ( (c.high > 0) && (c.high < c.period)) {
+
+              queue.push (Event { e.time + c.high, e.channel, false });
+            }
+            queue.push (Event { e.time + c.period, e.channel, true });
+          }
+          else {
+
+            level[e.channel] = 0;
+          }
+        }
+
+        if (t - deadline > _maxLatency) {
+
+          _maxLatency = t - deadline;
+        }
+      }
+
+      if (_usePort) {
+
+        for (int i : touched) {
+          const Channel & c = _ch[i];
+
+          if (level[i]) {
+
+            setMask[c.bank] |= c.mask;
+          }
+          else {
+
+            clrMask[c.bank] |= c.mask;
+          }
+        }
+        for (size_t b = 0; b < setMask.size(); b++) {
+
+          if (setMask[b] | clrMask[b]) {
+
+            dev->writeMask (b, setMask[b], clrMask[b]);
+            setMask[b] = 0;
+            clrMask[b] = 0;
+          }
+        }
+      }
+      else {
+
+        for (int i : touched) {
+
+          _ch[i].pin->write (level[i]);
+        }
+      }
+
+      for (int i : touched) {
+
+        level[i] = -1;
+      }
+      touched.clear();
+    }
+  }
+}
+/* ========================================================================== */
@@ -0,0 +1,316 @@
+/**
+ * @file
+ * @brief Maître SPI logiciel GPIO
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/defs.h>
+#include <sysio/gpiosoftspi.h>
+#include <system_error>
+#include <stdexcept>
+#include "gpiosoftline.h"
+#if SYSIO_WITH_SPI
+#include <sysio/spi.h>
+#endif
+
+namespace Sysio {
+
+  // bits du mode, identiques à SPI_CPHA et SPI_CPOL
+  static const int cpha = 0x01;
+  static const int cpol = 0x02;
+
+#if SYSIO_WITH_SPI
+  namespace {
+
+    // Opérations de xSpiAdapter, ctx est le SoftSpi
+    int adapterXfer (void * ctx, const uint8_t * tx, uint8_t * rx, uint8_t len) {
+
+      try {
+
+        return static_cast<SoftSpi *> (ctx)->xfer (tx, rx, len);
+      }
+      catch (std::system_error & e) {
+
+        errno = e.code().value();
+      }
+      catch (std::exception & e) {
+
+        errno = EIO;
+      }
+      return -1;
+    }
+
+    int adapterSetConfig (void * ctx, const xSpiIos * config) {
+      SoftSpi * spi = static_cast<SoftSpi *> (ctx);
+
+      if ( (config->bits != eSpiBits8) || (config->mode < 0) || (config->mode > 3)) {
+
+        errno = EINVAL;
+        return -1;
+      }
+      spi->setMode (config->mode);
+      spi->setLsbFirst (config->lsb == eSpiNumberingLsb);
+      spi->setSpeed (config->speed);
+      return 0;
+    }
+
+    int adapterGetConfig (void * ctx, xSpiIos * config) {
+      SoftSpi * spi = static_cast<SoftSpi *> (ctx);
+
+      config->mode = static_cast<eSpiMode> (spi->mode());
+      config->lsb = spi->lsbFirst() ? eSpiNumberingLsb : eSpiNumberingMsb;
+      config->bits = eSpiBits8;
+      config->speed = spi->speed();
+      return 0;
+    }
+  }
+#endif
+
+// -----------------------------------------------------------------------------
+//
+//                          SoftSpi Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  SoftSpi::SoftSpi (Pin & sclk, Pin & mosi, Pin * miso, Pin * cs) :
+    _sclk (new SoftLine), _mosi (new SoftLine), _mode (0), _lsb (false) {
+
+    setSpeed (1000000);
+
+    sclk.write (false);
+    sclk.setMode (Pin::ModeOutput);
+    _sclk->attach (sclk);
+
+    mosi.write (false);
+    mosi.setMode (Pin::ModeOutput);
+    _mosi->attach (mosi);
+
+    if (miso) {
+
+      miso->setMode (Pin::ModeInput);
+      _miso.reset (new SoftLine);
+      _miso->attach (*miso);
+    }
+
+    if (cs) {
+
+      cs->write (true);
+      cs->setMode (Pin::ModeOutput);
+      _cs.reset (new SoftLine);
+      _cs->attach (*cs);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  SoftSpi::~SoftSpi() {
+
+    if (!_device.empty()) {
+
+      try {
+
+        unregisterDevice();
+      }
+      catch (...) {
+
+      }
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftSpi::setMode (int mode) {
+
+    if ( (mode < 0) || (mode > 3)) {
+
+      throw std::invalid_argument ("SPI mode must be between 0 and 3");
+    }
+    std::lock_guard<std::mutex> lock (_mutex);
+    _mode = mode;
+    // niveau de repos de l'horloge
+    _sclk->write ( (_mode & cpol) != 0);
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  SoftSpi::mode() const {
+
+    return _mode;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftSpi::setSpeed (uint32_t hz) {
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    _speed = hz;
+    _half = hz ? (500000000ULL + hz - 1) / hz : 0;
+  }
+
+// -----------------------------------------------------------------------------
+  uint32_t
+  SoftSpi::speed() const {
+
+    return _speed;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftSpi::setLsbFirst (bool lsb) {
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    _lsb = lsb;
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  SoftSpi::lsbFirst() const {
+
+    return _lsb;
+  }
+
+// -----------------------------------------------------------------------------
+  // t est l'instant du dernier front, chaque demi-période est attendue par
+  // rapport à cet instant, le temps de calcul est ainsi absorbé
+  uint8_t
+  SoftSpi::transfer (uint8_t out, uint64_t & t) {
+    const bool idle = (_mode & cpol) != 0;
+    uint8_t in = 0;
+
+    for (int i = 0; i < 8; i++) {
+      const int b = _lsb ? i : 7 - i;
+      bool bit;
+
+      if ( (_mode & cpha) == 0) {
+
+        // donnée présente avant le premier front, lue sur celui-ci
+        _mosi->write ( (out >> b) & 1);
+        if (_half) {
+          SoftLine::waitUntil (t += _half);
+        }
+        _sclk->write (!idle);
+        bit = _miso ? _miso->read() : false;
+        if (_half) {
+          SoftLine::waitUntil (t += _half);
+        }
+        _sclk->write (idle);
+      }
+      else {
+
+        // donnée modifiée sur le premier front, lue sur le second
+        _sclk->write (!idle);
+        _mosi->write ( (out >> b) & 1);
+        if (_half) {
+          SoftLine::waitUntil (t += _half);
+        }
+        _sclk->write (idle);
+        bit = _miso ? _miso->read() : false;
+        if (_half) {
+          SoftLine::waitUntil (t += _half);
+        }
+      }
+
+      if (bit) {
+
+        in |= 1 << b;
+      }
+    }
+    return in;
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  SoftSpi::xfer (const uint8_t * tx, uint8_t * rx, size_t len) {
+    std::lock_guard<std::mutex> lock (_mutex);
+    uint64_t t = SoftLine::nanos();
+
+    if (_cs) {
+
+      _cs->write (false);
+      if (_half) {
+        SoftLine::waitUntil (t += _half);
+      }
+    }
+
+    for (size_t i = 0; i < len; i++) {
+      uint8_t in = transfer (tx ? tx[i] : 0, t);
+
+      if (rx) {
+
+        rx[i] = in;
+      }
+    }
+
+    if (_cs) {
+
+      if (_half) {
+        SoftLine::waitUntil (t += _half);
+      }
+      _cs->write (true);
+    }
+    return len;
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  SoftSpi::read (uint8_t * rx, size_t len) {
+
+    return xfer (nullptr, rx, len);
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  SoftSpi::write (const uint8_t * tx, size_t len) {
+
+    return xfer (tx, nullptr, len);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftSpi::registerDevice (const std::string & device) {
+#if SYSIO_WITH_SPI
+    xSpiAdapter a;
+
+    if (!_device.empty()) {
+
+      unregisterDevice();
+    }
+    a.xfer = adapterXfer;
+    a.setconfig = adapterSetConfig;
+    a.getconfig = adapterGetConfig;
+    a.ctx = this;
+    if (iSpiRegisterAdapter (device.c_str(), &a) < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+    _device = device;
+#else
+    throw std::system_error (ENOTSUP, std::system_category(), __FUNCTION__);
+#endif
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  SoftSpi::unregisterDevice() {
+#if SYSIO_WITH_SPI
+
+    if (!_device.empty()) {
+
+      if (iSpiUnregisterAdapter (_device.c_str()) < 0) {
+
+        throw std::system_error (errno, std::system_category(), __FUNCTION__);
+      }
+      _device.clear();
+    }
+#endif
+  }
+
+// -----------------------------------------------------------------------------
+  const std::string &
+  SoftSpi::device() const {
+
+    return _device;
+  }
+}
+/* ========================================================================== */
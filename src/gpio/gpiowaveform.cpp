@@ -0,0 +1,360 @@
+/**
+ * @file
+ * @brief Lecture de formes d'onde GPIO
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <sysio/gpio.h>
+#include <sysio/gpiodevice.h>
+#include <sysio/gpiowaveform.h>
+#include <sysio/scheduler.h>
+#include <system_error>
+//
+#include <time.h>
+
+namespace Sysio {
+
+  // délai entre le démarrage du thread et la première échéance
+  static const uint64_t leadTime = 200000;
+
+// -----------------------------------------------------------------------------
+//
+//                          Waveform Class
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  Waveform::Waveform (PinGroup & group) :
+    _group (group), _playing (false), _priority (90), _cpu (-1), _spin (50000),
+    _maxError (0), _meanError (0) {
+
+  }
+
+// -----------------------------------------------------------------------------
+  Waveform::~Waveform() {
+
+    if (_thread.joinable()) {
+
+      _thread.join();
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Waveform::add (uint64_t offset_ns, uint32_t setMask, uint32_t clrMask) {
+
+    add (Step (offset_ns, setMask, clrMask));
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Waveform::add (const Step & step) {
+
+    if (isPlaying()) {
+
+      throw std::logic_error ("Waveform is playing");
+    }
+    if (!_step.empty() && (step.offset_ns < _step.back().offset_ns)) {
+
+      throw std::invalid_argument ("Waveform steps must be in chronological order");
+    }
+    if (step.setMask & step.clrMask) {
+
+      throw std::invalid_argument ("A pin can not be set and cleared in the same step");
+    }
+    _step.push_back (step);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Waveform::clear() {
+
+    if (isPlaying()) {
+
+      throw std::logic_error ("Waveform is playing");
+    }
+    _step.clear();
+  }
+
+// -----------------------------------------------------------------------------
+  const std::vector<Waveform::Step> &
+  Waveform::steps() const {
+
+    return _step;
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Waveform::duration() const {
+
+    return _step.empty() ? 0 : _step.back().offset_ns;
+  }
+
+// -----------------------------------------------------------------------------
+  PinGroup &
+  Waveform::group() const {
+
+    return _group;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Waveform::setRtPriority (int priority) {
+
+    _priority = priority;
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  Waveform::rtPriority() const {
+
+    return _priority;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Waveform::setCpu (int cpu) {
+
+    _cpu = cpu;
+  }
+
+// -----------------------------------------------------------------------------
+  int
+  Waveform::cpu() const {
+
+    return _cpu;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Waveform::setSpin (uint64_t spin_ns) {
+
+    _spin = spin_ns;
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Waveform::spin() const {
+
+    return _spin;
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Waveform::play() {
+
+    start();
+    wait();
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Waveform::start() {
+
+    if (isPlaying()) {
+
+      throw std::logic_error ("Waveform is playing");
+    }
+    if (_thread.joinable()) {
+
+      _thread.join(); // lecture précédente terminée mais pas encore attendue
+    }
+    compile();
+    _error = nullptr;
+    _playing = true;
+    _thread = std::thread (&Waveform::loop, this);
+  }
+
+// -----------------------------------------------------------------------------
+  void
+  Waveform::wait() {
+
+    if (_thread.joinable()) {
+
+      _thread.join();
+    }
+    if (_error) {
+      std::exception_ptr e = _error;
+
+      _error = nullptr;
+      std::rethrow_exception (e);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  bool
+  Waveform::isPlaying() const {
+
+    return _playing;
+  }
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Waveform::maxError() const {
+
+    return _maxError;
+  }
+
+// -----------------------------------------------------------------------------
+  double
+  Waveform::meanError() const {
+
+    return _meanError;
+  }
+
+// -----------------------------------------------------------------------------
+//                                   Private
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+  uint64_t
+  Waveform::now() {
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  }
+
+// -----------------------------------------------------------------------------
+  // Calcul des écritures par port de chaque étape, si le groupe peut être
+  // écrit par port (même condition que PinGroup)
+  void
+  Waveform::compile() {
+    Gpio * gpio = _group.gpio();
+    std::vector<unsigned int> bank (_group.size());
+    std::vector<unsigned int> bit (_group.size());
+
+    _write.clear();
+    _first.clear();
+
+    if ( (gpio->accessLayer() & AccessLayerIoMap) == 0 ||
+         (gpio->device()->flags() & Device::hasPortAccess) == 0) {
+      return;
+    }
+
+    for (int i = 0; i < _group.size(); i++) {
+
+      if (_group.pin (i).useSysFs() || _group.pin (i).useCharDev()) {
+
+        return;
+      }
+      gpio->device()->pinBit (&_group.pin (i), bank[i], bit[i]);
+    }
+
+    for (const Step & s : _step) {
+      size_t first = _write.size();
+
+      _first.push_back (first);
+      for (int i = 0; i < _group.size(); i++) {
+        uint32_t m = 1U << i;
+
+        if ( (s.setMask | s.clrMask) & m) {
+          size_t w;
+
+          for (w = first; w < _write.size(); w++) {
+
+            if (_write[w].bank == bank[i]) {
+              break;
+            }
+          }
+          if (w == _write.size()) {
+
+            _write.push_back (PortWrite { bank[i], 0, 0 });
+          }
+          if (s.setMask & m) {
+
+            _write[w].setMask |= 1U << bit[i];
+          }
+          else {
+
+            _write[w].clrMask |= 1U << bit[i];
+          }
+        }
+      }
+    }
+    _first.push_back (_write.size());
+  }
+
+// -----------------------------------------------------------------------------
+  // Thread de lecture
+  void
+  Waveform::loop() {
+    uint64_t t0, sum = 0;
+    Device * dev = _group.gpio()->device();
+
+    _maxError = 0;
+    _meanError = 0;
+
+    try {
+
+      try {
+
+        if (!Scheduler::applyProfile ("gpio-waveform")) {
+
+          if (_cpu >= 0) {
+
+            Scheduler::setAffinity ({_cpu});
+          }
+          Scheduler::setRtPriority (_priority);
+        }
+      }
+      catch (std::system_error & e) {
+        // pas les droits nécessaires, priorité normale
+      }
+
+      t0 = now() + leadTime;
+      for (size_t i = 0; i < _step.size(); i++) {
+        const Step & s = _step[i];
+        uint64_t deadline = t0 + s.offset_ns;
+        uint64_t t = now();
+        uint64_t err;
+
+        if (deadline > t + _spin) {
+          struct timespec ts;
+          uint64_t wake = deadline - _spin;
+
+          ts.tv_sec = wake / 1000000000ULL;
+          ts.tv_nsec = wake % 1000000000ULL;
+          while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+            ;
+        }
+
+        do {
+          t = now();
+        }
+        while (t < deadline);
+
+        if (_first.empty()) {
+
+          _group.write (s.setMask, s.setMask | s.clrMask);
+        }
+        else {
+
+          for (size_t w = _first[i]; w < _first[i + 1]; w++) {
+
+            dev->writeMask (_write[w].bank, _write[w].setMask, _write[w].clrMask);
+          }
+        }
+
+        err = t - deadline;
+        sum += err;
+        if (err > _maxError) {
+
+          _maxError = err;
+        }
+      }
+
+      if (!_step.empty()) {
+
+        _meanError = static_cast<double> (sum) / _step.size();
+      }
+    }
+    catch (...) {
+
+      _error = std::current_exception();
+    }
+    _playing = false;
+  }
+}
+/* ========================================================================== */
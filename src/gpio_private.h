@@ -74,6 +74,13 @@ int iArchGpioWrite (int g, bool bValue, xGpio * gp);
 int iArchGpioRead (int g, xGpio * gp);
 int iArchGpioToggle (int g, xGpio * gp);
 const xConnectorList * pxArchGpioGetConnSize (xGpio * gp);
+// Contrôleur /dev/gpiochipN et numéro de ligne d'une broche, 0 si trouvés
+int iArchGpioLine (int g, char * chip, size_t size, unsigned * offset);
+
+// Contrôleur /dev/gpiochipN et numéro de ligne d'une broche de xGpio
+int iGpioLine (int p, char * chip, size_t size, unsigned * offset, xGpio * gp);
+// Chemin du contrôleur dont le label est fourni, 0 si trouvé (gpiochardev.cpp)
+int iGpioFindChip (const char * label, char * path, size_t size);
 
 /* ========================================================================== */
 #ifdef __cplusplus
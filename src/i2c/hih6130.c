@@ -51,7 +51,6 @@ struct xHih6130 {
 xHih6130 *
 xHih6130Open (const char * device, int i2caddr) {
   xHih6130 * s;
-  unsigned long i2cfuncs;
 
   s = calloc (sizeof (xHih6130), 1);
   assert (s);
@@ -63,12 +62,7 @@ xHih6130Open (const char * device, int i2caddr) {
     goto hih6130OE;
   }
 
-  if (ioctl (s->fd, I2C_FUNCS, &i2cfuncs) < 0) {
-
-    goto hih6130OC;
-  }
-
-  if (! (i2cfuncs & I2C_FUNC_I2C) ) {
+  if (!bI2cIsPlain (s->fd)) {
 
     errno = EIO;
     PERROR ("Plain i2c-level commands unsupported");
@@ -108,7 +102,7 @@ xHih6130Open (const char * device, int i2caddr) {
   return s;
 
 hih6130OC:
-  close (s->fd);
+  iI2cClose (s->fd);
 hih6130OE:
   free (s);
   return NULL;
@@ -12,14 +12,45 @@
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
 #include <sysio/i2c.h>
 #include <sysio/log.h>
 #include <sysio/delay.h>
 #include "i2c-dev.h"
 
+/* structures =============================================================== */
+// Bus logiciel enregistré
+typedef struct xI2cBus {
+  struct xI2cBus * next;
+  char * device;
+  xI2cAdapter adapter;
+  int busy; // nombre d'appels de adapter.xfer en cours
+} xI2cBus;
+
+// Connexion ouverte sur un bus logiciel, le descripteur est celui de
+// /dev/null, ce qui garantit son unicité. bus est NULL si le bus a été
+// retiré par iI2cUnregisterAdapter()
+typedef struct xI2cLink {
+  struct xI2cLink * next;
+  int fd;
+  int addr;
+  xI2cBus * bus;
+} xI2cLink;
+
+/* constants ================================================================ */
+#ifndef I2C_RDWR_IOCTL_MAX_MSGS
+#define I2C_RDWR_IOCTL_MAX_MSGS 42
+#endif
+
 /* private variables ======================================================== */
 static bool bI2cDebug;
+static xI2cBus * pxI2cBusList;
+static xI2cLink * pxI2cLinkList;
+static pthread_mutex_t xI2cMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xI2cIdle = PTHREAD_COND_INITIALIZER;
+
+/* private functions ======================================================== */
 
 // -----------------------------------------------------------------------------
 static void
@@ -30,12 +61,164 @@ vI2cPrintDebug (int iErr, const char * func) {
   }
 }
 
+// -----------------------------------------------------------------------------
+static xI2cBus *
+prvpxI2cFindBus (const char * device) {
+  xI2cBus * b;
+
+  for (b = pxI2cBusList; b; b = b->next) {
+
+    if (strcmp (b->device, device) == 0) {
+
+      return b;
+    }
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// A appeler avec xI2cMutex verrouillé
+static xI2cLink *
+prvpxI2cFindLink (int fd) {
+  xI2cLink * l;
+
+  for (l = pxI2cLinkList; l; l = l->next) {
+
+    if (l->fd == fd) {
+
+      break;
+    }
+  }
+  return l;
+}
+
+// -----------------------------------------------------------------------------
+// Renvoie true si fd est une connexion sur un bus logiciel, false si fd est
+// un bus du noyau
+static bool
+prvbI2cIsSoft (int fd) {
+  bool soft;
+
+  pthread_mutex_lock (&xI2cMutex);
+  soft = prvpxI2cFindLink (fd) != NULL;
+  pthread_mutex_unlock (&xI2cMutex);
+  return soft;
+}
+
+// -----------------------------------------------------------------------------
+// Transaction sur le bus logiciel de fd, l'adresse de la connexion est
+// affectée aux messages si setaddr est vrai. Le bus est réservé pendant
+// l'appel de l'adaptateur, iI2cUnregisterAdapter() attend la fin de
+// l'appel avant de rendre la main.
+static int
+prviI2cSoftTransfer (int fd, xI2cMsg * msgs, int n, bool setaddr) {
+  xI2cLink * l;
+  xI2cBus * b = NULL;
+  int ret, i;
+  int err = EBADF;
+
+  pthread_mutex_lock (&xI2cMutex);
+  l = prvpxI2cFindLink (fd);
+  if (l) {
+
+    b = l->bus;
+    if (b) {
+
+      b->busy++;
+      if (setaddr) {
+
+        for (i = 0; i < n; i++) {
+
+          msgs[i].addr = l->addr;
+        }
+      }
+    }
+    else {
+
+      // bus retiré
+      err = ENODEV;
+    }
+  }
+  pthread_mutex_unlock (&xI2cMutex);
+
+  if (!b) {
+
+    errno = err;
+    return -1;
+  }
+
+  ret = b->adapter.xfer (b->adapter.ctx, msgs, n);
+
+  pthread_mutex_lock (&xI2cMutex);
+  if (--b->busy == 0) {
+
+    pthread_cond_broadcast (&xI2cIdle);
+  }
+  pthread_mutex_unlock (&xI2cMutex);
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+// Émulation des commandes SMBus sur un bus logiciel : écriture de wlen
+// octets puis, après un démarrage répété, lecture de rlen octets
+static int
+prviI2cLinkXfer (int fd, const uint8_t * wbuf, int wlen,
+                 uint8_t * rbuf, int rlen) {
+  xI2cMsg msgs[2];
+  int n = 0;
+
+  if ( (wlen > 0) || (rlen == 0)) {
+
+    msgs[n].flags = 0;
+    msgs[n].len = wlen;
+    msgs[n].buf = (uint8_t *) wbuf;
+    n++;
+  }
+  if (rlen > 0) {
+
+    msgs[n].flags = I2C_MSG_READ;
+    msgs[n].len = rlen;
+    msgs[n].buf = rbuf;
+    n++;
+  }
+  if (prviI2cSoftTransfer (fd, msgs, n, true) < 0) {
+
+    return -1;
+  }
+  return 0;
+}
+
 /* internal public functions ================================================ */
 
 // -----------------------------------------------------------------------------
 int
 iI2cOpen (const char * device, int i2caddr) {
   int fd;
+  xI2cBus * b;
+
+  pthread_mutex_lock (&xI2cMutex);
+  b = prvpxI2cFindBus (device);
+  if (b) {
+
+    fd = open ("/dev/null", O_RDWR);
+    if (fd >= 0) {
+      xI2cLink * l = calloc (1, sizeof (xI2cLink));
+      assert (l);
+
+      l->fd = fd;
+      l->addr = i2caddr;
+      l->bus = b;
+      l->next = pxI2cLinkList;
+      pxI2cLinkList = l;
+    }
+    pthread_mutex_unlock (&xI2cMutex);
+    if (fd < 0) {
+
+      PERROR ("%s:%s", __func__, strerror (errno));
+    }
+    return fd;
+  }
+  pthread_mutex_unlock (&xI2cMutex);
 
   if ( (fd = open (device, O_RDWR)) >= 0) {
 
@@ -51,6 +234,20 @@ iI2cOpen (const char * device, int i2caddr) {
 // -----------------------------------------------------------------------------
 int
 iI2cClose (int fd) {
+  xI2cLink ** pl;
+
+  pthread_mutex_lock (&xI2cMutex);
+  for (pl = &pxI2cLinkList; *pl; pl = & (*pl)->next) {
+
+    if ( (*pl)->fd == fd) {
+      xI2cLink * l = *pl;
+
+      *pl = l->next;
+      free (l);
+      break;
+    }
+  }
+  pthread_mutex_unlock (&xI2cMutex);
 
   if (close (fd) != 0) {
 
@@ -63,6 +260,12 @@ iI2cClose (int fd) {
 // -----------------------------------------------------------------------------
 int
 iI2cRead (int fd) {
+
+  if (prvbI2cIsSoft (fd)) {
+    uint8_t b;
+
+    return prviI2cLinkXfer (fd, NULL, 0, &b, 1) < 0 ? -1 : b;
+  }
   int i = i2c_smbus_read_byte (fd);
 
   return i;
@@ -71,6 +274,12 @@ iI2cRead (int fd) {
 // -----------------------------------------------------------------------------
 int
 iI2cReadReg8 (int fd, uint8_t reg) {
+
+  if (prvbI2cIsSoft (fd)) {
+    uint8_t b;
+
+    return prviI2cLinkXfer (fd, &reg, 1, &b, 1) < 0 ? -1 : b;
+  }
   int i = i2c_smbus_read_byte_data (fd, reg);
 
   vI2cPrintDebug (i, __func__);
@@ -80,6 +289,13 @@ iI2cReadReg8 (int fd, uint8_t reg) {
 // -----------------------------------------------------------------------------
 int
 iI2cReadReg16 (int fd, uint8_t reg) {
+
+  if (prvbI2cIsSoft (fd)) {
+    uint8_t b[2];
+
+    // SMBus : octet de poids faible en premier
+    return prviI2cLinkXfer (fd, &reg, 1, b, 2) < 0 ? -1 : b[0] | (b[1] << 8);
+  }
   int i = i2c_smbus_read_word_data (fd, reg);
 
   vI2cPrintDebug (i, __func__);
@@ -89,6 +305,12 @@ iI2cReadReg16 (int fd, uint8_t reg) {
 // -----------------------------------------------------------------------------
 int
 iI2cReadRegBlock (int fd, uint8_t reg, uint8_t *values, uint8_t len) {
+
+  if (prvbI2cIsSoft (fd)) {
+
+    len = MIN (len, I2C_BLOCK_MAX);
+    return prviI2cLinkXfer (fd, &reg, 1, values, len) < 0 ? -1 : len;
+  }
   int i = i2c_smbus_read_i2c_block_data (fd, reg, len, values);
 
   vI2cPrintDebug (i, __func__);
@@ -98,6 +320,11 @@ iI2cReadRegBlock (int fd, uint8_t reg, uint8_t *values, uint8_t len) {
 // -----------------------------------------------------------------------------
 int
 iI2cWrite (int fd, uint8_t data) {
+
+  if (prvbI2cIsSoft (fd)) {
+
+    return prviI2cLinkXfer (fd, &data, 1, NULL, 0);
+  }
   int i = i2c_smbus_write_byte (fd, data);
 
   vI2cPrintDebug (i, __func__);
@@ -107,6 +334,12 @@ iI2cWrite (int fd, uint8_t data) {
 // -----------------------------------------------------------------------------
 int
 iI2cWriteReg8 (int fd, uint8_t reg, uint8_t value) {
+
+  if (prvbI2cIsSoft (fd)) {
+    uint8_t b[2] = { reg, value };
+
+    return prviI2cLinkXfer (fd, b, 2, NULL, 0);
+  }
   int i = i2c_smbus_write_byte_data (fd, reg, value);
 
   vI2cPrintDebug (i, __func__);
@@ -116,6 +349,12 @@ iI2cWriteReg8 (int fd, uint8_t reg, uint8_t value) {
 // -----------------------------------------------------------------------------
 int
 iI2cWriteReg16 (int fd, uint8_t reg, uint16_t value) {
+
+  if (prvbI2cIsSoft (fd)) {
+    uint8_t b[3] = { reg, value & 0xFF, value >> 8 };
+
+    return prviI2cLinkXfer (fd, b, 3, NULL, 0);
+  }
   int i = i2c_smbus_write_word_data (fd, reg, value);
 
   vI2cPrintDebug (i, __func__);
@@ -125,6 +364,15 @@ iI2cWriteReg16 (int fd, uint8_t reg, uint16_t value) {
 // -----------------------------------------------------------------------------
 int
 iI2cWriteRegBlock (int fd, uint8_t reg, const uint8_t * values, uint8_t len) {
+
+  if (prvbI2cIsSoft (fd)) {
+    uint8_t b[I2C_BLOCK_MAX + 1];
+
+    len = MIN (len, I2C_BLOCK_MAX);
+    b[0] = reg;
+    memcpy (&b[1], values, len);
+    return prviI2cLinkXfer (fd, b, len + 1, NULL, 0);
+  }
   int i = i2c_smbus_write_i2c_block_data (fd, reg, len, values);
 
   vI2cPrintDebug (i, __func__);
@@ -135,6 +383,11 @@ iI2cWriteRegBlock (int fd, uint8_t reg, const uint8_t * values, uint8_t len) {
 // -----------------------------------------------------------------------------
 int
 iI2cReadBlock (int fd, uint8_t * block, int len) {
+
+  if (prvbI2cIsSoft (fd)) {
+
+    return prviI2cLinkXfer (fd, NULL, 0, block, len) < 0 ? -1 : len;
+  }
   int i = read (fd, block, len);
 
   vI2cPrintDebug (i, __func__);
@@ -143,12 +396,131 @@ iI2cReadBlock (int fd, uint8_t * block, int len) {
 
 // -----------------------------------------------------------------------------
 int iI2cWriteBlock (int fd, const uint8_t * block, int len) {
+
+  if (prvbI2cIsSoft (fd)) {
+
+    return prviI2cLinkXfer (fd, block, len, NULL, 0) < 0 ? -1 : len;
+  }
   int i = write (fd, block, len);
 
   vI2cPrintDebug (i, __func__);
   return i;
 }
 
+// -----------------------------------------------------------------------------
+int
+iI2cTransfer (int fd, xI2cMsg * msgs, int n) {
+  struct i2c_rdwr_ioctl_data data;
+  struct i2c_msg kmsgs[I2C_RDWR_IOCTL_MAX_MSGS];
+  int i;
+
+  if (!msgs || (n <= 0) || (n > I2C_RDWR_IOCTL_MAX_MSGS)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (prvbI2cIsSoft (fd)) {
+
+    return prviI2cSoftTransfer (fd, msgs, n, false);
+  }
+
+  for (i = 0; i < n; i++) {
+
+    kmsgs[i].addr = msgs[i].addr;
+    kmsgs[i].flags = (msgs[i].flags & I2C_MSG_READ) ? I2C_M_RD : 0;
+    kmsgs[i].len = msgs[i].len;
+    kmsgs[i].buf = (char *) msgs[i].buf;
+  }
+  data.msgs = kmsgs;
+  data.nmsgs = n;
+  return ioctl (fd, I2C_RDWR, &data);
+}
+
+// -----------------------------------------------------------------------------
+bool
+bI2cIsPlain (int fd) {
+  unsigned long funcs;
+
+  if (prvbI2cIsSoft (fd)) {
+
+    return true;
+  }
+  if (ioctl (fd, I2C_FUNCS, &funcs) < 0) {
+
+    return false;
+  }
+  return (funcs & I2C_FUNC_I2C) != 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+iI2cRegisterAdapter (const char * device, const xI2cAdapter * adapter) {
+  xI2cBus * b;
+
+  pthread_mutex_lock (&xI2cMutex);
+  if (prvpxI2cFindBus (device)) {
+
+    pthread_mutex_unlock (&xI2cMutex);
+    errno = EEXIST;
+    PERROR ("%s already registered", device);
+    return -1;
+  }
+  b = calloc (1, sizeof (xI2cBus));
+  assert (b);
+  b->device = strdup (device);
+  b->adapter = *adapter;
+  b->next = pxI2cBusList;
+  pxI2cBusList = b;
+  pthread_mutex_unlock (&xI2cMutex);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+iI2cUnregisterAdapter (const char * device) {
+  xI2cBus ** pb;
+  xI2cLink * l;
+  int err = ENOENT;
+
+  pthread_mutex_lock (&xI2cMutex);
+  for (pb = &pxI2cBusList; *pb; pb = & (*pb)->next) {
+
+    if (strcmp ( (*pb)->device, device) == 0) {
+      xI2cBus * b = *pb;
+
+      *pb = b->next;
+      // les connexions encore ouvertes renvoient ENODEV jusqu'à leur
+      // fermeture
+      for (l = pxI2cLinkList; l; l = l->next) {
+
+        if (l->bus == b) {
+
+          l->bus = NULL;
+        }
+      }
+      // attente de la fin des transactions en cours, b->adapter.ctx n'est
+      // plus utilisé au retour
+      while (b->busy) {
+
+        pthread_cond_wait (&xI2cIdle, &xI2cMutex);
+      }
+      free (b->device);
+      free (b);
+      err = 0;
+      break;
+    }
+  }
+  pthread_mutex_unlock (&xI2cMutex);
+
+  if (err) {
+
+    errno = err;
+    return -1;
+  }
+  return 0;
+}
+
 /* structures =============================================================== */
 struct xI2cMem {
   int        i2caddr;    /* slave device address */
@@ -229,7 +601,6 @@ xI2cMem *
 xI2cMemOpen (const char * device, int i2caddr,
              uint32_t mem_size, uint16_t page_size, uint8_t flags) {
   xI2cMem * m;
-  unsigned long i2cfuncs;
 
   m = calloc (sizeof (xI2cMem), 1 );
   assert (m);
@@ -241,14 +612,10 @@ xI2cMemOpen (const char * device, int i2caddr,
   }
 
 
-  if (ioctl (m->fd, I2C_FUNCS, &i2cfuncs) < 0) {
-
-    goto xI2cMemOpenError;
-  }
-
-  if (! (i2cfuncs & I2C_FUNC_I2C) ) {
+  if (!bI2cIsPlain (m->fd)) {
 
     PERROR ("Plain i2c-level commands unsupported");
+    iI2cClose (m->fd);
     goto xI2cMemOpenError;
   }
 
@@ -302,8 +669,7 @@ iI2cMemWrite  (xI2cMem * m,
                uint32_t offset, const uint8_t * buffer, uint16_t size) {
   int ret;
   int io_try;
-  struct i2c_rdwr_ioctl_data i2c_data;
-  struct i2c_msg msg[1];
+  xI2cMsg msg[1];
   uint16_t count, remaining_bytes;
   const uint8_t * p;
 
@@ -313,10 +679,7 @@ iI2cMemWrite  (xI2cMem * m,
   /*
    * write operation
    */
-  i2c_data.msgs = msg;
-  i2c_data.nmsgs = 1;             // use one message structure
-
-  msg[0].buf = (char *) m->offset;
+  msg[0].buf = m->offset;
   msg[0].flags = 0;     // don't need flags
   p = buffer;
 
@@ -329,7 +692,7 @@ iI2cMemWrite  (xI2cMem * m,
     io_try = 0;
     do {
       // Si eeprom no ready, ret = -1, errno = EIO
-      ret = ioctl (m->fd, I2C_RDWR, &i2c_data);
+      ret = iI2cTransfer (m->fd, msg, 1);
 
       if ( (ret < 0) && (errno == EIO) ) {
 
@@ -364,8 +727,7 @@ int
 iI2cMemRead  (xI2cMem * m,
               uint32_t offset, uint8_t * buffer, uint16_t size) {
   int ret;
-  struct i2c_rdwr_ioctl_data i2c_data;
-  struct i2c_msg msg[2];
+  xI2cMsg msg[2];
   int io_try = 0;
 
   /*
@@ -373,25 +735,22 @@ iI2cMemRead  (xI2cMem * m,
    * First determine offset address
    * , and then receive data.
    */
-  i2c_data.msgs = msg;
-  i2c_data.nmsgs = 2;     // two i2c_msg
-
   msg[0].addr = prviSetOffset (m, offset);
   msg[0].flags = 0;     // write
   msg[0].len = 2;       // offset
-  msg[0].buf = (char *) m->offset;
+  msg[0].buf = m->offset;
 
   /*
    * Second, read data from the EEPROM
    */
   msg[1].addr = msg[0].addr;
-  msg[1].flags = I2C_M_RD;      // read command
+  msg[1].flags = I2C_MSG_READ;      // read command
   msg[1].len = size;
-  msg[1].buf = (char *) buffer;
+  msg[1].buf = buffer;
 
   do {
     // Si eeprom no ready, ret = -1, errno = EIO
-    ret = ioctl (m->fd, I2C_RDWR, &i2c_data);
+    ret = iI2cTransfer (m->fd, msg, 2);
 
     if ( (ret < 0) && (errno == EIO) ) {
 
@@ -43,7 +43,6 @@ struct xIaq {
 xIaq *
 xIaqOpen (const char * device, int i2caddr) {
   xIaq * s;
-  unsigned long i2cfuncs;
 
   s = calloc (sizeof (xIaq), 1);
   assert (s);
@@ -55,12 +54,7 @@ xIaqOpen (const char * device, int i2caddr) {
     goto iaqOE;
   }
 
-  if (ioctl (s->fd, I2C_FUNCS, &i2cfuncs) < 0) {
-
-    goto iaqOC;
-  }
-
-  if (! (i2cfuncs & I2C_FUNC_I2C)) {
+  if (!bI2cIsPlain (s->fd)) {
 
     errno = EIO;
     PERROR ("Plain i2c-level commands unsupported");
@@ -70,7 +64,7 @@ xIaqOpen (const char * device, int i2caddr) {
   return s;
 
 iaqOC:
-  close (s->fd);
+  iI2cClose (s->fd);
 iaqOE:
   free (s);
   return NULL;
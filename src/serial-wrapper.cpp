@@ -10,7 +10,62 @@
 #include <cstdlib>
 #include <cerrno>
 #include <stdexcept>
+#include <system_error>
+#include <chrono>
 #include <cstring>
+#include <climits>
+#include <algorithm>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/uio.h>
+
+namespace {
+
+  // Taille initiale du tampon de lecture (puissance de 2)
+  const size_t rxDefaultSize = 4096;
+  // Taille maximale d'un bloc regroupant des écritures par copie
+  const size_t txChunkSize = 4096;
+
+  typedef std::chrono::steady_clock Clock;
+
+  // Délai restant avant deadline en ms, -1 si timeout_ms est négatif
+  int
+  remaining (const Clock::time_point & deadline, int timeout_ms) {
+
+    if (timeout_ms < 0) {
+
+      return -1;
+    }
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds> (deadline - Clock::now()).count();
+    return (left > 0) ? static_cast<int> (left) : 0;
+  }
+
+  // Attente d'un événement, false si le délai est écoulé
+  bool
+  waitFd (int fd, short events, int timeout_ms) {
+    struct pollfd pfd = { fd, events, 0 };
+    int ret = ::poll (&pfd, 1, timeout_ms);
+
+    if (ret < 0) {
+
+      if (errno == EINTR) {
+
+        return false;
+      }
+      throw std::system_error (errno, std::system_category(), "poll");
+    }
+    if (ret > 0) {
+
+      if ( (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) && ! (pfd.revents & events)) {
+
+        // port déconnecté, read() et write() échoueraient sans attendre
+        throw std::system_error (EIO, std::system_category(), "poll");
+      }
+      return true;
+    }
+    return false;
+  }
+}
 
 //##############################################################################
 //#                                                                            #
@@ -21,7 +76,9 @@
 /* public  ================================================================== */
 
 // -----------------------------------------------------------------------------
-Serial::Serial (const char * portname, int baudrate) : fd (-1) {
+Serial::Serial (const char * portname, int baudrate) :
+  fd (-1), _rx (rxDefaultSize), _rxhead (0), _rxcount (0),
+  _txoffset (0), _txcount (0), _txthreshold (txChunkSize) {
 
   ios.baud = baudrate;
   ios.dbits = static_cast <eSerialDataBits> (Data8);
@@ -54,6 +111,9 @@ void Serial::close() {
     vSerialClose (fd);
     fd = -1;
   }
+  _rxhead = _rxcount = 0;
+  _tx.clear();
+  _txoffset = _txcount = 0;
 }
 
 // -----------------------------------------------------------------------------
@@ -70,6 +130,9 @@ Serial::flush() {
 
     vSerialFlush (fd);
   }
+  _rxhead = _rxcount = 0;
+  _tx.clear();
+  _txoffset = _txcount = 0;
 }
 
 // -----------------------------------------------------------------------------
@@ -167,5 +230,392 @@ Serial::setPort (const char * portname) {
   }
 }
 
+// -----------------------------------------------------------------------------
+size_t
+Serial::available() {
+
+  checkOpen (__FUNCTION__);
+  rxFill();
+  return _rxcount;
+}
+
+// -----------------------------------------------------------------------------
+size_t
+Serial::read (uint8_t * buf, size_t len, int timeout_ms) {
+
+  checkOpen (__FUNCTION__);
+  if (len == 0) {
+
+    return 0;
+  }
+
+  if (_rxcount == 0) {
+
+    if (len >= _rx.size()) {
+      // bloc plus grand que le tampon, lu sans copie intermédiaire
+      size_t n = rxRead (buf, len);
+
+      if ( (n == 0) && waitFd (fd, POLLIN, timeout_ms)) {
+
+        n = rxRead (buf, len);
+      }
+      return n;
+    }
+
+    if ( (rxFill() == 0) && waitFd (fd, POLLIN, timeout_ms)) {
+
+      rxFill();
+    }
+  }
+  return rxCopy (buf, len, true);
+}
+
+// -----------------------------------------------------------------------------
+size_t
+Serial::peek (uint8_t * buf, size_t len, int timeout_ms) {
+
+  checkOpen (__FUNCTION__);
+  if ( (rxFill() == 0) && (_rxcount == 0) && waitFd (fd, POLLIN, timeout_ms)) {
+
+    rxFill();
+  }
+  return rxCopy (buf, len, false);
+}
+
+// -----------------------------------------------------------------------------
+int
+Serial::peek (int timeout_ms) {
+  uint8_t c;
+
+  if (peek (&c, 1, timeout_ms) == 1) {
+
+    return c;
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+std::vector<uint8_t>
+Serial::readExact (size_t n, int timeout_ms) {
+  Clock::time_point deadline = Clock::now() + std::chrono::milliseconds (timeout_ms);
+
+  checkOpen (__FUNCTION__);
+  rxReserve (n);
+
+  for (;;) {
+
+    rxFill();
+    if (_rxcount >= n) {
+
+      return rxTake (n);
+    }
+
+    int left = remaining (deadline, timeout_ms);
+    if (left == 0) {
+
+      throw std::system_error (ETIMEDOUT, std::system_category(), __FUNCTION__);
+    }
+    waitFd (fd, POLLIN, left);
+  }
+}
+
+// -----------------------------------------------------------------------------
+std::vector<uint8_t>
+Serial::readUntil (uint8_t delim, size_t maxlen, int timeout_ms) {
+  Clock::time_point deadline = Clock::now() + std::chrono::milliseconds (timeout_ms);
+  size_t scanned = 0; // octets déjà examinés
+
+  checkOpen (__FUNCTION__);
+  for (;;) {
+    size_t mask = _rx.size() - 1;
+    size_t end;
+
+    rxFill();
+    end = (maxlen && (_rxcount > maxlen)) ? maxlen : _rxcount;
+
+    // recherche dans les deux zones du tampon circulaire
+    while (scanned < end) {
+      size_t i = (_rxhead + scanned) & mask;
+      size_t len = std::min (end - scanned, _rx.size() - i);
+      const uint8_t * p = static_cast<const uint8_t *> (memchr (&_rx[i], delim, len));
+
+      if (p) {
+
+        return rxTake (scanned + (p - &_rx[i]) + 1);
+      }
+      scanned += len;
+    }
+
+    if (maxlen && (_rxcount >= maxlen)) {
+
+      return rxTake (maxlen);
+    }
+
+    if (_rxcount == _rx.size()) {
+
+      rxReserve (_rx.size() * 2);
+      continue;
+    }
+
+    int left = remaining (deadline, timeout_ms);
+    if (left == 0) {
+
+      throw std::system_error (ETIMEDOUT, std::system_category(), __FUNCTION__);
+    }
+    waitFd (fd, POLLIN, left);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void
+Serial::write (const uint8_t * buf, size_t len) {
+
+  if (len == 0) {
+
+    return;
+  }
+
+  if (!_tx.empty() && (_tx.back().size() + len <= txChunkSize)) {
+
+    _tx.back().insert (_tx.back().end(), buf, buf + len);
+  }
+  else {
+
+    _tx.emplace_back (buf, buf + len);
+  }
+  _txcount += len;
+
+  if (_txthreshold && (_txcount >= _txthreshold)) {
+
+    sync();
+  }
+}
+
+// -----------------------------------------------------------------------------
+void
+Serial::write (std::vector<uint8_t> && buf) {
+
+  if (buf.empty()) {
+
+    return;
+  }
+
+  _txcount += buf.size();
+  _tx.push_back (std::move (buf));
+
+  if (_txthreshold && (_txcount >= _txthreshold)) {
+
+    sync();
+  }
+}
+
+// -----------------------------------------------------------------------------
+bool
+Serial::sync (int timeout_ms) {
+  Clock::time_point deadline = Clock::now() + std::chrono::milliseconds (timeout_ms);
+
+  checkOpen (__FUNCTION__);
+  while (_txcount) {
+    struct iovec iov[IOV_MAX];
+    int n = 0;
+    ssize_t ret;
+
+    if ( (timeout_ms >= 0) && !waitFd (fd, POLLOUT, remaining (deadline, timeout_ms))) {
+
+      if (remaining (deadline, timeout_ms) == 0) {
+
+        return false;
+      }
+      continue; // EINTR
+    }
+
+    for (auto it = _tx.begin(); (it != _tx.end()) && (n < IOV_MAX); ++it, ++n) {
+      size_t offset = (n == 0) ? _txoffset : 0;
+
+      iov[n].iov_base = it->data() + offset;
+      iov[n].iov_len = it->size() - offset;
+    }
+
+    ret = ::writev (fd, iov, n);
+    if (ret < 0) {
+
+      if ( (errno == EINTR) || (errno == EAGAIN)) {
+
+        continue;
+      }
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+
+    // retrait des blocs transmis
+    _txcount -= ret;
+    while (ret > 0) {
+      size_t left = _tx.front().size() - _txoffset;
+
+      if (static_cast<size_t> (ret) >= left) {
+
+        _tx.pop_front();
+        _txoffset = 0;
+        ret -= left;
+      }
+      else {
+
+        _txoffset += ret;
+        ret = 0;
+      }
+    }
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+size_t
+Serial::pending() const {
+
+  return _txcount;
+}
+
+// -----------------------------------------------------------------------------
+size_t
+Serial::writeThreshold() const {
+
+  return _txthreshold;
+}
+
+// -----------------------------------------------------------------------------
+void
+Serial::setWriteThreshold (size_t threshold) {
+
+  _txthreshold = threshold;
+}
+
+/* private  ================================================================= */
+
+// -----------------------------------------------------------------------------
+void
+Serial::checkOpen (const char * func) const {
+
+  if (fd < 0) {
+
+    throw std::system_error (EBADF, std::system_category(), func);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Agrandit le tampon de lecture à au moins n octets, les octets sont alors
+// remis au début du tampon
+void
+Serial::rxReserve (size_t n) {
+
+  if (n > _rx.size()) {
+    size_t size = _rx.size();
+
+    while (size < n) {
+
+      size *= 2;
+    }
+    std::vector<uint8_t> rx (size);
+    _rxcount = rxCopy (rx.data(), _rxcount, false);
+    _rxhead = 0;
+    _rx.swap (rx);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Lecture sans attente, 0 si aucun octet n'a été reçu
+size_t
+Serial::rxRead (uint8_t * buf, size_t len) {
+  ssize_t ret = ::read (fd, buf, len);
+
+  if (ret < 0) {
+
+    if ( (errno == EAGAIN) || (errno == EINTR)) {
+
+      return 0;
+    }
+    throw std::system_error (errno, std::system_category(), __FUNCTION__);
+  }
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+// Complète le tampon de lecture avec les octets reçus par le pilote
+size_t
+Serial::rxFill() {
+  size_t total = 0;
+
+  while (_rxcount < _rx.size()) {
+    size_t size = _rx.size();
+    size_t tail = (_rxhead + _rxcount) & (size - 1);
+    size_t free = size - _rxcount;
+    struct iovec iov[2];
+    int n = 1;
+    ssize_t ret;
+
+    iov[0].iov_base = &_rx[tail];
+    iov[0].iov_len = std::min (free, size - tail);
+    if (free > iov[0].iov_len) {
+
+      iov[1].iov_base = &_rx[0];
+      iov[1].iov_len = free - iov[0].iov_len;
+      n = 2;
+    }
+
+    ret = ::readv (fd, iov, n);
+    if (ret < 0) {
+
+      if (errno == EINTR) {
+
+        continue;
+      }
+      if (errno == EAGAIN) {
+
+        break;
+      }
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+
+    _rxcount += ret;
+    total += ret;
+    if (static_cast<size_t> (ret) < free) {
+
+      // tampon du pilote vidé
+      break;
+    }
+  }
+  return total;
+}
+
+// -----------------------------------------------------------------------------
+// Copie d'au plus len octets du tampon de lecture, retirés si consume
+size_t
+Serial::rxCopy (uint8_t * buf, size_t len, bool consume) {
+  size_t size = _rx.size();
+  size_t first;
+
+  len = std::min (len, _rxcount);
+  first = std::min (len, size - _rxhead);
+  memcpy (buf, &_rx[_rxhead], first);
+  memcpy (buf + first, &_rx[0], len - first);
+
+  if (consume) {
+
+    _rxhead = (_rxhead + len) & (size - 1);
+    _rxcount -= len;
+    if (_rxcount == 0) {
+
+      _rxhead = 0;
+    }
+  }
+  return len;
+}
+
+// -----------------------------------------------------------------------------
+std::vector<uint8_t>
+Serial::rxTake (size_t n) {
+  std::vector<uint8_t> v (n);
+
+  rxCopy (v.data(), n, true);
+  return v;
+}
 
 /* ========================================================================== */
@@ -13,14 +13,124 @@
 #include <errno.h>
 #include <sys/ioctl.h>
 #include <string.h>
+#include <pthread.h>
 #include <linux/spi/spidev.h>
 #include <sysio/spi.h>
 
+/* structures =============================================================== */
+// Bus logiciel enregistré
+typedef struct xSpiBus {
+  struct xSpiBus * next;
+  char * device;
+  xSpiAdapter adapter;
+  int busy; // nombre d'appels de l'adaptateur en cours
+} xSpiBus;
+
+// Connexion ouverte sur un bus logiciel, le descripteur est celui de
+// /dev/null, ce qui garantit son unicité. bus est NULL si le bus a été
+// retiré par iSpiUnregisterAdapter()
+typedef struct xSpiLink {
+  struct xSpiLink * next;
+  int fd;
+  xSpiBus * bus;
+} xSpiLink;
+
+/* private variables ======================================================== */
+static xSpiBus * pxSpiBusList;
+static xSpiLink * pxSpiLinkList;
+static pthread_mutex_t xSpiMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xSpiIdle = PTHREAD_COND_INITIALIZER;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static xSpiBus *
+prvpxSpiFindBus (const char * device) {
+  xSpiBus * b;
+
+  for (b = pxSpiBusList; b; b = b->next) {
+
+    if (strcmp (b->device, device) == 0) {
+
+      return b;
+    }
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Réserve le bus logiciel de fd pendant un appel de son adaptateur,
+// iSpiUnregisterAdapter() attend sa libération par prvvSpiRelease().
+// *soft est faux si fd est un bus du noyau. Renvoie NULL si fd n'est pas un
+// bus logiciel ou si son bus a été retiré (errno = ENODEV)
+static xSpiBus *
+prvpxSpiAcquire (int fd, bool * soft) {
+  xSpiBus * b = NULL;
+  xSpiLink * l;
+
+  *soft = false;
+  pthread_mutex_lock (&xSpiMutex);
+  for (l = pxSpiLinkList; l; l = l->next) {
+
+    if (l->fd == fd) {
+
+      *soft = true;
+      b = l->bus;
+      if (b) {
+
+        b->busy++;
+      }
+      else {
+
+        errno = ENODEV;
+      }
+      break;
+    }
+  }
+  pthread_mutex_unlock (&xSpiMutex);
+  return b;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvSpiRelease (xSpiBus * b) {
+
+  if (b) {
+
+    pthread_mutex_lock (&xSpiMutex);
+    if (--b->busy == 0) {
+
+      pthread_cond_broadcast (&xSpiIdle);
+    }
+    pthread_mutex_unlock (&xSpiMutex);
+  }
+}
+
 /* internal public functions ================================================ */
 
 // -----------------------------------------------------------------------------
 int iSpiOpen (const char *device) {
   int fd;
+  xSpiBus * b;
+
+  pthread_mutex_lock (&xSpiMutex);
+  b = prvpxSpiFindBus (device);
+  if (b) {
+
+    fd = open ("/dev/null", O_RDWR);
+    if (fd >= 0) {
+      xSpiLink * l = calloc (1, sizeof (xSpiLink));
+      assert (l);
+
+      l->fd = fd;
+      l->bus = b;
+      l->next = pxSpiLinkList;
+      pxSpiLinkList = l;
+    }
+    pthread_mutex_unlock (&xSpiMutex);
+    return fd;
+  }
+  pthread_mutex_unlock (&xSpiMutex);
 
   fd = open (device, O_RDWR);
 
@@ -30,16 +140,107 @@ int iSpiOpen (const char *device) {
 
 // -----------------------------------------------------------------------------
 int iSpiClose (int fd) {
+  xSpiLink ** pl;
+
+  pthread_mutex_lock (&xSpiMutex);
+  for (pl = &pxSpiLinkList; *pl; pl = & (*pl)->next) {
+
+    if ( (*pl)->fd == fd) {
+      xSpiLink * l = *pl;
+
+      *pl = l->next;
+      free (l);
+      break;
+    }
+  }
+  pthread_mutex_unlock (&xSpiMutex);
 
   return close (fd);
 }
 
+// -----------------------------------------------------------------------------
+int
+iSpiRegisterAdapter (const char * device, const xSpiAdapter * adapter) {
+  xSpiBus * b;
+
+  pthread_mutex_lock (&xSpiMutex);
+  if (prvpxSpiFindBus (device)) {
+
+    pthread_mutex_unlock (&xSpiMutex);
+    errno = EEXIST;
+    PERROR ("%s already registered", device);
+    return -1;
+  }
+  b = calloc (1, sizeof (xSpiBus));
+  assert (b);
+  b->device = strdup (device);
+  b->adapter = *adapter;
+  b->next = pxSpiBusList;
+  pxSpiBusList = b;
+  pthread_mutex_unlock (&xSpiMutex);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSpiUnregisterAdapter (const char * device) {
+  xSpiBus ** pb;
+  xSpiLink * l;
+  int err = ENOENT;
+
+  pthread_mutex_lock (&xSpiMutex);
+  for (pb = &pxSpiBusList; *pb; pb = & (*pb)->next) {
+
+    if (strcmp ( (*pb)->device, device) == 0) {
+      xSpiBus * b = *pb;
+
+      *pb = b->next;
+      // les connexions encore ouvertes renvoient ENODEV jusqu'à leur
+      // fermeture
+      for (l = pxSpiLinkList; l; l = l->next) {
+
+        if (l->bus == b) {
+
+          l->bus = NULL;
+        }
+      }
+      // attente de la fin des appels en cours, b->adapter.ctx n'est plus
+      // utilisé au retour
+      while (b->busy) {
+
+        pthread_cond_wait (&xSpiIdle, &xSpiMutex);
+      }
+      free (b->device);
+      free (b);
+      err = 0;
+      break;
+    }
+  }
+  pthread_mutex_unlock (&xSpiMutex);
+
+  if (err) {
+
+    errno = err;
+    return -1;
+  }
+  return 0;
+}
+
 // -----------------------------------------------------------------------------
 int
 iSpiGetConfig (int fd, xSpiIos * config) {
   uint8_t       byte;
   uint32_t      word;
   int ret;
+  bool soft;
+  xSpiBus * b = prvpxSpiAcquire (fd, &soft);
+
+  if (soft) {
+
+    ret = b ? b->adapter.getconfig (b->adapter.ctx, config) : -1;
+    prvvSpiRelease (b);
+    return ret;
+  }
 
   // Read the current configuration.
   if ( (ret = ioctl (fd, SPI_IOC_RD_MODE, &byte)) < 0) {
@@ -79,12 +280,35 @@ iSpiSetConfig (int fd, const xSpiIos * new_config) {
   uint8_t       byte;
   uint32_t      word;
   int ret;
+  bool soft;
+  xSpiBus * b;
 
   if ( (ret = iSpiGetConfig (fd, &config)) < 0) {
 
     return ret;
   }
 
+  b = prvpxSpiAcquire (fd, &soft);
+  if (soft) {
+
+    // seuls les champs spécifiés sont modifiés
+    if (new_config->mode != eSpiModeNotSet) {
+      config.mode = new_config->mode;
+    }
+    if (new_config->lsb != eSpiNumberingNotSet) {
+      config.lsb = new_config->lsb;
+    }
+    if (new_config->bits != (uint8_t) eSpiBitsNotSet) {
+      config.bits = new_config->bits;
+    }
+    if (new_config->speed != 0) {
+      config.speed = new_config->speed;
+    }
+    ret = b ? b->adapter.setconfig (b->adapter.ctx, &config) : -1;
+    prvvSpiRelease (b);
+    return ret;
+  }
+
   // Set the new configuration.
   if ( (config.mode != new_config->mode) && (new_config->mode != eSpiModeNotSet)) {
 
@@ -133,6 +357,15 @@ iSpiSetConfig (int fd, const xSpiIos * new_config) {
 // -----------------------------------------------------------------------------
 int iSpiXfer (int fd, uint8_t *tx_buffer, uint8_t tx_len, uint8_t *rx_buffer, uint8_t rx_len) {
   struct spi_ioc_transfer spi_message[1];
+  bool soft;
+  xSpiBus * b = prvpxSpiAcquire (fd, &soft);
+
+  if (soft) {
+    int ret = b ? b->adapter.xfer (b->adapter.ctx, tx_buffer, rx_buffer, tx_len) : -1;
+
+    prvvSpiRelease (b);
+    return ret;
+  }
   memset (spi_message, 0, sizeof (spi_message));
 
   spi_message[0].rx_buf = (unsigned long) rx_buffer;
@@ -145,6 +378,15 @@ int iSpiXfer (int fd, uint8_t *tx_buffer, uint8_t tx_len, uint8_t *rx_buffer, ui
 // -----------------------------------------------------------------------------
 int iSpiRead (int fd, uint8_t *rx_buffer, uint8_t rx_len) {
   struct spi_ioc_transfer spi_message[1];
+  bool soft;
+  xSpiBus * b = prvpxSpiAcquire (fd, &soft);
+
+  if (soft) {
+    int ret = b ? b->adapter.xfer (b->adapter.ctx, NULL, rx_buffer, rx_len) : -1;
+
+    prvvSpiRelease (b);
+    return ret;
+  }
   memset (spi_message, 0, sizeof (spi_message));
 
   spi_message[0].rx_buf = (unsigned long) rx_buffer;
@@ -157,6 +399,15 @@ int iSpiRead (int fd, uint8_t *rx_buffer, uint8_t rx_len) {
 // -----------------------------------------------------------------------------
 int iSpiWrite (int fd, uint8_t *tx_buffer, uint8_t tx_len) {
   struct spi_ioc_transfer spi_message[1];
+  bool soft;
+  xSpiBus * b = prvpxSpiAcquire (fd, &soft);
+
+  if (soft) {
+    int ret = b ? b->adapter.xfer (b->adapter.ctx, tx_buffer, NULL, tx_len) : -1;
+
+    prvvSpiRelease (b);
+    return ret;
+  }
   memset (spi_message, 0, sizeof (spi_message));
 
   spi_message[0].tx_buf = (unsigned long) tx_buffer;
@@ -6,6 +6,7 @@
  * This software is governed by the CeCILL license <http://www.cecill.info>
  */
 #include <string.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
@@ -685,7 +686,7 @@ prviProbeFrame (xTinfo * t) {
 
 // -----------------------------------------------------------------------------
 static int
-prviProbeBuffer (xTinfo * t, char * buffer, int len) {
+prviProbeBuffer (xTinfo * t, const char * buffer, int len) {
   int i;
 
   if (t->buflen == 0) {
@@ -790,6 +791,44 @@ iTinfoPoll (xTinfo * t) {
   return 0;
 }
 
+// -----------------------------------------------------------------------------
+int
+iTinfoFeed (xTinfo * t, const void * buf, size_t len) {
+
+  if (!t || (!buf && len)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+  return prviProbeBuffer (t, (const char *) buf, len);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviTinfoReactorCb (int fd, const uint8_t * buf, size_t len, void * udata) {
+
+  (void) fd;
+  if (buf) {
+
+    (void) prviProbeBuffer ( (xTinfo *) udata, (const char *) buf, len);
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+iTinfoAttachReactor (xTinfo * t, xSerialReactor * r) {
+
+  return iSerialReactorAdd (r, t->serial, TINFO_BUFFER_SIZE, prviTinfoReactorCb, t);
+}
+
+// -----------------------------------------------------------------------------
+int
+iTinfoDetachReactor (xTinfo * t, xSerialReactor * r) {
+
+  return iSerialReactorRemove (r, t->serial);
+}
+
 // -----------------------------------------------------------------------------
 int
 iTinfoClose (xTinfo * t) {
@@ -11,26 +11,136 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <pthread.h>
 #include <sysio/iomap.h>
 #include <sysio/log.h>
 
 /* constants ================================================================ */
 #define IOMAP_SHM "/dev/mem"
+#define IOMAP_GPIOMEM "/dev/gpiomem"
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
 
 /* structures =============================================================== */
 typedef struct xIoMap {
   unsigned long base; /*< adresse de base de la zone */
   unsigned int size; /*< Taille de la zone */
-  int fd;           /*< descripteur d'accès à la zone mémoire */
+  int fd;           /*< descripteur d'accès à la zone mémoire, -1 si fermé */
   void * map;         /*< pointeur de la zone */
   volatile unsigned int * io; /*< pointeur d'accès aux registres */
+  int link;         /*< nombre d'ouvertures, 0 si hors registre */
+  struct xIoMap * next; /*< projection suivante du registre */
 } xIoMap;
 
+/* private variables ======================================================== */
+// Registre des projections de registres matériels ouvertes dans le processus,
+// une zone (base, size) n'est projetée qu'une seule fois
+static xIoMap * pxRegistry;
+static pthread_mutex_t xRegistryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* private functions ======================================================== */
+// -----------------------------------------------------------------------------
+// Projection de la zone depuis le fichier dev à l'offset donné, le descripteur
+// est fermé après la projection qui reste valide
+static xIoMap *
+prvxIoMapNew (const char * dev, off_t offset, unsigned long base, unsigned int size) {
+  int fd;
+  void * map;
+  xIoMap * p;
+
+  if ( (fd = open (dev, O_RDWR | O_SYNC | O_CLOEXEC)) < 0) {  // TODO: NO POSIX COMPLIANT
+
+    return NULL;
+  }
+
+  map = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+  close (fd);
+  if (map == MAP_FAILED) {
+
+    return NULL;
+  }
+
+  if (! (p = malloc (sizeof (xIoMap)))) {
+
+    munmap (map, size);
+    return NULL;
+  }
+  memset (p, 0, sizeof (xIoMap));
+  p->fd = -1;
+  p->map = map;
+  p->io = (volatile unsigned int *) map;
+  p->base = base;
+  p->size = size;
+  return p;
+}
+
+// -----------------------------------------------------------------------------
+// gpiomem: true si la zone est le bloc GPIO, accessible par /dev/gpiomem
+static xIoMap *
+prvxIoMapOpen (unsigned long base, unsigned int size, bool gpiomem) {
+  xIoMap * p;
+
+  pthread_mutex_lock (&xRegistryMutex);
+  for (p = pxRegistry; p; p = p->next) {
+
+    if ( (p->base == base) && (p->size == size)) {
+
+      p->link++;
+      pthread_mutex_unlock (&xRegistryMutex);
+      return p;
+    }
+  }
+
+  p = NULL;
+  if (gpiomem && (access (IOMAP_GPIOMEM, F_OK) == 0)) {
+
+    // /dev/gpiomem ne donne accès qu'au bloc GPIO, à partir de l'offset 0,
+    // sans les droits root
+    p = prvxIoMapNew (IOMAP_GPIOMEM, 0, base, size);
+  }
+  if (!p) {
+
+    p = prvxIoMapNew (IOMAP_SHM, base, base, size);
+  }
+
+  if (p) {
+
+    p->link = 1;
+    p->next = pxRegistry;
+    pxRegistry = p;
+  }
+  else {
+
+    int err = errno;
+    PERROR ("Failed to map 0x%lx, try checking permissions: %s", base, strerror (err));
+    errno = err;
+  }
+  pthread_mutex_unlock (&xRegistryMutex);
+  return p;
+}
+
 /* internal public functions ================================================ */
 // -----------------------------------------------------------------------------
 xIoMap *
 xIoMapOpen (unsigned long base, unsigned int size) {
 
+  return prvxIoMapOpen (base, size, false);
+}
+
+// -----------------------------------------------------------------------------
+xIoMap *
+xIoMapOpenGpio (unsigned long base, unsigned int size) {
+
+  return prvxIoMapOpen (base, size, true);
+}
+
+// -----------------------------------------------------------------------------
+xIoMap *
+xIoMapOpenMemory (const char * name, unsigned int size) {
+
   xIoMap * p = malloc (sizeof(xIoMap));
   if (!p) {
 
@@ -38,11 +148,18 @@ xIoMapOpen (unsigned long base, unsigned int size) {
   }
   memset (p, 0, sizeof (xIoMap));
 
+  // memfd_create() n'est fourni que par les glibc >= 2.27
+  if ( (p->fd = syscall (SYS_memfd_create, name, MFD_CLOEXEC)) < 0) {
+
+    perror ("memfd_create");
+    goto iomap_memory_error;
+  }
 
-  if ( (p->fd = open (IOMAP_SHM, O_RDWR | O_SYNC | O_CLOEXEC)) < 0) {  // TODO: NO POSIX COMPLIANT
+  if (ftruncate (p->fd, size) < 0) {
 
-    perror ("open");
-    goto iomap_open_error;
+    perror ("ftruncate");
+    close (p->fd);
+    goto iomap_memory_error;
   }
 
   p->map = mmap (
@@ -51,22 +168,22 @@ xIoMapOpen (unsigned long base, unsigned int size) {
                PROT_READ | PROT_WRITE,
                MAP_SHARED,
                p->fd,
-               base
+               0
              );
 
   if (p->map == MAP_FAILED) {
 
     perror ("mmap");
-    goto iomap_open_error;
+    close (p->fd);
+    goto iomap_memory_error;
   }
 
   p->io = (volatile unsigned int *) p->map;
-  p->base = base;
+  p->base = 0;
   p->size = size;
   return p;
 
-iomap_open_error:
-  fprintf (stderr, "Failed to open %s, try checking permissions.\n", IOMAP_SHM);
+iomap_memory_error:
   free(p);
   return NULL;
 }
@@ -77,15 +194,37 @@ iIoMapClose (xIoMap *p) {
   assert (p);
   int i = 0;
 
-  if ((i = munmap (p->map, p->size)) != 0) {
+  if (p->link > 0) {
+    xIoMap ** pp;
+
+    pthread_mutex_lock (&xRegistryMutex);
+    if (--p->link > 0) {
+
+      // la zone est encore utilisée par ailleurs
+      pthread_mutex_unlock (&xRegistryMutex);
+      return 0;
+    }
+    for (pp = &pxRegistry; *pp; pp = & (*pp)->next) {
+
+      if (*pp == p) {
+
+        *pp = p->next;
+        break;
+      }
+    }
+    pthread_mutex_unlock (&xRegistryMutex);
+  }
+
+  if ( (i = munmap (p->map, p->size)) != 0) {
 
     perror ("munmap");
   }
-  if (close (p->fd) != 0) {  // TODO: NO POSIX COMPLIANT
+  if ( (p->fd >= 0) && (close (p->fd) != 0)) {  // TODO: NO POSIX COMPLIANT
 
     i = -1;
     perror ("close");
   }
+  free (p);
   return i;
 }
 
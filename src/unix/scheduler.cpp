@@ -7,42 +7,317 @@
  */
 #include <sysio/scheduler.h>
 #include <system_error>
+#include <stdexcept>
+#include <map>
+#include <mutex>
+//
 #include <sched.h>
+#include <unistd.h>
+#include <alloca.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
 
 namespace Sysio {
 
+  namespace {
+
+    // Paramètres de sched_setattr(), absent de la glibc
+    struct SchedAttr {
+      uint32_t size;
+      uint32_t sched_policy;
+      uint64_t sched_flags;
+      int32_t sched_nice;
+      uint32_t sched_priority;
+      uint64_t sched_runtime;
+      uint64_t sched_deadline;
+      uint64_t sched_period;
+    };
+
+    std::mutex profileMutex;
+    std::map<std::string, Scheduler::Profile> profiles;
+
+    const std::map<Scheduler::Policy, int> policy2int = {
+      {Scheduler::PolicyOther, SCHED_OTHER},
+      {Scheduler::PolicyFifo, SCHED_FIFO},
+      {Scheduler::PolicyRoundRobin, SCHED_RR},
+      {Scheduler::PolicyDeadline, SCHED_DEADLINE}
+    };
+  }
+
 // -----------------------------------------------------------------------------
 //
 //                        Scheduler Class
 //
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+  Scheduler::Profile::Profile() :
+    policy (PolicyOther), priority (0), lockMemory (false), stackPrefault (0),
+    runtime (0), deadline (0), period (0) {
+
+  }
+
 // -----------------------------------------------------------------------------
   void Scheduler::setRtPriority (int priority) {
+
+    setPolicy (PolicyRoundRobin, priority);
+  }
+
+// -----------------------------------------------------------------------------
+  void Scheduler::setPolicy (Policy policy, int priority) {
     struct sched_param sparam;
-    int min, max;
+    int p = policy2int.at (policy);
+
+    if (policy == PolicyDeadline) {
+
+      throw std::invalid_argument ("PolicyDeadline must be set by setDeadline()");
+    }
+
+    if (policy == PolicyOther) {
+
+      sparam.sched_priority = 0;
+    }
+    else {
+      int min = sched_get_priority_min (p);
+      int max = sched_get_priority_max (p);
+
+      if (priority < min) {
+
+        sparam.sched_priority = min;
+      }
+      else if (priority > max) {
+
+        sparam.sched_priority = max;
+      }
+      else {
+
+        sparam.sched_priority = priority;
+      }
+    }
+
+    if (sched_setscheduler (0, p, &sparam) < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void Scheduler::setDeadline (uint64_t runtime, uint64_t deadline, uint64_t period) {
+#ifdef SYS_sched_setattr
+    SchedAttr attr = {};
 
-    sched_setscheduler (0, SCHED_RR, &sparam);
-    min = sched_get_priority_min (SCHED_RR);
-    max = sched_get_priority_max (SCHED_RR);
+    attr.size = sizeof (attr);
+    attr.sched_policy = SCHED_DEADLINE;
+    attr.sched_runtime = runtime;
+    attr.sched_deadline = deadline;
+    attr.sched_period = period;
 
-    if (priority < min) {
+    if (syscall (SYS_sched_setattr, 0, &attr, 0) < 0) {
 
-      sparam.sched_priority = min;
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+#else
+    throw std::system_error (ENOTSUP, std::system_category(), __FUNCTION__);
+#endif
+  }
+
+// -----------------------------------------------------------------------------
+  Scheduler::Policy Scheduler::policy() {
+    int p = sched_getscheduler (0);
+
+    if (p < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+    for (const auto & i : policy2int) {
+
+      if (i.second == p) {
+        return i.first;
+      }
+    }
+    return PolicyOther;
+  }
+
+// -----------------------------------------------------------------------------
+  int Scheduler::priority() {
+    struct sched_param sparam;
+
+    if (sched_getparam (0, &sparam) < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
     }
-    if (priority > max) {
+    return sparam.sched_priority;
+  }
+
+// -----------------------------------------------------------------------------
+  void Scheduler::setAffinity (const std::vector<int> & cpus) {
+    cpu_set_t set;
+
+    CPU_ZERO (&set);
+    if (cpus.empty()) {
+      long n = sysconf (_SC_NPROCESSORS_CONF);
 
-      sparam.sched_priority = max;
+      for (long i = 0; i < n; i++) {
+
+        CPU_SET (i, &set);
+      }
     }
     else {
 
-      sparam.sched_priority = priority;
+      for (int cpu : cpus) {
+
+        CPU_SET (cpu, &set);
+      }
     }
 
-    if (sched_setscheduler (0, SCHED_RR, &sparam) < 0) {
+    if (sched_setaffinity (0, sizeof (set), &set) < 0) {
 
       throw std::system_error (errno, std::system_category(), __FUNCTION__);
     }
   }
+
+// -----------------------------------------------------------------------------
+  std::vector<int> Scheduler::affinity() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+
+    if (sched_getaffinity (0, sizeof (set), &set) < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+    for (int i = 0; i < CPU_SETSIZE; i++) {
+
+      if (CPU_ISSET (i, &set)) {
+
+        cpus.push_back (i);
+      }
+    }
+    return cpus;
+  }
+
+// -----------------------------------------------------------------------------
+  void Scheduler::lockMemory() {
+
+    if (mlockall (MCL_CURRENT | MCL_FUTURE) < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void Scheduler::unlockMemory() {
+
+    if (munlockall() < 0) {
+
+      throw std::system_error (errno, std::system_category(), __FUNCTION__);
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void Scheduler::prefaultStack (size_t size) {
+    volatile unsigned char * stack;
+    size_t page = sysconf (_SC_PAGESIZE);
+
+    stack = static_cast<volatile unsigned char *> (alloca (size));
+    for (size_t i = 0; i < size; i += page) {
+
+      stack[i] = 0;
+    }
+  }
+
+// -----------------------------------------------------------------------------
+  void Scheduler::setProfile (const std::string & name, const Profile & profile) {
+    std::lock_guard<std::mutex> lock (profileMutex);
+
+    profiles[name] = profile;
+  }
+
+// -----------------------------------------------------------------------------
+  void Scheduler::removeProfile (const std::string & name) {
+    std::lock_guard<std::mutex> lock (profileMutex);
+
+    profiles.erase (name);
+  }
+
+// -----------------------------------------------------------------------------
+  bool Scheduler::hasProfile (const std::string & name) {
+    std::lock_guard<std::mutex> lock (profileMutex);
+
+    return profiles.count (name) > 0;
+  }
+
+// -----------------------------------------------------------------------------
+  Scheduler::Profile Scheduler::profile (const std::string & name) {
+    std::lock_guard<std::mutex> lock (profileMutex);
+
+    return profiles.at (name);
+  }
+
+// -----------------------------------------------------------------------------
+  bool Scheduler::applyProfile (const std::string & name) {
+    Profile p;
+
+    {
+      std::lock_guard<std::mutex> lock (profileMutex);
+      auto it = profiles.find (name);
+
+      if (it == profiles.end()) {
+
+        it = profiles.find ("default");
+        if (it == profiles.end()) {
+
+          return false;
+        }
+      }
+      p = it->second;
+    }
+    apply (p);
+    return true;
+  }
+
+// -----------------------------------------------------------------------------
+  // La mémoire est verrouillée avant le préchargement de la pile pour que
+  // les pages touchées restent en RAM
+  void Scheduler::apply (const Profile & p) {
+
+    if (p.lockMemory) {
+
+      lockMemory();
+    }
+    if (p.stackPrefault) {
+
+      prefaultStack (p.stackPrefault);
+    }
+    if (!p.cpus.empty()) {
+
+      setAffinity (p.cpus);
+    }
+    if (p.policy == PolicyDeadline) {
+
+      setDeadline (p.runtime, p.deadline, p.period);
+    }
+    else {
+
+      setPolicy (p.policy, p.priority);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+iSchedulerApplyProfile (const char * name) {
+
+  try {
+
+    return Sysio::Scheduler::applyProfile (name) ? 1 : 0;
+  }
+  catch (...) {
+
+    return -1;
+  }
 }
 /* ========================================================================== */
@@ -11,8 +11,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <linux/serial.h>
 
 #include <sysio/serial.h>
@@ -24,6 +26,32 @@
 #define TIOCGRS485      0x542E
 #define TIOCSRS485      0x542F
 
+/*
+ * Vitesses quelconques : structure termios2 du noyau, que la glibc ne déclare
+ * pas (elle entre en conflit avec <asm/termbits.h>). La vitesse est donnée
+ * par c_ospeed lorsque le champ CBAUD de c_cflag vaut BOTHER.
+ */
+#ifndef BOTHER
+#define BOTHER          0010000
+#endif
+#ifndef CIBAUD
+#define CIBAUD          002003600000
+#endif
+#define KERNEL_NCCS     19
+
+struct xTermios2 {
+  tcflag_t c_iflag;
+  tcflag_t c_oflag;
+  tcflag_t c_cflag;
+  tcflag_t c_lflag;
+  cc_t c_line;
+  cc_t c_cc[KERNEL_NCCS];
+  speed_t c_ispeed;
+  speed_t c_ospeed;
+};
+#define TCGETS2_        _IOR('T', 0x2A, struct xTermios2)
+#define TCSETS2_        _IOW('T', 0x2B, struct xTermios2)
+
 //#ifdef BOARD_RASPBERRYPI
 #if 0
 // Le code ci-dessous est pour le Raspberry Pi
@@ -56,6 +84,54 @@ iCheckBaudrate (unsigned long ulBaud) {
 #define iCheckBaudrate(b) (0)
 #endif
 
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+// tcgetattr() complété par la vitesse quelconque éventuelle
+static int
+prviTcGetAttr (int fd, struct termios * ts) {
+  int iRet = tcgetattr (fd, ts);
+
+  if ( (iRet == 0) && ( (ts->c_cflag & CBAUD) == BOTHER)) {
+    struct xTermios2 t2;
+
+    if ( (iRet = ioctl (fd, TCGETS2_, &t2)) == 0) {
+
+      ts->c_ispeed = t2.c_ispeed;
+      ts->c_ospeed = t2.c_ospeed;
+    }
+  }
+  return iRet;
+}
+
+// -----------------------------------------------------------------------------
+// tcsetattr (TCSANOW), par TCSETS2 si la vitesse n'est pas une constante Bxxx
+static int
+prviTcSetAttr (int fd, const struct termios * ts) {
+  struct xTermios2 t2;
+  int iRet;
+
+  if ( (ts->c_cflag & CBAUD) != BOTHER) {
+
+    return tcsetattr (fd, TCSANOW, ts);
+  }
+
+  if ( (iRet = ioctl (fd, TCGETS2_, &t2)) == 0) {
+
+    t2.c_iflag = ts->c_iflag;
+    t2.c_oflag = ts->c_oflag;
+    // vitesse de réception identique à la vitesse d'émission
+    t2.c_cflag = ts->c_cflag & ~CIBAUD;
+    t2.c_lflag = ts->c_lflag;
+    t2.c_line = ts->c_line;
+    memcpy (t2.c_cc, ts->c_cc, KERNEL_NCCS);
+    t2.c_ispeed = ts->c_ospeed;
+    t2.c_ospeed = ts->c_ospeed;
+    iRet = ioctl (fd, TCSETS2_, &t2);
+  }
+  return iRet;
+}
+
 /* public variables ========================================================= */
 extern const char sUnknown[];
 
@@ -67,12 +143,12 @@ iSerialSetAttr (int fd, const xSerialIos * xIos) {
   struct termios ts;
   int iRet;
 
-  if ( (iRet = tcgetattr (fd, &ts) ) == 0) {
+  if ( (iRet = prviTcGetAttr (fd, &ts) ) == 0) {
 
     iRet = iSerialTermiosSetAttr (&ts, xIos);
     if (iRet == 0) {
       tcflush (fd, TCIOFLUSH);
-      iRet = tcsetattr (fd, TCSANOW, &ts);
+      iRet = prviTcSetAttr (fd, &ts);
       if (iRet == 0) {
 
         return iSerialSetFlow (fd, xIos->flow);
@@ -88,7 +164,7 @@ iSerialGetAttr (int fd, xSerialIos * xIos) {
   struct termios ts;
   int iRet;
 
-  if ( (iRet = tcgetattr (fd, &ts) ) == 0) {
+  if ( (iRet = prviTcGetAttr (fd, &ts) ) == 0) {
 
     if ( (iRet = iSerialTermiosGetAttr (&ts, xIos) ) == 0) {
 
@@ -112,7 +188,7 @@ iSerialOpen (const char *device, xSerialIos * xIos) {
   fcntl (fd, F_SETFL, O_RDWR);
 
   // Get and modify current options:
-  tcgetattr (fd, &ts);
+  prviTcGetAttr (fd, &ts);
 
   cfmakeraw (&ts);
   ts.c_cflag |= (CLOCAL | CREAD);
@@ -131,7 +207,7 @@ iSerialOpen (const char *device, xSerialIos * xIos) {
   ts.c_cc [VTIME] = 0;
 
   tcflush (fd, TCIOFLUSH);
-  tcsetattr (fd, TCSANOW, &ts);
+  prviTcSetAttr (fd, &ts);
 
   if ( (iRet = iSerialSetFlow (fd, xIos->flow) ) < 0) {
 
@@ -156,28 +232,11 @@ iSerialOpen (const char *device, xSerialIos * xIos) {
 int
 iSerialPoll (int fd, int timeout_ms) {
   int ret;
-  fd_set set;
+  struct pollfd pfd = { .fd = fd, .events = POLLIN };
 
-  /* Initialize the file descriptor set. */
-  FD_ZERO (&set);
-  FD_SET (fd, &set);
-
-
-  if (timeout_ms < 0) {
-
-    /* select returns 0 if timeout, 1 if input available, -1 if error. */
-    ret = select (FD_SETSIZE, &set, NULL, NULL, NULL);
-  }
-  else {
-    struct timeval timeout;
-    long timeout_us = timeout_ms * 1000L;
-
-    /* Initialize the timeout data structure. */
-    timeout.tv_sec  = timeout_us / 1000000L;
-    timeout.tv_usec = timeout_us % 1000000L;
-    /* select returns 0 if timeout, 1 if input available, -1 if error. */
-    ret = select (FD_SETSIZE, &set, NULL, NULL, &timeout);
-  }
+  /* poll returns 0 if timeout, 1 if input available, -1 if error.
+     Unlike select, fd is not limited to FD_SETSIZE. */
+  ret = poll (&pfd, 1, timeout_ms < 0 ? -1 : timeout_ms);
 
   if (ret == -1) {
     if (errno != EINTR) {
@@ -189,7 +248,7 @@ iSerialPoll (int fd, int timeout_ms) {
       ret = 0;
     }
   }
-  else if ( (ret > 0) && (FD_ISSET (fd, &set) ) ) {
+  else if ( (ret > 0) && (pfd.revents & POLLIN)) {
     int available_data;
 
     ret = ioctl (fd, FIONREAD, &available_data);
@@ -240,7 +299,7 @@ int
 iSerialGetBaudrate (int fd) {
   struct termios ts;
 
-  if (tcgetattr (fd, &ts) == 0) {
+  if (prviTcGetAttr (fd, &ts) == 0) {
 
     return iSerialTermiosGetBaudrate (&ts);
   }
@@ -252,7 +311,7 @@ eSerialDataBits
 eSerialGetDataBits (int fd) {
   struct termios ts;
 
-  if (tcgetattr (fd, &ts) == 0) {
+  if (prviTcGetAttr (fd, &ts) == 0) {
 
     return iSerialTermiosGetDataBits (&ts);
   }
@@ -264,7 +323,7 @@ eSerialStopBits
 eSerialGetStopBits (int fd) {
   struct termios ts;
 
-  if (tcgetattr (fd, &ts) == 0) {
+  if (prviTcGetAttr (fd, &ts) == 0) {
 
     return iSerialTermiosGetStopBits (&ts);
   }
@@ -276,7 +335,7 @@ eSerialParity
 eSerialGetParity (int fd) {
   struct termios ts;
 
-  if (tcgetattr (fd, &ts) == 0) {
+  if (prviTcGetAttr (fd, &ts) == 0) {
 
     return iSerialTermiosGetParity (&ts);
   }
@@ -289,7 +348,7 @@ eSerialFlow
 eSerialGetFlow (int fd) {
   struct termios ts;
 
-  if (tcgetattr (fd, &ts) == 0) {
+  if (prviTcGetAttr (fd, &ts) == 0) {
 
     int f = iSerialTermiosGetFlow (&ts);
     if (f == SERIAL_FLOW_NONE) {
@@ -327,12 +386,12 @@ iSerialSetBaudrate (int fd, int iBaudrate) {
   struct termios ts;
   int iRet;
 
-  if ( (iRet = tcgetattr (fd, &ts) ) == 0) {
+  if ( (iRet = prviTcGetAttr (fd, &ts) ) == 0) {
 
     iRet = iSerialTermiosSetBaudrate (&ts, iBaudrate);
     if (iRet == 0) {
       tcflush (fd, TCIOFLUSH);
-      return tcsetattr (fd, TCSANOW, &ts);
+      return prviTcSetAttr (fd, &ts);
     }
   }
   return iRet;
@@ -344,12 +403,12 @@ iSerialSetDataBits (int fd, eSerialDataBits eDataBits) {
   struct termios ts;
   int iRet;
 
-  if ( (iRet = tcgetattr (fd, &ts) ) == 0) {
+  if ( (iRet = prviTcGetAttr (fd, &ts) ) == 0) {
 
     iRet = iSerialTermiosSetDataBits (&ts, eDataBits);
     if (iRet == 0) {
       tcflush (fd, TCIOFLUSH);
-      return tcsetattr (fd, TCSANOW, &ts);
+      return prviTcSetAttr (fd, &ts);
     }
   }
   return iRet;
@@ -361,12 +420,12 @@ iSerialSetStopBits (int fd, eSerialStopBits eStopBits) {
   struct termios ts;
   int iRet;
 
-  if ( (iRet = tcgetattr (fd, &ts) ) == 0) {
+  if ( (iRet = prviTcGetAttr (fd, &ts) ) == 0) {
 
     iRet = iSerialTermiosSetStopBits (&ts, eStopBits);
     if (iRet == 0) {
       tcflush (fd, TCIOFLUSH);
-      return tcsetattr (fd, TCSANOW, &ts);
+      return prviTcSetAttr (fd, &ts);
     }
   }
   return iRet;
@@ -378,12 +437,12 @@ iSerialSetParity (int fd, eSerialParity eParity) {
   struct termios ts;
   int iRet;
 
-  if ( (iRet = tcgetattr (fd, &ts) ) == 0) {
+  if ( (iRet = prviTcGetAttr (fd, &ts) ) == 0) {
 
     iRet = iSerialTermiosSetParity (&ts, eParity);
     if (iRet == 0) {
       tcflush (fd, TCIOFLUSH);
-      return tcsetattr (fd, TCSANOW, &ts);
+      return prviTcSetAttr (fd, &ts);
     }
   }
   return iRet;
@@ -395,13 +454,13 @@ iSerialSetFlow (int fd, eSerialFlow eFlow) {
   struct termios ts;
   int iRet;
 
-  if ( (iRet = tcgetattr (fd, &ts) ) == 0) {
+  if ( (iRet = prviTcGetAttr (fd, &ts) ) == 0) {
 
     iRet = iSerialTermiosSetFlow (&ts, eFlow);
     if (iRet == 0) {
 
       tcflush (fd, TCIOFLUSH);
-      iRet = tcsetattr (fd, TCSANOW, &ts);
+      iRet = prviTcSetAttr (fd, &ts);
     }
 
     if  (iRet == 0) {
@@ -442,6 +501,26 @@ iSerialSetFlow (int fd, eSerialFlow eFlow) {
 }
 
 
+// -----------------------------------------------------------------------------
+int
+iSerialSetRs485Delays (int fd, unsigned uBeforeSendMs, unsigned uAfterSendMs) {
+  struct serial_rs485 rs485conf;
+  int iRet;
+
+  if ( (iRet = ioctl (fd, TIOCGRS485, &rs485conf)) == 0) {
+
+    if (! (rs485conf.flags & SER_RS485_ENABLED)) {
+
+      errno = EINVAL;
+      return -1;
+    }
+    rs485conf.delay_rts_before_send = uBeforeSendMs;
+    rs485conf.delay_rts_after_send = uAfterSendMs;
+    iRet = ioctl (fd, TIOCSRS485, &rs485conf);
+  }
+  return iRet;
+}
+
 // -----------------------------------------------------------------------------
 const char *
 sSerialGetFlowStr (int fd) {
@@ -466,13 +545,115 @@ double
 dSerialFrameDuration (int fd, size_t ulSize) {
   struct termios ts;
 
-  if (tcgetattr (fd, &ts) == 0) {
+  if (prviTcGetAttr (fd, &ts) == 0) {
 
     return dSerialTermiosFrameDuration (&ts, ulSize);
   }
   return -1;
 }
 
+// -----------------------------------------------------------------------------
+int
+iSerialSetLowLatency (int fd, bool bEnable, size_t ulPacketSize) {
+  struct serial_struct ss;
+  struct termios ts;
+  int iRet;
+
+  if ( (iRet = prviTcGetAttr (fd, &ts)) != 0) {
+
+    return iRet;
+  }
+
+  if ( (iRet = ioctl (fd, TIOCGSERIAL, &ss)) == 0) {
+
+    if (bEnable) {
+
+      ss.flags |= ASYNC_LOW_LATENCY;
+    }
+    else {
+
+      ss.flags &= ~ASYNC_LOW_LATENCY;
+    }
+    iRet = ioctl (fd, TIOCSSERIAL, &ss);
+  }
+  if (iRet != 0) {
+
+    PERROR ("low latency: %s", strerror (errno));
+    return iRet;
+  }
+
+  if (bEnable && (ulPacketSize > 0)) {
+
+    // read() rend la main dès qu'un paquet est reçu ou après un silence de
+    // 0,1 s suivant le dernier octet reçu
+    ts.c_cc [VMIN]  = (ulPacketSize > 255) ? 255 : ulPacketSize;
+    ts.c_cc [VTIME] = 1;
+  }
+  else {
+
+    ts.c_cc [VMIN]  = 0;
+    ts.c_cc [VTIME] = 0;
+  }
+  return prviTcSetAttr (fd, &ts);
+}
+
+// -----------------------------------------------------------------------------
+bool
+bSerialIsLowLatency (int fd) {
+  struct serial_struct ss;
+
+  if (ioctl (fd, TIOCGSERIAL, &ss) == 0) {
+
+    return (ss.flags & ASYNC_LOW_LATENCY) != 0;
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+double
+dSerialMeasureFrameDuration (int fd, const void * buf, size_t ulSize,
+                             double * dRatio) {
+  struct timespec t0, t1;
+  const uint8_t * p = buf;
+  size_t ulLeft = ulSize;
+  double dDuration;
+
+  // tampon d'émission vide avant la mesure
+  if (tcdrain (fd) != 0) {
+
+    return -1;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &t0);
+  while (ulLeft) {
+    ssize_t n = write (fd, p, ulLeft);
+
+    if (n < 0) {
+
+      if ( (errno == EINTR) || (errno == EAGAIN)) {
+
+        continue;
+      }
+      return -1;
+    }
+    p += n;
+    ulLeft -= n;
+  }
+  if (tcdrain (fd) != 0) {
+
+    return -1;
+  }
+  clock_gettime (CLOCK_MONOTONIC, &t1);
+
+  dDuration = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+  if (dRatio) {
+    double dTheoretical = dSerialFrameDuration (fd, ulSize);
+
+    *dRatio = (dTheoretical > 0) ? dDuration / dTheoretical : -1;
+  }
+  return dDuration;
+}
+
 // -----------------------------------------------------------------------------
 //                                TermIos                                     //
 // -----------------------------------------------------------------------------
@@ -544,6 +725,15 @@ iSerialTermiosSetBaudrate (struct termios * ts, int iBaudrate) {
       cfsetospeed (ts, s);
       return 0;
     }
+    if (iBaudrate > 0) {
+
+      // vitesse quelconque, appliquée par TCSETS2
+      ts->c_cflag &= ~ (CBAUD | CIBAUD);
+      ts->c_cflag |= BOTHER;
+      ts->c_ispeed = iBaudrate;
+      ts->c_ospeed = iBaudrate;
+      return 0;
+    }
   }
   return EBADBAUD;
 }
@@ -673,6 +863,10 @@ iSerialTermiosGetBaudrate (const struct termios * ts) {
   if (ts) {
     speed_t baud = cfgetospeed (ts);
 
+    if (baud == BOTHER) {
+
+      return ts->c_ospeed;
+    }
     return iSerialSpeedToInt (baud);
   }
   return EBADBAUD;
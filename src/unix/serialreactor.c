@@ -0,0 +1,445 @@
+/**
+ * @file
+ * @brief Réacteur multi-ports série (Implémentation)
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <sysio/serial.h>
+#include <sysio/log.h>
+
+/* constants ================================================================ */
+#define REACTOR_DEFAULT_BUFSIZE 256
+#define REACTOR_MAX_EVENTS      16
+
+/* structures =============================================================== */
+typedef struct xSerialPort {
+  int fd;
+  int flags;        /*< attributs d'origine du descripteur, -1 si rétablis */
+  uint8_t * buf;
+  size_t size;
+  iSerialReactorCb cb;
+  void * udata;
+} xSerialPort;
+
+struct xSerialReactor {
+  int epfd;
+  int wakefd;       /*< eventfd de réveil de epoll_wait() */
+  xSerialPort ** port;
+  int size;
+  int capacity;
+  xSerialPort * current; /*< port dont la fonction de réception s'exécute */
+  bool removed;     /*< current a été retiré par sa fonction de réception */
+  xSerialRecorder * rec; /*< enregistreur des blocs reçus, NULL si aucun */
+  pthread_mutex_t mutex; /*< récursif, les fonctions de réception peuvent ajouter ou retirer des ports */
+};
+
+/* private functions ======================================================== */
+// -----------------------------------------------------------------------------
+static int
+prviFind (const xSerialReactor * r, int fd) {
+
+  for (int i = 0; i < r->size; i++) {
+
+    if (r->port[i]->fd == fd) {
+
+      return i;
+    }
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+// Rétablit les attributs du descripteur modifiés par iSerialReactorAdd()
+static void
+prvvRestore (xSerialPort * p) {
+
+  if (p->flags >= 0) {
+
+    (void) fcntl (p->fd, F_SETFL, p->flags);
+    p->flags = -1;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvFreePort (xSerialPort * p) {
+
+  free (p->buf);
+  free (p);
+}
+
+// -----------------------------------------------------------------------------
+// Retrait de l'indice i, mutex verrouillé
+static void
+prvvRemove (xSerialReactor * r, int i) {
+  xSerialPort * p = r->port[i];
+
+  epoll_ctl (r->epfd, EPOLL_CTL_DEL, p->fd, NULL);
+  prvvRestore (p);
+  r->port[i] = r->port[--r->size];
+
+  if (p == r->current) {
+
+    // libéré par prviService() au retour de la fonction de réception
+    r->removed = true;
+  }
+  else {
+
+    prvvFreePort (p);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Appel de la fonction de réception, false si le port a été retiré
+static bool
+prvbCall (xSerialReactor * r, xSerialPort * p, const uint8_t * buf, size_t len) {
+  int ret;
+
+  if (buf && r->rec) {
+
+    (void) iSerialRecorderWrite (r->rec, p->fd, SERIAL_REC_RX, buf, len);
+  }
+  if (!buf) {
+
+    // le port va être retiré, la fonction de réception peut fermer fd
+    prvvRestore (p);
+  }
+  r->current = p;
+  r->removed = false;
+  ret = p->cb (p->fd, buf, len, p->udata);
+  r->current = NULL;
+
+  if (r->removed) {
+
+    prvvFreePort (p);
+    return false;
+  }
+  if ( (ret < 0) || (buf == NULL)) {
+
+    prvvRemove (r, prviFind (r, p->fd));
+    return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Lecture des octets reçus par un port, mutex verrouillé
+static void
+prvvService (xSerialReactor * r, xSerialPort * p, uint32_t events) {
+
+  if (events & EPOLLIN) {
+
+    for (;;) {
+      ssize_t len = read (p->fd, p->buf, p->size);
+
+      if (len > 0) {
+
+        if (!prvbCall (r, p, p->buf, len)) {
+
+          return;
+        }
+        if ( (size_t) len < p->size) {
+          // tampon du pilote vidé, un nouvel octet déclenchera un nouveau front
+          break;
+        }
+      }
+      else if ( (len < 0) && (errno == EINTR)) {
+
+        continue;
+      }
+      else {
+
+        // 0 : plus d'octets (VMIN = 0) ou fin de fichier, EAGAIN : plus
+        // d'octets, les autres erreurs sont signalées par EPOLLERR
+        if ( (len < 0) && (errno != EAGAIN)) {
+
+          events |= EPOLLERR;
+        }
+        break;
+      }
+    }
+  }
+
+  if (events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) {
+
+    (void) prvbCall (r, p, NULL, 0);
+  }
+}
+
+/* internal public functions ================================================ */
+// -----------------------------------------------------------------------------
+xSerialReactor *
+xSerialReactorNew (void) {
+  xSerialReactor * r = calloc (1, sizeof (xSerialReactor));
+  pthread_mutexattr_t attr;
+  struct epoll_event ev;
+
+  if (!r) {
+
+    return NULL;
+  }
+
+  r->epfd = epoll_create1 (EPOLL_CLOEXEC);
+  if (r->epfd < 0) {
+
+    PERROR ("epoll_create1: %s", strerror (errno));
+    free (r);
+    return NULL;
+  }
+
+  r->wakefd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (r->wakefd < 0) {
+
+    PERROR ("eventfd: %s", strerror (errno));
+    close (r->epfd);
+    free (r);
+    return NULL;
+  }
+
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = r->wakefd;
+  (void) epoll_ctl (r->epfd, EPOLL_CTL_ADD, r->wakefd, &ev);
+
+  pthread_mutexattr_init (&attr);
+  pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init (&r->mutex, &attr);
+  pthread_mutexattr_destroy (&attr);
+  return r;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialReactorDelete (xSerialReactor * r) {
+  int ret = 0;
+
+  if (!r) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  for (int i = 0; i < r->size; i++) {
+
+    prvvRestore (r->port[i]);
+    prvvFreePort (r->port[i]);
+  }
+  free (r->port);
+  if (close (r->wakefd) != 0) {
+
+    ret = -1;
+  }
+  if (close (r->epfd) != 0) {
+
+    ret = -1;
+  }
+  pthread_mutex_destroy (&r->mutex);
+  free (r);
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialReactorAdd (xSerialReactor * r, int fd, size_t bufsize,
+                   iSerialReactorCb cb, void * udata) {
+  struct epoll_event ev;
+  xSerialPort * p;
+  int flags;
+
+  if (!r || !cb || (fd < 0)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  flags = fcntl (fd, F_GETFL);
+  if (flags < 0) {
+
+    return -1;
+  }
+
+  if (bufsize == 0) {
+
+    bufsize = REACTOR_DEFAULT_BUFSIZE;
+  }
+  p = calloc (1, sizeof (xSerialPort));
+  if (!p || ! (p->buf = malloc (bufsize))) {
+
+    free (p);
+    errno = ENOMEM;
+    return -1;
+  }
+  p->fd = fd;
+  p->flags = -1;
+  p->size = bufsize;
+  p->cb = cb;
+  p->udata = udata;
+
+  pthread_mutex_lock (&r->mutex);
+  if (prviFind (r, fd) >= 0) {
+
+    pthread_mutex_unlock (&r->mutex);
+    prvvFreePort (p);
+    errno = EEXIST;
+    return -1;
+  }
+
+  if (r->size == r->capacity) {
+    int capacity = r->capacity ? r->capacity * 2 : 8;
+    xSerialPort ** v = realloc (r->port, capacity * sizeof (xSerialPort *));
+
+    if (!v) {
+
+      pthread_mutex_unlock (&r->mutex);
+      prvvFreePort (p);
+      errno = ENOMEM;
+      return -1;
+    }
+    r->port = v;
+    r->capacity = capacity;
+  }
+
+  // O_NONBLOCK s'applique à la description de fichier ouvert, partagée
+  // avec les autres descripteurs du port (dup(), fork())
+  if (fcntl (fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+    int err = errno;
+
+    pthread_mutex_unlock (&r->mutex);
+    prvvFreePort (p);
+    errno = err;
+    return -1;
+  }
+  p->flags = flags;
+
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+  ev.data.fd = fd;
+  if (epoll_ctl (r->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    int err = errno;
+
+    pthread_mutex_unlock (&r->mutex);
+    prvvRestore (p);
+    prvvFreePort (p);
+    errno = err;
+    return -1;
+  }
+  r->port[r->size++] = p;
+  pthread_mutex_unlock (&r->mutex);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialReactorRemove (xSerialReactor * r, int fd) {
+  int i;
+
+  if (!r) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock (&r->mutex);
+  i = prviFind (r, fd);
+  if (i >= 0) {
+
+    prvvRemove (r, i);
+  }
+  pthread_mutex_unlock (&r->mutex);
+
+  if (i < 0) {
+
+    errno = ENOENT;
+    return -1;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialReactorSize (const xSerialReactor * r) {
+
+  return r ? r->size : -1;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialReactorRun (xSerialReactor * r, int timeout_ms) {
+  struct epoll_event ev[REACTOR_MAX_EVENTS];
+  int n, count = 0;
+
+  if (!r) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  n = epoll_wait (r->epfd, ev, REACTOR_MAX_EVENTS, timeout_ms);
+  if (n < 0) {
+
+    if (errno == EINTR) {
+
+      return 0;
+    }
+    PERROR ("epoll_wait: %s", strerror (errno));
+    return -1;
+  }
+
+  pthread_mutex_lock (&r->mutex);
+  for (int i = 0; i < n; i++) {
+    int fd = ev[i].data.fd;
+    int j;
+
+    if (fd == r->wakefd) {
+      uint64_t v;
+
+      (void) read (r->wakefd, &v, sizeof (v));
+      continue;
+    }
+
+    // le port a pu être retiré par une fonction de réception précédente
+    j = prviFind (r, fd);
+    if (j >= 0) {
+
+      prvvService (r, r->port[j], ev[i].events);
+      count++;
+    }
+  }
+  pthread_mutex_unlock (&r->mutex);
+  return count;
+}
+
+// -----------------------------------------------------------------------------
+void
+vSerialReactorWakeup (xSerialReactor * r) {
+  uint64_t v = 1;
+
+  if (r) {
+
+    (void) write (r->wakefd, &v, sizeof (v));
+  }
+}
+
+// -----------------------------------------------------------------------------
+void
+vSerialReactorSetRecorder (xSerialReactor * r, xSerialRecorder * rec) {
+
+  if (r) {
+
+    pthread_mutex_lock (&r->mutex);
+    r->rec = rec;
+    pthread_mutex_unlock (&r->mutex);
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,405 @@
+/**
+ * @file
+ * @brief Enregistreur et relecteur de trafic série (Implémentation)
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* ptsname_r */
+#endif
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <termios.h>
+#include <sys/stat.h>
+
+#include <sysio/serial.h>
+#include <sysio/log.h>
+
+/* constants ================================================================ */
+#define REC_MAGIC       "SYSIOREC"
+#define REC_MAGIC_SIZE  8
+#define REC_BUFSIZE     65536
+#define REC_MAX_LEN     (16UL * 1024 * 1024) /*< taille maximale d'un bloc relu */
+
+/* structures =============================================================== */
+struct xSerialRecorder {
+  FILE * file;
+  uint64_t last;    /*< instant du bloc précédent en ns (CLOCK_MONOTONIC) */
+  pthread_mutex_t mutex;
+};
+
+/* private functions ======================================================== */
+// -----------------------------------------------------------------------------
+static uint64_t
+prvullNow (clockid_t clk) {
+  struct timespec ts;
+
+  clock_gettime (clk, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+// Codage LEB128 de v dans buf, retourne le nombre d'octets
+static int
+prviPutVarint (uint8_t * buf, uint64_t v) {
+  int i = 0;
+
+  do {
+    uint8_t b = v & 0x7F;
+
+    v >>= 7;
+    buf[i++] = v ? (b | 0x80) : b;
+  }
+  while (v);
+  return i;
+}
+
+// -----------------------------------------------------------------------------
+// Lecture d'un entier LEB128, -1 en fin de fichier ou si l'entier est tronqué
+static int
+prviGetVarint (FILE * f, uint64_t * v) {
+  int shift = 0;
+  int c;
+
+  *v = 0;
+  do {
+    if ( (c = getc (f)) == EOF || (shift > 63)) {
+
+      return -1;
+    }
+    *v |= (uint64_t) (c & 0x7F) << shift;
+    shift += 7;
+  }
+  while (c & 0x80);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvSleepUntil (uint64_t t_ns) {
+  struct timespec ts = { .tv_sec = t_ns / 1000000000ULL,
+           .tv_nsec = t_ns % 1000000000ULL
+  };
+
+  while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    ;
+}
+
+// -----------------------------------------------------------------------------
+typedef struct xReplayFd {
+  int port;
+  int fd;
+} xReplayFd;
+
+static int
+prviReplayToFdCb (unsigned port, eSerialRecDir dir,
+                  const uint8_t * buf, size_t len, void * udata) {
+  xReplayFd * r = (xReplayFd *) udata;
+
+  if ( (dir != SERIAL_REC_RX) || ( (r->port >= 0) && (port != (unsigned) r->port))) {
+
+    return 0;
+  }
+
+  while (len) {
+    ssize_t n = write (r->fd, buf, len);
+
+    if (n < 0) {
+
+      if (errno == EINTR) {
+
+        continue;
+      }
+      return -1;
+    }
+    buf += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/* internal public functions ================================================ */
+// -----------------------------------------------------------------------------
+xSerialRecorder *
+xSerialRecorderNew (const char * path) {
+  xSerialRecorder * rec;
+  uint8_t hdr[REC_MAGIC_SIZE + 8];
+  uint64_t t = prvullNow (CLOCK_REALTIME);
+
+  rec = calloc (1, sizeof (xSerialRecorder));
+  if (!rec) {
+
+    return NULL;
+  }
+
+  rec->file = fopen (path, "wb");
+  if (!rec->file) {
+
+    PERROR ("%s: %s", path, strerror (errno));
+    free (rec);
+    return NULL;
+  }
+  setvbuf (rec->file, NULL, _IOFBF, REC_BUFSIZE);
+
+  memcpy (hdr, REC_MAGIC, REC_MAGIC_SIZE);
+  for (int i = 0; i < 8; i++) {
+
+    hdr[REC_MAGIC_SIZE + i] = t >> (i * 8);
+  }
+  if (fwrite (hdr, sizeof (hdr), 1, rec->file) != 1) {
+
+    fclose (rec->file);
+    free (rec);
+    return NULL;
+  }
+
+  rec->last = prvullNow (CLOCK_MONOTONIC);
+  pthread_mutex_init (&rec->mutex, NULL);
+  return rec;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialRecorderDelete (xSerialRecorder * rec) {
+  int ret;
+
+  if (!rec) {
+
+    errno = EINVAL;
+    return -1;
+  }
+  ret = (fclose (rec->file) == 0) ? 0 : -1;
+  pthread_mutex_destroy (&rec->mutex);
+  free (rec);
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialRecorderWrite (xSerialRecorder * rec, unsigned port,
+                      eSerialRecDir dir, const void * buf, size_t len) {
+  uint8_t hdr[30];
+  uint64_t t;
+  int n, ret = 0;
+
+  if (!rec || (!buf && len)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock (&rec->mutex);
+  t = prvullNow (CLOCK_MONOTONIC);
+  n = prviPutVarint (hdr, t - rec->last);
+  n += prviPutVarint (&hdr[n], ( (uint64_t) port << 1) | (dir & 1));
+  n += prviPutVarint (&hdr[n], len);
+  rec->last = t;
+
+  if ( (fwrite (hdr, n, 1, rec->file) != 1) ||
+       (len && (fwrite (buf, len, 1, rec->file) != 1))) {
+
+    ret = -1;
+  }
+  pthread_mutex_unlock (&rec->mutex);
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialRecorderFlush (xSerialRecorder * rec) {
+  int ret;
+
+  if (!rec) {
+
+    errno = EINVAL;
+    return -1;
+  }
+  pthread_mutex_lock (&rec->mutex);
+  ret = (fflush (rec->file) == 0) ? 0 : -1;
+  pthread_mutex_unlock (&rec->mutex);
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+ssize_t
+iSerialRecordedWrite (xSerialRecorder * rec, int fd, const void * buf, size_t len) {
+  ssize_t n = write (fd, buf, len);
+
+  if ( (n > 0) && rec) {
+
+    (void) iSerialRecorderWrite (rec, fd, SERIAL_REC_TX, buf, n);
+  }
+  return n;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialReplay (const char * path, double dSpeed,
+               iSerialReplayCb cb, void * udata) {
+  uint8_t hdr[REC_MAGIC_SIZE + 8];
+  uint8_t * buf = NULL;
+  size_t size = 0;
+  uint64_t elapsed = 0; // durée enregistrée depuis le premier bloc
+  uint64_t start = 0;
+  int count = 0;
+  struct stat st;
+  FILE * f;
+
+  if (!path || !cb || (dSpeed < 0)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  f = fopen (path, "rb");
+  if (!f) {
+
+    return -1;
+  }
+  setvbuf (f, NULL, _IOFBF, REC_BUFSIZE);
+
+  if (fstat (fileno (f), &st) < 0) {
+    int err = errno;
+
+    fclose (f);
+    errno = err;
+    return -1;
+  }
+
+  if ( (fread (hdr, sizeof (hdr), 1, f) != 1) ||
+       (memcmp (hdr, REC_MAGIC, REC_MAGIC_SIZE) != 0)) {
+
+    fclose (f);
+    errno = EILSEQ;
+    return -1;
+  }
+
+  for (;;) {
+    uint64_t dt, id, len;
+    long pos;
+
+    if ( (prviGetVarint (f, &dt) < 0) || (prviGetVarint (f, &id) < 0) ||
+         (prviGetVarint (f, &len) < 0)) {
+
+      break;
+    }
+
+    // une taille invalide ne doit pas provoquer une allocation démesurée
+    if (len > REC_MAX_LEN) {
+
+      count = -1;
+      errno = EILSEQ;
+      break;
+    }
+    pos = ftell (f);
+    if ( (pos < 0) || (len > (uint64_t) (st.st_size - pos))) {
+
+      // dernier bloc tronqué
+      break;
+    }
+
+    if (len > size) {
+      uint8_t * p = realloc (buf, len);
+
+      if (!p) {
+
+        count = -1;
+        errno = ENOMEM;
+        break;
+      }
+      buf = p;
+      size = len;
+    }
+    if (len && (fread (buf, len, 1, f) != 1)) {
+
+      break;
+    }
+
+    if (dSpeed > 0) {
+
+      // le silence précédant le premier bloc n'est pas reproduit
+      if (count == 0) {
+
+        start = prvullNow (CLOCK_MONOTONIC);
+      }
+      else {
+
+        elapsed += dt;
+        prvvSleepUntil (start + (uint64_t) (elapsed / dSpeed));
+      }
+    }
+
+    count++;
+    if (cb (id >> 1, id & 1, buf, len, udata) < 0) {
+
+      // errno est fixé par cb
+      count = -1;
+      break;
+    }
+  }
+
+  {
+    int err = errno;
+
+    free (buf);
+    fclose (f);
+    errno = err;
+  }
+  return count;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialReplayToFd (const char * path, int iPort, double dSpeed, int fd) {
+  xReplayFd r = { .port = iPort, .fd = fd };
+
+  return iSerialReplay (path, dSpeed, prviReplayToFdCb, &r);
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialOpenPty (char * name, size_t size) {
+  struct termios ts;
+  int fd = posix_openpt (O_RDWR | O_NOCTTY | O_CLOEXEC);
+
+  if (fd < 0) {
+
+    return -1;
+  }
+  if ( (grantpt (fd) < 0) || (unlockpt (fd) < 0) ||
+       (name && (ptsname_r (fd, name, size) != 0))) {
+
+    goto iSerialOpenPtyError;
+  }
+
+  // mode brut : les octets relus ne doivent pas être traduits (CR/LF) ni
+  // interprétés (caractères de contrôle, écho) par la discipline de ligne
+  if (tcgetattr (fd, &ts) < 0) {
+
+    goto iSerialOpenPtyError;
+  }
+  cfmakeraw (&ts);
+  if (tcsetattr (fd, TCSANOW, &ts) < 0) {
+
+    goto iSerialOpenPtyError;
+  }
+  return fd;
+
+iSerialOpenPtyError:
+  {
+    int err = errno;
+
+    close (fd);
+    errno = err;
+  }
+  return -1;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,329 @@
+/**
+ * @file
+ * @brief Bus RS485 half-duplex (Implémentation)
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* ppoll */
+#endif
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/ioctl.h>
+
+#include <sysio/serial.h>
+#include <sysio/log.h>
+
+/* constants ================================================================ */
+#define RS485_MIN_CHAR_TIMEOUT_US 1000
+
+/* structures =============================================================== */
+struct xSerialRs485 {
+  int fd;
+  bool kernel;      /*< RTS commandé par le pilote */
+  int txlevel;      /*< niveau de RTS pendant l'émission (commande logicielle) */
+  unsigned before;  /*< délai avant émission en ms (commande logicielle) */
+  unsigned after;   /*< délai après émission en ms (commande logicielle) */
+};
+
+/* private functions ======================================================== */
+// -----------------------------------------------------------------------------
+static void
+prvvNow (struct timespec * t) {
+
+  clock_gettime (CLOCK_MONOTONIC, t);
+}
+
+// -----------------------------------------------------------------------------
+static double
+prvdElapsed (const struct timespec * t0, const struct timespec * t1) {
+
+  return (t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+// -----------------------------------------------------------------------------
+// les durées sont en int64_t, un long sur 32 bits déborde au delà de 2,1 s
+static void
+prvvAdd (struct timespec * t, int64_t ns) {
+
+  t->tv_sec += ns / 1000000000LL;
+  t->tv_nsec += ns % 1000000000LL;
+  if (t->tv_nsec >= 1000000000L) {
+
+    t->tv_sec++;
+    t->tv_nsec -= 1000000000L;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvSleepUntil (const struct timespec * t) {
+
+  while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, t, NULL) == EINTR)
+    ;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviSetRts (int fd, int level) {
+  int bit = TIOCM_RTS;
+
+  return ioctl (fd, level ? TIOCMBIS : TIOCMBIC, &bit);
+}
+
+// -----------------------------------------------------------------------------
+// Attente d'octets pendant au plus timeout_ns (infinie si négatif), 0 si le
+// délai est écoulé
+static int
+prviWait (int fd, int64_t timeout_ns) {
+  struct pollfd pfd = { .fd = fd, .events = POLLIN };
+  struct timespec ts = { .tv_sec = timeout_ns / 1000000000LL,
+           .tv_nsec = timeout_ns % 1000000000LL
+  };
+  int ret;
+
+  do {
+    ret = ppoll (&pfd, 1, (timeout_ns < 0) ? NULL : &ts, NULL);
+  }
+  while ( (ret < 0) && (errno == EINTR));
+
+  if ( (ret > 0) && ! (pfd.revents & POLLIN)) {
+
+    errno = EIO;
+    return -1;
+  }
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviWriteAll (int fd, const uint8_t * p, size_t len) {
+
+  while (len) {
+    ssize_t n = write (fd, p, len);
+
+    if (n < 0) {
+
+      if (errno == EINTR) {
+
+        continue;
+      }
+      if (errno == EAGAIN) {
+        struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+
+        (void) poll (&pfd, 1, -1);
+        continue;
+      }
+      return -1;
+    }
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/* internal public functions ================================================ */
+// -----------------------------------------------------------------------------
+xSerialRs485 *
+xSerialRs485New (int fd, eSerialFlow eFlow,
+                 unsigned uBeforeSendMs, unsigned uAfterSendMs) {
+  xSerialRs485 * bus;
+
+  if ( (fd < 0) || ( (eFlow != SERIAL_FLOW_RS485_RTS_ON_SEND) &&
+                     (eFlow != SERIAL_FLOW_RS485_RTS_AFTER_SEND))) {
+
+    errno = EINVAL;
+    return NULL;
+  }
+
+  bus = calloc (1, sizeof (xSerialRs485));
+  if (!bus) {
+
+    return NULL;
+  }
+  bus->fd = fd;
+
+  if (iSerialSetFlow (fd, eFlow) == 0) {
+
+    if (iSerialSetRs485Delays (fd, uBeforeSendMs, uAfterSendMs) == 0) {
+
+      bus->kernel = true;
+      return bus;
+    }
+    // délais refusés par le pilote : le mode RS485 du noyau est désactivé
+    // pour que RTS ne soit pas commandé à la fois par le pilote et par
+    // le logiciel
+    (void) iSerialSetFlow (fd, SERIAL_FLOW_NONE);
+  }
+
+  // le pilote ne gère pas le RS485, iSerialSetFlow() a désactivé le contrôle
+  // de flux termios, RTS est placé au niveau de réception
+  bus->txlevel = (eFlow == SERIAL_FLOW_RS485_RTS_ON_SEND);
+  bus->before = uBeforeSendMs;
+  bus->after = uAfterSendMs;
+  if (prviSetRts (fd, !bus->txlevel) < 0) {
+
+    PERROR ("RTS: %s", strerror (errno));
+    free (bus);
+    return NULL;
+  }
+  vLog (LOG_DEBUG, "RS485 not supported by the driver, RTS driven by software");
+  return bus;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialRs485Delete (xSerialRs485 * bus) {
+
+  if (!bus) {
+
+    errno = EINVAL;
+    return -1;
+  }
+  free (bus);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+bool
+bSerialRs485IsKernel (const xSerialRs485 * bus) {
+
+  return bus ? bus->kernel : false;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSerialRs485Transaction (xSerialRs485 * bus,
+                         const void * tx, size_t txlen,
+                         void * rx, size_t rxsize,
+                         int iTimeoutMs, long lCharTimeoutUs,
+                         xSerialRs485Stats * stats) {
+  struct timespec t0, tSwitch, tFirst, tLast, t;
+  uint8_t * p = rx;
+  size_t len = 0;
+  int64_t charTimeoutNs;
+  int ret;
+
+  if (!bus || (!tx && txlen) || (!rx && rxsize)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (lCharTimeoutUs <= 0) {
+    double d = dSerialFrameDuration (bus->fd, 1) * 3.5e6;
+
+    lCharTimeoutUs = (d > RS485_MIN_CHAR_TIMEOUT_US) ? (long) d : RS485_MIN_CHAR_TIMEOUT_US;
+  }
+  charTimeoutNs = (int64_t) lCharTimeoutUs * 1000;
+
+  // une réponse tardive à la transaction précédente ne doit pas être prise
+  // pour la réponse à celle-ci
+  tcflush (bus->fd, TCIFLUSH);
+
+  // Émission
+  prvvNow (&t0);
+  if (!bus->kernel) {
+
+    if (prviSetRts (bus->fd, bus->txlevel) < 0) {
+
+      return -1;
+    }
+    if (bus->before) {
+
+      t = t0;
+      prvvAdd (&t, (int64_t) bus->before * 1000000);
+      prvvSleepUntil (&t);
+    }
+  }
+
+  if ( (prviWriteAll (bus->fd, tx, txlen) < 0) || (tcdrain (bus->fd) < 0)) {
+
+    if (!bus->kernel) {
+
+      (void) prviSetRts (bus->fd, !bus->txlevel);
+    }
+    return -1;
+  }
+
+  if (!bus->kernel) {
+    // fin théorique du dernier bit de stop, si tcdrain() a rendu la main
+    // plus tôt
+    double dFrame = dSerialFrameDuration (bus->fd, txlen);
+
+    prvvNow (&tSwitch);
+    t = t0;
+    prvvAdd (&t, (int64_t) bus->before * 1000000 + (int64_t) (dFrame * 1e9));
+    if (prvdElapsed (&tSwitch, &t) < 0) {
+
+      t = tSwitch;
+    }
+    prvvAdd (&t, (int64_t) bus->after * 1000000);
+    prvvSleepUntil (&t);
+    if (prviSetRts (bus->fd, !bus->txlevel) < 0) {
+
+      return -1;
+    }
+  }
+  prvvNow (&tSwitch);
+
+  // Réception
+  if (rxsize) {
+
+    ret = prviWait (bus->fd, (iTimeoutMs < 0) ? -1 : (int64_t) iTimeoutMs * 1000000);
+    while (ret > 0) {
+      ssize_t n = read (bus->fd, p + len, rxsize - len);
+
+      if (n < 0) {
+
+        if ( (errno != EINTR) && (errno != EAGAIN)) {
+
+          return -1;
+        }
+      }
+      else if (n > 0) {
+
+        prvvNow (&tLast);
+        if (len == 0) {
+
+          tFirst = tLast;
+        }
+        len += n;
+        if (len == rxsize) {
+
+          break;
+        }
+      }
+      ret = prviWait (bus->fd, charTimeoutNs);
+    }
+    if (ret < 0) {
+
+      return -1;
+    }
+  }
+
+  if (stats) {
+
+    stats->dTx = prvdElapsed (&t0, &tSwitch);
+    stats->ulRxLen = len;
+    if (len) {
+
+      stats->dTurnaround = prvdElapsed (&tSwitch, &tFirst);
+      stats->dRx = prvdElapsed (&tFirst, &tLast);
+    }
+    else {
+
+      stats->dTurnaround = -1;
+      stats->dRx = 0;
+    }
+  }
+  return len;
+}
+
+/* ========================================================================== */
@@ -13,6 +13,7 @@
 #include <pthread.h>
 #include <sysio/timer.h>
 #include <sysio/dlist.h>
+#include <sysio/scheduler.h>
 
 /* constants ================================================================ */
 #define MAX_EVENTS 20
@@ -51,6 +52,7 @@ pvThread (void * unused) {
   struct epoll_event ev[MAX_EVENTS];
   xTimer * tm;
 
+  iSchedulerApplyProfile ("timer");
   while (ctx.run) {
 
     ret = epoll_wait (ctx.epfd, ev, MAX_EVENTS, -1);
@@ -7,6 +7,7 @@
  * This software is governed by the CeCILL license <http://www.cecill.info>
  */
 #include <string.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <sysio/log.h>
@@ -1169,6 +1170,7 @@ vXBeeFreePkt (xXBee * xbee, xXBeePkt * pkt) {
 
 /* platform specific functions ============================================== */
 #include <unistd.h>
+#include <poll.h>
 
 /* -----------------------------------------------------------------------------
  */
@@ -1214,16 +1216,33 @@ iXBeeClose (xXBee *xbee) {
  */
 int
 iXBeeOut (xXBee *xbee, xXBeePkt *pkt, uint8_t len) {
-  int iDataWrite = 0;
+  const uint8_t * p = (const uint8_t *) pkt;
 
-  while (len) {
+  if (xbee->rec) {
+
+    (void) iSerialRecorderWrite (xbee->rec, xbee->fd, SERIAL_REC_TX, pkt, len);
+  }
 
-    iDataWrite = write (xbee->fd, &pkt[iDataWrite], len);
+  while (len) {
+    int iDataWrite = write (xbee->fd, p, len);
 
     if (iDataWrite < 0) {
 
+      if (errno == EINTR) {
+
+        continue;
+      }
+      if (errno == EAGAIN) {
+        // port en mode non bloquant (réacteur), attente de place dans le
+        // tampon d'émission
+        struct pollfd pfd = { .fd = xbee->fd, .events = POLLOUT };
+
+        (void) poll (&pfd, 1, -1);
+        continue;
+      }
       return -1;
     }
+    p += iDataWrite;
     len -= iDataWrite;
   }
   vXBeeFreePkt (xbee, pkt);
@@ -1261,6 +1280,71 @@ iXBeePoll (xXBee * xbee, int timeout_ms) {
   return iDataAvailable;
 }
 
+/* -----------------------------------------------------------------------------
+ * Fonction de réception du réacteur
+ */
+static int
+prviXBeeReactorCb (int fd, const uint8_t * buf, size_t len, void * udata) {
+
+  (void) fd;
+  if (buf) {
+
+    vXBeeIn ( (xXBee *) udata, buf, len);
+  }
+  return 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Confie la réception à un réacteur
+ */
+int
+iXBeeAttachReactor (xXBee * xbee, xSerialReactor * r) {
+
+  return iSerialReactorAdd (r, xbee->fd, XBEE_MAX_RF_PAYLOAD, prviXBeeReactorCb, xbee);
+}
+
+/* -----------------------------------------------------------------------------
+ * Retire le module du réacteur
+ */
+int
+iXBeeDetachReactor (xXBee * xbee, xSerialReactor * r) {
+
+  return iSerialReactorRemove (r, xbee->fd);
+}
+
+/* -----------------------------------------------------------------------------
+ * Décodage d'octets déjà lus
+ */
+int
+iXBeeFeed (xXBee * xbee, const void * buf, size_t len) {
+  const uint8_t * p = buf;
+
+  if (!xbee || (!buf && len)) {
+
+    errno = EINVAL;
+    return -1;
+  }
+
+  // vXBeeIn() traite au plus 255 octets
+  while (len) {
+    uint8_t n = MIN (len, UINT8_MAX);
+
+    vXBeeIn (xbee, p, n);
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Enregistre les trames transmises
+ */
+void
+vXBeeSetRecorder (xXBee * xbee, xSerialRecorder * rec) {
+
+  xbee->rec = rec;
+}
+
 /* -----------------------------------------------------------------------------
  * Génère un numéro de trame différent de zéro
  */
@@ -0,0 +1,202 @@
+/**
+ * @file test/gpioedge/sysio_test_gpioedge.cpp
+ * @brief Test de l'historique et du compteur de fronts (EdgeHistory, EdgeCounter)
+ *
+ * EdgeHistory et EdgeCounter sont internes à la bibliothèque
+ * (src/gpio/gpioedgecounter.h), le test ne nécessite ni matériel, ni droits
+ * particuliers. Le refus de Pin::enableCounter() sur une broche déjà
+ * attachée n'est vérifié que si l'hôte permet d'attacher une routine
+ * d'interruption à une broche du GPIO simulé (sysfs ou chardev).
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <sysio/gpio.h>
+#include "gpioedgecounter.h"
+
+using namespace std;
+using namespace Sysio;
+
+/* constants ================================================================ */
+static const uint64_t ms = 1000000ULL;
+static const uint64_t ThreadPoints = 2000000;
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+
+  cout << "GPIO edge history test" << endl;
+
+  // Il faut au moins deux points pour calculer une variation
+  {
+    EdgeHistory h;
+
+    assert (h.rate (0) == 0);
+    h.push (5 * ms, 10);
+    assert (h.rate (0) == 0);
+    h.push (6 * ms, 11);
+    assert (h.rate (0) == 1000);
+  }
+  cout << "Rate: Success" << endl;
+
+  // Un point plus proche du précédent que la résolution est omis
+  {
+    EdgeHistory h;
+
+    h.push (0, 0);
+    h.push (ms / 2, 100);
+    h.push (ms - 1, 100);
+    h.push (ms, 1);
+    assert (h.rate (0) == 1000);
+    h.push (ms + ms / 2, 100);
+    h.push (2 * ms, 3);
+    assert (h.rate (0) == 1500);
+  }
+  cout << "Resolution: Success" << endl;
+
+  // Seuls les points postérieurs à since sont pris en compte
+  {
+    EdgeHistory h;
+
+    for (uint64_t i = 1; i <= 10; i++) {
+
+      h.push (i * ms, (i <= 5) ? i : 5 + (i - 5) * 3);
+    }
+    assert (h.rate (0) == 19 * 1e9 / (9 * ms));
+    assert (h.rate (5 * ms) == 3000);
+    assert (h.rate (6 * ms) == 3000);
+    assert (h.rate (10 * ms) == 0);
+    assert (h.rate (11 * ms) == 0);
+  }
+  cout << "Window: Success" << endl;
+
+  // Après plusieurs tours, le plus ancien point lu est le plus ancien non
+  // réécrit (size - 1 points)
+  {
+    unique_ptr<EdgeHistory> h (new EdgeHistory);
+    const uint64_t n = 10000;
+    const double first = n - EdgeHistory::size + 1;
+    const double last = n - 1;
+
+    for (uint64_t i = 0; i < n; i++) {
+
+      h->push (i * ms, i * i);
+    }
+    double expected = (last * last - first * first) * 1e9 / ( (last - first) * ms);
+    assert (fabs (h->rate (0) - expected) < expected * 1e-9);
+  }
+  cout << "Wrap around: Success" << endl;
+
+  // Deux producteurs et deux lecteurs concurrents : la valeur vaut 1000 fois
+  // l'instant en ms, un point lu à moitié réécrit fausserait la variation
+  {
+    unique_ptr<EdgeHistory> h (new EdgeHistory);
+    atomic<uint64_t> next (0);
+    atomic<bool> done (false);
+    atomic<uint64_t> reads (0);
+    vector<thread> threads;
+
+    for (int i = 0; i < 2; i++) {
+
+      threads.emplace_back ([&h, &next]() {
+        uint64_t k;
+
+        while ( (k = next.fetch_add (1)) < ThreadPoints) {
+
+          h->push (k * ms, k * 1000);
+        }
+      });
+    }
+    for (int i = 0; i < 2; i++) {
+
+      threads.emplace_back ([&h, &done, &reads]() {
+
+        while (!done.load()) {
+          double r = h->rate (0);
+
+          assert ( (r == 0) || (r == 1e6));
+          reads++;
+        }
+      });
+    }
+
+    threads[0].join();
+    threads[1].join();
+    done = true;
+    threads[2].join();
+    threads[3].join();
+    assert (h->rate (0) == 1e6);
+    assert (reads > 0);
+  }
+  cout << "Concurrent readers: Success" << endl;
+
+  // Le compteur est remis à zéro sans perdre l'historique
+  {
+    unique_ptr<EdgeCounter> c (new EdgeCounter);
+
+    assert (c->count() == 0);
+    assert (c->frequency (0) == 0);
+    for (uint64_t i = 0; i < 100; i++) {
+
+      c->push (i * 2 * ms);
+    }
+    assert (c->count() == 100);
+    assert (c->frequency (0) == 500);
+    c->reset();
+    assert (c->count() == 0);
+    assert (c->frequency (0) == 500);
+    c->push (200 * ms);
+    assert (c->count() == 1);
+    assert (c->frequency (150 * ms) == 500);
+  }
+  cout << "Counter: Success" << endl;
+
+  // Une broche dont les fronts sont déjà traités ne peut pas compter, sinon
+  // le compteur resterait à zéro
+  {
+    Gpio g (AccessLayerAll, true);
+    bool attached = false;
+
+    g.open();
+    assert (g.isOpen());
+    g.setNumbering (Pin::NumberingMcu);
+    Pin & p = g.pin (17);
+
+    try {
+      p.attachInterrupt ([] (Pin &, Pin::Edge, uint64_t) {}, Pin::EdgeBoth);
+      attached = true;
+    }
+    catch (exception & e) {
+
+      cout << "Attached pin: skipped (" << e.what() << ")" << endl;
+    }
+
+    if (attached) {
+      bool refused = false;
+
+      try {
+        p.enableCounter (Pin::EdgeRising);
+      }
+      catch (logic_error & e) {
+
+        refused = true;
+      }
+      assert (refused);
+      assert (p.counter() == 0);
+      p.detachInterrupt();
+      cout << "Attached pin: Success" << endl;
+    }
+    g.close();
+  }
+
+  cout << "All tests passed !" << endl;
+  return 0;
+}
+/* ========================================================================== */
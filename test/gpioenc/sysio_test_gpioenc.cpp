@@ -0,0 +1,193 @@
+/**
+ * @file test/gpioenc/sysio_test_gpioenc.cpp
+ * @brief Test du décodage d'un codeur en quadrature
+ *
+ * quadratureStep() et quadratureLevels() sont les fonctions internes utilisée par QuadratureEncoder
+ * (src/gpio/gpioquadrature.h), le test ne nécessite ni matériel, ni droits
+ * particuliers.
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <cassert>
+#include "gpioquadrature.h"
+
+using namespace std;
+using namespace Sysio;
+
+/* constants ================================================================ */
+static const int A = 0;
+static const int B = 1;
+static const Pin::Edge Up = Pin::EdgeRising;
+static const Pin::Edge Down = Pin::EdgeFalling;
+static const int ThreadEdges = 1000000;
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+
+  cout << "GPIO quadrature decoder test" << endl;
+
+  // A en avance sur B : 00, 01, 11, 10, un cycle compte 4 fronts
+  {
+    atomic<unsigned> s (0);
+    int pos = 0;
+
+    for (int i = 0; i < 10; i++) {
+
+      assert (quadratureStep (s, A, Up) == 1);
+      assert (s == 1);
+      assert (quadratureStep (s, B, Up) == 1);
+      assert (s == 3);
+      assert (quadratureStep (s, A, Down) == 1);
+      assert (s == 2);
+      assert (quadratureStep (s, B, Down) == 1);
+      assert (s == 0);
+      pos += 4;
+    }
+    assert (pos == 40);
+  }
+  cout << "Forward: Success" << endl;
+
+  // B en avance sur A, depuis un état initial quelconque
+  {
+    atomic<unsigned> s (3);
+
+    assert (quadratureStep (s, B, Down) == -1);
+    assert (quadratureStep (s, A, Down) == -1);
+    assert (quadratureStep (s, B, Up) == -1);
+    assert (quadratureStep (s, A, Up) == -1);
+    assert (s == 3);
+  }
+  cout << "Reverse: Success" << endl;
+
+  // Changement de sens : le front suivant de la même voie revient en arrière
+  {
+    atomic<unsigned> s (0);
+
+    assert (quadratureStep (s, A, Up) == 1);
+    assert (quadratureStep (s, A, Down) == -1);
+    assert (quadratureStep (s, B, Up) == -1);
+    assert (quadratureStep (s, B, Down) == 1);
+    assert (s == 0);
+  }
+  cout << "Direction change: Success" << endl;
+
+  // Deux fronts de même sens sur une voie : un front a été perdu, l'état
+  // n'est pas modifié
+  {
+    atomic<unsigned> s (0);
+
+    assert (quadratureStep (s, A, Down) == QuadratureIllegal);
+    assert (quadratureStep (s, A, Up) == 1);
+    assert (quadratureStep (s, A, Up) == QuadratureIllegal);
+    assert (s == 1);
+    assert (quadratureStep (s, B, Down) == QuadratureIllegal);
+    assert (s == 1);
+  }
+  cout << "Illegal transitions: Success" << endl;
+
+  // A↑ B↑ A↓ (+3) reçus dans l'ordre chronologique, une seule file pour les
+  // deux voies (requête commune /dev/gpiochipN)
+  {
+    struct { int channel; Pin::Edge edge; } ev[] = { {A, Up}, {B, Up}, {A, Down} };
+    atomic<unsigned> s (0);
+    int pos = 0;
+
+    for (const auto & e : ev) {
+      int d = quadratureStep (s, e.channel, e.edge);
+
+      assert (d != QuadratureIllegal);
+      pos += d;
+    }
+    assert (pos == 3);
+    assert (s == 2);
+  }
+  cout << "Ordered events: Success" << endl;
+
+  // A↑ B↑ A↓ reçus dans le désordre (file de A vidée avant celle de B) :
+  // décodés d'après leur type, ils comptent -1 au lieu de +3, c'est
+  // pourquoi les deux voies partagent une même file, ou à défaut sont
+  // décodées d'après leurs niveaux
+  {
+    atomic<unsigned> s (0);
+    int pos = 0;
+
+    pos += quadratureStep (s, A, Up);
+    pos += quadratureStep (s, A, Down);
+    pos += quadratureStep (s, B, Up);
+    assert (pos == -1);
+  }
+  {
+    // Décodage par niveaux (fronts sur deux files) : seul compte l'instant
+    // de la lecture, pas la voie notifiée. A↑ B↑ A↓ traités chacun avant le
+    // front suivant, la notification de B↑ arrive après celle de A↓
+    atomic<unsigned> s (0);
+    int pos = 0;
+
+    pos += quadratureLevels (s, 1); // A↑, niveaux 01
+    pos += quadratureLevels (s, 3); // A↓ notifié, B↑ a eu lieu : 11
+    pos += quadratureLevels (s, 2); // A↓ a eu lieu : 10
+    assert (quadratureLevels (s, 2) == 0); // B↑ déjà pris en compte
+    assert (pos == 3);
+    assert (s == 2);
+
+    // deux fronts entre deux lectures : transition illégale et
+    // resynchronisation sur les niveaux lus
+    s = 0;
+    pos = 0;
+    assert (quadratureLevels (s, 1) == 1); // A↑
+    assert (quadratureLevels (s, 2) == QuadratureIllegal); // B↑ et A↓
+    assert (quadratureLevels (s, 2) == 0);
+    assert (s == 2);
+
+    // puis un cycle complet dans le même sens compte 4 fronts
+    for (unsigned l : { 0U, 1U, 3U, 2U }) {
+
+      pos += quadratureLevels (s, l);
+    }
+    assert (pos == 4);
+  }
+  cout << "Out of order events: Success" << endl;
+
+  // Les deux voies décodées en parallèle : aucun front de l'une n'efface
+  // l'autre, la position finale correspond à l'état final (modulo 4)
+  {
+    static const int grayIndex[4] = { 0, 1, 3, 2 };
+    atomic<unsigned> s (0);
+    atomic<long> pos (0);
+    atomic<long> illegal (0);
+
+    auto channel = [&s, &pos, &illegal] (int c) {
+
+      for (int i = 0; i < ThreadEdges; i++) {
+        int d = quadratureStep (s, c, (i & 1) ? Down : Up);
+
+        if (d == QuadratureIllegal) {
+
+          illegal++;
+        }
+        else {
+
+          pos += d;
+        }
+      }
+    };
+    thread ta (channel, A);
+    thread tb (channel, B);
+
+    ta.join();
+    tb.join();
+    assert (illegal == 0);
+    assert (s == 0);
+    assert ( ( (pos - grayIndex[s]) & 3) == 0);
+  }
+  cout << "Parallel channels: Success" << endl;
+
+  cout << "All tests passed !" << endl;
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,149 @@
+/**
+ * @file test/gpioring/sysio_test_gpioring.cpp
+ * @brief Test du tampon circulaire des fronts (EventRing)
+ *
+ * EventRing est interne à la bibliothèque (src/gpio/gpioeventring.h), le test
+ * ne nécessite ni matériel, ni droits particuliers.
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include "gpioeventring.h"
+
+using namespace std;
+using namespace Sysio;
+
+/* constants ================================================================ */
+static const uint64_t ThreadEvents = 100000;
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  Pin::Event ev[16];
+
+  cout << "GPIO event ring test" << endl;
+
+  // La capacité est arrondie à la puissance de 2 supérieure
+  {
+    EventRing r5 (5);
+    EventRing r8 (8);
+
+    assert (r5.capacity() == 8);
+    assert (r8.capacity() == 8);
+    assert (r5.size() == 0);
+    assert (r5.drain (ev, 16) == 0);
+  }
+  cout << "Capacity: Success" << endl;
+
+  // Les fronts sont restitués dans l'ordre, par lots de taille max
+  {
+    EventRing r (8);
+
+    for (uint64_t i = 0; i < 5; i++) {
+
+      assert (r.push (100 + i, (i & 1) ? Pin::EdgeFalling : Pin::EdgeRising));
+    }
+    assert (r.size() == 5);
+    assert (r.drain (ev, 2) == 2);
+    assert ( (ev[0].timestamp_ns == 100) && (ev[0].edge == Pin::EdgeRising));
+    assert ( (ev[1].timestamp_ns == 101) && (ev[1].edge == Pin::EdgeFalling));
+    assert (r.size() == 3);
+    assert (r.drain (ev, 16) == 3);
+    assert ( (ev[0].timestamp_ns == 102) && (ev[2].timestamp_ns == 104));
+    assert (r.size() == 0);
+  }
+  cout << "FIFO order: Success" << endl;
+
+  // File pleine : le nouveau front est perdu, les anciens sont conservés
+  {
+    EventRing r (4);
+
+    for (uint64_t i = 0; i < 4; i++) {
+
+      assert (r.push (i, Pin::EdgeRising));
+    }
+    assert (!r.push (4, Pin::EdgeRising));
+    assert (!r.push (5, Pin::EdgeRising));
+    assert (r.overflows() == 2);
+    assert (r.size() == 4);
+    assert (r.drain (ev, 16) == 4);
+    for (uint64_t i = 0; i < 4; i++) {
+
+      assert (ev[i].timestamp_ns == i);
+    }
+    // une place libérée est de nouveau utilisable
+    assert (r.push (6, Pin::EdgeFalling));
+    assert (r.drain (ev, 16) == 1);
+    assert (ev[0].timestamp_ns == 6);
+  }
+  cout << "Overflow: Success" << endl;
+
+  // Les indices dépassent largement la capacité
+  {
+    EventRing r (4);
+    uint64_t next = 0;
+
+    for (uint64_t i = 0; i < 1000; i++) {
+
+      assert (r.push (i, Pin::EdgeBoth));
+      if ( (i % 3) == 2) {
+        size_t n = r.drain (ev, 16);
+
+        for (size_t j = 0; j < n; j++) {
+
+          assert (ev[j].timestamp_ns == next++);
+        }
+      }
+    }
+    next += r.drain (ev, 16);
+    assert (next == 1000);
+    assert (r.overflows() == 0);
+  }
+  cout << "Wrap around: Success" << endl;
+
+  // Un producteur et un consommateur concurrents
+  {
+    EventRing r (64);
+    uint64_t rejected = 0;
+    uint64_t next = 0;
+
+    thread producer ([&r, &rejected]() {
+
+      for (uint64_t i = 0; i < ThreadEvents; i++) {
+
+        while (!r.push (i, Pin::EdgeRising)) {
+
+          rejected++;
+          this_thread::yield();
+        }
+      }
+    });
+
+    while (next < ThreadEvents) {
+      size_t n = r.drain (ev, 16);
+
+      if (n == 0) {
+
+        // laisse le producteur s'exécuter sur une machine à un seul cœur
+        this_thread::yield();
+      }
+      for (size_t j = 0; j < n; j++) {
+
+        assert (ev[j].timestamp_ns == next);
+        next++;
+      }
+    }
+    producer.join();
+    assert (r.size() == 0);
+    assert (r.overflows() == rejected);
+  }
+  cout << "Producer/consumer: Success" << endl;
+
+  cout << "All tests passed !" << endl;
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,84 @@
+/**
+ * @file test/gpiosim/sysio_test_gpiosim.cpp
+ * @brief Test du GPIO simulé (DeviceSim)
+ *
+ * Ne nécessite ni matériel, ni droits particuliers : les registres du BCM2835
+ * sont simulés en mémoire, le test fonctionne sur n'importe quel hôte.
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <iostream>
+#include <cassert>
+#include <sysio/gpio.h>
+#include <sysio/gpiofastpin.h>
+
+using namespace std;
+using namespace Sysio;
+
+/* constants ================================================================ */
+static const int pinA = 17;
+static const int pinB = 27;
+static const uint32_t maskA = 1U << pinA;
+static const uint32_t maskB = 1U << pinB;
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  Gpio g (AccessLayerIoMap, true);
+
+  cout << "GPIO simulated test" << endl;
+  g.open();
+  assert (g.isOpen());
+  g.setNumbering (Pin::NumberingMcu);
+
+  Pin & a = g.pin (pinA);
+  Pin & b = g.pin (pinB);
+
+  // GPLEV reflète les sorties écrites par GPSET/GPCLR
+  a.setMode (Pin::ModeOutput);
+  b.setMode (Pin::ModeOutput);
+  a.write (true);
+  assert (a.read());
+  assert (g.readPort (0) & maskA);
+  a.write (false);
+  assert (!a.read());
+  assert ( (g.readPort (0) & maskA) == 0);
+  a.toggle();
+  assert (a.read());
+  a.write (false);
+  cout << "Pin write/read: Success" << endl;
+
+  // Les broches d'un port sont modifiées en un seul accès
+  g.writePort (0, maskA | maskB, 0);
+  assert ( (g.readPort (0) & (maskA | maskB)) == (maskA | maskB));
+  g.writePort (0, maskB, maskA);
+  assert ( (g.readPort (0) & (maskA | maskB)) == maskB);
+  g.writePort (0, 0, maskA | maskB);
+  assert ( (g.readPort (0) & (maskA | maskB)) == 0);
+  cout << "Port write/read: Success" << endl;
+
+  // Une entrée non commandée prend le niveau de sa résistance de tirage
+  a.setMode (Pin::ModeInput);
+  a.setPull (Pin::PullUp);
+  assert (a.pull() == Pin::PullUp);
+  assert (a.read());
+  a.setPull (Pin::PullDown);
+  assert (!a.read());
+  cout << "Input pull: Success" << endl;
+
+  // Accès direct : les sorties sont écrites dans GPLEV (DataRegister)
+  b.setMode (Pin::ModeOutput);
+  FastPinRegisters r = FastPinRegisters::get (b);
+  assert (!r.setClear);
+  *r.set |= r.mask;
+  assert (b.read());
+  *r.clr &= ~r.mask;
+  assert (!b.read());
+  cout << "Fast registers: Success" << endl;
+
+  g.close();
+  cout << "All tests passed !" << endl;
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,240 @@
+/**
+ * @file test/onewire/sysio_test_onewire.cpp
+ * @brief Test du CRC et de la recherche 1-Wire (OneWire)
+ *
+ * Les esclaves sont simulés par une classe dérivée qui redéfinit les
+ * créneaux (reset(), writeBit(), readBit()), le test ne nécessite ni
+ * matériel, ni droits particuliers.
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <iostream>
+#include <algorithm>
+#include <system_error>
+#include <vector>
+#include <cassert>
+#include <cerrno>
+#include <sysio/gpioonewire.h>
+
+using namespace std;
+using namespace Sysio;
+
+/* constants ================================================================ */
+static const uint8_t cmdSearchRom = 0xF0;
+static const uint8_t cmdAlarmSearch = 0xEC;
+
+/* private classes ========================================================== */
+// Bus dont les esclaves répondent aux commandes Search ROM et Alarm Search,
+// le niveau lu est le ET câblé des bits transmis par les esclaves actifs
+class SimBus : public OneWire {
+
+  public:
+    struct Slave {
+      uint64_t rom;
+      bool alarm;
+    };
+
+    SimBus() : OneWire(), stuckLow (false), _state (Idle) {}
+
+    bool reset() override {
+
+      _state = Command;
+      _cmd = 0;
+      _count = 0;
+      _active.assign (slaves.size(), true);
+      return stuckLow || !slaves.empty();
+    }
+
+    void writeBit (bool bit) override {
+
+      if (_state == Command) {
+
+        _cmd |= bit << _count;
+        if (++_count == 8) {
+
+          _state = Idle;
+          if ( (_cmd == cmdSearchRom) || (_cmd == cmdAlarmSearch)) {
+
+            for (size_t i = 0; i < slaves.size(); i++) {
+
+              _active[i] = (_cmd == cmdSearchRom) || slaves[i].alarm;
+            }
+            _state = Search;
+            _count = 0;
+            _phase = 0;
+          }
+        }
+      }
+      else if (_state == Search) {
+
+        // les esclaves dont le bit diffère de la direction choisie se retirent
+        for (size_t i = 0; i < slaves.size(); i++) {
+
+          if ( ( (slaves[i].rom >> _count) & 1) != bit) {
+
+            _active[i] = false;
+          }
+        }
+        _count++;
+        _phase = 0;
+      }
+    }
+
+    bool readBit() override {
+      bool level = true;
+
+      if (stuckLow) {
+
+        return false;
+      }
+      if (_state == Search) {
+
+        for (size_t i = 0; i < slaves.size(); i++) {
+
+          if (_active[i]) {
+            bool b = (slaves[i].rom >> _count) & 1;
+
+            level &= (_phase == 0) ? b : !b;
+          }
+        }
+        _phase++;
+      }
+      return level;
+    }
+
+    vector<Slave> slaves;
+    bool stuckLow;
+
+  private:
+    enum { Idle, Command, Search } _state;
+    uint8_t _cmd;
+    int _count;
+    int _phase;
+    vector<bool> _active;
+};
+
+/* private functions ======================================================== */
+// -----------------------------------------------------------------------------
+// Identifiant complet : famille, numéro de série sur 48 bits et CRC
+static uint64_t
+makeRom (uint8_t family, uint64_t serial) {
+  uint8_t buf[8];
+  uint64_t rom = family | ( (serial & 0xFFFFFFFFFFFFULL) << 8);
+
+  for (int i = 0; i < 7; i++) {
+
+    buf[i] = rom >> (i * 8);
+  }
+  return rom | ( (uint64_t) OneWire::crc8 (buf, 7) << 56);
+}
+
+// -----------------------------------------------------------------------------
+// Vérifie que la recherche trouve chaque identifiant attendu une seule fois
+static bool
+sameRoms (vector<uint64_t> found, vector<uint64_t> expected) {
+
+  sort (found.begin(), found.end());
+  sort (expected.begin(), expected.end());
+  return found == expected;
+}
+
+// -----------------------------------------------------------------------------
+static int
+searchError (SimBus & bus) {
+
+  try {
+    bus.search();
+  }
+  catch (system_error & e) {
+
+    return e.code().value();
+  }
+  return 0;
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+
+  cout << "OneWire test" << endl;
+
+  // Exemple de la note d'application 27 de Maxim
+  {
+    const uint8_t rom[8] = { 0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2 };
+
+    assert (OneWire::crc8 (rom, 7) == 0xA2);
+    assert (OneWire::crc8 (rom, 8) == 0);
+    assert (OneWire::crc8 (rom, 0) == 0);
+    assert (OneWire::family (makeRom (OneWire::FamilyDS18B20, 1)) == 0x28);
+  }
+  cout << "CRC: Success" << endl;
+
+  // Recherche avec 0, 1, 3 et 8 esclaves, les numéros de série ont des
+  // préfixes communs pour provoquer des divergences à différents rangs
+  {
+    const uint64_t serials[] = { 0x000001, 0x000002, 0x000003, 0x800000,
+                                 0xFFFFFFFFFFFFULL, 0x000004, 0x010001, 0x7F
+                               };
+    const uint8_t families[] = { OneWire::FamilyDS18B20, OneWire::FamilyDS18S20,
+                                 OneWire::FamilyDS1822
+                               };
+
+    for (size_t n : { 0, 1, 3, 8 }) {
+      SimBus bus;
+      vector<uint64_t> expected;
+
+      for (size_t i = 0; i < n; i++) {
+        uint64_t rom = makeRom (families[i % 3], serials[i]);
+
+        bus.slaves.push_back ({ rom, false });
+        expected.push_back (rom);
+      }
+      assert (sameRoms (bus.search(), expected));
+    }
+  }
+  cout << "Search ROM: Success" << endl;
+
+  // Seuls les esclaves en alarme répondent à Alarm Search
+  {
+    SimBus bus;
+    vector<uint64_t> alarms;
+
+    for (uint64_t i = 1; i <= 6; i++) {
+      uint64_t rom = makeRom (OneWire::FamilyDS18B20, i * 0x1111);
+      bool alarm = (i % 3) == 0;
+
+      bus.slaves.push_back ({ rom, alarm });
+      if (alarm) {
+
+        alarms.push_back (rom);
+      }
+    }
+    assert (sameRoms (bus.search (true), alarms));
+    assert (bus.search().size() == 6);
+
+    for (auto & s : bus.slaves) {
+
+      s.alarm = false;
+    }
+    assert (bus.search (true).empty());
+  }
+  cout << "Alarm search: Success" << endl;
+
+  // Un identifiant dont le CRC est faux, un bus bloqué à l'état bas
+  {
+    SimBus bus;
+
+    bus.slaves.push_back ({ makeRom (OneWire::FamilyDS18B20, 1) ^ (1ULL << 63), false });
+    assert (searchError (bus) == EIO);
+
+    bus.slaves.clear();
+    bus.stuckLow = true;
+    assert (searchError (bus) == EIO);
+  }
+  cout << "Search errors: Success" << endl;
+
+  cout << "All tests passed !" << endl;
+  return 0;
+}
+/* ========================================================================== */
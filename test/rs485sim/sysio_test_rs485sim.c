@@ -0,0 +1,343 @@
+/**
+ * @file test/rs485sim/sysio_test_rs485sim.c
+ * @brief Test des transactions RS485 sur un pseudo-terminal
+ *
+ * Le port est l'esclave d'un pseudo-terminal (iSerialOpenPty()), le maître
+ * joue le rôle de l'esclave RS485 distant. Un pseudo-terminal ne possède
+ * pas de ligne RTS : le test fournit sa propre fonction ioctl(), appelée à
+ * la place de celle de la libc par la bibliothèque, qui mémorise les
+ * basculements de RTS et leurs instants. Elle peut aussi simuler un pilote
+ * gérant le mode RS485 (TIOCSRS485). Le test ne nécessite ni matériel, ni
+ * droits particuliers.
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/serial.h>
+#include <sysio/serial.h>
+
+/* constants ================================================================ */
+#define BAUDRATE    9600
+#define BEFORE_MS   2
+#define AFTER_MS    3
+#define RTS_MAX     16
+#define REPLY_MAX   16
+
+/* structures =============================================================== */
+// Esclave distant, répond après le retour de RTS au niveau de réception
+typedef struct xDevice {
+  int fd;
+  size_t reqlen;      /*< taille de la requête attendue */
+  int rxlevel;        /*< niveau de RTS en réception */
+  unsigned delay;     /*< délai de réponse en ms */
+  const char * reply; /*< réponse, NULL pour ne pas répondre */
+  unsigned gap;       /*< silence en ms au milieu de la réponse */
+  int txrts;          /*< niveau de RTS à la réception de la requête */
+} xDevice;
+
+/* private variables ======================================================== */
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static int kernelRs485;     /*< pilote simulé gérant le RS485 */
+static struct serial_rs485 rs485conf;
+static int rts;
+static int rtsCount;        /*< nombre de basculements mémorisés */
+static int rtsLevel[RTS_MAX];
+static struct timespec rtsTime[RTS_MAX];
+
+/* private functions ======================================================== */
+// -----------------------------------------------------------------------------
+static double
+dElapsed (const struct timespec * t0, const struct timespec * t1) {
+
+  return (t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vSleepMs (unsigned ms) {
+  struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
+
+  while (nanosleep (&ts, &ts) < 0)
+    ;
+}
+
+// -----------------------------------------------------------------------------
+static int
+iRts (void) {
+  int level;
+
+  pthread_mutex_lock (&mutex);
+  level = rts;
+  pthread_mutex_unlock (&mutex);
+  return level;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vRtsClear (void) {
+
+  pthread_mutex_lock (&mutex);
+  rtsCount = 0;
+  pthread_mutex_unlock (&mutex);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vMasterWrite (int fd, const char * s) {
+  size_t len = strlen (s);
+
+  while (len) {
+    ssize_t n = write (fd, s, len);
+
+    assert (n > 0);
+    s += n;
+    len -= n;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void *
+pvDevice (void * arg) {
+  xDevice * d = (xDevice *) arg;
+  char buf[REPLY_MAX];
+  size_t len = 0;
+
+  while (len < d->reqlen) {
+    struct pollfd pfd = { .fd = d->fd, .events = POLLIN };
+    ssize_t n;
+
+    assert (poll (&pfd, 1, 1000) == 1);
+    n = read (d->fd, buf + len, sizeof (buf) - len);
+    assert (n > 0);
+    len += n;
+  }
+  d->txrts = iRts();
+
+  if (d->reply) {
+    size_t half = strlen (d->reply) / 2;
+
+    while (iRts() != d->rxlevel) {
+
+      vSleepMs (1);
+    }
+    vSleepMs (d->delay);
+    if (d->gap) {
+      char first[REPLY_MAX];
+
+      memcpy (first, d->reply, half);
+      first[half] = 0;
+      vMasterWrite (d->fd, first);
+      vSleepMs (d->gap);
+      vMasterWrite (d->fd, d->reply + half);
+    }
+    else {
+
+      vMasterWrite (d->fd, d->reply);
+    }
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Transaction avec l'esclave simulé, retourne le nombre d'octets reçus
+static int
+iTransaction (xSerialRs485 * bus, int master, int rxlevel,
+              const char * reply, unsigned delay, unsigned gap,
+              char * rx, size_t rxsize, int iTimeoutMs, long lCharTimeoutUs,
+              xSerialRs485Stats * st) {
+  static const char req[] = "0123456789";
+  xDevice d = { .fd = master, .reqlen = sizeof (req) - 1, .rxlevel = rxlevel,
+                .delay = delay, .reply = reply, .gap = gap
+              };
+  pthread_t th;
+  int n;
+
+  assert (pthread_create (&th, NULL, pvDevice, &d) == 0);
+  n = iSerialRs485Transaction (bus, req, sizeof (req) - 1, rx, rxsize,
+                               iTimeoutMs, lCharTimeoutUs, st);
+  pthread_join (th, NULL);
+  assert (!bSerialRs485IsKernel (bus) || (d.txrts == rxlevel));
+  assert (bSerialRs485IsKernel (bus) || (d.txrts == !rxlevel));
+  return n;
+}
+
+/* public functions ========================================================= */
+// -----------------------------------------------------------------------------
+// Remplace ioctl() de la libc pour le programme et la bibliothèque
+int
+ioctl (int fd, unsigned long request, ...) {
+  va_list ap;
+  void * arg;
+  int ret = 0;
+
+  va_start (ap, request);
+  arg = va_arg (ap, void *);
+  va_end (ap);
+
+  pthread_mutex_lock (&mutex);
+  switch (request) {
+
+    case TIOCMBIS:
+    case TIOCMBIC:
+      if (* (int *) arg & TIOCM_RTS) {
+
+        rts = (request == TIOCMBIS);
+        if (rtsCount < RTS_MAX) {
+
+          rtsLevel[rtsCount] = rts;
+          clock_gettime (CLOCK_MONOTONIC, &rtsTime[rtsCount]);
+          rtsCount++;
+        }
+      }
+      break;
+
+    case TIOCGRS485:
+    case TIOCSRS485:
+      if (!kernelRs485) {
+
+        errno = ENOTTY;
+        ret = -1;
+      }
+      else if (request == TIOCGRS485) {
+
+        memcpy (arg, &rs485conf, sizeof (rs485conf));
+      }
+      else {
+
+        memcpy (&rs485conf, arg, sizeof (rs485conf));
+      }
+      break;
+
+    default:
+      ret = syscall (SYS_ioctl, fd, request, arg);
+      break;
+  }
+  pthread_mutex_unlock (&mutex);
+  return ret;
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  xSerialIos ios = { .baud = BAUDRATE, .dbits = SERIAL_DATABIT_8,
+                     .parity = SERIAL_PARITY_NONE, .sbits = SERIAL_STOPBIT_ONE,
+                     .flow = SERIAL_FLOW_NONE
+                   };
+  xSerialRs485Stats st;
+  xSerialRs485 * bus;
+  struct timespec t0, t1;
+  char name[64];
+  char rx[REPLY_MAX];
+  double dFrame;
+  int master, fd, n;
+
+  printf ("RS485 transaction test\n");
+  master = iSerialOpenPty (name, sizeof (name));
+  assert (master >= 0);
+  fd = iSerialOpen (name, &ios);
+  assert (fd >= 0);
+  dFrame = dSerialFrameDuration (fd, 10);
+  assert (dFrame > 0.010);
+
+  assert (xSerialRs485New (-1, SERIAL_FLOW_RS485_RTS_ON_SEND, 0, 0) == NULL);
+  assert (errno == EINVAL);
+  assert (xSerialRs485New (fd, SERIAL_FLOW_RTSCTS, 0, 0) == NULL);
+  assert (errno == EINVAL);
+  assert (iSerialRs485Transaction (NULL, "", 0, rx, 0, 0, 0, NULL) < 0);
+  assert (errno == EINVAL);
+  printf ("Invalid arguments: Success\n");
+
+  // RTS commandé par le logiciel, à 1 pendant l'émission. Le pseudo-terminal
+  // transmet sans délai : RTS doit rester à 1 jusqu'à la fin théorique de la
+  // trame, prolongée du délai après émission
+  bus = xSerialRs485New (fd, SERIAL_FLOW_RS485_RTS_ON_SEND, BEFORE_MS, AFTER_MS);
+  assert (bus);
+  assert (!bSerialRs485IsKernel (bus));
+  assert ( (rtsCount == 1) && (rtsLevel[0] == 0));
+
+  vRtsClear();
+  n = iTransaction (bus, master, 0, "hello", 20, 0, rx, sizeof (rx), 1000, 0, &st);
+  assert (n == 5);
+  assert (memcmp (rx, "hello", 5) == 0);
+  assert ( (rtsCount == 2) && (rtsLevel[0] == 1) && (rtsLevel[1] == 0));
+  assert (dElapsed (&rtsTime[0], &rtsTime[1]) >= dFrame + (BEFORE_MS + AFTER_MS) / 1e3);
+  assert (st.dTx >= dFrame + (BEFORE_MS + AFTER_MS) / 1e3);
+  assert ( (st.dTurnaround >= 0.019) && (st.dTurnaround < 1));
+  assert ( (st.ulRxLen == 5) && (st.dRx >= 0));
+  printf ("Software RTS on send: Success\n");
+
+  // Un silence plus court que le délai inter-caractères ne termine pas la
+  // réponse, un silence plus long la termine
+  n = iTransaction (bus, master, 0, "abcdef", 0, 5, rx, sizeof (rx), 1000, 50000, &st);
+  assert ( (n == 6) && (memcmp (rx, "abcdef", 6) == 0));
+  assert (st.dRx >= 0.004);
+  n = iTransaction (bus, master, 0, "abcdef", 0, 50, rx, sizeof (rx), 1000, 0, &st);
+  assert ( (n == 3) && (memcmp (rx, "abc", 3) == 0));
+  vSleepMs (100);
+  printf ("Character timeout: Success\n");
+
+  // La fin de la réponse précédente (reçue en retard) est ignorée, sans
+  // réponse la transaction se termine après le délai
+  clock_gettime (CLOCK_MONOTONIC, &t0);
+  n = iTransaction (bus, master, 0, NULL, 0, 0, rx, sizeof (rx), 50, 0, &st);
+  clock_gettime (CLOCK_MONOTONIC, &t1);
+  assert (n == 0);
+  assert ( (st.ulRxLen == 0) && (st.dTurnaround == -1) && (st.dRx == 0));
+  assert (dElapsed (&t0, &t1) >= 0.050);
+  printf ("Stale input and timeout: Success\n");
+
+  // La lecture s'arrête lorsque le tampon est plein
+  n = iTransaction (bus, master, 0, "0123456", 0, 0, rx, 4, 1000, 0, &st);
+  assert ( (n == 4) && (memcmp (rx, "0123", 4) == 0));
+  vSleepMs (20);
+  assert (iSerialRs485Delete (bus) == 0);
+  printf ("Receive buffer full: Success\n");
+
+  // RTS à 0 pendant l'émission
+  vRtsClear();
+  bus = xSerialRs485New (fd, SERIAL_FLOW_RS485_RTS_AFTER_SEND, 0, 0);
+  assert (bus);
+  n = iTransaction (bus, master, 1, "ok", 0, 0, rx, sizeof (rx), 1000, 0, &st);
+  assert (n == 2);
+  assert ( (rtsCount == 3) && (rtsLevel[0] == 1) && (rtsLevel[1] == 0) && (rtsLevel[2] == 1));
+  assert (dElapsed (&rtsTime[1], &rtsTime[2]) >= dFrame);
+  assert (iSerialRs485Delete (bus) == 0);
+  printf ("Software RTS after send: Success\n");
+
+  // Pilote gérant le RS485 : les délais lui sont transmis, RTS n'est pas
+  // commandé par le logiciel
+  kernelRs485 = 1;
+  rts = 0; // niveau laissé par le bus précédent
+  vRtsClear();
+  bus = xSerialRs485New (fd, SERIAL_FLOW_RS485_RTS_ON_SEND, BEFORE_MS, AFTER_MS);
+  assert (bus);
+  assert (bSerialRs485IsKernel (bus));
+  assert (rs485conf.flags & SER_RS485_ENABLED);
+  assert (rs485conf.flags & SER_RS485_RTS_ON_SEND);
+  assert ( (rs485conf.delay_rts_before_send == BEFORE_MS) &&
+           (rs485conf.delay_rts_after_send == AFTER_MS));
+  n = iTransaction (bus, master, 0, "kernel", 0, 0, rx, sizeof (rx), 1000, 0, &st);
+  assert ( (n == 6) && (memcmp (rx, "kernel", 6) == 0));
+  assert (rtsCount == 0);
+  assert (iSerialRs485Delete (bus) == 0);
+  assert (iSerialRs485Delete (NULL) < 0);
+  printf ("Kernel RS485: Success\n");
+
+  vSerialClose (fd);
+  close (master);
+  printf ("All tests passed !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,277 @@
+/**
+ * @file test/serialbuf/sysio_test_serialbuf.cpp
+ * @brief Test des lectures et écritures tamponnées de la classe Serial
+ *
+ * Le port est l'esclave d'un pseudo-terminal (iSerialOpenPty()), le maître
+ * joue le rôle du matériel distant : le test ne nécessite ni matériel, ni
+ * droits particuliers.
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <system_error>
+#include <functional>
+#include <cassert>
+#include <cerrno>
+#include <unistd.h>
+#include <poll.h>
+#include <sysio/serial.hpp>
+
+using namespace std;
+
+/* constants ================================================================ */
+static const int BaudRate = 115200;
+static const int Timeout = 1000;
+
+/* private functions ======================================================== */
+// -----------------------------------------------------------------------------
+static uint8_t
+pattern (size_t i) {
+
+  return i % 251;
+}
+
+// -----------------------------------------------------------------------------
+static void
+masterWrite (int fd, const vector<uint8_t> & v) {
+  const uint8_t * p = v.data();
+  size_t len = v.size();
+
+  while (len) {
+    ssize_t n = write (fd, p, len);
+
+    assert (n > 0);
+    p += n;
+    len -= n;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+masterWrite (int fd, const string & s) {
+
+  masterWrite (fd, vector<uint8_t> (s.begin(), s.end()));
+}
+
+// -----------------------------------------------------------------------------
+static vector<uint8_t>
+masterRead (int fd, size_t len) {
+  vector<uint8_t> v (len);
+  size_t got = 0;
+
+  while (got < len) {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    ssize_t n;
+
+    assert (poll (&pfd, 1, Timeout) == 1);
+    n = read (fd, &v[got], len - got);
+    assert (n > 0);
+    got += n;
+  }
+  return v;
+}
+
+// -----------------------------------------------------------------------------
+// Code d'erreur de l'exception déclenchée par f, 0 s'il n'y en a pas
+static int
+errorOf (function<void() > f) {
+
+  try {
+    f();
+  }
+  catch (system_error & e) {
+
+    return e.code().value();
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+equals (const vector<uint8_t> & v, const string & s) {
+
+  return v == vector<uint8_t> (s.begin(), s.end());
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  char name[64];
+  int master = iSerialOpenPty (name, sizeof (name));
+  uint8_t buf[8192];
+
+  cout << "Serial buffered I/O test" << endl;
+  assert (master >= 0);
+
+  Serial s (name, BaudRate);
+
+  // Port fermé
+  assert (errorOf ([&s]() { s.available(); }) == EBADF);
+  assert (errorOf ([&s]() { s.readExact (1, 0); }) == EBADF);
+  assert (errorOf ([&s]() { s.sync(); }) == EBADF);
+  assert (s.open());
+  cout << "Closed port: Success" << endl;
+
+  // Délai écoulé sans réception
+  assert (s.available() == 0);
+  assert (s.read (buf, 16, 50) == 0);
+  assert (s.peek (20) == -1);
+  cout << "Read timeout: Success" << endl;
+
+  // Lignes, lecture sans retrait
+  masterWrite (master, "hello\nworld\n");
+  assert (equals (s.readUntil ('\n', 0, Timeout), "hello\n"));
+  assert (s.peek (Timeout) == 'w');
+  assert (s.peek (buf, 3, Timeout) == 3);
+  assert (equals (s.readExact (6, Timeout), "world\n"));
+  assert (s.available() == 0);
+  cout << "Lines: Success" << endl;
+
+  // Un délai écoulé laisse les octets reçus dans le tampon
+  masterWrite (master, "abc");
+  assert (errorOf ([&s]() { s.readExact (5, 100); }) == ETIMEDOUT);
+  assert (equals (s.readExact (3, Timeout), "abc"));
+
+  masterWrite (master, "abcdef");
+  assert (equals (s.readUntil ('\n', 4, Timeout), "abcd"));
+  assert (errorOf ([&s]() { s.readUntil ('\n', 0, 100); }) == ETIMEDOUT);
+  assert (s.read (buf, sizeof (buf), Timeout) == 2);
+  assert ( (buf[0] == 'e') && (buf[1] == 'f'));
+  cout << "Timeouts: Success" << endl;
+
+  // Le tampon circulaire fait plusieurs tours sans jamais être vidé, les
+  // délimiteurs sont recherchés dans ses deux zones
+  {
+    size_t written = 0;
+    size_t consumed = 0;
+
+    for (int round = 0; round < 20; round++) {
+      vector<uint8_t> v (3000);
+
+      for (size_t i = 0; i < v.size(); i++) {
+
+        v[i] = pattern (written + i);
+      }
+      masterWrite (master, v);
+      written += v.size();
+
+      while (written - consumed >= 951) {
+        vector<uint8_t> a = s.readExact (700, Timeout);
+
+        for (size_t i = 0; i < a.size(); i++) {
+
+          assert (a[i] == pattern (consumed + i));
+        }
+        consumed += a.size();
+
+        vector<uint8_t> b = s.readUntil (250, 0, Timeout);
+        assert (b.size() == 251 - (consumed % 251));
+        for (size_t i = 0; i < b.size(); i++) {
+
+          assert (b[i] == pattern (consumed + i));
+        }
+        consumed += b.size();
+      }
+    }
+    vector<uint8_t> c = s.readExact (written - consumed, Timeout);
+    for (size_t i = 0; i < c.size(); i++) {
+
+      assert (c[i] == pattern (consumed + i));
+    }
+    assert (s.available() == 0);
+  }
+  cout << "Wrap around: Success" << endl;
+
+  // Un bloc plus grand que le tampon est lu directement
+  {
+    vector<uint8_t> v (sizeof (buf));
+    size_t got = 0;
+
+    for (size_t i = 0; i < v.size(); i++) {
+
+      v[i] = pattern (i);
+    }
+    thread writer ([master, &v]() { masterWrite (master, v); });
+    while (got < v.size()) {
+      size_t n = s.read (buf + got, sizeof (buf) - got, Timeout);
+
+      assert (n > 0);
+      got += n;
+    }
+    writer.join();
+    assert (vector<uint8_t> (buf, buf + got) == v);
+  }
+  cout << "Large read: Success" << endl;
+
+  // Une ligne plus longue que le tampon l'agrandit
+  {
+    vector<uint8_t> v (10000, 'x');
+
+    v.back() = '\n';
+    thread writer ([master, &v]() { masterWrite (master, v); });
+    assert (s.readUntil ('\n', 0, 2 * Timeout) == v);
+    writer.join();
+  }
+  cout << "Buffer growth: Success" << endl;
+
+  // File d'écriture : regroupement, blocs déplacés, transmission par sync()
+  {
+    vector<uint8_t> big (5000);
+    vector<uint8_t> expected;
+    vector<uint8_t> received;
+    struct pollfd pfd = { master, POLLIN, 0 };
+
+    for (size_t i = 0; i < big.size(); i++) {
+
+      big[i] = pattern (i);
+    }
+    s.setWriteThreshold (0);
+    s.write (reinterpret_cast<const uint8_t *> ("ab"), 2);
+    s.write (reinterpret_cast<const uint8_t *> ("cd"), 2);
+    expected = { 'a', 'b', 'c', 'd' };
+    expected.insert (expected.end(), big.begin(), big.end());
+    s.write (move (big));
+    assert (s.pending() == 5004);
+    assert (poll (&pfd, 1, 50) == 0);
+
+    thread reader ([master, &received]() {
+      received = masterRead (master, 5004);
+    });
+    assert (s.sync (Timeout));
+    reader.join();
+    assert (s.pending() == 0);
+    assert (received == expected);
+
+    // transmission automatique au seuil
+    s.setWriteThreshold (16);
+    assert (s.writeThreshold() == 16);
+    s.write (reinterpret_cast<const uint8_t *> ("0123456789"), 10);
+    assert (s.pending() == 10);
+    s.write (reinterpret_cast<const uint8_t *> ("0123456789"), 10);
+    assert (s.pending() == 0);
+    assert (equals (masterRead (master, 20), "01234567890123456789"));
+  }
+  cout << "Write queue: Success" << endl;
+
+  // flush() abandonne la file d'écriture et le tampon de lecture
+  {
+    masterWrite (master, "zz");
+    assert (s.peek (Timeout) == 'z');
+    s.setWriteThreshold (0);
+    s.write (reinterpret_cast<const uint8_t *> ("abc"), 3);
+    s.flush();
+    assert (s.pending() == 0);
+    assert (s.available() == 0);
+  }
+  cout << "Flush: Success" << endl;
+
+  s.close();
+  close (master);
+  cout << "All tests passed !" << endl;
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,396 @@
+/**
+ * @file test/serialrec/sysio_test_serialrec.c
+ * @brief Test de l'enregistreur et du relecteur de trafic série
+ *
+ * Les journaux sont créés dans /tmp, la relecture vers un port utilise un
+ * pseudo-terminal (iSerialOpenPty()) : le test ne nécessite ni matériel, ni
+ * droits particuliers.
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sysio/serial.h>
+
+/* constants ================================================================ */
+#define BLOCK_MAX     64
+#define BIG_SIZE      300
+#define THREADS       4
+#define THREAD_BLOCKS 1000
+
+/* structures =============================================================== */
+typedef struct xBlock {
+  unsigned port;
+  eSerialRecDir dir;
+  size_t len;
+  uint8_t data[BIG_SIZE];
+  struct timespec t; /*< instant de relecture */
+} xBlock;
+
+typedef struct xReplay {
+  int count;
+  int stop;   /*< relecture arrêtée par la fonction au bloc stop, 0 sans arrêt */
+  xBlock block[BLOCK_MAX];
+} xReplay;
+
+typedef struct xThreadCheck {
+  int count;
+  unsigned next[THREADS]; /*< prochain numéro attendu de chaque thread */
+} xThreadCheck;
+
+/* private variables ======================================================== */
+static char path[] = "/tmp/sysio_test_serialrec_XXXXXX";
+static xSerialRecorder * rec;
+
+/* private functions ======================================================== */
+// -----------------------------------------------------------------------------
+static double
+dElapsed (const struct timespec * t0, const struct timespec * t1) {
+
+  return (t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vSleepMs (unsigned ms) {
+  struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
+
+  while (nanosleep (&ts, &ts) < 0)
+    ;
+}
+
+// -----------------------------------------------------------------------------
+static off_t
+lFileSize (void) {
+  struct stat st;
+
+  assert (stat (path, &st) == 0);
+  return st.st_size;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vWriteFile (const void * buf, size_t len) {
+  FILE * f = fopen (path, "wb");
+
+  assert (f);
+  assert (fwrite (buf, 1, len, f) == len);
+  fclose (f);
+}
+
+// -----------------------------------------------------------------------------
+static int
+iCollect (unsigned port, eSerialRecDir dir,
+          const uint8_t * buf, size_t len, void * udata) {
+  xReplay * r = (xReplay *) udata;
+  xBlock * b;
+
+  assert ( (r->count < BLOCK_MAX) && (len <= BIG_SIZE));
+  b = &r->block[r->count++];
+  b->port = port;
+  b->dir = dir;
+  b->len = len;
+  memcpy (b->data, buf, len);
+  clock_gettime (CLOCK_MONOTONIC, &b->t);
+
+  if (r->count == r->stop) {
+
+    errno = ECANCELED;
+    return -1;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+static int
+iReplay (double dSpeed, xReplay * r, int stop) {
+
+  memset (r, 0, sizeof (*r));
+  r->stop = stop;
+  return iSerialReplay (path, dSpeed, iCollect, r);
+}
+
+// -----------------------------------------------------------------------------
+// Chaque thread enregistre ses blocs numérotés, de longueur variable
+static void *
+pvRecorder (void * arg) {
+  unsigned id = (unsigned) (uintptr_t) arg;
+  uint8_t buf[8];
+
+  for (unsigned i = 0; i < THREAD_BLOCKS; i++) {
+
+    memset (buf, id, sizeof (buf));
+    buf[0] = i & 0xFF;
+    buf[1] = i >> 8;
+    assert (iSerialRecorderWrite (rec, id, SERIAL_REC_RX, buf, 2 + (i % 7)) == 0);
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+static int
+iThreadCheck (unsigned port, eSerialRecDir dir,
+              const uint8_t * buf, size_t len, void * udata) {
+  xThreadCheck * c = (xThreadCheck *) udata;
+  unsigned i;
+
+  assert ( (port < THREADS) && (dir == SERIAL_REC_RX));
+  i = buf[0] | (buf[1] << 8);
+  assert (i == c->next[port]);
+  assert (len == 2 + (i % 7));
+  for (size_t j = 2; j < len; j++) {
+
+    assert (buf[j] == port);
+  }
+  c->next[port]++;
+  c->count++;
+  return 0;
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  static const char text[] = "AT\r\n\x03\x11\x13+++";
+  uint8_t big[BIG_SIZE];
+  off_t end[4];
+  xReplay r;
+  int fd;
+
+  printf ("Serial recorder test\n");
+  fd = mkstemp (path);
+  assert (fd >= 0);
+  close (fd);
+  for (int i = 0; i < BIG_SIZE; i++) {
+
+    big[i] = i;
+  }
+
+  // Arguments invalides
+  assert ( (iSerialRecorderDelete (NULL) < 0) && (errno == EINVAL));
+  assert ( (iSerialRecorderWrite (NULL, 0, SERIAL_REC_RX, "", 0) < 0) && (errno == EINVAL));
+  assert ( (iSerialRecorderFlush (NULL) < 0) && (errno == EINVAL));
+  assert ( (iSerialReplay (NULL, 0, iCollect, &r) < 0) && (errno == EINVAL));
+  assert ( (iSerialReplay (path, -1, iCollect, &r) < 0) && (errno == EINVAL));
+  assert ( (iSerialReplay (path, 0, NULL, &r) < 0) && (errno == EINVAL));
+  assert (xSerialRecorderNew ("/nonexistent/rec") == NULL);
+  assert ( (iSerialReplay ("/nonexistent/rec", 0, iCollect, &r) < 0) && (errno == ENOENT));
+  printf ("Invalid arguments: Success\n");
+
+  // Aller-retour : port, sens, longueur (dont un bloc vide et un bloc dont la
+  // longueur est codée sur 2 octets) et contenu, la taille de chaque bloc
+  // est notée pour les tests de troncature
+  rec = xSerialRecorderNew (path);
+  assert (rec);
+  assert (iSerialRecorderFlush (rec) == 0);
+  assert (lFileSize() == 16);
+  assert (iSerialRecorderWrite (rec, 0, SERIAL_REC_RX, "abc", 3) == 0);
+  assert (iSerialRecorderFlush (rec) == 0);
+  end[0] = lFileSize();
+  assert (iSerialRecorderWrite (rec, 3, SERIAL_REC_TX, NULL, 0) == 0);
+  assert (iSerialRecorderFlush (rec) == 0);
+  end[1] = lFileSize();
+  vSleepMs (30);
+  assert (iSerialRecorderWrite (rec, 7, SERIAL_REC_RX, big, BIG_SIZE) == 0);
+  assert (iSerialRecorderFlush (rec) == 0);
+  end[2] = lFileSize();
+  assert (iSerialRecorderWrite (rec, 200, SERIAL_REC_TX, text, sizeof (text) - 1) == 0);
+  assert (iSerialRecorderDelete (rec) == 0);
+  end[3] = lFileSize();
+
+  assert (iReplay (0, &r, 0) == 4);
+  assert ( (r.block[0].port == 0) && (r.block[0].dir == SERIAL_REC_RX));
+  assert ( (r.block[0].len == 3) && (memcmp (r.block[0].data, "abc", 3) == 0));
+  assert ( (r.block[1].port == 3) && (r.block[1].dir == SERIAL_REC_TX));
+  assert (r.block[1].len == 0);
+  assert ( (r.block[2].port == 7) && (r.block[2].dir == SERIAL_REC_RX));
+  assert ( (r.block[2].len == BIG_SIZE) && (memcmp (r.block[2].data, big, BIG_SIZE) == 0));
+  assert ( (r.block[3].port == 200) && (r.block[3].dir == SERIAL_REC_TX));
+  assert ( (r.block[3].len == sizeof (text) - 1) &&
+           (memcmp (r.block[3].data, text, sizeof (text) - 1) == 0));
+  printf ("Round trip: Success\n");
+
+  // Le silence entre deux blocs est reproduit, divisé par la vitesse
+  assert (iReplay (1, &r, 0) == 4);
+  assert (dElapsed (&r.block[1].t, &r.block[2].t) >= 0.030);
+  assert (iReplay (2, &r, 0) == 4);
+  assert (dElapsed (&r.block[1].t, &r.block[2].t) >= 0.015);
+  printf ("Replay speed: Success\n");
+
+  // Une valeur négative de la fonction arrête la relecture
+  errno = 0;
+  assert (iReplay (0, &r, 2) == -1);
+  assert ( (errno == ECANCELED) && (r.count == 2));
+  printf ("Callback stop: Success\n");
+
+  // Un journal tronqué est relu jusqu'au dernier bloc complet
+  {
+    uint8_t * buf = malloc (end[3]);
+    FILE * f = fopen (path, "rb");
+
+    assert (buf && f);
+    assert (fread (buf, 1, end[3], f) == (size_t) end[3]);
+    fclose (f);
+
+    for (off_t len = 0; len < end[3]; len++) {
+      int expected = 0;
+
+      vWriteFile (buf, len);
+      if (len < 16) {
+
+        assert ( (iReplay (0, &r, 0) == -1) && (errno == EILSEQ));
+        continue;
+      }
+      for (int i = 0; i < 4; i++) {
+
+        if (len >= end[i]) {
+
+          expected = i + 1;
+        }
+      }
+      assert (iReplay (0, &r, 0) == expected);
+    }
+
+    // en-tête incorrect
+    buf[0] = 'X';
+    vWriteFile (buf, end[3]);
+    assert ( (iReplay (0, &r, 0) == -1) && (errno == EILSEQ));
+    free (buf);
+  }
+  printf ("Truncation: Success\n");
+
+  // Une longueur de bloc démesurée est une erreur, même si le fichier est
+  // plus court
+  {
+    // en-tête, dt = 0, port 0 RX, longueur = 16 Mo + 1 (LEB128)
+    static const uint8_t huge[] = { 'S', 'Y', 'S', 'I', 'O', 'R', 'E', 'C',
+                                    0, 0, 0, 0, 0, 0, 0, 0,
+                                    0x00, 0x00, 0x81, 0x80, 0x80, 0x08
+                                  };
+    vWriteFile (huge, sizeof (huge));
+    assert ( (iReplay (0, &r, 0) == -1) && (errno == EILSEQ));
+  }
+  printf ("Oversized block: Success\n");
+
+  // Transmission enregistrée, le numéro de port est le descripteur
+  {
+    int p[2];
+    char buf[8];
+
+    assert (pipe (p) == 0);
+    rec = xSerialRecorderNew (path);
+    assert (rec);
+    assert (iSerialRecordedWrite (rec, p[1], "hello", 5) == 5);
+    assert (iSerialRecordedWrite (NULL, p[1], "!", 1) == 1);
+    assert (read (p[0], buf, sizeof (buf)) == 6);
+    assert (memcmp (buf, "hello!", 6) == 0);
+    close (p[1]);
+    assert (iSerialRecordedWrite (rec, p[1], "x", 1) < 0);
+    close (p[0]);
+    assert (iSerialRecorderDelete (rec) == 0);
+
+    assert (iReplay (0, &r, 0) == 1);
+    assert ( (r.block[0].port == (unsigned) p[1]) && (r.block[0].dir == SERIAL_REC_TX));
+    assert ( (r.block[0].len == 5) && (memcmp (r.block[0].data, "hello", 5) == 0));
+  }
+  printf ("Recorded write: Success\n");
+
+  // Plusieurs threads enregistrent en même temps : aucun bloc n'est perdu ni
+  // mélangé, l'ordre de chaque thread est conservé
+  {
+    pthread_t th[THREADS];
+    xThreadCheck c;
+
+    rec = xSerialRecorderNew (path);
+    assert (rec);
+    for (uintptr_t i = 0; i < THREADS; i++) {
+
+      assert (pthread_create (&th[i], NULL, pvRecorder, (void *) i) == 0);
+    }
+    for (int i = 0; i < THREADS; i++) {
+
+      pthread_join (th[i], NULL);
+    }
+    assert (iSerialRecorderDelete (rec) == 0);
+
+    memset (&c, 0, sizeof (c));
+    assert (iSerialReplay (path, 0, iThreadCheck, &c) == THREADS * THREAD_BLOCKS);
+    assert (c.count == THREADS * THREAD_BLOCKS);
+  }
+  printf ("Concurrent writers: Success\n");
+
+  // Relecture vers un pseudo-terminal : seuls les octets reçus du port
+  // choisi sont transmis, sans traduction par la discipline de ligne
+  {
+    xSerialIos ios = { .baud = 115200, .dbits = SERIAL_DATABIT_8,
+                       .parity = SERIAL_PARITY_NONE, .sbits = SERIAL_STOPBIT_ONE,
+                       .flow = SERIAL_FLOW_NONE
+                     };
+    char name[64];
+    char buf[64];
+    size_t len = 0;
+    int master, slave;
+
+    rec = xSerialRecorderNew (path);
+    assert (rec);
+    assert (iSerialRecorderWrite (rec, 1, SERIAL_REC_RX, text, sizeof (text) - 1) == 0);
+    assert (iSerialRecorderWrite (rec, 2, SERIAL_REC_RX, "other", 5) == 0);
+    assert (iSerialRecorderWrite (rec, 1, SERIAL_REC_TX, "sent", 4) == 0);
+    assert (iSerialRecorderWrite (rec, 1, SERIAL_REC_RX, "end", 3) == 0);
+    assert (iSerialRecorderDelete (rec) == 0);
+
+    master = iSerialOpenPty (name, sizeof (name));
+    assert (master >= 0);
+    slave = iSerialOpen (name, &ios);
+    assert (slave >= 0);
+
+    assert (iSerialReplayToFd (path, 1, 0, master) == 4);
+    while (len < sizeof (text) - 1 + 3) {
+      struct pollfd pfd = { .fd = slave, .events = POLLIN };
+      ssize_t n;
+
+      assert (poll (&pfd, 1, 1000) == 1);
+      n = read (slave, buf + len, sizeof (buf) - len);
+      assert (n > 0);
+      len += n;
+    }
+    assert (memcmp (buf, text, sizeof (text) - 1) == 0);
+    assert (memcmp (buf + sizeof (text) - 1, "end", 3) == 0);
+
+    // tous les ports
+    assert (iSerialReplayToFd (path, -1, 0, master) == 4);
+    len = 0;
+    while (len < sizeof (text) - 1 + 5 + 3) {
+      struct pollfd pfd = { .fd = slave, .events = POLLIN };
+      ssize_t n;
+
+      assert (poll (&pfd, 1, 1000) == 1);
+      n = read (slave, buf + len, sizeof (buf) - len);
+      assert (n > 0);
+      len += n;
+    }
+    assert (memcmp (buf + sizeof (text) - 1, "otherend", 8) == 0);
+
+    vSerialClose (slave);
+    close (master);
+
+    // erreur d'écriture sur le descripteur
+    assert (iSerialReplayToFd (path, 1, 0, master) == -1);
+    assert (errno == EBADF);
+  }
+  printf ("Replay to pty: Success\n");
+
+  unlink (path);
+  printf ("All tests passed !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,140 @@
+/**
+ * @file test/softbus/i2c/sysio_test_softbus_i2c.cpp
+ * @brief Test du maître I2C logiciel (SoftI2c) sur le GPIO simulé
+ *
+ * Aucun esclave n'est présent : le niveau des lignes relâchées est fixé par
+ * les résistances de tirage simulées. Une résistance de tirage à l'état bas
+ * sur SDA simule un esclave qui acquitte tout et renvoie des zéros, sur SCL
+ * un esclave qui allonge indéfiniment l'horloge.
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <iostream>
+#include <system_error>
+#include <cassert>
+#include <cerrno>
+#include <sysio/gpio.h>
+#include <sysio/gpiosofti2c.h>
+#include <sysio/i2c.h>
+
+using namespace std;
+using namespace Sysio;
+
+/* constants ================================================================ */
+static const int sclPin = 23;
+static const int sdaPin = 24;
+static const int slaveAddr = 0x50;
+static const char device[] = "/dev/i2c-soft-test";
+
+/* private functions ======================================================== */
+// -----------------------------------------------------------------------------
+// Code d'erreur de l'exception déclenchée par f, 0 si aucune
+template <class F> static int
+errorOf (F f) {
+
+  try {
+
+    f();
+  }
+  catch (system_error & e) {
+
+    return e.code().value();
+  }
+  return 0;
+}
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  Gpio g (AccessLayerIoMap, true);
+  uint8_t buf[4] = { 0xA5, 0x5A, 0xFF, 0x00 };
+
+  cout << "Software I2C test" << endl;
+  g.open();
+  assert (g.isOpen());
+  g.setNumbering (Pin::NumberingMcu);
+
+  Pin & scl = g.pin (sclPin);
+  Pin & sda = g.pin (sdaPin);
+  SoftI2c bus (scl, sda);
+
+  // Les lignes sont relâchées (entrées tirées à l'état haut) au repos
+  assert (scl.mode() == Pin::ModeInput && scl.pull() == Pin::PullUp);
+  assert (sda.mode() == Pin::ModeInput && sda.pull() == Pin::PullUp);
+  assert (scl.read() && sda.read());
+  cout << "Idle bus: Success" << endl;
+
+  // Bus vide : l'adresse n'est pas acquittée, la transaction se termine
+  // par une condition d'arrêt
+  bus.setSpeed (0);
+  assert (!bus.probe (slaveAddr));
+  assert (errorOf ([&]() { bus.write (slaveAddr, buf, 2); }) == ENXIO);
+  assert (errorOf ([&]() { bus.read (slaveAddr, buf, 2); }) == ENXIO);
+  assert (scl.read() && sda.read());
+  assert (scl.mode() == Pin::ModeInput && sda.mode() == Pin::ModeInput);
+  cout << "Address NACK: Success" << endl;
+
+  // SDA maintenue à l'état bas : chaque bit est acquitté, les octets lus
+  // sont nuls et le dernier octet lu n'est pas acquitté par le maître
+  sda.setPull (Pin::PullDown);
+  assert (bus.probe (slaveAddr));
+  buf[0] = buf[1] = 0xFF;
+  bus.readRegBlock (slaveAddr, 0x10, buf, 2);
+  assert (buf[0] == 0 && buf[1] == 0);
+  sda.setPull (Pin::PullUp);
+  cout << "Acknowledge: Success" << endl;
+
+  // SCL maintenue à l'état bas par un esclave : délai d'allongement dépassé
+  bus.setStretchTimeout (1000);
+  assert (bus.stretchTimeout() == 1000);
+  scl.setPull (Pin::PullDown);
+  assert (errorOf ([&]() { bus.write (slaveAddr, buf, 1); }) == ETIMEDOUT);
+  scl.setPull (Pin::PullUp);
+  // le bus reste utilisable
+  assert (!bus.probe (slaveAddr));
+  cout << "Clock stretching timeout: Success" << endl;
+
+  // Accès par le module I2C
+  bus.registerDevice (device);
+  assert (bus.device() == device);
+  int fd = iI2cOpen (device, slaveAddr);
+  assert (fd >= 0);
+  errno = 0;
+  assert ( (iI2cWrite (fd, 0x55) < 0) && (errno == ENXIO));
+
+  xI2cMsg msgs[43];
+  for (int i = 0; i < 43; i++) {
+
+    msgs[i].addr = slaveAddr;
+    msgs[i].flags = 0;
+    msgs[i].len = 1;
+    msgs[i].buf = buf;
+  }
+  errno = 0;
+  assert ( (iI2cTransfer (fd, msgs, 0) < 0) && (errno == EINVAL));
+  errno = 0;
+  assert ( (iI2cTransfer (fd, msgs, 43) < 0) && (errno == EINVAL));
+  errno = 0;
+  assert ( (iI2cTransfer (fd, msgs, 42) < 0) && (errno == ENXIO));
+
+  sda.setPull (Pin::PullDown);
+  assert (iI2cTransfer (fd, msgs, 2) == 2);
+  assert (iI2cReadReg8 (fd, 0x10) == 0);
+  sda.setPull (Pin::PullUp);
+  cout << "I2C module: Success" << endl;
+
+  // Un descripteur ouvert sur un bus retiré renvoie une erreur
+  bus.unregisterDevice();
+  assert (bus.device().empty());
+  errno = 0;
+  assert ( (iI2cWrite (fd, 0x55) < 0) && (errno == ENODEV));
+  assert (iI2cClose (fd) == 0);
+  assert (iI2cOpen (device, slaveAddr) < 0);
+  cout << "Unregister: Success" << endl;
+
+  g.close();
+  cout << "All tests passed !" << endl;
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,147 @@
+/**
+ * @file test/softbus/spi/sysio_test_softbus_spi.cpp
+ * @brief Test du maître SPI logiciel (SoftSpi) sur le GPIO simulé
+ *
+ * Aucun esclave n'est présent : MISO est une entrée dont le niveau est fixé
+ * par la résistance de tirage simulée. L'état des lignes est vérifié après
+ * chaque transfert (niveau de repos de l'horloge, sélection, dernier bit
+ * émis sur MOSI).
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <iostream>
+#include <stdexcept>
+#include <cassert>
+#include <cerrno>
+#include <sysio/gpio.h>
+#include <sysio/gpiosoftspi.h>
+#include <sysio/spi.h>
+
+using namespace std;
+using namespace Sysio;
+
+/* constants ================================================================ */
+static const int sclkPin = 11;
+static const int mosiPin = 10;
+static const int misoPin = 9;
+static const int csPin = 8;
+static const char device[] = "/dev/spidev-soft-test";
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  Gpio g (AccessLayerIoMap, true);
+  uint8_t tx[3] = { 0x01, 0x80, 0xA5 };
+  uint8_t rx[3];
+
+  cout << "Software SPI test" << endl;
+  g.open();
+  assert (g.isOpen());
+  g.setNumbering (Pin::NumberingMcu);
+
+  Pin & sclk = g.pin (sclkPin);
+  Pin & mosi = g.pin (mosiPin);
+  Pin & miso = g.pin (misoPin);
+  Pin & cs = g.pin (csPin);
+  SoftSpi bus (sclk, mosi, &miso, &cs);
+
+  // Au repos : horloge basse (mode 0), circuit non sélectionné
+  assert (sclk.mode() == Pin::ModeOutput && mosi.mode() == Pin::ModeOutput);
+  assert (cs.mode() == Pin::ModeOutput && miso.mode() == Pin::ModeInput);
+  assert (!sclk.read() && cs.read());
+  cout << "Idle lines: Success" << endl;
+
+  // Les octets lus suivent le niveau de MISO
+  bus.setSpeed (0);
+  miso.setPull (Pin::PullUp);
+  assert (bus.xfer (tx, rx, 3) == 3);
+  assert (rx[0] == 0xFF && rx[1] == 0xFF && rx[2] == 0xFF);
+  miso.setPull (Pin::PullDown);
+  assert (bus.read (rx, 3) == 3);
+  assert (rx[0] == 0 && rx[1] == 0 && rx[2] == 0);
+  assert (!sclk.read() && cs.read());
+  cout << "MISO sampling: Success" << endl;
+
+  // Ordre des bits : le dernier bit émis reste sur MOSI
+  assert (bus.write (&tx[0], 1) == 1); // 0x01, MSB en premier
+  assert (mosi.read());
+  assert (bus.write (&tx[1], 1) == 1); // 0x80
+  assert (!mosi.read());
+  bus.setLsbFirst (true);
+  assert (bus.lsbFirst());
+  assert (bus.write (&tx[0], 1) == 1);
+  assert (!mosi.read());
+  assert (bus.write (&tx[1], 1) == 1);
+  assert (mosi.read());
+  bus.setLsbFirst (false);
+  cout << "Bit order: Success" << endl;
+
+  // Niveau de repos de l'horloge selon CPOL, modes invalides refusés
+  for (int m = 0; m < 4; m++) {
+
+    bus.setMode (m);
+    assert (bus.mode() == m);
+    assert (sclk.read() == ( (m & SPI_CPOL) != 0));
+    assert (bus.xfer (tx, rx, 3) == 3);
+    assert (sclk.read() == ( (m & SPI_CPOL) != 0));
+    assert (cs.read());
+  }
+  try {
+
+    bus.setMode (4);
+    assert (false);
+  }
+  catch (invalid_argument & e) {
+
+    assert (bus.mode() == 3);
+  }
+  bus.setMode (0);
+  cout << "Clock polarity: Success" << endl;
+
+  // Accès par le module SPI
+  xSpiIos ios;
+
+  bus.registerDevice (device);
+  assert (bus.device() == device);
+  int fd = iSpiOpen (device);
+  assert (fd >= 0);
+
+  ios.mode = eSpiMode2;
+  ios.lsb = eSpiNumberingLsb;
+  ios.bits = eSpiBits8;
+  ios.speed = 500000;
+  assert (iSpiSetConfig (fd, &ios) == 0);
+  assert (bus.mode() == 2 && bus.lsbFirst() && bus.speed() == 500000);
+  assert (iSpiGetConfig (fd, &ios) == 0);
+  assert (ios.mode == eSpiMode2 && ios.lsb == eSpiNumberingLsb && ios.speed == 500000);
+  assert (sclk.read());
+
+  ios.bits = eSpiBits7;
+  errno = 0;
+  assert ( (iSpiSetConfig (fd, &ios) < 0) && (errno == EINVAL));
+
+  ios.mode = eSpiMode0;
+  ios.lsb = eSpiNumberingMsb;
+  ios.bits = eSpiBits8;
+  ios.speed = 0;
+  assert (iSpiSetConfig (fd, &ios) == 0);
+  miso.setPull (Pin::PullUp);
+  assert (iSpiXfer (fd, tx, 2, rx, 2) >= 0);
+  assert (rx[0] == 0xFF && rx[1] == 0xFF);
+  assert (cs.read());
+  cout << "SPI module: Success" << endl;
+
+  // Un descripteur ouvert sur un bus retiré renvoie une erreur
+  bus.unregisterDevice();
+  assert (bus.device().empty());
+  errno = 0;
+  assert ( (iSpiXfer (fd, tx, 1, rx, 1) < 0) && (errno == ENODEV));
+  assert (iSpiClose (fd) == 0);
+  cout << "Unregister: Success" << endl;
+
+  g.close();
+  cout << "All tests passed !" << endl;
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,200 @@
+/**
+ * @file
+ * @brief GPIO benchmark
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <system_error>
+#include <unistd.h>
+#include <sched.h>
+#include <sysio/gpio.h>
+#include <sysio/scheduler.h>
+#include "bench.h"
+
+using namespace std;
+using namespace Sysio;
+
+/* private functions ======================================================== */
+void usage ();
+vector<string> split (const string& s, char seperator);
+
+/* main ===================================================================== */
+int
+main (int argc, char **argv) {
+  int opt;
+  int ret = 0;
+  bool simulated = false;
+  bool json = false;
+  Pin::Numbering numbering = Pin::NumberingLogical;
+  unsigned long count = 0;
+  int priority = -1;
+  int cpu = -1;
+  string output;
+  vector<string> layers;
+  Gpio * gpio = 0;
+
+  try {
+    /* Traitement options ligne de commande */
+    while ( (opt = getopt (argc, argv, "sjgn:l:p:a:o:h")) != -1) {
+
+      switch (opt) {
+
+        case 's':
+          simulated = true;
+          break;
+
+        case 'j':
+          json = true;
+          break;
+
+        case 'g':
+          numbering = Pin::NumberingMcu;
+          break;
+
+        case 'n':
+          count = stoul (string (optarg));
+          break;
+
+        case 'l':
+          layers = split (string (optarg), ',');
+          break;
+
+        case 'p':
+          priority = stoi (string (optarg));
+          break;
+
+        case 'a':
+          cpu = stoi (string (optarg));
+          break;
+
+        case 'o':
+          output = optarg;
+          break;
+
+        case 'h':
+          usage();
+          exit (EXIT_SUCCESS);
+          break;
+
+        default:
+          /* An invalid option has been used, exit with code EXIT_FAILURE */
+          exit (EXIT_FAILURE);
+          break;
+      }
+    }
+
+    if (optind >= argc)    {
+
+      throw invalid_argument ("output pin number expected");
+    }
+
+    if (cpu >= 0) {
+      cpu_set_t set;
+
+      CPU_ZERO (&set);
+      CPU_SET (cpu, &set);
+      if (sched_setaffinity (0, sizeof (set), &set) < 0) {
+
+        throw system_error (errno, system_category(), "sched_setaffinity");
+      }
+    }
+    if (priority >= 0) {
+
+      Scheduler::setRtPriority (priority);
+    }
+
+    // le constructeur par défaut tient compte de SYSIO_GPIO_SIM
+    gpio = simulated ? new Gpio (AccessLayerAuto, true) : new Gpio();
+    gpio->setNumbering (numbering);
+    gpio->open();
+
+    Pin * out = &gpio->pin (stoi (string (argv[optind])));
+    Pin * in = 0;
+    if ( (argc - optind) > 1) {
+
+      in = &gpio->pin (stoi (string (argv[optind + 1])));
+    }
+
+    Bench b (gpio, out, in);
+    if (count) {
+
+      b.setIterations (count, count / 10 + 1);
+    }
+    b.run (layers);
+
+    if (output.empty()) {
+
+      json ? b.printJson (cout) : b.print (cout);
+    }
+    else {
+
+      // le fichier de sortie est créé avec les droits de l'utilisateur réel
+      if ( (setgid (getgid()) < 0) || (setuid (getuid()) < 0)) {
+
+        throw system_error (errno, system_category(), "setuid");
+      }
+      ofstream f (output);
+
+      json ? b.printJson (f) : b.print (f);
+    }
+  }
+  catch (exception& e) {
+
+    cerr << __progname << ": " << e.what() << " !" << endl;
+    ret = -1;
+  }
+
+  if (gpio) {
+
+    delete gpio;
+  }
+
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+vector<string>
+split (const string& s, char seperator) {
+  vector<string> output;
+  string::size_type prev_pos = 0, pos = 0;
+
+  while ( (pos = s.find (seperator, pos)) != string::npos) {
+
+    string substring (s.substr (prev_pos, pos - prev_pos));
+    output.push_back (substring);
+    prev_pos = ++pos;
+  }
+
+  output.push_back (s.substr (prev_pos, pos - prev_pos)); // Last word
+  return output;
+}
+
+// -----------------------------------------------------------------------------
+void
+usage () {
+  cout << "usage : " << __progname << " [ options ] <pin> [irqpin]" << endl;;
+  //       01234567890123456789012345678901234567890123456789012345678901234567890123456789
+  cout << "Measures the cost of the GPIO accesses for each access layer." << endl;
+  cout << "pin is set as output, it is toggled, written and read. If irqpin is provided," << endl;
+  cout << "it must be connected to pin and the edge-to-callback latency is measured." << endl << endl;
+
+  //       01234567890123456789012345678901234567890123456789012345678901234567890123456789
+  cout << "valid options are :" << endl;
+  cout << "  -s\tUse the simulated GPIO. On a machine without GPIO, SYSIO_GPIO_SIM=1" << endl;
+  cout << "    \tmust be set in the environment instead." << endl;
+  cout << "  -g\tUse the SOC pins numbers rather than SysIo pin numbers." << endl;
+  cout << "  -n count\tNumber of toggles and writes (reads: count/10)." << endl;
+  cout << "  -l layers\tComma separated list of layers (iomap,sysfs,chardev)." << endl;
+  cout << "  -p prio\tRun with the given real-time priority (1-99)." << endl;
+  cout << "  -a cpu\tRun on the given CPU only." << endl;
+  cout << "  -j\tOutput the results in JSON." << endl;
+  cout << "  -o file\tWrite the results to file." << endl;
+  cout << "  -h\tPrint this message and exit" << endl << endl;
+}
+/* ========================================================================== */
@@ -0,0 +1,407 @@
+/**
+ * @file
+ * @brief gpio utility benchmark
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <time.h>
+#include <sched.h>
+#include "bench.h"
+
+using namespace std;
+using namespace Sysio;
+
+/* constants ================================================================ */
+static const vector<string> allLayers = {"iomap", "sysfs", "chardev"};
+static const int irqTimeoutMs = 100;
+
+// -----------------------------------------------------------------------------
+static const char *
+policyName() {
+  int policy = sched_getscheduler (0);
+
+  return policy == SCHED_FIFO ? "fifo" : (policy == SCHED_RR ? "rr" : "other");
+}
+
+// -----------------------------------------------------------------------------
+// Chaîne JSON entre guillemets, les messages d'erreur (e.what()) peuvent
+// contenir des guillemets, des barres obliques inverses ou des caractères de
+// contrôle
+static string
+jsonString (const string & s) {
+  ostringstream os;
+
+  os << '"';
+  for (unsigned char c : s) {
+
+    switch (c) {
+      case '"':
+        os << "\\\"";
+        break;
+      case '\\':
+        os << "\\\\";
+        break;
+      case '\n':
+        os << "\\n";
+        break;
+      case '\r':
+        os << "\\r";
+        break;
+      case '\t':
+        os << "\\t";
+        break;
+      default:
+        if (c < 0x20) {
+
+          os << "\\u" << hex << setw (4) << setfill ('0') << static_cast<int> (c)
+             << dec << setfill (' ');
+        }
+        else {
+
+          os << c;
+        }
+        break;
+    }
+  }
+  os << '"';
+  return os.str();
+}
+
+// -----------------------------------------------------------------------------
+Bench::Stats::Stats() :
+  count (0), mean (0), min (0), p50 (0), p90 (0), p99 (0), max (0) {
+}
+
+// -----------------------------------------------------------------------------
+Bench::Stats::Stats (vector<uint64_t> & samples) : Stats() {
+
+  count = samples.size();
+  if (count) {
+    double sum = 0;
+
+    sort (samples.begin(), samples.end());
+    for (auto s : samples) {
+      sum += s;
+    }
+    mean = sum / count;
+    min = samples.front();
+    p50 = samples[ (count - 1) * 50 / 100];
+    p90 = samples[ (count - 1) * 90 / 100];
+    p99 = samples[ (count - 1) * 99 / 100];
+    max = samples.back();
+  }
+}
+
+// -----------------------------------------------------------------------------
+Bench::Bench (Gpio * gpio, Pin * out, Pin * in) :
+  _gpio (gpio), _out (out), _in (in), _toggles (100000), _samples (10000),
+  _clockOverhead (0), _irqLayer ("none") {
+}
+
+// -----------------------------------------------------------------------------
+void
+Bench::setIterations (unsigned long toggles, unsigned long samples) {
+
+  _toggles = toggles;
+  _samples = samples;
+}
+
+// -----------------------------------------------------------------------------
+uint64_t
+Bench::now() {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+void
+Bench::run (const vector<string> & layers) {
+  const vector<string> & l = layers.empty() ? allLayers : layers;
+
+  // coût de la lecture de l'horloge, retranché des latences
+  _clockOverhead = UINT64_MAX;
+  for (int i = 0; i < 1000; i++) {
+    uint64_t t = now();
+
+    _clockOverhead = std::min (_clockOverhead, now() - t);
+  }
+
+  _result.clear();
+  for (const auto & layer : l) {
+    Result r;
+
+    r.layer = layer;
+    r.togglesPerSec = 0;
+    r.writesPerSec = 0;
+    try {
+
+      if (selectLayer (_out, layer)) {
+
+        measureLayer (r);
+      }
+      else {
+
+        r.error = "layer not available";
+      }
+    }
+    catch (exception & e) {
+
+      r.error = e.what();
+    }
+    _result.push_back (r);
+  }
+  selectLayer (_out, "iomap");
+
+  if (_in) {
+
+    measureInterrupt();
+  }
+}
+
+// -----------------------------------------------------------------------------
+bool
+Bench::selectLayer (Pin * pin, const string & layer) {
+
+  if (layer == "iomap") {
+
+    if ( (_gpio->accessLayer() & AccessLayerIoMap) == 0) {
+
+      return false;
+    }
+    pin->forceUseSysFs (false);
+    pin->forceUseCharDev (false);
+    return !pin->useSysFs() && !pin->useCharDev();
+  }
+  if (layer == "sysfs") {
+
+    if ( (_gpio->accessLayer() & AccessLayerSysFs) == 0) {
+
+      return false;
+    }
+    return pin->forceUseSysFs (true);
+  }
+  if (layer == "chardev") {
+
+    if ( (_gpio->accessLayer() & AccessLayerCharDev) == 0) {
+
+      return false;
+    }
+    return pin->forceUseCharDev (true);
+  }
+  throw invalid_argument ("unknown access layer " + layer);
+}
+
+// -----------------------------------------------------------------------------
+void
+Bench::measureLayer (Result & r) {
+  vector<uint64_t> samples;
+  uint64_t t;
+
+  _out->setMode (Pin::ModeOutput);
+
+  t = now();
+  for (unsigned long i = 0; i < _toggles; i++) {
+
+    _out->toggle();
+  }
+  t = now() - t;
+  r.togglesPerSec = t ? (_toggles * 1e9) / t : 0;
+
+  t = now();
+  for (unsigned long i = 0; i < _toggles; i++) {
+
+    _out->write (i & 1);
+  }
+  t = now() - t;
+  r.writesPerSec = t ? (_toggles * 1e9) / t : 0;
+
+  samples.reserve (_samples);
+  for (unsigned long i = 0; i < _samples; i++) {
+    uint64_t t1, t2;
+    bool v;
+
+    t1 = now();
+    v = _out->read();
+    t2 = now() - t1;
+    (void) v;
+    samples.push_back (t2 > _clockOverhead ? t2 - _clockOverhead : 0);
+  }
+  r.read = Stats (samples);
+}
+
+// -----------------------------------------------------------------------------
+void
+Bench::measureInterrupt() {
+  mutex m;
+  condition_variable cv;
+  uint64_t tcb = 0, tev = 0;
+  bool done = false;
+  vector<uint64_t> cbSamples, evSamples;
+  unsigned long samples = std::min (_samples, 1000UL);
+
+  _irqError.clear();
+  try {
+
+    if ( (_gpio->accessLayer() & (AccessLayerSysFs | AccessLayerCharDev)) == 0) {
+
+      throw runtime_error ("interrupts need the sysfs or chardev access layer");
+    }
+    _out->setMode (Pin::ModeOutput);
+    _in->setMode (Pin::ModeInput);
+    _in->attachInterrupt ([&] (Pin &, Pin::Edge, uint64_t timestamp_ns) {
+      uint64_t t = now();
+      lock_guard<mutex> lock (m);
+
+      tcb = t;
+      tev = timestamp_ns;
+      done = true;
+      cv.notify_one();
+    }, Pin::EdgeBoth);
+    _irqLayer = _in->useCharDev() ? "chardev" : "sysfs";
+
+    for (unsigned long i = 0; i < samples; i++) {
+      unique_lock<mutex> lock (m);
+      uint64_t t0;
+
+      done = false;
+      t0 = now();
+      _out->toggle();
+      if (!cv.wait_for (lock, chrono::milliseconds (irqTimeoutMs), [&] { return done; })) {
+
+        throw runtime_error ("no edge received, is the output pin connected to the input pin ?");
+      }
+      cbSamples.push_back (tcb - t0);
+      evSamples.push_back (tev > t0 ? tev - t0 : 0);
+    }
+  }
+  catch (exception & e) {
+
+    _irqError = e.what();
+  }
+  _in->detachInterrupt();
+  _irqCallback = Stats (cbSamples);
+  _irqKernel = Stats (evSamples);
+}
+
+// -----------------------------------------------------------------------------
+void
+Bench::printStats (ostream & os, const string & name, const Stats & s) {
+
+  os << "  " << left << setw (12) << name << right
+     << " mean " << setw (9) << fixed << setprecision (0) << s.mean
+     << "  p50 " << setw (9) << s.p50
+     << "  p90 " << setw (9) << s.p90
+     << "  p99 " << setw (9) << s.p99
+     << "  max " << setw (9) << s.max << " ns" << endl;
+}
+
+// -----------------------------------------------------------------------------
+void
+Bench::print (ostream & os) const {
+  struct sched_param sp;
+
+  sched_getparam (0, &sp);
+  os << "board: " << _gpio->name() << ", pin: " << _out->name()
+     << ", cpu: " << sched_getcpu()
+     << ", policy: " << policyName()
+     << ", priority: " << sp.sched_priority << endl;
+  os << "clock overhead: " << _clockOverhead << " ns (subtracted from latencies)" << endl;
+
+  for (const auto & r : _result) {
+
+    os << r.layer << ":" << endl;
+    if (!r.error.empty()) {
+
+      os << "  skipped (" << r.error << ")" << endl;
+      continue;
+    }
+    os << fixed << setprecision (0)
+       << "  toggle       " << setw (12) << r.togglesPerSec << " /s" << endl
+       << "  write        " << setw (12) << r.writesPerSec << " /s" << endl;
+    printStats (os, "read", r.read);
+  }
+
+  if (_in) {
+
+    os << "interrupt (" << _irqLayer << ", pin " << _in->name() << "):" << endl;
+    if (!_irqError.empty()) {
+
+      os << "  failed (" << _irqError << ")" << endl;
+    }
+    if (_irqCallback.count) {
+
+      printStats (os, "callback", _irqCallback);
+      printStats (os, "timestamp", _irqKernel);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void
+Bench::printJsonStats (ostream & os, const Stats & s) {
+
+  os << fixed << setprecision (1)
+     << "{\"count\": " << s.count << ", \"mean\": " << s.mean
+     << ", \"min\": " << s.min << ", \"p50\": " << s.p50
+     << ", \"p90\": " << s.p90 << ", \"p99\": " << s.p99
+     << ", \"max\": " << s.max << "}";
+}
+
+// -----------------------------------------------------------------------------
+void
+Bench::printJson (ostream & os) const {
+  struct sched_param sp;
+
+  sched_getparam (0, &sp);
+  os << "{" << endl
+     << "  \"board\": " << jsonString (_gpio->name()) << "," << endl
+     << "  \"pin\": " << jsonString (_out->name()) << "," << endl
+     << "  \"cpu\": " << sched_getcpu() << "," << endl
+     << "  \"policy\": " << jsonString (policyName()) << "," << endl
+     << "  \"priority\": " << sp.sched_priority << "," << endl
+     << "  \"clock_overhead_ns\": " << _clockOverhead << "," << endl
+     << "  \"layers\": {";
+
+  for (size_t i = 0; i < _result.size(); i++) {
+    const Result & r = _result[i];
+
+    os << (i ? "," : "") << endl << "    " << jsonString (r.layer) << ": ";
+    if (!r.error.empty()) {
+
+      os << "{\"error\": " << jsonString (r.error) << "}";
+      continue;
+    }
+    os << fixed << setprecision (1)
+       << "{\"toggles_per_sec\": " << r.togglesPerSec
+       << ", \"writes_per_sec\": " << r.writesPerSec
+       << ", \"read_ns\": ";
+    printJsonStats (os, r.read);
+    os << "}";
+  }
+  os << endl << "  }";
+
+  if (_in) {
+
+    os << "," << endl << "  \"interrupt\": {\"layer\": " << jsonString (_irqLayer);
+    if (!_irqError.empty()) {
+
+      os << ", \"error\": " << jsonString (_irqError);
+    }
+    os << ", \"callback_ns\": ";
+    printJsonStats (os, _irqCallback);
+    os << ", \"timestamp_ns\": ";
+    printJsonStats (os, _irqKernel);
+    os << "}";
+  }
+  os << endl << "}" << endl;
+}
+/* ========================================================================== */
@@ -0,0 +1,77 @@
+/**
+ * @file
+ * @brief gpio utility benchmark
+ *
+ * Copyright © 2018 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _SYSIO_UTILS_GPIO_BENCH_H_
+#define _SYSIO_UTILS_GPIO_BENCH_H_
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <sysio/gpio.h>
+
+// -----------------------------------------------------------------------------
+// Mesure du coût des accès aux broches pour chaque couche d'accès
+//
+// out est une broche placée en sortie, in (optionnelle) est une broche reliée
+// à out qui permet de mesurer le délai entre un front et l'exécution de la
+// routine d'interruption.
+class Bench {
+  public:
+    // Répartition des durées d'une série de mesures en nanosecondes
+    class Stats {
+      public:
+        Stats();
+        explicit Stats (std::vector<uint64_t> & samples);
+        unsigned long count;
+        double mean;
+        uint64_t min, p50, p90, p99, max;
+    };
+
+    // Résultats pour une couche d'accès
+    class Result {
+      public:
+        std::string layer;
+        std::string error; // vide si les mesures ont été effectuées
+        double togglesPerSec;
+        double writesPerSec;
+        Stats read;
+    };
+
+    Bench (Sysio::Gpio * gpio, Sysio::Pin * out, Sysio::Pin * in = 0);
+
+    // Nombre d'itérations des mesures de débit et de latence
+    void setIterations (unsigned long toggles, unsigned long samples);
+
+    // Exécute toutes les mesures, layers vide pour toutes les couches
+    void run (const std::vector<std::string> & layers = std::vector<std::string>());
+
+    void print (std::ostream & os) const;
+    void printJson (std::ostream & os) const;
+
+    static uint64_t now();
+
+  private:
+    Sysio::Gpio * _gpio;
+    Sysio::Pin * _out;
+    Sysio::Pin * _in;
+    unsigned long _toggles;
+    unsigned long _samples;
+    uint64_t _clockOverhead;
+    std::vector<Result> _result;
+    std::string _irqLayer;
+    std::string _irqError;
+    Stats _irqCallback; // front écrit -> routine exécutée
+    Stats _irqKernel;   // front écrit -> horodatage de l'événement
+
+    bool selectLayer (Sysio::Pin * pin, const std::string & layer);
+    void measureLayer (Result & r);
+    void measureInterrupt();
+    static void printStats (std::ostream & os, const std::string & name, const Stats & s);
+    static void printJsonStats (std::ostream & os, const Stats & s);
+};
+/* ========================================================================== */
+#endif /*_SYSIO_UTILS_GPIO_BENCH_H_ defined */
@@ -13,12 +13,14 @@
 #include <vector>
 #include <cstdlib>
 #include <csignal>
+#include <system_error>
 #include <unistd.h>
 #include <sysio/log.h>
 #include <sysio/delay.h>
 #include <sysio/gpio.h>
 #include <sysio/pwm.h>
 #include "exception.h"
+#include "bench.h"
 #include "version.h"
 
 using namespace std;
@@ -40,7 +42,12 @@ bool physicalNumbering = false;
 Pin * pin = 0;
 bool debug = false;
 bool forceSysFs = false;
+bool forceCharDev = false;
 int useSysFsBeforeWfi = -1;
+bool jsonOutput = false;
+Capture * logic = 0;
+SoftPwm * softpwm = 0;
+volatile sig_atomic_t stopRequested = 0;
 
 /* private functions ======================================================== */
 void mode (int argc, char * argv[]);
@@ -52,11 +59,15 @@ void blink (int argc, char * argv[]);
 void readall (int argc, char * argv[]);
 void wfi (int argc, char * argv[]);
 void pwm (int argc, char * argv[]); // TODO
+void bench (int argc, char * argv[]);
+void capture (int argc, char * argv[]);
+void spwm (int argc, char * argv[]);
 
 Pin * getPin (char * c_str);
 void usage ();
 void version ();
 void sig_handler (int sig);
+void realUser (bool enable);
 vector<string> split (const string& s, char seperator);
 
 /* main ===================================================================== */
@@ -75,12 +86,15 @@ main (int argc, char **argv) {
     {"blink", blink},
     {"wfi", wfi},
     {"readall", readall},
-    {"pwm", pwm} // TODO
+    {"pwm", pwm}, // TODO
+    {"bench", bench},
+    {"capture", capture},
+    {"softpwm", spwm}
   };
 
   try {
     /* Traitement options ligne de commande */
-    while ( (opt = getopt (argc, argv, "gs1dhfv")) != -1) {
+    while ( (opt = getopt (argc, argv, "gs1dhfcjv")) != -1) {
 
       switch (opt) {
 
@@ -104,6 +118,14 @@ main (int argc, char **argv) {
           forceSysFs = true;
           break;
 
+        case 'c':
+          forceCharDev = true;
+          break;
+
+        case 'j':
+          jsonOutput = true;
+          break;
+
         case 'h':
           usage();
           exit (EXIT_SUCCESS);
@@ -387,9 +409,9 @@ blink (int argc, char * argv[]) {
     if (paramc > 1)    {
 
       period = stoi (string (argv[optind + 1]));
-      if (pin->useSysFs() && period < 1) {
+      if ( (pin->useSysFs() || pin->useCharDev()) && period < 1) {
         period = 1;
-        cout << "Warning: Pin " << pin->name() << " uses SYSFS, the delay has been set to " << period << " ms (min.) !" << endl;
+        cout << "Warning: Pin " << pin->name() << " uses a kernel interface, the delay has been set to " << period << " ms (min.) !" << endl;
       }
     }
 
@@ -482,6 +504,209 @@ pwm (int argc, char * argv[]) {
 
 }
 
+/* -----------------------------------------------------------------------------
+  bench <pin> [irqpin] [count]
+    Measures toggles/s, writes/s and read latency of the given pin (output)
+    for each access layer. If irqpin is provided, it must be connected to pin
+    and the edge-to-callback latency is measured.
+ */
+void
+bench (int argc, char * argv[]) {
+  int paramc = (argc - optind);
+
+  if (paramc < 1) {
+
+    throw Exception (Exception::PinNumberExpected);
+  }
+  else {
+    Pin * in = 0;
+
+    gpio->setReleaseOnClose (true);
+    pin = getPin (argv[optind]);
+    if (paramc > 1) {
+
+      in = getPin (argv[optind + 1]);
+    }
+    Bench b (gpio, pin, in);
+    if (paramc > 2) {
+      unsigned long count = stoul (string (argv[optind + 2]));
+
+      b.setIterations (count, count / 10 + 1);
+    }
+
+    if (!jsonOutput) {
+
+      cout << "Running, please wait ..." << endl;
+    }
+    b.run();
+    if (jsonOutput) {
+
+      b.printJson (cout);
+    }
+    else {
+
+      b.print (cout);
+    }
+  }
+}
+
+/* -----------------------------------------------------------------------------
+  capture <pin[,pin...]> <rate> <count> [file]
+    Samples the given pins at rate Hz, count times. The result is written in
+    VCD to the standard output or to file, a file ending in .sr is written
+    as a sigrok session. Ctrl+C stops the capture and writes the samples.
+    The file is created with the rights of the real user (the utility is
+    installed SETUID root).
+ */
+void
+capture (int argc, char * argv[]) {
+  int paramc = (argc - optind);
+
+  if (paramc < 3) {
+
+    throw Exception (Exception::ArgumentExpected);
+  }
+  else {
+    vector<Pin *> pins;
+    string file;
+
+    for (auto & s : split (string (argv[optind]), ',')) {
+
+      pins.push_back (getPin (const_cast<char *> (s.c_str())));
+    }
+    double rate = stod (string (argv[optind + 1]));
+    uint64_t count = stoull (string (argv[optind + 2]));
+    if (paramc > 3) {
+
+      file = argv[optind + 3];
+    }
+
+    PinGroup group (pins);
+    Capture c (group);
+    c.setRate (rate);
+
+    // sig_handler() intercepte le CTRL+C et arrête la capture
+    logic = &c;
+    signal (SIGINT, sig_handler);
+    signal (SIGTERM, sig_handler);
+    cerr << "Capturing, press Ctrl+C to abort ..." << endl;
+    c.record (count);
+    logic = 0;
+
+    cerr << c.samples() << " samples, " << c.size() << " runs, "
+         << c.overruns() << " overruns" << (c.wrapped() ? ", buffer wrapped" : "") << endl;
+
+    if (file.empty()) {
+
+      c.writeVcd (cout);
+    }
+    else {
+
+      // le fichier est créé avec les droits de l'utilisateur réel
+      realUser (true);
+      try {
+
+        if ( (file.size() > 3) && (file.compare (file.size() - 3, 3, ".sr") == 0)) {
+
+          c.writeSigrok (file);
+        }
+        else {
+          ofstream f (file);
+
+          c.writeVcd (f);
+        }
+      }
+      catch (...) {
+
+        realUser (false);
+        throw;
+      }
+      realUser (false);
+    }
+  }
+}
+
+/* -----------------------------------------------------------------------------
+  softpwm <pin[,pin...]> <frequency> <duty>
+    Generates a software PWM on the given pins (explicitly sets the pins to
+    output), duty in percent. Runs until Ctrl+C.
+ */
+void
+spwm (int argc, char * argv[]) {
+  int paramc = (argc - optind);
+
+  if (paramc < 3) {
+
+    throw Exception (Exception::ArgumentExpected);
+  }
+  else {
+    SoftPwm p;
+
+    double frequency = stod (string (argv[optind + 1]));
+    double duty = stod (string (argv[optind + 2]));
+    if ( (duty < 0) || (duty > 100)) {
+
+      throw Exception (Exception::NotPwmValue, static_cast<int> (duty));
+    }
+
+    for (auto & s : split (string (argv[optind]), ',')) {
+
+      pin = getPin (const_cast<char *> (s.c_str()));
+      p.add (*pin, frequency, duty / 100);
+    }
+
+    // sig_handler() intercepte le CTRL+C et demande l'arrêt du PWM, les
+    // signaux sont bloqués hors de sigsuspend() pour qu'aucune demande ne
+    // soit perdue
+    sigset_t mask, orig;
+
+    sigemptyset (&mask);
+    sigaddset (&mask, SIGINT);
+    sigaddset (&mask, SIGTERM);
+    sigprocmask (SIG_BLOCK, &mask, &orig);
+    softpwm = &p;
+    signal (SIGINT, sig_handler);
+    signal (SIGTERM, sig_handler);
+    p.start();
+    cerr << "Running, press Ctrl+C to abort ..." << endl;
+    while (!stopRequested) {
+
+      sigsuspend (&orig);
+    }
+
+    // stop() attend la fin du thread, il ne peut être appelé par le
+    // gestionnaire de signal
+    p.stop();
+    softpwm = 0;
+    sigprocmask (SIG_SETMASK, &orig, NULL);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// sysio-gpio est installé SETUID root, les chemins fournis par l'utilisateur
+// doivent être accédés avec son uid réel, enable à false rétablit l'uid
+// effectif initial (uid sauvegardé)
+void
+realUser (bool enable) {
+  static uid_t euid = geteuid();
+  static gid_t egid = getegid();
+
+  if (enable) {
+
+    if ( (setegid (getgid()) < 0) || (seteuid (getuid()) < 0)) {
+
+      throw system_error (errno, system_category(), __FUNCTION__);
+    }
+  }
+  else {
+
+    if ( (seteuid (euid) < 0) || (setegid (egid) < 0)) {
+
+      throw system_error (errno, system_category(), __FUNCTION__);
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 vector<string>
 split (const string& s, char seperator) {
@@ -532,6 +757,10 @@ getPin (char * c_str) {
     p = &gpio->connector (connector)->pin (pinnumber);
   }
   p->forceUseSysFs (forceSysFs);
+  if (forceCharDev) {
+
+    p->forceUseCharDev (true);
+  }
   return p;
 }
 
@@ -539,6 +768,18 @@ getPin (char * c_str) {
 void
 sig_handler (int sig) {
 
+  if (logic) {
+
+    logic->stop();
+    return;
+  }
+
+  if (softpwm) {
+
+    stopRequested = 1;
+    return;
+  }
+
   if (gpio) {
 
     if (useSysFsBeforeWfi >= 0) {
@@ -573,6 +814,8 @@ usage () {
   cout << "  -g\tUse the SOC pins numbers rather than SysIo pin numbers." << endl;
   cout << "  -s\tUse the System pin numbers rather than SysIo pin numbers." << endl;
   cout << "  -f\tForce to use SysFS interface (/sys/class/gpio)." << endl;
+  cout << "  -c\tForce to use GPIO character device interface (/dev/gpiochipN)." << endl;
+  cout << "  -j\tOutput the results of the bench command in JSON." << endl;
   cout << "  -1\tUse the connector pin numbers rather than SysIo pin numbers." << endl;
   cout << "    \ta number is written in the form C.P, eg: 1.5 denotes pin 5 of connector #1." << endl;
   cout << "  -v\tOutput the current version including the board informations." << endl;
@@ -598,5 +841,13 @@ usage () {
   cout << "    Waits  for  the  interrupt  to happen. It's a non-busy wait." << endl;
   cout << "  pwm <pin> <value>" << endl;
   cout << "    Write a PWM value (0-1023) to the given pin (pwm pin only)." << endl;
+  cout << "  bench <pin> [irqpin] [count]" << endl;
+  cout << "    Measures the speed of the given pin (output) for each access layer." << endl;
+  cout << "    irqpin must be connected to pin to measure the interrupt latency." << endl;
+  cout << "  capture <pin[,pin...]> <rate> <count> [file]" << endl;
+  cout << "    Samples the given pins at rate Hz, writes VCD to stdout or to file," << endl;
+  cout << "    a sigrok session if file ends in .sr (created as the real user)." << endl;
+  cout << "  softpwm <pin[,pin...]> <frequency> <duty>" << endl;
+  cout << "    Generates a software PWM on the given pins, duty in percent." << endl;
 }
 /* ========================================================================== */